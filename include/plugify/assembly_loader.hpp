@@ -33,6 +33,13 @@ namespace plugify {
 		 * @return Success or error
 		 */
 		virtual Result<void> Unload(const AssemblyPtr& assembly) = 0;
+
+		/**
+		 * @brief Periodic housekeeping, called from Manager::Update
+		 * @details Lets a loader release resources on a timer, e.g. cached
+		 * assemblies which were unloaded long ago.
+		 */
+		virtual void Update() {}
 	};
 
 	using AssemblyLoaderPtr = std::shared_ptr<IAssemblyLoader>;
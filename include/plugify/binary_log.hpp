@@ -0,0 +1,267 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "plugify/global.h"
+#include "plugify/logger.hpp"
+#include "plugify/types.hpp"
+
+namespace plugify {
+	/**
+	 * @enum LogArgKind
+	 * @brief How an argument of a binary log record is encoded.
+	 */
+	enum class LogArgKind : uint8_t {
+		Bool,     ///< 1 byte
+		Char,     ///< 1 byte
+		Int,      ///< int64_t, any signed integer or enum
+		UInt,     ///< uint64_t, any unsigned integer
+		Float,    ///< double, any floating point
+		Pointer,  ///< Address, printed as a pointer
+		String    ///< uint32_t length followed by the bytes, copied at the call
+	};
+
+	/**
+	 * @struct LogSite
+	 * @brief Static description of one binary log call site.
+	 * @details Lives in a static at the call site (see PLUGIFY_LOG_BINARY) and is registered
+	 * on its first call. Records then carry the site id instead of any text.
+	 */
+	struct LogSite {
+		std::string_view format;              ///< std::format string, rendered by the decoder
+		Severity severity{};                  ///< Severity of every record of the site
+		Location location;                    ///< Where the site is
+		std::atomic<uint32_t> id{ 0 };        ///< Assigned on registration, 0 before that
+	};
+
+	/**
+	 * @brief Encoding of an argument type.
+	 * @tparam T Decayed argument type.
+	 */
+	template <typename T>
+	consteval LogArgKind GetLogArgKind() {
+		if constexpr (std::same_as<T, bool>) {
+			return LogArgKind::Bool;
+		} else if constexpr (std::same_as<T, char>) {
+			return LogArgKind::Char;
+		} else if constexpr (std::convertible_to<const T&, std::string_view>) {
+			return LogArgKind::String;
+		} else if constexpr (std::is_enum_v<T>) {
+			return std::is_signed_v<std::underlying_type_t<T>> ? LogArgKind::Int : LogArgKind::UInt;
+		} else if constexpr (std::is_integral_v<T>) {
+			return std::is_signed_v<T> ? LogArgKind::Int : LogArgKind::UInt;
+		} else if constexpr (std::is_floating_point_v<T>) {
+			return LogArgKind::Float;
+		} else if constexpr (std::is_pointer_v<T>) {
+			return LogArgKind::Pointer;
+		} else {
+			static_assert(sizeof(T) == 0, "Type cannot be written to a binary log");
+		}
+	}
+
+	/**
+	 * @struct BinaryLogRecord
+	 * @brief Record rendered back to text by a decoder.
+	 */
+	struct BinaryLogRecord {
+		std::chrono::system_clock::time_point time;  ///< Time of the call
+		Severity severity{};                         ///< Severity of the site
+		Location location;                           ///< Location of the site
+		std::string_view message;                    ///< Rendered message, valid during the callback
+	};
+
+	/**
+	 * @struct BinaryLogOptions
+	 * @brief Buffering of a BinaryLog.
+	 */
+	struct BinaryLogOptions {
+		size_t threadBufferSize{ 1 << 20 };              ///< Ring size of each thread, in bytes
+		std::chrono::milliseconds flushInterval{ 100 };  ///< How often the rings are collected
+		Severity minSeverity{ Severity::Trace };         ///< Records below are not written
+	};
+
+	/**
+	 * @class BinaryLog
+	 * @brief Logging which defers all formatting, modeled on NanoLog.
+	 * @details A call site registers its format string once. Every call then only copies its
+	 * raw arguments, with a site id and a timestamp, into a ring owned by the calling thread;
+	 * no formatting, no allocation and no lock. A background thread collects the rings and
+	 * either stores the records in a file, to be rendered offline (`plug decode <file>`), or
+	 * renders them and hands the text to a logger.
+	 * @note When a ring is full the record is dropped and counted, the call never waits.
+	 */
+	class PLUGIFY_API BinaryLog {
+	public:
+		static constexpr size_t kMaxArgs = 16;
+
+		using Options = BinaryLogOptions;
+
+		/**
+		 * @brief Store records in a file for offline decoding.
+		 * @param file File to create, overwritten if it exists.
+		 * @param options Buffering options.
+		 * @return Log, or an error if the file cannot be created.
+		 */
+		static Result<std::shared_ptr<BinaryLog>> Create(const std::filesystem::path& file, Options options = {});
+
+		/**
+		 * @brief Render records on the background thread and pass them to a logger.
+		 * @details The logger timestamps records when they reach it, up to a flush interval
+		 * after the call.
+		 * @param sink Logger receiving the text.
+		 * @param options Buffering options.
+		 * @return Log.
+		 */
+		static std::shared_ptr<BinaryLog> Create(std::shared_ptr<ILogger> sink, Options options = {});
+
+		/**
+		 * @brief Render every record of a file.
+		 * @param file File written by a log created with a path.
+		 * @param callback Called for each record, in order.
+		 * @return Error if the file cannot be read or is not a binary log.
+		 */
+		static Result<void> Decode(const std::filesystem::path& file, const std::function<void(const BinaryLogRecord&)>& callback);
+
+		~BinaryLog();
+		BinaryLog(const BinaryLog&) = delete;
+		BinaryLog& operator=(const BinaryLog&) = delete;
+
+		/**
+		 * @brief Write a record of a call site.
+		 * @details Prefer PLUGIFY_LOG_BINARY, which also checks the format string against the
+		 * arguments at compile time.
+		 * @param site Call site, must outlive the log.
+		 * @param args Arguments of the format string.
+		 */
+		template <typename... Args>
+		void Write(LogSite& site, const Args&... args) noexcept {
+			static_assert(sizeof...(Args) <= kMaxArgs, "Too many arguments for a binary log record");
+
+			if (site.severity < _minSeverity.load(std::memory_order_relaxed)) {
+				return;
+			}
+
+			uint32_t id = site.id.load(std::memory_order_acquire);
+			if (id == 0) {
+				static constexpr std::array<LogArgKind, sizeof...(Args)> kKinds{ GetLogArgKind<std::decay_t<Args>>()... };
+				id = RegisterSite(site, kKinds);
+			}
+
+			const size_t size = (size_t{ 0 } + ... + EncodedSize(args));
+			std::byte* data = Reserve(id, size);
+			if (!data) {
+				return;
+			}
+			(Encode(data, args), ...);
+			Commit();
+		}
+
+		/**
+		 * @brief Collect and write out every record logged so far.
+		 */
+		void Flush();
+
+		/**
+		 * @brief Get the number of records dropped because a ring was full.
+		 */
+		[[nodiscard]] uint64_t GetDropped() const noexcept;
+
+		void SetLogLevel(Severity minSeverity) noexcept {
+			_minSeverity.store(minSeverity, std::memory_order_relaxed);
+		}
+
+		[[nodiscard]] Severity GetLogLevel() const noexcept {
+			return _minSeverity.load(std::memory_order_relaxed);
+		}
+
+		PLUGIFY_ACCESS : struct Impl;
+		PLUGIFY_NO_DLL_EXPORT_WARNING(std::unique_ptr<Impl> _impl;)
+
+	private:
+		explicit BinaryLog(std::unique_ptr<Impl> impl, Severity minSeverity);
+
+		static uint32_t RegisterSite(LogSite& site, std::span<const LogArgKind> kinds);
+
+		// Space for the arguments in the ring of the calling thread, nullptr if full
+		std::byte* Reserve(uint32_t site, size_t size) noexcept;
+
+		// Publishes the record reserved last by the calling thread
+		void Commit() noexcept;
+
+		template <typename T>
+		static size_t EncodedSize(const T& value) noexcept {
+			if constexpr (GetLogArgKind<T>() == LogArgKind::String) {
+				return sizeof(uint32_t) + ToStringView(value).size();
+			} else if constexpr (GetLogArgKind<T>() == LogArgKind::Bool || GetLogArgKind<T>() == LogArgKind::Char) {
+				return 1;
+			} else {
+				return sizeof(uint64_t);
+			}
+		}
+
+		template <typename T>
+		static void Encode(std::byte*& data, const T& value) noexcept {
+			constexpr LogArgKind kind = GetLogArgKind<T>();
+			if constexpr (kind == LogArgKind::String) {
+				std::string_view str = ToStringView(value);
+				auto length = static_cast<uint32_t>(str.size());
+				std::memcpy(data, &length, sizeof(length));
+				std::memcpy(data + sizeof(length), str.data(), str.size());
+				data += sizeof(length) + str.size();
+			} else if constexpr (kind == LogArgKind::Bool || kind == LogArgKind::Char) {
+				*data++ = static_cast<std::byte>(value);
+			} else {
+				uint64_t slot;
+				if constexpr (kind == LogArgKind::Float) {
+					auto number = static_cast<double>(value);
+					std::memcpy(&slot, &number, sizeof(slot));
+				} else if constexpr (kind == LogArgKind::Pointer) {
+					slot = reinterpret_cast<uintptr_t>(value);
+				} else {
+					slot = static_cast<uint64_t>(value);
+				}
+				std::memcpy(data, &slot, sizeof(slot));
+				data += sizeof(slot);
+			}
+		}
+
+		template <typename T>
+		static std::string_view ToStringView(const T& value) noexcept {
+			if constexpr (std::is_pointer_v<T>) {
+				return value ? std::string_view(value) : std::string_view("(null)");
+			} else {
+				return std::string_view(value);
+			}
+		}
+
+		PLUGIFY_NO_DLL_EXPORT_WARNING(std::atomic<Severity> _minSeverity;)
+	};
+}  // namespace plugify
+
+/**
+ * @brief Write a record to a BinaryLog, e.g.
+ * `PLUGIFY_LOG_BINARY(log, Severity::Trace, "tick {} took {:.3f} ms", frame, ms);`
+ * @details The format string is checked against the arguments at compile time, the call
+ * site is registered on first use.
+ */
+#define PLUGIFY_LOG_BINARY(log, severity, format, ...)                                          \
+	do {                                                                                        \
+		static ::plugify::LogSite plugifyLogSite_{ format, severity, ::plugify::Location::current() }; \
+		[&]<typename... PlugifyArgs_>(const PlugifyArgs_&... plugifyArgs_) {                     \
+			[[maybe_unused]] constexpr std::format_string<const PlugifyArgs_&...> plugifyCheck_(format); \
+			(log).Write(plugifyLogSite_, plugifyArgs_...);                                       \
+		}(__VA_ARGS__);                                                                         \
+	} while (false)
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
@@ -9,6 +10,8 @@
 #include <span>
 #include <concepts>
 #include <type_traits>
+#include <tuple>
+#include <utility>
 
 #include "plugify/global.h"
 #include "plugify/address.hpp"
@@ -19,8 +22,12 @@
 #include "plg/inplace_vector.hpp"
 
 namespace plugify {
+	class Parameters;
 	class Return;
 
+	template <typename... Args>
+	class TypedParameters;
+
 	/**
 	 * @class JitCall
 	 * @brief Class encapsulates architecture-, OS- and compiler-specific
@@ -61,7 +68,8 @@ namespace plugify {
 
 		/**
 		 * @brief HiddenParam is a predicate function pointer to determine if a ValueType should be
-		 * passed as a hidden parameter. Use for return structs on x86 and arm arch.
+		 * passed as a hidden parameter. Use for return structs on x86 and arm arch. nullptr
+		 * selects ValueUtils::IsHiddenParam.
 		 */
 		using HiddenParam = bool (*)(ValueType);
 
@@ -92,7 +100,7 @@ namespace plugify {
 		    const Method& method,
 		    Address target,
 		    WaitType waitType = WaitType::None,
-		    HiddenParam hidden = &ValueUtils::IsHiddenParam
+		    HiddenParam hidden = nullptr
 		);
 
 		/**
@@ -111,8 +119,52 @@ namespace plugify {
 		 */
 		Address GetTargetFunc() const noexcept;
 
+		/**
+		 * @brief Get the signature the function was generated for.
+		 * @return Lowered signature, a hidden return shows up as its first argument.
+		 */
+		const Signature& GetSignature() const noexcept;
+
+		/**
+		 * @brief Call the generated function with a typed parameter block.
+		 * @details The slots are passed to the stub as they are, there is no per-argument
+		 * work left. Debug builds assert that the argument types fit the signature.
+		 * @tparam Args Types of the arguments.
+		 * @param params Parameters of the call.
+		 * @param ret Optional return value.
+		 */
+		template <typename... Args>
+		void Invoke(const TypedParameters<Args...>& params, Return* ret = nullptr) const;
+
+		/**
+		 * @brief Call every target with the same parameters in one generated loop.
+		 * @details Arguments are loaded once and reused for every call. All targets must
+		 * match the signature the function was generated with. Signatures returning through
+		 * a hidden parameter are rejected, the single buffer would be shared by every target;
+		 * call them with InvokeEach and a buffer per parameter block instead.
+		 * @param targets Functions to call, in order.
+		 * @param params Parameters passed to each target.
+		 * @param rets Optional return values, one per target.
+		 * @return False if no function was generated, \p rets is too short, the return is
+		 * hidden or the loop stub could not be compiled (see GetError).
+		 */
+		bool InvokeAll(std::span<const Address> targets, const Parameters& params, std::span<Return> rets = {});
+
+		/**
+		 * @brief Call the target once per parameter block in one generated loop.
+		 * @param params Parameter blocks, one call each.
+		 * @param rets Optional return values, one per parameter block.
+		 * @return False if no function was generated, \p rets is too short or the loop stub
+		 * could not be compiled (see GetError).
+		 */
+		bool InvokeEach(std::span<const Parameters> params, std::span<Return> rets = {});
+
 		/**
 		 * @brief Get the error message, if any.
+		 * @details Once a function is generated, this reports why the latest InvokeAll or
+		 * InvokeEach returned false, and is empty after one that succeeded. When those are
+		 * called concurrently on one instance, it holds the outcome of whichever finished
+		 * last.
 		 * @return Error message.
 		 */
 		std::string_view GetError() noexcept;
@@ -278,6 +330,93 @@ namespace plugify {
 		std::inplace_vector<SlotType, Signature::kMaxFuncArgs> _storage{};  ///< Fixed-capacity vector storage
 	};
 
+	/**
+	 * @class TypedParameters
+	 * @brief Parameter block with one slot per argument, laid out at compile time.
+	 * @details Same slots as Parameters, but the argument count and types are part of the
+	 * type: filling it is a fixed sequence of stores with no bounds checks, which suits
+	 * calls made over and over with the same signature.
+	 * @tparam Args Types of the arguments, each fitting a single slot.
+	 */
+	template <typename... Args>
+	class TypedParameters {
+		static_assert((SingleSlotType<Args> && ...), "Every argument must fit a parameter slot");
+		static_assert(sizeof...(Args) <= Signature::kMaxFuncArgs, "Too many arguments");
+
+	public:
+		using SlotType = uint64_t;
+		static constexpr size_t SlotCount = sizeof...(Args);
+
+		/**
+		 * @brief Constructor.
+		 * @param args Arguments, in order.
+		 */
+		explicit TypedParameters(Args... args) noexcept {
+			Store(std::index_sequence_for<Args...>{}, args...);
+		}
+
+		/**
+		 * @brief Overwrite one argument.
+		 * @tparam I Position of the argument.
+		 * @param value Value to set.
+		 */
+		template <size_t I>
+		void Set(std::tuple_element_t<I, std::tuple<Args...>> value) noexcept {
+			_storage[I] = {};
+			std::memcpy(&_storage[I], &value, sizeof(value));
+		}
+
+		/**
+		 * @brief Get pointer to the parameter data.
+		 * @return Const pointer to the parameter storage.
+		 */
+		[[nodiscard]] const SlotType* Get() const noexcept {
+			return _storage.data();
+		}
+
+		/**
+		 * @brief Check the argument types against a signature.
+		 * @details Every argument must have the size and kind of its slot: floating point
+		 * for float/double, integer for integer types and pointer for pointers, objects
+		 * and structs, which are passed by address.
+		 * @param signature Signature to check, as returned by JitCall::GetSignature().
+		 * @return True if the block can be passed to a function of the signature.
+		 */
+		[[nodiscard]] static constexpr bool Matches(const Signature& signature) noexcept {
+			if (signature.ArgCount() != SlotCount) {
+				return false;
+			}
+			return [&]<size_t... I>(std::index_sequence<I...>) {
+				return (IsSlotOf<Args>(signature.argTypes[I]) && ...);
+			}(std::index_sequence_for<Args...>{});
+		}
+
+	private:
+		template <size_t... I>
+		void Store(std::index_sequence<I...>, Args... args) noexcept {
+			(std::memcpy(&_storage[I], &args, sizeof(args)), ...);
+		}
+
+		template <typename T>
+		static constexpr bool IsSlotOf(ValueType type) noexcept {
+			if constexpr (std::is_pointer_v<T>) {
+				return type == ValueType::Pointer || type == ValueType::Function || !ValueUtils::IsScalar(type);
+			} else if constexpr (std::is_floating_point_v<T>) {
+				return ValueUtils::IsFloating(type) && ValueUtils::SizeOf(type) == sizeof(T);
+			} else {
+				// integers and enums, a pointer sized one may carry an address
+				if (type == ValueType::Pointer) {
+					return sizeof(T) == sizeof(void*);
+				}
+				return ValueUtils::IsScalar(type) && !ValueUtils::IsFloating(type)
+					&& type != ValueType::Void && type != ValueType::Function
+					&& ValueUtils::SizeOf(type) == sizeof(T);
+			}
+		}
+
+		std::array<SlotType, SlotCount == 0 ? 1 : SlotCount> _storage{};  ///< One slot per argument
+	};
+
 	/**
 	 * @class Return
 	 * @brief Wrapper for function return values.
@@ -336,4 +475,13 @@ namespace plugify {
 		alignas(alignof(std::max_align_t))
 		std::array<std::byte, MaxSize> _storage{};  ///< 128-bit storage
 	};
+
+	template <typename... Args>
+	void JitCall::Invoke(const TypedParameters<Args...>& params, Return* ret) const {
+		assert(TypedParameters<Args...>::Matches(GetSignature()) && "Arguments do not match the signature");
+
+		// the stub stores a non-void result unconditionally
+		Return scratch;
+		GetFunction().template As<CallingFunc>()(params.Get(), ret ? ret : &scratch);
+	}
 }  // namespace plugify
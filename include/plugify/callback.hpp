@@ -64,7 +64,8 @@ namespace plugify {
 
 		/**
 		 * @brief HiddenParam is a predicate function pointer to determine if a ValueType should be
-		 * passed as a hidden parameter. Use for return structs on x86 and arm arch.
+		 * passed as a hidden parameter. Use for return structs on x86 and arm arch. nullptr
+		 * selects ValueUtils::IsHiddenParam.
 		 */
 		using HiddenParam = bool (*)(ValueType);
 
@@ -106,7 +107,45 @@ namespace plugify {
 		    const Method& method,
 		    CallbackHandler callback,
 		    Address data = nullptr,
-		    HiddenParam hidden = &ValueUtils::IsHiddenParam
+		    HiddenParam hidden = nullptr
+		);
+
+		/**
+		 * @brief Generates a callback which forwards straight to a typed native handler.
+		 * @param signature The function signature of the generated callback.
+		 * @param handler Native function with the same signature and the user data pointer
+		 * inserted as first parameter: `Ret handler(void* data, Args... args)`.
+		 * @param data User data passed to the handler.
+		 * @param hidden If true, the return value is passed as a hidden argument; it stays in
+		 * front of \p data, as the native handler expects.
+		 * @return Pointer to the generated function, or nullptr if generation fails.
+		 * @details Unlike the generic mode, arguments are never boxed into a slot array.
+		 * Where the ABI allows it (SysV x86-64 and AArch64 with a free integer register),
+		 * the generated code only shifts the integer argument registers, loads \p data and
+		 * tail-jumps into the handler; otherwise it performs a direct typed call.
+		 */
+		Address GetTypedJitFunc(
+		    const Signature& signature,
+		    Address handler,
+		    Address data,
+		    bool hidden
+		);
+
+		/**
+		 * @brief Generates a callback matching the method which forwards straight to a typed
+		 * native handler, see the Signature overload.
+		 * @param method The method descriptor defining the function signature.
+		 * @param handler Native function `Ret handler(void* data, Args... args)`.
+		 * @param data Optional user data passed to the handler.
+		 * @param hidden Predicate to determine if the return value should be passed as a hidden
+		 * argument.
+		 * @return Pointer to the generated function, or nullptr if generation fails.
+		 */
+		Address GetTypedJitFunc(
+		    const Method& method,
+		    Address handler,
+		    Address data = nullptr,
+		    HiddenParam hidden = nullptr
 		);
 
 		/**
@@ -87,6 +87,8 @@ namespace plugify {
 			std::chrono::milliseconds loadTimeout{ 500 };
 			std::chrono::milliseconds exportTimeout{ 100 };
 			std::chrono::milliseconds startTimeout{ 250 };
+			size_t warmCacheSize = 0;                  // unloaded assemblies kept mapped for reloads, 0 disables
+			std::chrono::seconds warmCacheMaxAge{ 300 };
 
 			// Check if values are non-default
 			bool HasCustomPreferOwnSymbols() const {
@@ -108,6 +110,14 @@ namespace plugify {
 			bool HasCustomStartTimeout() const {
 				return startTimeout != std::chrono::milliseconds{ 250 };
 			}
+
+			bool HasCustomWarmCacheSize() const {
+				return warmCacheSize != 0;
+			}
+
+			bool HasCustomWarmCacheMaxAge() const {
+				return warmCacheMaxAge != std::chrono::seconds{ 300 };
+			}
 		} loading{};
 
 		// Security configuration
@@ -137,6 +147,10 @@ namespace plugify {
 			bool printDependencyGraph = false;
 			bool printDigraphDot = false;
 			std::filesystem::path exportDigraphDot;
+			bool flightRecorder = false;         // keep recent logs and lifecycle events in logsDir/flight.rec
+			size_t flightRecorderSize = 4096;    // entries kept by the flight recorder
+			size_t queueCapacity = 8192;         // messages the default logger queues for its writer thread
+			OverflowPolicy overflowPolicy = OverflowPolicy::Block;  // what the default logger does with a full queue
 
 			bool HasCustomSeverity() const {
 				return severity != DefaultVerbosity;
@@ -161,6 +175,22 @@ namespace plugify {
 			bool HasExportPath() const {
 				return !exportDigraphDot.empty();
 			}
+
+			bool HasCustomFlightRecorder() const {
+				return flightRecorder != false;
+			}
+
+			bool HasCustomFlightRecorderSize() const {
+				return flightRecorderSize != 4096;
+			}
+
+			bool HasCustomQueueCapacity() const {
+				return queueCapacity != 8192;
+			}
+
+			bool HasCustomOverflowPolicy() const {
+				return overflowPolicy != OverflowPolicy::Block;
+			}
 		} logging{};
 
 		// Comprehensive merge implementation
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string_view>
+
+#include "plg/format.hpp"
+
+#include "plugify/global.h"
+#include "plugify/logger.hpp"
+#include "plugify/types.hpp"
+
+namespace plugify {
+	/**
+	 * @enum FlightEvent
+	 * @brief What a flight recorder entry describes.
+	 */
+	enum class FlightEvent : uint8_t {
+		Log,     ///< Message passed to the logger
+		State,   ///< Extension state transition
+		Loader   ///< Extension loader calling into, or back from, an extension
+	};
+
+	/**
+	 * @struct FlightRecord
+	 * @brief Entry read back from a flight recorder file.
+	 */
+	struct FlightRecord {
+		std::chrono::system_clock::time_point time;  ///< Time of the entry
+		uint64_t sequence{};                         ///< Position in the order of writes
+		uint32_t thread{};                           ///< Hash of the writing thread id
+		FlightEvent event{};                         ///< Kind of entry
+		Severity severity{};                         ///< Severity of the entry
+		std::string_view text;                       ///< Text, valid during the callback
+	};
+
+	/**
+	 * @class FlightRecorder
+	 * @brief Fixed-size ring of the latest log messages and lifecycle events, kept in a
+	 * memory-mapped file.
+	 * @details Writers claim a slot with a single atomic increment and copy their text into
+	 * it, there is no lock, allocation or system call. The mapping is shared with the file,
+	 * so whatever was written is in the page cache and reaches the disk even if the process
+	 * dies on a signal. Decode the file afterwards with `plug flight <file>`.
+	 * @note Texts longer than a slot are truncated. A slot being written at the time of a
+	 * crash is skipped by the decoder. A writer which reaches a slot still being written by
+	 * one that the ring lapped drops its entry instead of mixing the two.
+	 */
+	class PLUGIFY_API FlightRecorder {
+	public:
+		static constexpr size_t kSlotSize = 256;
+		static constexpr size_t kDefaultCapacity = 4096;
+
+		/**
+		 * @brief Map a new recorder file.
+		 * @details An existing file is kept as `<file>.prev`, so the entries of a crashed
+		 * session survive the restart which follows it.
+		 * @param file File to create.
+		 * @param capacity Number of slots, rounded up to a power of two.
+		 * @return Recorder, or an error if the file cannot be created or mapped.
+		 */
+		static Result<std::shared_ptr<FlightRecorder>> Create(const std::filesystem::path& file, size_t capacity = kDefaultCapacity);
+
+		/**
+		 * @brief Read back every complete entry of a recorder file, oldest first.
+		 * @param file File written by a recorder.
+		 * @param callback Called for each entry.
+		 * @return Error if the file cannot be read or is not a recorder file.
+		 */
+		static Result<void> Decode(const std::filesystem::path& file, const std::function<void(const FlightRecord&)>& callback);
+
+		/**
+		 * @brief Set the recorder which lifecycle events go to.
+		 * @param recorder Recorder, or nullptr to stop recording them.
+		 */
+		static void SetActive(std::shared_ptr<FlightRecorder> recorder);
+
+		/**
+		 * @brief Get the recorder which lifecycle events go to.
+		 * @return Recorder, or nullptr if none is set.
+		 */
+		static std::shared_ptr<FlightRecorder> GetActive();
+
+		~FlightRecorder();
+		FlightRecorder(const FlightRecorder&) = delete;
+		FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+		/**
+		 * @brief Write an entry.
+		 * @param event Kind of entry.
+		 * @param severity Severity of the entry.
+		 * @param text Text, truncated to fit a slot.
+		 */
+		void Record(FlightEvent event, Severity severity, std::string_view text) noexcept;
+
+		/**
+		 * @brief Format and write an entry, without allocating.
+		 */
+		template <typename... Args>
+		void Record(FlightEvent event, Severity severity, std::format_string<Args...> format, Args&&... args) noexcept {
+			char buffer[kSlotSize];
+			try {
+				auto result = std::format_to_n(buffer, sizeof(buffer), format, std::forward<Args>(args)...);
+				Record(event, severity, std::string_view(buffer, result.out));
+			} catch (...) {
+				Record(event, severity, format.get());
+			}
+		}
+
+		/**
+		 * @brief Get the number of slots.
+		 */
+		[[nodiscard]] size_t GetCapacity() const noexcept;
+
+		/**
+		 * @brief Get the mapped file.
+		 */
+		[[nodiscard]] const std::filesystem::path& GetPath() const noexcept;
+
+		PLUGIFY_ACCESS : struct Impl;
+		PLUGIFY_NO_DLL_EXPORT_WARNING(std::unique_ptr<Impl> _impl;)
+
+	private:
+		explicit FlightRecorder(std::unique_ptr<Impl> impl) noexcept;
+	};
+}  // namespace plugify
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+
+#include "plugify/global.h"
+#include "plugify/address.hpp"
+#include "plugify/call.hpp"
+#include "plugify/callback.hpp"
+#include "plugify/method.hpp"
+#include "plugify/signarure.hpp"
+
+namespace plugify {
+	/**
+	 * @class JitBatch
+	 * @brief Generates many JitCall and JitCallback stubs at once, e.g. the whole export
+	 * set of a plugin, into a single contiguous block of executable memory.
+	 * @details Entries are queued with AddCall() / AddCallback() and generated together by
+	 * Compile(), which relocates and commits the code only once instead of once per stub.
+	 * Generic call stubs for signatures not seen before are compiled in one pass as well and
+	 * shared with every other JitCall of the process. The generated functions stay valid
+	 * for as long as the batch is alive.
+	 */
+	class PLUGIFY_API JitBatch {
+	public:
+		/**
+		 * @brief Constructor.
+		 */
+		JitBatch();
+
+		/**
+		 * @brief Copy constructor.
+		 * @param other Another instance of JitBatch.
+		 */
+		JitBatch(const JitBatch& other) = delete;
+
+		/**
+		 * @brief Move constructor.
+		 * @param other Another instance of JitBatch.
+		 */
+		JitBatch(JitBatch&& other) noexcept;
+
+		/**
+		 * @brief Destructor. Releases the generated block.
+		 */
+		~JitBatch();
+
+		/**
+		 * @brief Queues a call stub, see JitCall::GetJitFunc.
+		 * @param signature Signature of the function to call.
+		 * @param target Target function.
+		 * @param waitType Optional breakpoint or keypress before the call.
+		 * @param hidden If true, return will be pass as hidden argument.
+		 * @return Index of the entry to pass to GetFunction().
+		 */
+		size_t AddCall(const Signature& signature, Address target, JitCall::WaitType waitType, bool hidden);
+
+		/**
+		 * @brief Queues a call stub, see JitCall::GetJitFunc.
+		 * @param method Reference to the method.
+		 * @param target Target function.
+		 * @param waitType Optional breakpoint or keypress before the call.
+		 * @param hidden Predicate telling whether the return is passed as hidden argument.
+		 * @return Index of the entry to pass to GetFunction().
+		 */
+		size_t AddCall(
+		    const Method& method,
+		    Address target,
+		    JitCall::WaitType waitType = JitCall::WaitType::None,
+		    JitCall::HiddenParam hidden = nullptr
+		);
+
+		/**
+		 * @brief Queues a callback stub, see JitCallback::GetJitFunc.
+		 * @param signature Signature of the callback.
+		 * @param method Method passed back to the handler.
+		 * @param callback Callback handler.
+		 * @param data User data.
+		 * @param hidden If true, return will be pass as hidden argument.
+		 * @return Index of the entry to pass to GetFunction().
+		 */
+		size_t AddCallback(
+		    const Signature& signature,
+		    const Method* method,
+		    JitCallback::CallbackHandler callback,
+		    Address data,
+		    bool hidden
+		);
+
+		/**
+		 * @brief Queues a callback stub, see JitCallback::GetJitFunc.
+		 * @param method Reference to the method.
+		 * @param callback Callback handler.
+		 * @param data User data.
+		 * @param hidden Predicate telling whether the return is passed as hidden argument.
+		 * @return Index of the entry to pass to GetFunction().
+		 */
+		size_t AddCallback(
+		    const Method& method,
+		    JitCallback::CallbackHandler callback,
+		    Address data = nullptr,
+		    JitCallback::HiddenParam hidden = nullptr
+		);
+
+		/**
+		 * @brief Generates and commits every queued entry.
+		 * @return True on success, otherwise GetError() describes the failure.
+		 * @note A batch can be compiled only once.
+		 */
+		bool Compile();
+
+		/**
+		 * @brief Get a generated function.
+		 * @param index Index returned by AddCall() or AddCallback().
+		 * @return Pointer to the generated function, or nullptr if not compiled.
+		 */
+		Address GetFunction(size_t index) const noexcept;
+
+		/**
+		 * @brief Get the number of queued entries.
+		 * @return Number of entries.
+		 */
+		size_t GetSize() const noexcept;
+
+		/**
+		 * @brief Get the error message, if any.
+		 * @return Error message.
+		 */
+		std::string_view GetError() const noexcept;
+
+		/**
+		 * @brief Copy assignment operator for JitBatch.
+		 * @param other The other JitBatch instance to copy from.
+		 * @return A reference to this instance after copying.
+		 */
+		JitBatch& operator=(const JitBatch& other) = delete;
+
+		/**
+		 * @brief Move assignment operator for JitBatch.
+		 * @param other The other JitBatch instance to move from.
+		 * @return A reference to this instance after moving.
+		 */
+		JitBatch& operator=(JitBatch&& other) noexcept;
+
+		PLUGIFY_ACCESS : struct Impl;
+		PLUGIFY_NO_DLL_EXPORT_WARNING(std::unique_ptr<Impl> _impl;)
+	};
+}  // namespace plugify
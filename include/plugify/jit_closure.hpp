@@ -0,0 +1,116 @@
+#pragma once
+
+#include <memory>
+#include <string_view>
+
+#include "plugify/global.h"
+#include "plugify/address.hpp"
+#include "plugify/callback.hpp"
+#include "plugify/method.hpp"
+#include "plugify/signarure.hpp"
+
+namespace plugify {
+	/**
+	 * @class JitClosure
+	 * @brief Callback with the same behaviour as JitCallback, meant for creating many instances
+	 * of one signature (e.g. one per bound delegate).
+	 * @details The stub is compiled once per signature and takes its callback, method and data
+	 * as context. Every instance only gets a small fixed-size thunk, carved from preallocated
+	 * executable pages, which loads its context and jumps into the shared stub. Creating and
+	 * destroying an instance is therefore a slab allocation instead of a compilation.
+	 * @note When the context cannot be passed in a register (32-bit targets, variadic
+	 * signatures or every argument register taken) the instance falls back to a stub of its own.
+	 */
+	class PLUGIFY_API JitClosure {
+	public:
+		/**
+		 * @brief Constructor.
+		 */
+		JitClosure();
+
+		/**
+		 * @brief Copy constructor.
+		 * @param other Another instance of JitClosure.
+		 */
+		JitClosure(const JitClosure& other) = delete;
+
+		/**
+		 * @brief Move constructor.
+		 * @param other Another instance of JitClosure.
+		 */
+		JitClosure(JitClosure&& other) noexcept;
+
+		/**
+		 * @brief Destructor. Returns the thunk to its pool.
+		 */
+		~JitClosure();
+
+		/**
+		 * @brief Binds a thunk for the signature, see JitCallback::GetJitFunc().
+		 * @param signature The function signature of the closure.
+		 * @param method Optional pointer to a method descriptor passed to the handler.
+		 * @param callback Pointer to the callback handler to invoke.
+		 * @param data User data to be passed to the callback handler.
+		 * @param hidden If true, the return value will be passed as a hidden argument.
+		 * @return Pointer to the closure, or nullptr if generation fails.
+		 */
+		Address GetJitFunc(
+		    const Signature& signature,
+		    const Method* method,
+		    JitCallback::CallbackHandler callback,
+		    Address data,
+		    bool hidden
+		);
+
+		/**
+		 * @brief Binds a thunk matching the method signature.
+		 * @param method The method descriptor, must outlive the object.
+		 * @param callback Pointer to the callback handler to invoke.
+		 * @param data Optional user data passed to the callback handler.
+		 * @param hidden Predicate to determine if the return value should be passed as a hidden
+		 * argument.
+		 * @return Pointer to the closure, or nullptr if generation fails.
+		 */
+		Address GetJitFunc(
+		    const Method& method,
+		    JitCallback::CallbackHandler callback,
+		    Address data = nullptr,
+		    JitCallback::HiddenParam hidden = nullptr
+		);
+
+		/**
+		 * @brief Get the closure.
+		 * @return Pointer to the closure, nullptr if not created.
+		 */
+		Address GetFunction() const noexcept;
+
+		/**
+		 * @brief Get the user data associated with the object.
+		 * @return A void pointer to the user data.
+		 */
+		Address GetUserData() const noexcept;
+
+		/**
+		 * @brief Get the error message, if any.
+		 * @return Error message.
+		 */
+		std::string_view GetError() const noexcept;
+
+		/**
+		 * @brief Copy assignment operator for JitClosure.
+		 * @param other The other JitClosure instance to copy from.
+		 * @return A reference to this instance after copying.
+		 */
+		JitClosure& operator=(const JitClosure& other) = delete;
+
+		/**
+		 * @brief Move assignment operator for JitClosure.
+		 * @param other The other JitClosure instance to move from.
+		 * @return A reference to this instance after moving.
+		 */
+		JitClosure& operator=(JitClosure&& other) noexcept;
+
+		PLUGIFY_ACCESS : struct Impl;
+		PLUGIFY_NO_DLL_EXPORT_WARNING(std::unique_ptr<Impl> _impl;)
+	};
+}  // namespace plugify
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "plugify/global.h"
+#include "plugify/signarure.hpp"
+#include "plg/bitmask.hpp"
+
+namespace plugify {
+	/**
+	 * @enum JitStubKind
+	 * @brief Kind of generated stub, as reported by JitStats.
+	 */
+	enum class JitStubKind : uint8_t {
+		Call,           ///< JitCall stub or the thunk binding its target
+		Callback,       ///< JitCallback stub
+		TypedCallback,  ///< JitCallback stub created by GetTypedJitFunc
+		Generic,        ///< Generic call stub shared by every call of one signature
+		Loop,           ///< Stub of JitCall::InvokeAll or JitCall::InvokeEach, shared per signature
+		Count
+	};
+
+	/**
+	 * @struct JitSignatureStats
+	 * @brief Number of stubs generated for one signature.
+	 */
+	struct JitSignatureStats {
+		JitStubKind kind{};
+		Signature signature;
+		std::string name;  ///< Human readable signature, e.g. `int64(ptr, float)`
+		size_t count{};
+	};
+
+	/**
+	 * @struct JitStats
+	 * @brief Snapshot of the process-wide JIT counters.
+	 * @details Stub counts are cumulative (stubs created since start or the last reset),
+	 * memory figures describe the code currently held by the runtime.
+	 */
+	struct JitStats {
+		std::array<size_t, static_cast<size_t>(JitStubKind::Count)> stubs{};  ///< Stubs created, by kind
+
+		size_t liveBlocks{};     ///< Committed code blocks not released yet
+		size_t codeBytes{};      ///< Machine code bytes of live blocks
+		size_t dataBytes{};      ///< Data and padding bytes of live blocks
+		size_t reservedBytes{};  ///< Executable memory reserved by the runtime
+		size_t overheadBytes{};  ///< Allocator bookkeeping of the runtime
+
+		size_t compilations{};  ///< Compiled code units (a batch counts once)
+		std::chrono::nanoseconds totalCompileTime{};
+		std::chrono::nanoseconds maxCompileTime{};
+
+		size_t cacheHits{};    ///< Generic stubs found in the in-memory cache
+		size_t cacheMisses{};  ///< Generic stubs which had to be loaded or compiled
+		size_t thunkHits{};    ///< Stubs served by precompiled thunks
+		size_t diskHits{};     ///< Generic stubs loaded from the disk cache
+		size_t diskMisses{};   ///< Disk cache lookups which found no valid entry
+
+		std::vector<JitSignatureStats> signatures;  ///< Sorted by count, largest first
+
+		[[nodiscard]] size_t GetStubCount(JitStubKind kind) const noexcept {
+			return stubs[static_cast<size_t>(kind)];
+		}
+
+		[[nodiscard]] double GetCacheHitRate() const noexcept {
+			size_t lookups = cacheHits + cacheMisses + thunkHits;
+			return lookups ? static_cast<double>(cacheHits + thunkHits) / static_cast<double>(lookups) : 0.0;
+		}
+
+		[[nodiscard]] double GetDiskHitRate() const noexcept {
+			size_t lookups = diskHits + diskMisses;
+			return lookups ? static_cast<double>(diskHits) / static_cast<double>(lookups) : 0.0;
+		}
+	};
+
+	/**
+	 * @enum JitProfilerOutput
+	 * @brief Symbol files written for external profilers such as Linux `perf`.
+	 */
+	enum class JitProfilerOutput : uint8_t {
+		None = 0,
+
+		PerfMap = 1 << 0,  // /tmp/perf-<pid>.map, read by perf report directly
+		JitDump = 1 << 1,  // /tmp/jit-<pid>.dump, merged by perf inject --jit (needs perf record -k mono)
+
+		All = PerfMap | JitDump
+	};
+
+	consteval void enable_bitmask_operators(JitProfilerOutput);
+
+	/**
+	 * @enum JitEmitter
+	 * @brief How generic call stubs are emitted.
+	 */
+	enum class JitEmitter : uint8_t {
+		Assembler,  ///< Fixed calling sequence written directly from the ABI layout, no register allocation, opt-in
+		Compiler,   ///< asmjit Compiler with register allocation, the reference implementation and default
+	};
+
+	/**
+	 * @class JitContext
+	 * @brief Process-wide settings of the JIT which generates JitCall and JitCallback stubs.
+	 */
+	class PLUGIFY_API JitContext {
+	public:
+		JitContext() = delete;
+
+		/**
+		 * @brief Set the directory of the persistent stub cache.
+		 * @details Generic call stubs are stored there as relocatable machine code, keyed by
+		 * signature, host CPU features and library version, and are loaded back instead of
+		 * being compiled again on the next start. Plugify points it to a subfolder of
+		 * `cacheDir` on initialization.
+		 * @param directory Cache directory, an empty path disables the disk cache.
+		 */
+		static void SetCacheDirectory(const std::filesystem::path& directory);
+
+		/**
+		 * @brief Get the directory of the persistent stub cache.
+		 * @return Cache directory or an empty path if disabled.
+		 */
+		static std::filesystem::path GetCacheDirectory();
+
+		/**
+		 * @brief Forget the generic call stubs shared in memory.
+		 * @details The next call of each signature looks the disk cache up again, or
+		 * compiles the stub, e.g. after pointing the cache to another directory. Stubs
+		 * already handed out stay valid and keep their memory until the process exits,
+		 * so this is not meant to be called repeatedly.
+		 */
+		static void ClearStubCache();
+
+		/**
+		 * @brief Get a snapshot of the JIT statistics.
+		 * @details Useful to size executable memory and to spot plugins which generate
+		 * stubs in a loop (a signature with a steadily growing count).
+		 * @return Current counters.
+		 */
+		static JitStats GetStats();
+
+		/**
+		 * @brief Reset the cumulative counters (stub counts, compile times, hit rates).
+		 * @details Memory figures always describe the live state and are not affected.
+		 */
+		static void ResetStats();
+
+		/**
+		 * @brief Select the symbol files written for every stub committed from now on.
+		 * @details Each stub is named after its kind, method and signature, e.g.
+		 * `plugify::call Foo double(double, int32)`, so profilers can attribute samples to
+		 * the language boundary instead of `[unknown]`. Only supported on Linux.
+		 * Also enabled by setting the `PLUGIFY_PERF_MAP` or `PLUGIFY_JITDUMP` environment
+		 * variable to a non-zero value.
+		 * @param output Files to write, JitProfilerOutput::None closes them.
+		 */
+		static void SetProfilerOutput(JitProfilerOutput output);
+
+		/**
+		 * @brief Get the symbol files currently written.
+		 * @return Enabled outputs.
+		 */
+		static JitProfilerOutput GetProfilerOutput();
+
+		/**
+		 * @brief Select the emitter of generic call stubs compiled from now on.
+		 * @details The Assembler emitter writes the argument moves of a call directly from the
+		 * ABI layout and skips the register allocation of the Compiler, which makes compiling
+		 * a stub several times cheaper. It is opt-in, the Compiler remains the reference;
+		 * variadic signatures and stubs with a WaitType always use the Compiler. Stubs already
+		 * in the memory or disk cache are kept, each emitter has its own entries.
+		 * @param emitter Emitter to use, JitEmitter::Compiler by default.
+		 */
+		static void SetEmitter(JitEmitter emitter);
+
+		/**
+		 * @brief Get the emitter of generic call stubs.
+		 * @return Current emitter.
+		 */
+		static JitEmitter GetEmitter();
+	};
+}  // namespace plugify
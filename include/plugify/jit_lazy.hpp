@@ -0,0 +1,112 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string_view>
+
+#include "plugify/global.h"
+#include "plugify/address.hpp"
+#include "plugify/callback.hpp"
+#include "plugify/method.hpp"
+
+namespace plugify {
+	/**
+	 * @class JitLazy
+	 * @brief Entry point whose real function is only generated when it is first called,
+	 * in the manner of a PLT entry.
+	 * @details GetLazyFunc() returns a tiny trampoline which jumps through a slot. The slot
+	 * first points to a shared resolver: it saves the argument registers, generates the real
+	 * function once (concurrent first calls wait for it), patches the slot atomically and
+	 * jumps on with the original arguments. Later calls only pay the indirect jump.
+	 * Useful for exports handed out at load time of which most are never called.
+	 * @note On 32-bit targets the function is generated eagerly and returned as is.
+	 */
+	class PLUGIFY_API JitLazy {
+	public:
+		/**
+		 * @brief Produces the real function, called at most once.
+		 * @details Must return a valid function; a failure on first call cannot be reported
+		 * to the caller of the entry point and aborts the process.
+		 */
+		using Factory = std::function<Address()>;
+
+		/**
+		 * @brief Constructor.
+		 */
+		JitLazy();
+
+		/**
+		 * @brief Copy constructor.
+		 * @param other Another instance of JitLazy.
+		 */
+		JitLazy(const JitLazy& other) = delete;
+
+		/**
+		 * @brief Move constructor.
+		 * @param other Another instance of JitLazy.
+		 */
+		JitLazy(JitLazy&& other) noexcept;
+
+		/**
+		 * @brief Destructor. Releases the trampoline and the generated function.
+		 */
+		~JitLazy();
+
+		/**
+		 * @brief Get an entry point which calls \p factory on its first call.
+		 * @param factory Generates the function the entry point forwards to.
+		 * @return Pointer to the entry point, or nullptr on failure.
+		 */
+		Address GetLazyFunc(Factory factory);
+
+		/**
+		 * @brief Get an entry point which generates a JitCallback stub on its first call.
+		 * @param method Reference to the method, must outlive the object.
+		 * @param callback Callback function.
+		 * @param data User data.
+		 * @param hidden If true, return will be pass as hidden argument.
+		 * @return Pointer to the entry point, or nullptr on failure.
+		 */
+		Address GetLazyFunc(
+		    const Method& method,
+		    JitCallback::CallbackHandler callback,
+		    Address data = nullptr,
+		    JitCallback::HiddenParam hidden = nullptr
+		);
+
+		/**
+		 * @brief Get the entry point.
+		 * @return Pointer to the entry point, nullptr if not created.
+		 */
+		Address GetFunction() const noexcept;
+
+		/**
+		 * @brief Get the generated function.
+		 * @return Pointer to the real function, nullptr until the entry point was first called.
+		 */
+		Address GetResolvedFunc() const noexcept;
+
+		/**
+		 * @brief Get the error message, if any.
+		 * @return Error message.
+		 */
+		std::string_view GetError() const noexcept;
+
+		/**
+		 * @brief Copy assignment operator for JitLazy.
+		 * @param other The other JitLazy instance to copy from.
+		 * @return A reference to this instance after copying.
+		 */
+		JitLazy& operator=(const JitLazy& other) = delete;
+
+		/**
+		 * @brief Move assignment operator for JitLazy.
+		 * @param other The other JitLazy instance to move from.
+		 * @return A reference to this instance after moving.
+		 */
+		JitLazy& operator=(JitLazy&& other) noexcept;
+
+		PLUGIFY_ACCESS : struct Impl;
+		PLUGIFY_NO_DLL_EXPORT_WARNING(std::unique_ptr<Impl> _impl;)
+	};
+}  // namespace plugify
@@ -100,6 +100,13 @@ namespace plugify {
 
 		/**
 		 * @brief Handle method export event.
+		 * @details Called only on running language modules hosting a plugin that
+		 *          declares a dependency on the exporting plugin, at most once per
+		 *          module and exporting plugin. Earlier versions called it on every
+		 *          running module: a module whose plugins use methods of a plugin
+		 *          they do not depend on no longer receives the call, and must look
+		 *          them up via Provider::FindMethods / Provider::FindMethod, which
+		 *          cover every plugin exported so far.
 		 * @param plugin Ref to the plugin exporting a method.
 		 * @return Result of the export, either void or an error string.
 		 */
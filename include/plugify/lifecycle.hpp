@@ -7,10 +7,24 @@
 namespace plugify {
 	class Extension;
 
+	// How lifecycle events reach an observer. Both deliver on the manager's
+	// thread: callbacks get the live extension, which must not be read while
+	// the loader may be changing it.
+	enum class LifecycleDelivery {
+		Synchronous, // Inline on the loader thread (blocking)
+		Deferred     // Batched and delivered at the end of Manager::Update/Initialize/Terminate
+	};
+
 	// Lifecycle interface
+	// Events are queued and delivered in batches unless the observer opts into
+	// synchronous delivery, so extension state may have moved on by the time
+	// a deferred callback runs.
 	class IExtensionLifecycle {
 	public:
 		virtual ~IExtensionLifecycle() = default;
+		virtual LifecycleDelivery GetDelivery() const {
+			return LifecycleDelivery::Deferred;
+		}
 		// virtual void OnReload(Extension& extension) = 0;
 		virtual void OnLoad(Extension& extension) = 0;
 		virtual void OnUnload(Extension& extension) = 0;
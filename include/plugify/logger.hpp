@@ -1,6 +1,9 @@
 #pragma once
 
+#include <concepts>
+#include <cstdint>
 #include <string>
+#include <string_view>
 
 #include "plugify/types.hpp"
 
@@ -11,6 +14,45 @@ namespace plugify {
 	 */
 	enum class Severity { Unknown, Trace, Debug, Info, Warning, Error, Fatal };
 
+	/**
+	 * @enum OverflowPolicy
+	 * @brief What a logger with a bounded queue does when the queue is full.
+	 */
+	enum class OverflowPolicy : uint8_t {
+		Block,       ///< Wait for the queue to make room
+		DropOldest,  ///< Discard the oldest queued message
+		DropNewest   ///< Discard the message being logged
+	};
+
+	/**
+	 * @struct LogStats
+	 * @brief Counters of messages a logger did not write.
+	 */
+	struct LogStats {
+		uint64_t droppedOldest{};  ///< Queued messages discarded to make room
+		uint64_t droppedNewest{};  ///< Messages discarded because the queue was full
+	};
+
+	/**
+	 * @struct LogFormat
+	 * @brief Format string of a log message together with the location it was written at.
+	 * @details The location is captured as a default argument of the implicit conversion
+	 * from the format string, which lets it sit in front of a variadic argument pack.
+	 * @tparam Args Types of the format arguments.
+	 */
+	template <typename... Args>
+	struct LogFormat {
+		template <typename T>
+		    requires std::convertible_to<const T&, std::string_view>
+		consteval LogFormat(const T& format, const Location& location = Location::current())
+			: format(format)
+			, location(location) {
+		}
+
+		std::format_string<Args...> format;  ///< Checked at compile time
+		Location location;                   ///< Where the message was written
+	};
+
 	/**
 	 * @class ILogger
 	 * @brief Interface for logging messages with different severity levels.
@@ -48,6 +90,14 @@ namespace plugify {
 		 * @brief Flush any buffered log messages.
 		 */
 		virtual void Flush() = 0;
+
+		/**
+		 * @brief Get the counters of messages which were not written.
+		 * @return The counters, all zero for loggers which never drop messages.
+		 */
+		virtual LogStats GetStats() {
+			return {};
+		}
 	};
 
 }  // namespace plugify
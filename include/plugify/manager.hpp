@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <span>
 #include <string>
 #include <vector>
 #include <chrono>
@@ -45,6 +46,10 @@ namespace plugify {
 		[[nodiscard]] std::vector<const Extension*> GetExtensionsByState(ExtensionState state) const;
 		[[nodiscard]] std::vector<const Extension*> GetExtensionsByType(ExtensionType type) const;
 
+		// Method registry
+		[[nodiscard]] std::span<const MethodData> FindMethods(std::string_view plugin) const;
+		[[nodiscard]] const MethodData* FindMethod(std::string_view plugin, std::string_view method) const;
+
 		// Dump operations
 		[[nodiscard]] std::string GenerateLoadOrder() const;
 		[[nodiscard]] std::string GenerateDependencyGraph() const;
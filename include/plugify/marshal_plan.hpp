@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+
+#include "plugify/global.h"
+#include "plugify/signarure.hpp"
+#include "plugify/value_type.hpp"
+#include "plg/inplace_vector.hpp"
+
+namespace plugify {
+	class Method;
+
+	/**
+	 * @enum RegClass
+	 * @brief Kind of native register a value travels in.
+	 * @details Which register or stack slot it ends up in depends on the target ABI and is
+	 * left to the emitter, the class is what every convention agrees on.
+	 */
+	enum class RegClass : uint8_t {
+		None,    ///< Nothing is passed (void return)
+		Int,     ///< Integers, pointers, refs and objects passed by pointer
+		Float,   ///< float and double passed by value
+		Struct   ///< plg::vec / plg::mat passed by value, the slot holds a pointer to it
+	};
+
+	/**
+	 * @struct MarshalSlot
+	 * @brief One slot of the parameter block passed to JitCall and JitCallback stubs.
+	 */
+	struct MarshalSlot {
+		ValueType type{};           ///< Declared type
+		ValueType native{};         ///< Type of the native argument, Pointer for refs and the hidden return
+		RegClass regClass{};        ///< Register class of the native argument
+		bool ref{};                 ///< Passed by reference
+		bool hidden{};              ///< Pointer to the storage of a hidden return
+		uint16_t offset{};          ///< Byte offset of the slot in the parameter block
+	};
+
+	/**
+	 * @struct MarshalPlan
+	 * @brief How the arguments and the return of a method are laid out between a caller
+	 * and a JIT stub.
+	 * @details Methods keep one built with ValueUtils::IsHiddenParam once the manifest is
+	 * resolved (see Method::GetMarshalPlan()), so the classification of every parameter is
+	 * not repeated by each stub and language module which marshals a call.
+	 */
+	struct PLUGIFY_API MarshalPlan {
+		/**
+		 * @brief Default constructor, plan of a void() method.
+		 */
+		MarshalPlan() = default;
+
+		/**
+		 * @brief Classify the parameters and return of a method.
+		 * @param method Method to plan.
+		 * @param hidden Predicate telling whether the return is passed as hidden argument,
+		 * nullptr for ValueUtils::IsHiddenParam.
+		 */
+		explicit MarshalPlan(const Method& method, bool (*hidden)(ValueType) = nullptr);
+
+		/**
+		 * @brief Get the size of the parameter block.
+		 * @return Size in bytes.
+		 */
+		[[nodiscard]] size_t GetFrameSize() const noexcept {
+			return slots.size() * sizeof(uint64_t);
+		}
+
+		Signature signature;  ///< Lowered signature the stubs are generated for
+		std::inplace_vector<MarshalSlot, Signature::kMaxFuncArgs + 1> slots;  ///< Hidden return first, then parameters
+		ValueType retType{ ValueType::Void };  ///< Declared return type
+		RegClass retClass{ RegClass::None };   ///< Register class of the native return
+		bool retHidden{};                      ///< Return is written through the first slot
+	};
+}  // namespace plugify
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <span>
+
+#include "plugify/global.h"
+#include "plugify/call.hpp"
+#include "plugify/method.hpp"
+#include "plugify/types.hpp"
+#include "plugify/value_type.hpp"
+#include "plg/any.hpp"
+
+namespace plugify {
+	/**
+	 * @class Marshaller
+	 * @brief Converts plg::any arguments of a method into a Parameters block and the Return
+	 * back into a plg::any.
+	 * @details Built once from the parameter types of a method: every argument gets a
+	 * conversion picked ahead of time, so packing a call is one type check per argument
+	 * followed by straight stores, instead of a switch over ValueType per argument and call.
+	 * Scalars are copied into their slot. Refs, strings, arrays and vectors are passed as
+	 * pointers into the plg::any itself, so writes through a ref land in the argument.
+	 */
+	class PLUGIFY_API Marshaller {
+	public:
+		/**
+		 * @brief Scratch state of one call.
+		 * @details Holds the parameter block, the return registers and the storage of an
+		 * object returned through a hidden pointer.
+		 */
+		struct Frame {
+			Parameters params{ Signature::kMaxFuncArgs };
+			Return ret;
+			alignas(alignof(std::max_align_t)) std::array<std::byte, sizeof(plg::any)> storage{};
+		};
+
+		/**
+		 * @brief Build the marshaller of a method.
+		 * @param method Method to call.
+		 * @param hidden Predicate telling whether the return is passed as hidden argument,
+		 * must match the one given to JitCall. nullptr for ValueUtils::IsHiddenParam.
+		 * @return Marshaller, or an error if a type cannot be held by plg::any (e.g. mat4x4).
+		 */
+		static Result<Marshaller> Create(const Method& method, JitCall::HiddenParam hidden = nullptr);
+
+		/**
+		 * @brief Move constructor.
+		 * @param other Another instance of Marshaller.
+		 */
+		Marshaller(Marshaller&& other) noexcept;
+
+		/**
+		 * @brief Destructor.
+		 */
+		~Marshaller();
+
+		/**
+		 * @brief Move assignment operator for Marshaller.
+		 * @param other The other Marshaller instance to move from.
+		 * @return A reference to this instance after moving.
+		 */
+		Marshaller& operator=(Marshaller&& other) noexcept;
+
+		/**
+		 * @brief Get the number of arguments expected by Pack().
+		 * @return Argument count.
+		 */
+		[[nodiscard]] size_t GetArgCount() const noexcept;
+
+		/**
+		 * @brief Fill the parameter block of the frame from the arguments.
+		 * @param args Arguments, must stay alive until the call returned.
+		 * @param frame Frame to fill.
+		 * @return False if the count or a type of \p args does not match the method.
+		 */
+		bool Pack(std::span<plg::any> args, Frame& frame) const noexcept;
+
+		/**
+		 * @brief Read the return value of a call made with a packed frame.
+		 * @details An object returned through a hidden pointer is moved out of the frame and
+		 * destroyed there, so it must be called exactly once per call.
+		 * @param frame Frame passed to the call.
+		 * @return Return value, plg::none for void methods.
+		 */
+		plg::any Unpack(Frame& frame) const;
+
+		/**
+		 * @brief Pack, call and unpack.
+		 * @param func Function generated by JitCall for the method.
+		 * @param args Arguments of the call.
+		 * @param ret Receives the return value.
+		 * @return False if the arguments do not match the method, nothing is called then.
+		 */
+		bool Invoke(JitCall::CallingFunc func, std::span<plg::any> args, plg::any& ret) const;
+
+		Marshaller(const Marshaller& other) = delete;
+		Marshaller& operator=(const Marshaller& other) = delete;
+
+		PLUGIFY_ACCESS : struct Impl;
+		PLUGIFY_NO_DLL_EXPORT_WARNING(std::unique_ptr<Impl> _impl;)
+
+	private:
+		explicit Marshaller(std::unique_ptr<Impl> impl) noexcept;
+	};
+}  // namespace plugify
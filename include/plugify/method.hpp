@@ -11,6 +11,7 @@
 
 namespace plugify {
 	class Property;
+	struct MarshalPlan;
 
 	// Method Class
 	class PLUGIFY_API Method {
@@ -29,6 +30,8 @@ namespace plugify {
 		[[nodiscard]] const std::string& GetFuncName() const noexcept;
 		[[nodiscard]] CallConv GetCallConv() const noexcept;
 		[[nodiscard]] uint8_t GetVarIndex() const noexcept;
+		// Null until Manifest::Resolve() or one of the signature setters ran
+		[[nodiscard]] const MarshalPlan* GetMarshalPlan() const noexcept;
 
 		// Setters (pass by value and move)
 		void SetParamTypes(std::inplace_vector<Property, Signature::kMaxFuncArgs> paramTypes);
@@ -19,6 +19,11 @@ namespace plugify {
 		virtual Result<Address> GetSymbol(void* handle, std::string_view name) = 0;
 		virtual Result<std::filesystem::path> GetLibraryPath(void* handle) = 0;
 
+		// Stable identity of a file on disk (inode/device or file index), if available
+		virtual Result<uint64_t> GetFileId([[maybe_unused]] const std::filesystem::path& path) {
+			return MakeError("File identity not supported on this platform!");
+		}
+
 		// Platform capabilities
 		[[nodiscard]] virtual bool SupportsRuntimePathModification() const = 0;
 		[[nodiscard]] virtual bool SupportsLazyBinding() const = 0;
@@ -5,9 +5,13 @@
 #include <vector>
 #include <filesystem>
 #include <optional>
+#include <span>
+#include <type_traits>
 
 #include "plugify/global.h"
+#include "plugify/jit_context.hpp"
 #include "plugify/logger.hpp"
+#include "plugify/method.hpp"
 #include "plugify/service_locator.hpp"
 #include "plugify/types.hpp"
 
@@ -27,6 +31,22 @@ namespace plugify {
 		Provider& operator=(Provider&& other) noexcept;
 
 		// Logging helpers
+
+		// Formats only when the severity passes the level of the logger, so a disabled
+		// call costs a virtual call and a compare. Goes straight to the logger cached at
+		// construction, whose level is the one every copy of the provider reads.
+		template <typename... Args>
+		void Log(Severity sev, LogFormat<std::type_identity_t<Args>...> fmt, Args&&... args) const {
+			if (!_logger || (sev != Severity::Unknown && sev < _logger->GetLogLevel())) {
+				return;
+			}
+			_logger->Log(std::format(fmt.format, std::forward<Args>(args)...), sev, fmt.location);
+		}
+
+		// Minimum severity of the shared logger, also used by the filter above
+		void SetLogLevel(Severity minSeverity) const;
+		[[nodiscard]] Severity GetLogLevel() const noexcept;
+
 		void Log(
 		    std::string_view msg,
 		    Severity sev = Severity::Info,
@@ -92,6 +112,16 @@ namespace plugify {
 		[[nodiscard]] const Extension* FindExtension(UniqueId id) const noexcept;
 		[[nodiscard]] std::vector<const Extension*> GetExtensions() const;
 
+		// Method registry, filled while plugins are exported.
+		// Language modules can use it to bind methods of plugins
+		// they did not receive an OnMethodExport call for.
+		[[nodiscard]] std::span<const MethodData> FindMethods(std::string_view plugin) const;
+		[[nodiscard]] const MethodData* FindMethod(std::string_view plugin, std::string_view method) const;
+
+		// JIT statistics: stubs by kind and signature, executable memory,
+		// compile times and cache hit rates (see JitContext::GetStats)
+		[[nodiscard]] JitStats GetJitStats() const;
+
 		// Service access helpers
 		template <typename Service>
 		[[nodiscard]] std::shared_ptr<Service> Resolve() const {
@@ -103,6 +133,12 @@ namespace plugify {
 			return GetServices().TryResolve<Service>();
 		}
 
+		// Borrowed singleton, a single table load once Plugify is initialized
+		template <typename Service>
+		[[nodiscard]] Service* Get() const noexcept {
+			return GetServices().Get<Service>();
+		}
+
 		[[nodiscard]] bool operator==(const Provider& other) const noexcept;
 		[[nodiscard]] auto operator<=>(const Provider& other) const noexcept;
 
@@ -113,5 +149,8 @@ namespace plugify {
 	private:
 		struct Impl;
 		PLUGIFY_NO_DLL_EXPORT_WARNING(std::unique_ptr<Impl> _impl;)
+
+		// Read by the inline Log() above, hence outside the Impl
+		ILogger* _logger{};
 	};
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <typeindex>
 #include <functional>
@@ -172,6 +173,22 @@ namespace plugify {
 			return result ? std::static_pointer_cast<Interface>(result) : nullptr;
 		}
 
+		/**
+		 * @brief Get a singleton without taking ownership
+		 * @details Once sealed this is a load from an immutable table, at a slot assigned to
+		 * the type on first use. Before that it falls back to a locked lookup.
+		 * @return Pointer owned by the locator, nullptr if missing or not a singleton
+		 */
+		template <typename Interface>
+		[[nodiscard]] Interface* Get() const noexcept {
+			static const size_t slot = SlotOfInternal(std::type_index(typeid(Interface)));
+			void* const* slots = _slots.load(std::memory_order_acquire);
+			if (slots && slot != kNoSlot) {
+				return slot < _slotCount.load(std::memory_order_relaxed) ? static_cast<Interface*>(slots[slot]) : nullptr;
+			}
+			return static_cast<Interface*>(GetInternal(std::type_index(typeid(Interface))));
+		}
+
 		/**
 		 * @brief Check if a service is registered
 		 */
@@ -194,8 +211,22 @@ namespace plugify {
 		 */
 		void EndScope();
 
+		/**
+		 * @brief Freeze the registrations
+		 * @details Singletons are published into a table indexed by type slot, so Get() and
+		 * Resolve() no longer lock. Registering or clearing afterwards throws, the table stays
+		 * valid for the lifetime of the locator.
+		 */
+		void Seal();
+
+		/**
+		 * @brief Check if the registrations are frozen
+		 */
+		[[nodiscard]] bool IsSealed() const noexcept;
+
 		/**
 		 * @brief Clear all registrations
+		 * @throws std::logic_error If the locator is sealed
 		 */
 		void Clear();
 
@@ -253,10 +284,18 @@ namespace plugify {
 		[[nodiscard]] std::shared_ptr<void> ResolveInternal(std::type_index type) const;
 		[[nodiscard]] std::shared_ptr<void> TryResolveInternal(std::type_index type) const noexcept;
 		[[nodiscard]] bool IsRegisteredInternal(std::type_index type) const;
+		[[nodiscard]] void* GetInternal(std::type_index type) const noexcept;
+		// kNoSlot if the slot could not be assigned, Get() then takes the lookup
+		[[nodiscard]] static size_t SlotOfInternal(std::type_index type) noexcept;
+		static constexpr size_t kNoSlot = static_cast<size_t>(-1);
 
 		// PIMPL
 		PLUGIFY_ACCESS : struct Impl;
 		PLUGIFY_NO_DLL_EXPORT_WARNING(std::unique_ptr<Impl> _impl;)
+
+		// Sealed singletons by type slot, owned by the Impl
+		PLUGIFY_NO_DLL_EXPORT_WARNING(std::atomic<void* const*> _slots{};)
+		PLUGIFY_NO_DLL_EXPORT_WARNING(std::atomic<size_t> _slotCount{};)
 	};
 
 	// ============================================
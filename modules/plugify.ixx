@@ -16,6 +16,8 @@ module;
 #include "plugify/extension.hpp"
 #include "plugify/file_system.hpp"
 #include "plugify/global.h"
+#include "plugify/jit_batch.hpp"
+#include "plugify/jit_context.hpp"
 #include "plugify/language_module.hpp"
 #include "plugify/lifecycle.hpp"
 #include "plugify/load_flag.hpp"
@@ -0,0 +1,236 @@
+#pragma once
+
+#include "core/console_logger.hpp"
+#include "core/ring_queue.hpp"
+
+namespace plugify {
+	// Console logger which leaves all the work to a background thread.
+	// Callers only copy the message and its location into a bounded lock-free
+	// ring. The writer thread timestamps with the time of the call, formats and
+	// writes whole batches, flushing once per batch instead of once per line.
+	class AsyncLogger final : public ConsoleLogger {
+	public:
+		static constexpr size_t kDefaultCapacity = 8192;
+
+		explicit AsyncLogger(
+			Severity minSeverity = Severity::Info,
+			size_t capacity = kDefaultCapacity,
+			OverflowPolicy policy = OverflowPolicy::Block
+		)
+			: ConsoleLogger(minSeverity)
+			, _policy(policy)
+			, _queue(capacity) {
+			_worker = std::thread(&AsyncLogger::Run, this);
+		}
+
+		~AsyncLogger() override {
+			_stop.store(true, std::memory_order_release);
+			Wake();
+			_worker.join();
+		}
+
+		AsyncLogger(const AsyncLogger&) = delete;
+		AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+		void Log(
+			std::string_view message,
+			Severity severity,
+			const Location& location = Location::current()
+		) override {
+			if (message.empty() || (severity != Severity::Unknown && severity < _minSeverity)) {
+				return;
+			}
+
+			Record record(message, severity, location);
+			switch (_policy) {
+				case OverflowPolicy::Block:
+					while (!_queue.TryPush(std::move(record))) {
+						WaitForRoom();
+					}
+					break;
+
+				case OverflowPolicy::DropOldest:
+					while (!_queue.TryPush(std::move(record))) {
+						Record oldest;
+						if (_queue.TryPop(oldest)) {
+							_droppedOldest.fetch_add(1, std::memory_order_relaxed);
+							Consumed(1);
+						}
+					}
+					break;
+
+				case OverflowPolicy::DropNewest:
+					if (!_queue.TryPush(std::move(record))) {
+						_droppedNewest.fetch_add(1, std::memory_order_relaxed);
+						return;
+					}
+					break;
+			}
+
+			_pushed.fetch_add(1, std::memory_order_release);
+			Wake();
+		}
+
+		// Returns once everything logged before the call has been written
+		void Flush() override {
+			const uint64_t target = _pushed.load(std::memory_order_acquire);
+			Wake();
+
+			uint64_t consumed = _consumed.load(std::memory_order_acquire);
+			while (consumed < target) {
+				_consumed.wait(consumed, std::memory_order_acquire);
+				consumed = _consumed.load(std::memory_order_acquire);
+			}
+		}
+
+		OverflowPolicy GetOverflowPolicy() const noexcept {
+			return _policy;
+		}
+
+		uint64_t GetDroppedOldest() const noexcept {
+			return _droppedOldest.load(std::memory_order_relaxed);
+		}
+
+		uint64_t GetDroppedNewest() const noexcept {
+			return _droppedNewest.load(std::memory_order_relaxed);
+		}
+
+		LogStats GetStats() override {
+			return { GetDroppedOldest(), GetDroppedNewest() };
+		}
+
+	private:
+		// Owns copies of the location strings too, the module which logged may
+		// be unloaded before the record is written
+		struct Record {
+			Record() = default;
+
+			Record(std::string_view message, Severity severity, const Location& location)
+				: time(std::chrono::system_clock::now())
+				, line(location.line())
+				, column(location.column())
+				, fileSize(static_cast<uint32_t>(location.file_name().size()))
+				, functionSize(static_cast<uint32_t>(location.function_name().size()))
+				, moduleSize(static_cast<uint32_t>(location.module_name().size()))
+				, severity(severity) {
+				text.reserve(fileSize + functionSize + moduleSize + message.size());
+				text.append(location.file_name());
+				text.append(location.function_name());
+				text.append(location.module_name());
+				text.append(message);
+			}
+
+			Location GetLocation() const noexcept {
+				std::string_view view = text;
+				return Location(
+					line,
+					column,
+					view.substr(0, fileSize),
+					view.substr(fileSize, functionSize),
+					view.substr(fileSize + functionSize, moduleSize)
+				);
+			}
+
+			std::string_view GetMessage() const noexcept {
+				return std::string_view(text).substr(fileSize + functionSize + moduleSize);
+			}
+
+			std::string text;
+			std::chrono::system_clock::time_point time;
+			size_t line{};
+			size_t column{};
+			uint32_t fileSize{};
+			uint32_t functionSize{};
+			uint32_t moduleSize{};
+			Severity severity{};
+		};
+
+		void Wake() {
+			if (_pending.fetch_add(1, std::memory_order_release) == 0) {
+				_pending.notify_one();
+			}
+		}
+
+		void Consumed(uint64_t count) {
+			_consumed.fetch_add(count, std::memory_order_release);
+			_consumed.notify_all();
+		}
+
+		void WaitForRoom() {
+			const uint64_t consumed = _consumed.load(std::memory_order_acquire);
+			Wake();
+			if (_queue.SizeApprox() >= _queue.Capacity()) {
+				_consumed.wait(consumed, std::memory_order_acquire);
+			}
+		}
+
+		void Run() {
+			std::string out;
+			std::string err;
+			uint64_t reportedDrops = 0;
+
+			while (true) {
+				_pending.wait(0, std::memory_order_acquire);
+				_pending.store(0, std::memory_order_release);
+
+				Record record;
+				uint64_t count = 0;
+				while (_queue.TryPop(record)) {
+					auto& buffer = record.severity >= Severity::Error ? err : out;
+					if (record.severity == Severity::Unknown) {
+						buffer.append(record.GetMessage());
+					} else {
+						buffer.append(FormatMessage(record.GetMessage(), record.severity, record.GetLocation(), record.time));
+					}
+					buffer.push_back('\n');
+
+					if (++count == _queue.Capacity()) {
+						Write(out, err);
+						Consumed(count);
+						count = 0;
+					}
+				}
+
+				const uint64_t drops = GetDroppedOldest() + GetDroppedNewest();
+				if (drops != reportedDrops) {
+					err.append(std::format("[AsyncLogger] {} message(s) dropped, queue of {} is full\n", drops - reportedDrops, _queue.Capacity()));
+					reportedDrops = drops;
+				}
+
+				Write(out, err);
+				if (count != 0) {
+					Consumed(count);
+				}
+
+				if (_stop.load(std::memory_order_acquire) && _queue.EmptyApprox()) {
+					break;
+				}
+			}
+		}
+
+		// Only the writer thread gets here, no lock needed
+		static void Write(std::string& out, std::string& err) {
+			if (!out.empty()) {
+				std::cout.write(out.data(), static_cast<std::streamsize>(out.size()));
+				std::cout.flush();
+				out.clear();
+			}
+			if (!err.empty()) {
+				std::cerr.write(err.data(), static_cast<std::streamsize>(err.size()));
+				std::cerr.flush();
+				err.clear();
+			}
+		}
+
+	private:
+		const OverflowPolicy _policy;
+		RingQueue<Record> _queue;
+		std::atomic<uint32_t> _pending{ 0 };
+		std::atomic<uint64_t> _pushed{ 0 };
+		std::atomic<uint64_t> _consumed{ 0 };
+		std::atomic<uint64_t> _droppedOldest{ 0 };
+		std::atomic<uint64_t> _droppedNewest{ 0 };
+		std::atomic<bool> _stop{ false };
+		std::thread _worker;
+	};
+}
@@ -8,14 +8,73 @@
 
 namespace plugify {
 	class BasicAssemblyLoader final : public IAssemblyLoader {
+	public:
+		// Recently unloaded assemblies are kept mapped for a while, so a reload
+		// of an unchanged file skips dlopen/relocation and keeps pages hot.
+		// Opt-in through Config::Loading::warmCacheSize.
+		struct WarmCacheOptions {
+			size_t maxEntries = 0;                 // 0 disables the warm cache
+			std::chrono::seconds maxAge{ 300 };    // Parked assemblies older than this are released
+			bool noDelete = false;                 // Load with LoadFlag::NoUnload (RTLD_NODELETE)
+		};
+
 	private:
+		// What makes a file on disk "the same" for reuse
+		struct FileIdentity {
+			uint64_t fileId{};
+			std::uintmax_t size{};
+			std::filesystem::file_time_type lastWriteTime{};
+
+			bool operator==(const FileIdentity&) const = default;
+		};
+
+		struct CacheEntry {
+			std::weak_ptr<IAssembly> assembly;
+			FileIdentity identity;
+			LoadFlag flags{};
+		};
+
+		struct WarmEntry {
+			AssemblyPtr assembly;
+			FileIdentity identity;
+			LoadFlag flags{};
+			std::chrono::steady_clock::time_point parkedAt;
+		};
+
 		std::shared_ptr<IPlatformOps> _ops;
 		std::shared_ptr<IFileSystem> _fs;
+		WarmCacheOptions _warmOptions;
 
 		// Assembly cache
-		std::unordered_map<std::filesystem::path, std::weak_ptr<IAssembly>, plg::path_hash> _cache;
+		std::unordered_map<std::filesystem::path, CacheEntry, plg::path_hash> _cache;
+		std::unordered_map<std::filesystem::path, WarmEntry, plg::path_hash> _warm;
 		std::mutex _mutex;
 
+		FileIdentity GetIdentity(const std::filesystem::path& path) const {
+			FileIdentity identity;
+			if (auto info = _fs->GetFileInfo(path)) {
+				identity.size = info->size;
+				identity.lastWriteTime = info->last_write_time;
+			}
+			if (auto fileId = _ops->GetFileId(path)) {
+				identity.fileId = *fileId;
+			}
+			return identity;
+		}
+
+		void EvictWarm(std::chrono::steady_clock::time_point now) {
+			std::erase_if(_warm, [&](const auto& entry) {
+				return now - entry.second.parkedAt > _warmOptions.maxAge;
+			});
+
+			while (_warm.size() > _warmOptions.maxEntries) {
+				auto oldest = std::ranges::min_element(_warm, {}, [](const auto& entry) {
+					return entry.second.parkedAt;
+				});
+				_warm.erase(oldest);
+			}
+		}
+
 		Result<std::filesystem::path> ResolvePath(const std::filesystem::path& path) const {
 			// If absolute path, just verify it exists
 			if (path.is_absolute()) {
@@ -29,9 +88,14 @@ namespace plugify {
 		}
 
 	public:
-		BasicAssemblyLoader(std::shared_ptr<IPlatformOps> ops, std::shared_ptr<IFileSystem> fs)
+		BasicAssemblyLoader(
+			std::shared_ptr<IPlatformOps> ops,
+			std::shared_ptr<IFileSystem> fs,
+			WarmCacheOptions warmOptions = {}
+		)
 			: _ops(std::move(ops))
-			, _fs(std::move(fs)) {
+			, _fs(std::move(fs))
+			, _warmOptions(warmOptions) {
 		}
 
 		Result<AssemblyPtr> Load(
@@ -50,11 +114,32 @@ namespace plugify {
 			// Check cache
 			auto it = _cache.find(*resolvedPath);
 			if (it != _cache.end()) {
-				if (auto cached = it->second.lock()) {
+				if (auto cached = it->second.assembly.lock()) {
 					return cached;
 				}
 			}
 
+			if (_warmOptions.noDelete) {
+				flags |= LoadFlag::NoUnload;
+			}
+
+			// Only the warm cache compares identities, spare the stat calls without it
+			FileIdentity identity;
+			if (_warmOptions.maxEntries > 0) {
+				identity = GetIdentity(*resolvedPath);
+
+				// Check warm cache, reuse only if the file was not replaced meanwhile
+				EvictWarm(std::chrono::steady_clock::now());
+				if (auto wit = _warm.find(*resolvedPath); wit != _warm.end()) {
+					auto entry = std::move(wit->second);
+					_warm.erase(wit);
+					if (entry.identity == identity && entry.flags == flags) {
+						_cache.insert_or_assign(*resolvedPath, CacheEntry{ entry.assembly, identity, flags });
+						return std::move(entry.assembly);
+					}
+				}
+			}
+
 			bool supportRuntimePaths = _ops->SupportsRuntimePathModification() && !searchPaths.empty();
 
 			[[maybe_unused]] auto guard = plg::make_scope_guard([&] {
@@ -85,7 +170,7 @@ namespace plugify {
 			auto assembly = std::make_shared<BasicAssembly>(std::move(handle), _ops);
 
 			// Update cache
-			_cache.emplace(std::move(*resolvedPath), assembly);
+			_cache.insert_or_assign(std::move(*resolvedPath), CacheEntry{ assembly, identity, flags });
 
 			return assembly;
 		}
@@ -95,11 +180,42 @@ namespace plugify {
 				return MakeError("Cannot unload null assembly");
 			}
 
-			// Remove from cache
 			std::unique_lock lock(_mutex);
-			_cache.erase(assembly->GetPath());
+
+			// Remove from cache
+			auto it = _cache.find(assembly->GetPath());
+			if (it == _cache.end()) {
+				return {};
+			}
+			auto entry = std::move(it->second);
+			_cache.erase(it);
+
+			// Park in warm cache instead of closing
+			if (_warmOptions.maxEntries > 0) {
+				auto now = std::chrono::steady_clock::now();
+				_warm.insert_or_assign(
+					assembly->GetPath(),
+					WarmEntry{ assembly, entry.identity, entry.flags, now }
+				);
+				EvictWarm(now);
+			}
 
 			return {};
 		}
+
+		// Releases parked assemblies past their age, Unload alone only evicts
+		// while loads and unloads keep happening
+		void Update() override {
+			std::unique_lock lock(_mutex);
+			if (!_warm.empty()) {
+				EvictWarm(std::chrono::steady_clock::now());
+			}
+		}
+
+		// Releases every parked assembly
+		void ClearWarmCache() {
+			std::unique_lock lock(_mutex);
+			_warm.clear();
+		}
 	};
 }
@@ -0,0 +1,683 @@
+#include <cstdio>
+#include <deque>
+
+#include "plugify/binary_log.hpp"
+
+using namespace plugify;
+
+namespace {
+	// File layout: header, then a stream of chunks. A site chunk precedes the
+	// first record of its site, so a file decodes on its own.
+	constexpr std::array<char, 8> kMagic = { 'P', 'L', 'G', 'B', 'L', 'O', 'G', '\0' };
+	constexpr uint32_t kVersion = 1;
+
+	enum class Chunk : uint8_t {
+		Site = 1,     // id, severity, line, column, file, function, module, format, kinds
+		Record = 2,   // id, steady time, payload size, payload
+		Dropped = 3   // number of records lost since the previous one
+	};
+
+	// Record in a thread ring, followed by its payload. Site 0 pads the end of the ring.
+	struct RecordHeader {
+		uint32_t site;
+		uint32_t size;
+		uint64_t time;
+	};
+	static_assert(sizeof(RecordHeader) == 16);
+
+	constexpr size_t kRecordAlign = sizeof(RecordHeader);
+	constexpr size_t kMinThreadBuffer = 4096;
+
+	uint64_t SteadyNow() noexcept {
+		using namespace std::chrono;
+		return static_cast<uint64_t>(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count());
+	}
+
+	int64_t SystemNow() noexcept {
+		using namespace std::chrono;
+		return duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count();
+	}
+
+	struct SiteInfo {
+		std::string format;
+		std::string file;
+		std::string function;
+		std::string module;
+		uint32_t line{};
+		uint32_t column{};
+		Severity severity{};
+		std::vector<LogArgKind> kinds;
+
+		Location GetLocation() const noexcept {
+			return Location(line, column, file, function, module);
+		}
+	};
+
+	// Sites are registered once per process, whatever log they are written to.
+	// A deque keeps the entries in place while it grows.
+	class SiteRegistry {
+	public:
+		uint32_t Register(LogSite& site, std::span<const LogArgKind> kinds) {
+			std::unique_lock lock(_mutex);
+			if (uint32_t id = site.id.load(std::memory_order_relaxed)) {
+				return id;
+			}
+
+			_sites.push_back({
+				std::string(site.format),
+				std::string(site.location.file_name()),
+				std::string(site.location.function_name()),
+				std::string(site.location.module_name()),
+				static_cast<uint32_t>(site.location.line()),
+				static_cast<uint32_t>(site.location.column()),
+				site.severity,
+				{ kinds.begin(), kinds.end() },
+			});
+
+			auto id = static_cast<uint32_t>(_sites.size());
+			site.id.store(id, std::memory_order_release);
+			return id;
+		}
+
+		const SiteInfo* Find(uint32_t id) const {
+			std::shared_lock lock(_mutex);
+			return id != 0 && id <= _sites.size() ? &_sites[id - 1] : nullptr;
+		}
+
+	private:
+		mutable std::shared_mutex _mutex;
+		std::deque<SiteInfo> _sites;
+	};
+
+	SiteRegistry& GetSiteRegistry() {
+		static SiteRegistry registry;
+		return registry;
+	}
+
+	// Single producer (the owning thread), single consumer (the collector)
+	struct ThreadBuffer {
+		explicit ThreadBuffer(size_t size)
+			: capacity(std::bit_ceil(std::max(size, kMinThreadBuffer)))
+			, mask(capacity - 1)
+			, data(std::make_unique<std::byte[]>(capacity))
+			, owner(std::this_thread::get_id()) {
+		}
+
+		const size_t capacity;
+		const size_t mask;
+		std::unique_ptr<std::byte[]> data;
+		const std::thread::id owner;
+		alignas(64) std::atomic<size_t> head{ 0 };
+		alignas(64) std::atomic<size_t> tail{ 0 };
+		size_t next{};  // head once the reserved record is committed, producer only
+		std::atomic<uint64_t> dropped{ 0 };
+		std::atomic<bool> retired{ false };  // the owner exited, freed once drained
+	};
+
+	// Rings of the calling thread, one per log it wrote to. Retires them when
+	// the thread exits so the collector can free them.
+	class ThreadCache {
+	public:
+		~ThreadCache() {
+			for (const auto& entry : _entries) {
+				if (auto buffer = entry.owner.lock()) {
+					buffer->retired.store(true, std::memory_order_release);
+				}
+			}
+		}
+
+		ThreadBuffer* Find(uint64_t serial) const noexcept {
+			for (const auto& entry : _entries) {
+				if (entry.serial == serial) {
+					return entry.buffer;
+				}
+			}
+			return nullptr;
+		}
+
+		void Add(uint64_t serial, const std::shared_ptr<ThreadBuffer>& buffer) {
+			// serials are never reused, entries of destroyed logs are only pruned
+			std::erase_if(_entries, [](const Entry& entry) { return entry.owner.expired(); });
+			_entries.push_back({ serial, buffer, buffer.get() });
+		}
+
+		ThreadBuffer* current{};  // ring of the record reserved last
+
+	private:
+		struct Entry {
+			uint64_t serial;
+			std::weak_ptr<ThreadBuffer> owner;
+			ThreadBuffer* buffer;
+		};
+
+		std::vector<Entry> _entries;
+	};
+
+	thread_local ThreadCache t_cache;
+
+	std::atomic<uint64_t> g_serial{ 0 };
+
+	// One decoded argument, formatted with the spec the format string gives it
+	struct LogArgValue {
+		LogArgKind kind{};
+		bool b{};
+		char c{};
+		int64_t i{};
+		uint64_t u{};
+		double f{};
+		const void* p{};
+		std::string_view s;
+	};
+
+	using LogArgs = std::array<LogArgValue, BinaryLog::kMaxArgs>;
+
+	bool DecodeArgs(std::span<const LogArgKind> kinds, std::span<const std::byte> payload, LogArgs& args) {
+		if (kinds.size() > args.size()) {
+			return false;
+		}
+
+		size_t offset = 0;
+		auto take = [&](void* out, size_t size) {
+			if (payload.size() - offset < size) {
+				return false;
+			}
+			std::memcpy(out, payload.data() + offset, size);
+			offset += size;
+			return true;
+		};
+
+		for (size_t i = 0; i < kinds.size(); ++i) {
+			auto& arg = args[i];
+			arg.kind = kinds[i];
+
+			uint64_t slot = 0;
+			uint32_t length = 0;
+			switch (arg.kind) {
+				case LogArgKind::Bool:
+				case LogArgKind::Char: {
+					uint8_t byte;
+					if (!take(&byte, sizeof(byte))) {
+						return false;
+					}
+					arg.b = byte != 0;
+					arg.c = static_cast<char>(byte);
+					break;
+				}
+				case LogArgKind::String:
+					if (!take(&length, sizeof(length)) || payload.size() - offset < length) {
+						return false;
+					}
+					arg.s = { reinterpret_cast<const char*>(payload.data() + offset), length };
+					offset += length;
+					break;
+				default:
+					if (!take(&slot, sizeof(slot))) {
+						return false;
+					}
+					arg.i = static_cast<int64_t>(slot);
+					arg.u = slot;
+					std::memcpy(&arg.f, &slot, sizeof(slot));
+					arg.p = reinterpret_cast<const void*>(static_cast<uintptr_t>(slot));
+					break;
+			}
+		}
+
+		return offset == payload.size();
+	}
+
+	template <size_t... I>
+	std::string VFormat(std::string_view format, const LogArgs& args, std::index_sequence<I...>) {
+		return std::vformat(format, std::make_format_args(args[I]...));
+	}
+
+	std::string Render(const SiteInfo& site, std::span<const std::byte> payload) {
+		LogArgs args{};
+		if (!DecodeArgs(site.kinds, payload, args)) {
+			return std::format("{} [corrupt arguments]", site.format);
+		}
+
+		try {
+			return VFormat(site.format, args, std::make_index_sequence<BinaryLog::kMaxArgs>{});
+		} catch (const std::exception& e) {
+			return std::format("{} [{}]", site.format, e.what());
+		}
+	}
+
+	template <typename T>
+	void Put(std::FILE* file, const T& value) {
+		std::fwrite(&value, sizeof(T), 1, file);
+	}
+
+	void PutString(std::FILE* file, std::string_view str) {
+		Put(file, static_cast<uint32_t>(str.size()));
+		std::fwrite(str.data(), 1, str.size(), file);
+	}
+
+	template <typename T>
+	bool Get(std::istream& in, T& value) {
+		return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+	}
+
+	bool GetString(std::istream& in, std::string& str) {
+		uint32_t length;
+		if (!Get(in, length)) {
+			return false;
+		}
+		str.resize(length);
+		return static_cast<bool>(in.read(str.data(), length));
+	}
+}
+
+#ifdef FMT_HEADER_ONLY
+namespace fmt {
+#else
+namespace std {
+#endif
+	// The spec is only known to apply once the argument type is, so it is kept
+	// as text and handed to the formatter of the decoded value.
+	template <>
+	struct formatter<LogArgValue> {
+		std::string spec = "{}";
+
+		auto parse(std::format_parse_context& ctx) {
+			auto it = ctx.begin();
+			while (it != ctx.end() && *it != '}') {
+				++it;
+			}
+			if (it != ctx.begin()) {
+				spec = "{:" + std::string(ctx.begin(), it) + "}";
+			}
+			return it;
+		}
+
+		template <class FormatContext>
+		auto format(const LogArgValue& arg, FormatContext& ctx) const {
+			switch (arg.kind) {
+				case LogArgKind::Bool:
+					return vformat_to(ctx.out(), spec, make_format_args(arg.b));
+				case LogArgKind::Char:
+					return vformat_to(ctx.out(), spec, make_format_args(arg.c));
+				case LogArgKind::Int:
+					return vformat_to(ctx.out(), spec, make_format_args(arg.i));
+				case LogArgKind::UInt:
+					return vformat_to(ctx.out(), spec, make_format_args(arg.u));
+				case LogArgKind::Float:
+					return vformat_to(ctx.out(), spec, make_format_args(arg.f));
+				case LogArgKind::Pointer:
+					return vformat_to(ctx.out(), spec, make_format_args(arg.p));
+				case LogArgKind::String:
+				default:
+					return vformat_to(ctx.out(), spec, make_format_args(arg.s));
+			}
+		}
+	};
+}
+
+struct BinaryLog::Impl {
+	Impl(Options opts, std::FILE* out, std::shared_ptr<ILogger> logger)
+		: serial(++g_serial)
+		, options(opts)
+		, file(out)
+		, sink(std::move(logger)) {
+	}
+
+	~Impl() {
+		{
+			std::lock_guard lock(wakeMutex);
+			stop = true;
+		}
+		wake.notify_one();
+		if (worker.joinable()) {
+			worker.join();
+		}
+
+		Collect();
+
+		if (file) {
+			std::fclose(file);
+		}
+	}
+
+	std::shared_ptr<ThreadBuffer> GetThreadBuffer() {
+		std::lock_guard lock(buffersMutex);
+		auto& buffer = threadBuffers[std::this_thread::get_id()];
+		// a retired ring belongs to an exited thread whose id was reused
+		if (!buffer || buffer->retired.load(std::memory_order_acquire)) {
+			buffer = buffers.emplace_back(std::make_shared<ThreadBuffer>(options.threadBufferSize));
+		}
+		return buffer;
+	}
+
+	// Frees the rings of exited threads once nothing is left in them
+	void ReleaseRetired(std::span<const std::shared_ptr<ThreadBuffer>> drained) {
+		std::lock_guard lock(buffersMutex);
+		for (const auto& buffer : drained) {
+			retiredDropped += buffer->dropped.load(std::memory_order_relaxed);
+			auto it = threadBuffers.find(buffer->owner);
+			if (it != threadBuffers.end() && it->second == buffer) {
+				threadBuffers.erase(it);
+			}
+			std::erase(buffers, buffer);
+		}
+	}
+
+	void Run() {
+		std::unique_lock lock(wakeMutex);
+		while (!stop) {
+			wake.wait_for(lock, options.flushInterval, [this] { return stop; });
+			lock.unlock();
+			Collect();
+			lock.lock();
+		}
+	}
+
+	// Takes every committed record out of the rings, then writes them in time order
+	void Collect() {
+		std::lock_guard lock(collectMutex);
+
+		std::vector<std::shared_ptr<ThreadBuffer>> snapshot;
+		uint64_t dropped = 0;
+		{
+			std::lock_guard buffersLock(buffersMutex);
+			snapshot = buffers;
+			dropped = retiredDropped;
+		}
+
+		struct Pending {
+			uint64_t time;
+			uint32_t site;
+			size_t offset;
+			size_t size;
+		};
+
+		std::vector<Pending> pending;
+		std::vector<std::shared_ptr<ThreadBuffer>> drained;
+		arena.clear();
+
+		for (const auto& buffer : snapshot) {
+			dropped += buffer->dropped.load(std::memory_order_relaxed);
+
+			// read before the head, so a retired ring is empty after this pass
+			const bool retired = buffer->retired.load(std::memory_order_acquire);
+			const size_t head = buffer->head.load(std::memory_order_acquire);
+			size_t tail = buffer->tail.load(std::memory_order_relaxed);
+			while (tail != head) {
+				const std::byte* record = buffer->data.get() + (tail & buffer->mask);
+				RecordHeader header;
+				std::memcpy(&header, record, sizeof(header));
+
+				if (header.site != 0) {
+					pending.push_back({ header.time, header.site, arena.size(), header.size });
+					arena.insert(arena.end(), record + sizeof(header), record + sizeof(header) + header.size);
+				}
+				tail += (sizeof(header) + header.size + kRecordAlign - 1) & ~(kRecordAlign - 1);
+			}
+			buffer->tail.store(tail, std::memory_order_release);
+
+			if (retired) {
+				drained.push_back(buffer);
+			}
+		}
+
+		if (!drained.empty()) {
+			ReleaseRetired(drained);
+		}
+
+		std::ranges::stable_sort(pending, {}, &Pending::time);
+
+		auto& registry = GetSiteRegistry();
+		for (const auto& record : pending) {
+			const SiteInfo* site = registry.Find(record.site);
+			if (!site) {
+				continue;
+			}
+			std::span<const std::byte> payload(arena.data() + record.offset, record.size);
+
+			if (file) {
+				if (sitesWritten.size() <= record.site) {
+					sitesWritten.resize(record.site + 1);
+				}
+				if (!sitesWritten[record.site]) {
+					WriteSite(record.site, *site);
+					sitesWritten[record.site] = true;
+				}
+				Put(file, Chunk::Record);
+				Put(file, record.site);
+				Put(file, record.time);
+				Put(file, static_cast<uint32_t>(record.size));
+				std::fwrite(payload.data(), 1, payload.size(), file);
+			} else if (sink) {
+				sink->Log(Render(*site, payload), site->severity, site->GetLocation());
+			}
+		}
+
+		if (dropped != reportedDrops) {
+			const uint64_t lost = dropped - reportedDrops;
+			if (file) {
+				Put(file, Chunk::Dropped);
+				Put(file, lost);
+			} else if (sink) {
+				sink->Log(std::format("[BinaryLog] {} record(s) dropped, thread buffer full", lost), Severity::Warning);
+			}
+			reportedDrops = dropped;
+		}
+
+		if (file) {
+			std::fflush(file);
+		}
+	}
+
+	void WriteSite(uint32_t id, const SiteInfo& site) const {
+		Put(file, Chunk::Site);
+		Put(file, id);
+		Put(file, site.severity);
+		Put(file, site.line);
+		Put(file, site.column);
+		PutString(file, site.file);
+		PutString(file, site.function);
+		PutString(file, site.module);
+		PutString(file, site.format);
+		Put(file, static_cast<uint8_t>(site.kinds.size()));
+		std::fwrite(site.kinds.data(), sizeof(LogArgKind), site.kinds.size(), file);
+	}
+
+	const uint64_t serial;
+	const Options options;
+
+	std::mutex buffersMutex;
+	std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+	std::unordered_map<std::thread::id, std::shared_ptr<ThreadBuffer>> threadBuffers;
+	uint64_t retiredDropped{};  // dropped by rings already freed
+
+	std::mutex collectMutex;
+	std::vector<std::byte> arena;
+	std::vector<bool> sitesWritten;
+	uint64_t reportedDrops{};
+	std::FILE* file{};
+	std::shared_ptr<ILogger> sink;
+
+	std::mutex wakeMutex;
+	std::condition_variable wake;
+	bool stop{};
+	std::thread worker;
+};
+
+BinaryLog::BinaryLog(std::unique_ptr<Impl> impl, Severity minSeverity)
+	: _impl(std::move(impl))
+	, _minSeverity(minSeverity) {
+	_impl->worker = std::thread(&Impl::Run, _impl.get());
+}
+
+BinaryLog::~BinaryLog() = default;
+
+Result<std::shared_ptr<BinaryLog>> BinaryLog::Create(const std::filesystem::path& file, Options options) {
+	std::error_code ec;
+	std::filesystem::create_directories(file.parent_path(), ec);
+
+#if PLUGIFY_PLATFORM_WINDOWS
+	std::FILE* out = _wfopen(file.c_str(), L"wb");
+#else
+	std::FILE* out = std::fopen(file.c_str(), "wb");
+#endif
+	if (!out) {
+		return MakeError("Failed to create binary log: {}", plg::as_string(file));
+	}
+
+	// steady timestamps of records are turned back into wall time with this pair
+	std::fwrite(kMagic.data(), 1, kMagic.size(), out);
+	Put(out, kVersion);
+	Put(out, SystemNow());
+	Put(out, SteadyNow());
+
+	return std::shared_ptr<BinaryLog>(new BinaryLog(std::make_unique<Impl>(options, out, nullptr), options.minSeverity));
+}
+
+std::shared_ptr<BinaryLog> BinaryLog::Create(std::shared_ptr<ILogger> sink, Options options) {
+	return std::shared_ptr<BinaryLog>(new BinaryLog(std::make_unique<Impl>(options, nullptr, std::move(sink)), options.minSeverity));
+}
+
+Result<void> BinaryLog::Decode(const std::filesystem::path& file, const std::function<void(const BinaryLogRecord&)>& callback) {
+	std::ifstream in(file, std::ios::binary);
+	if (!in) {
+		return MakeError("Failed to open binary log: {}", plg::as_string(file));
+	}
+
+	std::array<char, 8> magic{};
+	uint32_t version = 0;
+	int64_t baseSystem = 0;
+	uint64_t baseSteady = 0;
+	if (!in.read(magic.data(), magic.size()) || magic != kMagic || !Get(in, version)) {
+		return MakeError("Not a binary log: {}", plg::as_string(file));
+	}
+	if (version != kVersion) {
+		return MakeError("Unsupported binary log version {} in {}", version, plg::as_string(file));
+	}
+	if (!Get(in, baseSystem) || !Get(in, baseSteady)) {
+		return MakeError("Truncated binary log header: {}", plg::as_string(file));
+	}
+
+	auto toTime = [&](uint64_t steady) {
+		auto ns = baseSystem + static_cast<int64_t>(steady - baseSteady);
+		return std::chrono::system_clock::time_point(
+			std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(ns))
+		);
+	};
+
+	std::unordered_map<uint32_t, SiteInfo> sites;
+	std::vector<std::byte> payload;
+
+	Chunk chunk;
+	while (Get(in, chunk)) {
+		switch (chunk) {
+			case Chunk::Site: {
+				uint32_t id;
+				SiteInfo site;
+				uint8_t count;
+				if (!Get(in, id) || !Get(in, site.severity) || !Get(in, site.line) || !Get(in, site.column)
+					|| !GetString(in, site.file) || !GetString(in, site.function) || !GetString(in, site.module)
+					|| !GetString(in, site.format) || !Get(in, count)) {
+					return MakeError("Truncated site in binary log: {}", plg::as_string(file));
+				}
+				site.kinds.resize(count);
+				if (!in.read(reinterpret_cast<char*>(site.kinds.data()), count)) {
+					return MakeError("Truncated site in binary log: {}", plg::as_string(file));
+				}
+				sites[id] = std::move(site);
+				break;
+			}
+			case Chunk::Record: {
+				uint32_t id;
+				uint64_t time;
+				uint32_t size;
+				if (!Get(in, id) || !Get(in, time) || !Get(in, size)) {
+					return MakeError("Truncated record in binary log: {}", plg::as_string(file));
+				}
+				payload.resize(size);
+				if (!in.read(reinterpret_cast<char*>(payload.data()), size)) {
+					return MakeError("Truncated record in binary log: {}", plg::as_string(file));
+				}
+
+				auto it = sites.find(id);
+				if (it == sites.end()) {
+					return MakeError("Record of unknown site {} in binary log: {}", id, plg::as_string(file));
+				}
+				const auto& site = it->second;
+				std::string message = Render(site, payload);
+				callback({ toTime(time), site.severity, site.GetLocation(), message });
+				break;
+			}
+			case Chunk::Dropped: {
+				uint64_t count;
+				if (!Get(in, count)) {
+					return MakeError("Truncated binary log: {}", plg::as_string(file));
+				}
+				std::string message = std::format("{} record(s) dropped, thread buffer full", count);
+				callback({ {}, Severity::Warning, Location(), message });
+				break;
+			}
+			default:
+				return MakeError("Unknown chunk {} in binary log: {}", static_cast<int>(chunk), plg::as_string(file));
+		}
+	}
+
+	return {};
+}
+
+void BinaryLog::Flush() {
+	_impl->Collect();
+}
+
+uint64_t BinaryLog::GetDropped() const noexcept {
+	std::lock_guard lock(_impl->buffersMutex);
+	uint64_t dropped = _impl->retiredDropped;
+	for (const auto& buffer : _impl->buffers) {
+		dropped += buffer->dropped.load(std::memory_order_relaxed);
+	}
+	return dropped;
+}
+
+uint32_t BinaryLog::RegisterSite(LogSite& site, std::span<const LogArgKind> kinds) {
+	return GetSiteRegistry().Register(site, kinds);
+}
+
+std::byte* BinaryLog::Reserve(uint32_t site, size_t size) noexcept {
+	ThreadBuffer* current = t_cache.Find(_impl->serial);
+	if (!current) {
+		auto owned = _impl->GetThreadBuffer();
+		t_cache.Add(_impl->serial, owned);
+		current = owned.get();
+	}
+	t_cache.current = current;
+	ThreadBuffer& buffer = *current;
+
+	const size_t total = (sizeof(RecordHeader) + size + kRecordAlign - 1) & ~(kRecordAlign - 1);
+	size_t head = buffer.head.load(std::memory_order_relaxed);
+	const size_t tail = buffer.tail.load(std::memory_order_acquire);
+	size_t offset = head & buffer.mask;
+	const size_t contiguous = buffer.capacity - offset;
+
+	// a record never wraps, the end of the ring is padded instead
+	const size_t needed = total <= contiguous ? total : contiguous + total;
+	if (total > buffer.capacity / 2 || needed > buffer.capacity - (head - tail)) {
+		buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	if (total > contiguous) {
+		RecordHeader padding{ 0, static_cast<uint32_t>(contiguous - sizeof(RecordHeader)), 0 };
+		std::memcpy(buffer.data.get() + offset, &padding, sizeof(padding));
+		head += contiguous;
+		offset = 0;
+	}
+
+	RecordHeader header{ site, static_cast<uint32_t>(size), SteadyNow() };
+	std::byte* record = buffer.data.get() + offset;
+	std::memcpy(record, &header, sizeof(header));
+	buffer.next = head + total;
+	return record + sizeof(header);
+}
+
+void BinaryLog::Commit() noexcept {
+	ThreadBuffer& buffer = *t_cache.current;
+	buffer.head.store(buffer.next, std::memory_order_release);
+}
@@ -66,6 +66,14 @@ void Config::MergeFrom(const Config& other, ConfigSource source) {
 			loading.startTimeout = other.loading.startTimeout;
 			loadingChanged = true;
 		}
+		if (other.loading.HasCustomWarmCacheSize()) {
+			loading.warmCacheSize = other.loading.warmCacheSize;
+			loadingChanged = true;
+		}
+		if (other.loading.HasCustomWarmCacheMaxAge()) {
+			loading.warmCacheMaxAge = other.loading.warmCacheMaxAge;
+			loadingChanged = true;
+		}
 
 		if (loadingChanged) {
 			_sources.loading = source;
@@ -149,6 +157,22 @@ void Config::MergeFrom(const Config& other, ConfigSource source) {
 			logging.exportDigraphDot = other.logging.exportDigraphDot;
 			loggingChanged = true;
 		}
+		if (other.logging.HasCustomFlightRecorder()) {
+			logging.flightRecorder = other.logging.flightRecorder;
+			loggingChanged = true;
+		}
+		if (other.logging.HasCustomFlightRecorderSize()) {
+			logging.flightRecorderSize = other.logging.flightRecorderSize;
+			loggingChanged = true;
+		}
+		if (other.logging.HasCustomQueueCapacity()) {
+			logging.queueCapacity = other.logging.queueCapacity;
+			loggingChanged = true;
+		}
+		if (other.logging.HasCustomOverflowPolicy()) {
+			logging.overflowPolicy = other.logging.overflowPolicy;
+			loggingChanged = true;
+		}
 
 		if (loggingChanged) {
 			_sources.logging = source;
@@ -215,6 +239,14 @@ Result<void> Config::Validate() const{
 		}
 	}
 
+	if (logging.flightRecorder && logging.flightRecorderSize == 0) {
+		return MakeError("Flight recorder size must be positive");
+	}
+
+	if (logging.queueCapacity == 0) {
+		return MakeError("Logger queue capacity must be positive");
+	}
+
 	return {};
 }
 
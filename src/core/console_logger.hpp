@@ -5,7 +5,7 @@
 #include "plg/enum.hpp"
 
 namespace plugify {
-	class ConsoleLogger final : public ILogger {
+	class ConsoleLogger : public ILogger {
 	public:
 		ConsoleLogger(Severity minSeverity = Severity::Info)
 			: _minSeverity(minSeverity) {
@@ -53,11 +53,14 @@ namespace plugify {
 		}
 
 	protected:
-		static std::string
-		FormatMessage(std::string_view message, Severity severity, const Location& location) {
+		static std::string FormatMessage(
+			std::string_view message,
+			Severity severity,
+			const Location& location,
+			std::chrono::system_clock::time_point now = std::chrono::system_clock::now()
+		) {
 			using namespace std::chrono;
 
-			auto now = system_clock::now();
 			auto seconds = floor<std::chrono::seconds>(now);
 			auto ms = duration_cast<milliseconds>(now - seconds);
 
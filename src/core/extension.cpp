@@ -1,5 +1,6 @@
 #include "plugify/assembly.hpp"
 #include "plugify/extension.hpp"
+#include "plugify/flight_recorder.hpp"
 #include "plugify/language_module.hpp"
 #include "plugify/registrar.hpp"
 
@@ -337,6 +338,17 @@ void Extension::EndOperation(ExtensionState newState) {
 
 void Extension::SetState(ExtensionState state) {
 	assert(IsValidTransition(_impl->state, state) && "Invalid state transition");
+	if (auto recorder = FlightRecorder::GetActive()) {
+		recorder->Record(
+			FlightEvent::State,
+			state == ExtensionState::Failed || state == ExtensionState::Corrupted ? Severity::Error : Severity::Info,
+			"{} {}: {} -> {}",
+			plg::enum_to_string(_impl->type),
+			GetName(),
+			plg::enum_to_string(_impl->state),
+			plg::enum_to_string(state)
+		);
+	}
 	_impl->state = state;
 }
 
@@ -3,11 +3,15 @@
 #include "plugify/assembly.hpp"
 #include "plugify/extension.hpp"
 #include "plugify/file_system.hpp"
+#include "plugify/flight_recorder.hpp"
 #include "plugify/language_module.hpp"
 #include "plugify/lifecycle.hpp"
 #include "plugify/provider.hpp"
 #include "plugify/registrar.hpp"
 
+#include "core/lifecycle_dispatcher.hpp"
+#include "core/method_registry.hpp"
+
 namespace plugify {
 	template <typename Callback>
 	class ScopedTimer {
@@ -61,6 +65,7 @@ namespace plugify {
 		struct LoadStatistics {
 			size_t modulesLoaded{ 0 };
 			size_t pluginsLoaded{ 0 };
+			size_t exportCalls{ 0 };
 			std::chrono::milliseconds totalLoadTime{};
 
 			std::chrono::milliseconds slowestModuleLoad{};
@@ -73,11 +78,13 @@ namespace plugify {
 					"\n=== Loader Report ===\n"
 					"  Modules loaded: {}\n"
 					"  Plugins loaded: {}\n"
+					"  Export calls: {}\n"
 					"  Slowest module: {} - {}\n"
 					"  Slowest plugin: {} - {}\n"
 					"  Total load time: {}\n",
 					modulesLoaded,
 					pluginsLoaded,
+					exportCalls,
 					slowestModuleLoad,
 					ToString(slowestModule),
 					slowestPluginLoad,
@@ -92,9 +99,11 @@ namespace plugify {
 		const Provider& _provider;
 		std::shared_ptr<IFileSystem> _fileSystem;
 		std::shared_ptr<IAssemblyLoader> _assemblyLoader;
-		std::shared_ptr<IExtensionLifecycle> _extensionLifecycle;
+		std::unique_ptr<LifecycleDispatcher> _extensionLifecycle;
 		std::shared_ptr<IProfiler> _profiler;
+		std::shared_ptr<FlightRecorder> _recorder;
 		LoadStatistics _stats;
+		MethodRegistry _methodRegistry;
 
 		std::unordered_map<std::filesystem::path, std::shared_ptr<IAssembly>, plg::path_hash> _assemblies;
 
@@ -104,8 +113,18 @@ namespace plugify {
 			, _provider(provider)
 			, _fileSystem(services.Resolve<IFileSystem>())
 			, _assemblyLoader(services.Resolve<IAssemblyLoader>())
-			, _extensionLifecycle(services.TryResolve<IExtensionLifecycle>())
-			, _profiler(services.TryResolve<IProfiler>()) {
+			, _profiler(services.TryResolve<IProfiler>())
+			, _recorder(services.TryResolve<FlightRecorder>()) {
+			if (auto lifecycle = services.TryResolve<IExtensionLifecycle>()) {
+				_extensionLifecycle = std::make_unique<LifecycleDispatcher>(std::move(lifecycle));
+			}
+		}
+
+		// Delivers queued lifecycle events to a deferred observer
+		void FlushLifecycleEvents() {
+			if (_extensionLifecycle) {
+				_extensionLifecycle->Flush();
+			}
 		}
 
 		// Module Operations
@@ -148,7 +167,7 @@ namespace plugify {
 			}
 			auto result = SafeCall<void>("OnUpdate", module.GetName(), [&] {
 				return module.GetLanguageModule()->OnUpdate(deltaTime);
-			});
+			}, false);
 			if (_extensionLifecycle) {
 				_extensionLifecycle->OnUpdate(module, deltaTime);
 			}
@@ -167,10 +186,14 @@ namespace plugify {
 				module.SetLanguageModule(nullptr);
 			}
 
-			// Clear assembly and remove from cache
-			if ([[maybe_unused]] auto assembly = module.GetAssembly()) {
+			// Clear assembly and remove from cache, the assembly loader
+			// may keep it warm for a quick reload
+			if (auto assembly = module.GetAssembly()) {
 				_assemblies.erase(module.GetRuntime());
 				module.SetAssembly(nullptr);
+				if (auto unloadResult = _assemblyLoader->Unload(assembly); !unloadResult && result) {
+					result = MakeError(std::move(unloadResult.error()));
+				}
 			}
 
 			if (_extensionLifecycle) {
@@ -261,7 +284,7 @@ namespace plugify {
 			}
 			auto result = SafeCall<void>("OnPluginUpdate", plugin.GetName(), [&] {
 				return plugin.GetLanguageModule()->OnPluginUpdate(plugin, deltaTime);
-			});
+			}, false);
 			if (_extensionLifecycle) {
 				_extensionLifecycle->OnUpdate(plugin, deltaTime);
 			}
@@ -272,6 +295,7 @@ namespace plugify {
 			[[maybe_unused]] ScopedZone zone(_profiler, PLUGIFY_SIGNATURE);
 
 			// Clear all plugin data
+			_methodRegistry.Unregister(plugin);
 			plugin.SetLanguageModule(nullptr);
 			plugin.SetUserData(nullptr);
 			plugin.SetMethodTable({});
@@ -283,22 +307,37 @@ namespace plugify {
 			return {};
 		}
 
-		Result<void> MethodExport(const Extension& module, Extension& plugin) {
+		// Publishes plugin methods in the registry and notifies only the
+		// language modules which host plugins depending on it
+		Result<void> MethodExport(Extension& plugin, std::span<const Extension* const> consumers) {
 			[[maybe_unused]] ScopedZone zone(_profiler, PLUGIFY_SIGNATURE);
 
+			_methodRegistry.Register(plugin);
+
 			const auto& [hasUpdate, hasStart, hasEnd, hasExport] = plugin.GetMethodTable();
 			if (!hasExport) {
 				return {};
 			}
-			auto result = SafeCall<void>("OnMethodExport", module.GetName(), [&] {
-				return module.GetLanguageModule()->OnMethodExport(plugin);
-			});
+			Result<void> result;
+			for (const auto* module : consumers) {
+				result = SafeCall<void>("OnMethodExport", module->GetName(), [&] {
+					return module->GetLanguageModule()->OnMethodExport(plugin);
+				});
+				++_stats.exportCalls;
+				if (!result) {
+					break;
+				}
+			}
 			if (_extensionLifecycle) {
 				_extensionLifecycle->OnExport(plugin);
 			}
 			return result;
 		}
 
+		const MethodRegistry& GetMethodRegistry() const noexcept {
+			return _methodRegistry;
+		}
+
 		// Preload support
 		/*Result<void> PreloadAssembly(
 			const std::filesystem::path& path,
@@ -357,10 +396,12 @@ namespace plugify {
 				}
 			}
 
-			// Load assembly
+			// Load assembly, its static initializers run here
+			Trace(Severity::Debug, "Load assembly '{}'", plg::as_string(*absPath));
 			LoadFlag flags = GetLoadFlags();
 			auto assemblyResult = _assemblyLoader->Load(*absPath, flags, searchPaths);
 			if (!assemblyResult) {
+				Trace(Severity::Error, "{}", assemblyResult.error());
 				return MakeError(std::move(assemblyResult.error()));
 			}
 
@@ -461,17 +502,37 @@ namespace plugify {
 			return {};
 		}
 
+		// The call is traced before it is made: after a crash inside an
+		// extension the flight recorder ends with the call which was running
 		template <typename T, typename Func>
-		Result<T> SafeCall(std::string_view op, std::string_view name, Func&& func) noexcept {
+		Result<T> SafeCall(std::string_view op, std::string_view name, Func&& func, bool trace = true) noexcept {
 			[[maybe_unused]] ScopedZone zone(_profiler, std::format("{}::{}", name, op));
-			try {
-				return func();
-			} catch (const std::bad_alloc&) {
-				return MakeError("{}: out of memory", op);
-			} catch (const std::exception& e) {
-				return MakeError("{} failed for '{}': {}", op, name, e.what());
-			} catch (...) {
-				return MakeError("{} failed for '{}': unknown exception", op, name);
+			if (trace) {
+				Trace(Severity::Debug, "{} '{}'", op, name);
+			}
+
+			Result<T> result = [&]() -> Result<T> {
+				try {
+					return func();
+				} catch (const std::bad_alloc&) {
+					return MakeError("{}: out of memory", op);
+				} catch (const std::exception& e) {
+					return MakeError("{} failed for '{}': {}", op, name, e.what());
+				} catch (...) {
+					return MakeError("{} failed for '{}': unknown exception", op, name);
+				}
+			}();
+
+			if (!result) {
+				Trace(Severity::Error, "{} '{}': {}", op, name, result.error());
+			}
+			return result;
+		}
+
+		template <typename... Args>
+		void Trace(Severity severity, std::format_string<Args...> format, Args&&... args) const noexcept {
+			if (_recorder) {
+				_recorder->Record(FlightEvent::Loader, severity, format, std::forward<Args>(args)...);
 			}
 		}
 	};
@@ -1,56 +1,128 @@
 #pragma once
 
+#include <cstdio>
+
+#if PLUGIFY_PLATFORM_WINDOWS
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
 #include "core/console_logger.hpp"
 
 namespace plugify {
+	// When the log file is forced to stable storage
+	enum class FsyncPolicy : uint8_t {
+		Never,     // leave it to the OS
+		OnRotate,  // a full file once it is rotated away, on the maintenance thread
+		OnFlush,   // every time the write buffer reaches the file
+		Always     // after every message, the buffer is bypassed
+	};
+
+	// Compresses a rotated file, returns the compressed file or an empty path
+	// when the original should be kept. Runs on the maintenance thread.
+	using LogCompressor = std::function<std::filesystem::path(const std::filesystem::path&)>;
+
+	struct FileLoggerOptions {
+		size_t maxFileSize{ 10 * 1024 * 1024 };          // rotate once the file reaches it
+		size_t bufferSize{ 256 * 1024 };                 // written out once that much is pending
+		std::chrono::milliseconds flushInterval{ 1000 }; // or once the oldest pending line is that old
+		size_t maxFiles{ 10 };                           // rotated files kept, 0 for no limit
+		uint64_t maxTotalSize{ 0 };                      // bytes of rotated files kept, 0 for no limit
+		FsyncPolicy fsync{ FsyncPolicy::OnRotate };
+		LogCompressor compressor;                        // rotated files are kept as is when empty
+		bool echoWarnings{ true };                       // warnings and errors also go to the console
+	};
+
+	// Logs to `<name><ext>`, which is renamed to `<name>-<time><ext>` once full.
+	// Lines are collected in a buffer which reaches the file when large enough,
+	// after the flush interval, or right away for errors. Rotation itself is a
+	// rename and a reopen, syncing, compressing and pruning old files happens on the
+	// maintenance thread without holding up writers.
 	class FileLogger final : public ConsoleLogger {
 	public:
-		FileLogger(
+		explicit FileLogger(
 			std::filesystem::path logFile,
 			Severity minSeverity = Severity::Info,
-			size_t maxFileSize = 10 * 1024 * 1024
-		)  // 10MB default
+			FileLoggerOptions options = {}
+		)
 			: ConsoleLogger(minSeverity)
-			, _logPath(TimestampedPath(logFile))
-			, _logBase(std::move(logFile))
-			, _maxFileSize(maxFileSize) {
+			, _logPath(std::move(logFile))
+			, _options(std::move(options)) {
 			std::error_code ec;
-			std::filesystem::create_directories(base.parent_path(), ec);
+			std::filesystem::create_directories(_logPath.parent_path(), ec);
 
-			_logFile.open(_logPath, std::ios::app);
-			if (!_logFile) {
+			if (!Open()) {
 				throw std::runtime_error(std::format("Failed to open log file: {}", plg::as_string(_logPath)));
 			}
+			_buffer.reserve(_options.bufferSize);
+			_worker = std::thread(&FileLogger::Run, this);
+
+			// files rotated by an earlier session count towards retention too
+			Schedule({});
 		}
 
-		~FileLogger() {
-			if (_logFile.is_open()) {
-				_logFile.close();
+		~FileLogger() override {
+			{
+				std::lock_guard lock(_jobsMutex);
+				_stop = true;
+			}
+			_wake.notify_one();
+			_worker.join();
+
+			// rotations which raced with the last pass are still synced
+			for (auto& job : _jobs) {
+				SyncRotated(job);
+			}
+
+			std::lock_guard lock(_fileMutex);
+			WriteBuffer();
+			Sync(_options.fsync != FsyncPolicy::Never);
+			if (_file) {
+				std::fclose(_file);
 			}
 		}
 
+		FileLogger(const FileLogger&) = delete;
+		FileLogger& operator=(const FileLogger&) = delete;
+
 		void Log(
 			std::string_view message,
 			Severity severity,
 			const Location& location = Location::current()
 		) override {
-			if (severity < _minSeverity) {
+			if (message.empty() || severity < _minSeverity) {
 				return;
 			}
 
 			auto output = FormatMessage(message, severity, location);
 
-			std::lock_guard lock(_mutex);
+			{
+				std::lock_guard lock(_fileMutex);
 
-			// Check for rotation
-			if (ShouldRotate()) {
-				RotateLog();
-			}
+				if (_buffer.empty()) {
+					_bufferedSince = std::chrono::steady_clock::now();
+				}
+				_buffer.append(output);
+				_buffer.push_back('\n');
 
-			_logFile << output << std::endl;
+				if (_options.fsync == FsyncPolicy::Always) {
+					WriteBuffer();
+					Sync(true);
+				} else if (_buffer.size() >= _options.bufferSize || severity >= Severity::Error) {
+					WriteBuffer();
+					Sync(_options.fsync == FsyncPolicy::OnFlush);
+				}
+
+				if (_fileSize >= _options.maxFileSize) {
+					Rotate();
+				}
+			}
 
 			// Also log to console for warnings and errors
-			if (severity >= Severity::Warning) {
+			if (_options.echoWarnings && severity >= Severity::Warning) {
+				std::lock_guard lock(_mutex);
 				if (severity >= Severity::Error) {
 					std::cerr << output << std::endl;
 				} else {
@@ -60,44 +132,295 @@ namespace plugify {
 		}
 
 		void Flush() override {
-			std::lock_guard lock(_mutex);
-			_logFile.flush();
+			{
+				std::lock_guard lock(_fileMutex);
+				WriteBuffer();
+				Sync(_options.fsync != FsyncPolicy::Never);
+			}
 			ConsoleLogger::Flush();
 		}
 
+		const std::filesystem::path& GetPath() const noexcept {
+			return _logPath;
+		}
+
 	private:
-		std::ofstream _logFile;
-		std::filesystem::path _logPath;
-		std::filesystem::path _logBase;
-		size_t _maxFileSize;
+		// A rotated file waiting for the maintenance thread
+		struct RotateJob {
+			std::filesystem::path path;
+			bool sync{};
+			int fd{ -1 };  // duplicate of the file, kept open until it is synced
+		};
 
-		bool ShouldRotate() {
-			auto pos = _logFile.tellp();
-			return pos >= static_cast<std::streamoff>(_maxFileSize);
+		bool Open() {
+#if PLUGIFY_PLATFORM_WINDOWS
+			_file = _wfopen(_logPath.c_str(), L"ab");
+#else
+			_file = std::fopen(_logPath.c_str(), "ab");
+#endif
+			if (!_file) {
+				return false;
+			}
+			// the logger does its own buffering
+			std::setvbuf(_file, nullptr, _IONBF, 0);
+
+			std::error_code ec;
+			auto size = std::filesystem::file_size(_logPath, ec);
+			_fileSize = ec ? 0 : static_cast<size_t>(size);
+			return true;
 		}
 
-		void RotateLog() {
-			_logFile.close();
-			_logPath = TimestampedPath(_logBase);
-			_logFile.open(_logPath, std::ios::trunc);
+		// Called with _fileMutex held
+		void WriteBuffer() {
+			if (!_file) {
+				_buffer.clear();
+				return;
+			}
+			_fileSize += std::fwrite(_buffer.data(), 1, _buffer.size(), _file);
+			_buffer.clear();
+		}
+
+		// Called with _fileMutex held
+		void Sync(bool enabled) {
+			if (!enabled || !_file) {
+				return;
+			}
+#if PLUGIFY_PLATFORM_WINDOWS
+			_commit(_fileno(_file));
+#elif PLUGIFY_PLATFORM_APPLE
+			fsync(fileno(_file));
+#else
+			fdatasync(fileno(_file));
+#endif
+		}
+
+		// Called with _fileMutex held, only renames: syncing, compressing and
+		// pruning the rotated file is left to the maintenance thread
+		void Rotate() {
+			if (_file) {
+				WriteBuffer();
+				RotateJob job{ .sync = _options.fsync != FsyncPolicy::Never };
+#if !PLUGIFY_PLATFORM_WINDOWS
+				// the data reaches the disk through a duplicate once the file is renamed
+				if (job.sync) {
+					job.fd = dup(fileno(_file));
+				}
+#endif
+				std::fclose(_file);
+				_file = nullptr;
+
+				job.path = RotatedPath();
+				std::error_code ec;
+				std::filesystem::rename(_logPath, job.path, ec);
+				if (!ec) {
+					Schedule(std::move(job));
+				} else {
+					CloseRotated(job);
+				}
+			}
+
+			// when reopening fails lines are dropped, it is retried on the next one
+			Open();
 		}
 
 		// Helper: turn /logs/session.log → /logs/session-20260418_143022.log
-		static std::filesystem::path TimestampedPath(std::filesystem::path base) {
+		std::filesystem::path RotatedPath() const {
 			using namespace std::chrono;
 
-			auto now = system_clock::now();
-			auto seconds = floor<std::chrono::seconds>(now);
-
-			base.replace_filename(
-				std::format(
-					PLUGIFY_PATH_LITERAL("{}-{:%Y%m%d_%H%M%S}{}"),
-					base.stem().native(),
-					utc_clock::from_sys(seconds),
-					base.extension().native()
-				)
+			auto seconds = floor<std::chrono::seconds>(system_clock::now());
+			auto stem = std::format(
+				PLUGIFY_PATH_LITERAL("{}-{:%Y%m%d_%H%M%S}"),
+				_logPath.stem().native(),
+				utc_clock::from_sys(seconds)
 			);
-			return base;
+
+			auto path = _logPath;
+			path.replace_filename(stem + _logPath.extension().native());
+			// several rotations within a second
+			for (size_t i = 1; std::filesystem::exists(path); ++i) {
+				path.replace_filename(std::format(PLUGIFY_PATH_LITERAL("{}.{}{}"), stem, i, _logPath.extension().native()));
+			}
+			return path;
+		}
+
+		// An empty path only asks for retention to be applied
+		void Schedule(RotateJob job) {
+			{
+				std::lock_guard lock(_jobsMutex);
+				_jobs.push_back(std::move(job));
+			}
+			_wake.notify_one();
+		}
+
+		void Run() {
+			std::unique_lock lock(_jobsMutex);
+			while (!_stop) {
+				_wake.wait_for(lock, _options.flushInterval, [this] { return _stop || !_jobs.empty(); });
+
+				auto jobs = std::move(_jobs);
+				_jobs.clear();
+				lock.unlock();
+
+				FlushIfStale();
+				if (!jobs.empty()) {
+					for (auto& job : jobs) {
+						SyncRotated(job);
+						Compress(job.path);
+					}
+					ApplyRetention();
+				}
+
+				lock.lock();
+			}
+		}
+
+		void FlushIfStale() {
+			std::lock_guard lock(_fileMutex);
+			if (!_buffer.empty() && std::chrono::steady_clock::now() - _bufferedSince >= _options.flushInterval) {
+				WriteBuffer();
+				Sync(_options.fsync == FsyncPolicy::OnFlush);
+			}
+		}
+
+		// Runs on the maintenance thread, a rotation never waits for the disk
+		static void SyncRotated(RotateJob& job) {
+			if (!job.sync || job.path.empty()) {
+				return;
+			}
+#if PLUGIFY_PLATFORM_WINDOWS
+			// an open handle would have made the rename fail, so the file is reopened
+			int fd = _wopen(job.path.c_str(), _O_WRONLY | _O_BINARY);
+			if (fd != -1) {
+				_commit(fd);
+				_close(fd);
+			}
+#elif PLUGIFY_PLATFORM_APPLE
+			if (job.fd != -1) {
+				fsync(job.fd);
+			}
+#else
+			if (job.fd != -1) {
+				fdatasync(job.fd);
+			}
+#endif
+			CloseRotated(job);
+		}
+
+		static void CloseRotated(RotateJob& job) {
+#if !PLUGIFY_PLATFORM_WINDOWS
+			if (job.fd != -1) {
+				close(job.fd);
+				job.fd = -1;
+			}
+#endif
 		}
+
+		void Compress(const std::filesystem::path& rotated) const {
+			if (rotated.empty() || !_options.compressor) {
+				return;
+			}
+
+			auto compressed = _options.compressor(rotated);
+			if (!compressed.empty() && compressed != rotated && std::filesystem::exists(compressed)) {
+				std::error_code ec;
+				std::filesystem::remove(rotated, ec);
+			}
+		}
+
+		// Matches the names RotatedPath gives, `<stem>-YYYYMMDD_HHMMSS[.N]<ext>`,
+		// with any suffix the compressor appended. Other files sharing the stem
+		// were not written by the logger and are left alone.
+		bool IsRotated(std::basic_string_view<std::filesystem::path::value_type> name) const {
+			using View = decltype(name);
+
+			auto skip = [&name](View text) {
+				if (!name.starts_with(text)) {
+					return false;
+				}
+				name.remove_prefix(text.size());
+				return true;
+			};
+			auto isDigit = [&name](size_t i) {
+				return i < name.size() && name[i] >= '0' && name[i] <= '9';
+			};
+			auto digits = [&name, &isDigit](size_t min, size_t max) {
+				size_t count = 0;
+				while (count < max && isDigit(count)) {
+					++count;
+				}
+				if (count < min || isDigit(count)) {
+					return false;
+				}
+				name.remove_prefix(count);
+				return true;
+			};
+
+			const auto stem = _logPath.stem();
+			const auto ext = _logPath.extension();
+			if (!skip(stem.native()) || !skip(PLUGIFY_PATH_LITERAL("-")) || !digits(8, 8)
+				|| !skip(PLUGIFY_PATH_LITERAL("_")) || !digits(6, 6)) {
+				return false;
+			}
+
+			// several rotations within a second
+			const auto counter = name;
+			if (!skip(PLUGIFY_PATH_LITERAL(".")) || !digits(1, SIZE_MAX)) {
+				name = counter;
+			}
+
+			return skip(ext.native()) && (name.empty() || (name.size() > 1 && name.front() == '.'));
+		}
+
+		// Removes the oldest rotated files until both limits hold
+		void ApplyRetention() const {
+			if (_options.maxFiles == 0 && _options.maxTotalSize == 0) {
+				return;
+			}
+
+			struct Rotated {
+				std::filesystem::path path;
+				std::filesystem::file_time_type time;
+				uint64_t size;
+			};
+
+			std::vector<Rotated> files;
+
+			std::error_code ec;
+			for (const auto& entry : std::filesystem::directory_iterator(_logPath.parent_path(), ec)) {
+				if (entry.is_regular_file(ec) && IsRotated(entry.path().filename().native())) {
+					files.push_back({ entry.path(), entry.last_write_time(ec), entry.file_size(ec) });
+				}
+			}
+
+			// newest first
+			std::ranges::sort(files, std::ranges::greater{}, &Rotated::time);
+
+			uint64_t total = 0;
+			for (size_t i = 0; i < files.size(); ++i) {
+				total += files[i].size;
+				bool overCount = _options.maxFiles != 0 && i >= _options.maxFiles;
+				bool overSize = _options.maxTotalSize != 0 && total > _options.maxTotalSize;
+				if (overCount || overSize) {
+					std::filesystem::remove(files[i].path, ec);
+				}
+			}
+		}
+
+	private:
+		std::filesystem::path _logPath;
+		const FileLoggerOptions _options;
+
+		// guards the file, _mutex only serializes the console
+		std::mutex _fileMutex;
+		std::FILE* _file{};
+		size_t _fileSize{};
+		std::string _buffer;
+		std::chrono::steady_clock::time_point _bufferedSince;
+
+		std::mutex _jobsMutex;
+		std::condition_variable _wake;
+		std::vector<RotateJob> _jobs;
+		bool _stop{};
+		std::thread _worker;
 	};
 }
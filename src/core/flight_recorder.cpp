@@ -0,0 +1,273 @@
+#include "plugify/flight_recorder.hpp"
+
+#if PLUGIFY_PLATFORM_WINDOWS
+#ifndef NOMINMAX
+#define NOMINMAX 1 // Macros min(a,b) and max(a,b)
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace plugify;
+
+namespace {
+	constexpr std::array<char, 8> kMagic = { 'P', 'L', 'G', 'F', 'L', 'T', 'R', '\0' };
+	constexpr uint32_t kVersion = 2;
+
+	// Start of the file, the slots follow it
+	struct alignas(64) Header {
+		std::array<char, 8> magic;
+		uint32_t version;
+		uint32_t slotSize;
+		uint64_t capacity;
+		int64_t baseSystem;   // system and steady time taken together,
+		uint64_t baseSteady;  // to turn slot times back into wall time
+		alignas(64) uint64_t next;  // sequence of the next slot to claim
+	};
+
+	// A slot is complete once its sequence is set: it is cleared first and
+	// stored last, with release ordering, so a torn slot reads as empty.
+	// Writers which lapped the ring meet on the claim word: it holds the
+	// sequence of the last writer shifted left, with bit 0 set while it writes.
+	struct Slot {
+		uint64_t claim;
+		uint64_t sequence;  // 0 while written, sequence + 1 after
+		uint64_t time;
+		uint32_t thread;
+		FlightEvent event;
+		Severity severity;
+		uint16_t length;
+	};
+
+	constexpr size_t kTextSize = FlightRecorder::kSlotSize - sizeof(Slot);
+	static_assert(sizeof(Slot) < FlightRecorder::kSlotSize);
+	static_assert(sizeof(Header) % 64 == 0);
+
+	uint64_t SteadyNow() noexcept {
+		using namespace std::chrono;
+		return static_cast<uint64_t>(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count());
+	}
+
+	int64_t SystemNow() noexcept {
+		using namespace std::chrono;
+		return duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count();
+	}
+
+	uint32_t ThreadHash() noexcept {
+		thread_local const auto hash = static_cast<uint32_t>(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+		return hash;
+	}
+
+	std::mutex g_activeMutex;
+	std::shared_ptr<FlightRecorder> g_active;
+}
+
+struct FlightRecorder::Impl {
+	~Impl() {
+#if PLUGIFY_PLATFORM_WINDOWS
+		FlushViewOfFile(data, 0);
+		UnmapViewOfFile(data);
+#else
+		msync(data, size, MS_ASYNC);
+		munmap(data, size);
+#endif
+	}
+
+	Header& GetHeader() const noexcept {
+		return *reinterpret_cast<Header*>(data);
+	}
+
+	std::byte* GetSlot(uint64_t sequence) const noexcept {
+		return static_cast<std::byte*>(data) + sizeof(Header) + (sequence & mask) * kSlotSize;
+	}
+
+	std::filesystem::path path;
+	void* data{};
+	size_t size{};
+	size_t capacity{};
+	uint64_t mask{};
+};
+
+FlightRecorder::FlightRecorder(std::unique_ptr<Impl> impl) noexcept
+	: _impl(std::move(impl)) {
+}
+
+FlightRecorder::~FlightRecorder() = default;
+
+Result<std::shared_ptr<FlightRecorder>> FlightRecorder::Create(const std::filesystem::path& file, size_t capacity) {
+	capacity = std::bit_ceil(std::max<size_t>(capacity, 16));
+	const size_t size = sizeof(Header) + capacity * kSlotSize;
+
+	std::error_code ec;
+	std::filesystem::create_directories(file.parent_path(), ec);
+	if (std::filesystem::exists(file, ec)) {
+		auto previous = file;
+		previous += PLUGIFY_PATH_LITERAL(".prev");
+		std::filesystem::rename(file, previous, ec);
+	}
+
+#if PLUGIFY_PLATFORM_WINDOWS
+	HANDLE handle = CreateFileW(file.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE) {
+		return MakeError("Failed to create flight recorder: {}", plg::as_string(file));
+	}
+	HANDLE mapping = CreateFileMappingW(handle, nullptr, PAGE_READWRITE, static_cast<DWORD>(uint64_t(size) >> 32), static_cast<DWORD>(size), nullptr);
+	void* data = mapping ? MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size) : nullptr;
+	// the view keeps the mapping and the file alive
+	if (mapping) {
+		CloseHandle(mapping);
+	}
+	CloseHandle(handle);
+	if (!data) {
+		return MakeError("Failed to map flight recorder: {}", plg::as_string(file));
+	}
+#else
+	int fd = open(file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd == -1) {
+		return MakeError("Failed to create flight recorder: {}", plg::as_string(file));
+	}
+	void* data = ftruncate(fd, static_cast<off_t>(size)) == 0
+		? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+		: MAP_FAILED;
+	close(fd);
+	if (data == MAP_FAILED) {
+		return MakeError("Failed to map flight recorder: {}", plg::as_string(file));
+	}
+#endif
+
+	// a fresh file reads back as zeros, so every slot starts out empty
+	auto& header = *static_cast<Header*>(data);
+	header.magic = kMagic;
+	header.version = kVersion;
+	header.slotSize = static_cast<uint32_t>(kSlotSize);
+	header.capacity = capacity;
+	header.baseSystem = SystemNow();
+	header.baseSteady = SteadyNow();
+
+	auto impl = std::make_unique<Impl>();
+	impl->path = file;
+	impl->data = data;
+	impl->size = size;
+	impl->capacity = capacity;
+	impl->mask = capacity - 1;
+	return std::shared_ptr<FlightRecorder>(new FlightRecorder(std::move(impl)));
+}
+
+Result<void> FlightRecorder::Decode(const std::filesystem::path& file, const std::function<void(const FlightRecord&)>& callback) {
+	std::ifstream in(file, std::ios::binary);
+	if (!in) {
+		return MakeError("Failed to open flight recorder: {}", plg::as_string(file));
+	}
+
+	Header header;
+	if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != kMagic) {
+		return MakeError("Not a flight recorder: {}", plg::as_string(file));
+	}
+	if (header.version != kVersion || header.slotSize != kSlotSize || !std::has_single_bit(header.capacity)) {
+		return MakeError("Unsupported flight recorder layout in {}", plg::as_string(file));
+	}
+
+	// the capacity comes from the file, it is checked before it sizes anything
+	std::error_code ec;
+	const uintmax_t fileSize = std::filesystem::file_size(file, ec);
+	if (ec || fileSize < sizeof(Header) || header.capacity > (fileSize - sizeof(Header)) / kSlotSize) {
+		return MakeError("Truncated flight recorder: {}", plg::as_string(file));
+	}
+
+	std::vector<std::byte> slots(header.capacity * kSlotSize);
+	if (!in.read(reinterpret_cast<char*>(slots.data()), static_cast<std::streamsize>(slots.size()))) {
+		return MakeError("Truncated flight recorder: {}", plg::as_string(file));
+	}
+
+	// only the last capacity sequences can still be in the ring, older
+	// ones were overwritten, newer ones were claimed but not written
+	const uint64_t first = header.next > header.capacity ? header.next - header.capacity : 0;
+
+	std::vector<const std::byte*> complete;
+	complete.reserve(header.capacity);
+	for (size_t i = 0; i < header.capacity; ++i) {
+		const std::byte* slot = slots.data() + i * kSlotSize;
+		Slot entry;
+		std::memcpy(&entry, slot, sizeof(entry));
+		if (entry.sequence != 0 && entry.sequence - 1 >= first && entry.sequence - 1 < header.next) {
+			complete.push_back(slot);
+		}
+	}
+
+	auto sequenceOf = [](const std::byte* slot) {
+		uint64_t sequence;
+		std::memcpy(&sequence, slot + offsetof(Slot, sequence), sizeof(sequence));
+		return sequence;
+	};
+	std::ranges::sort(complete, {}, sequenceOf);
+
+	for (const std::byte* slot : complete) {
+		Slot entry;
+		std::memcpy(&entry, slot, sizeof(entry));
+
+		auto ns = header.baseSystem + static_cast<int64_t>(entry.time - header.baseSteady);
+		callback({
+			std::chrono::system_clock::time_point(
+				std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(ns))
+			),
+			entry.sequence - 1,
+			entry.thread,
+			entry.event,
+			entry.severity,
+			std::string_view(reinterpret_cast<const char*>(slot + sizeof(Slot)), std::min<size_t>(entry.length, kTextSize)),
+		});
+	}
+
+	return {};
+}
+
+void FlightRecorder::SetActive(std::shared_ptr<FlightRecorder> recorder) {
+	std::lock_guard lock(g_activeMutex);
+	g_active = std::move(recorder);
+}
+
+std::shared_ptr<FlightRecorder> FlightRecorder::GetActive() {
+	std::lock_guard lock(g_activeMutex);
+	return g_active;
+}
+
+void FlightRecorder::Record(FlightEvent event, Severity severity, std::string_view text) noexcept {
+	const uint64_t sequence = std::atomic_ref(_impl->GetHeader().next).fetch_add(1, std::memory_order_relaxed);
+	std::byte* slot = _impl->GetSlot(sequence);
+	auto& entry = *reinterpret_cast<Slot*>(slot);
+
+	// a writer still busy with this slot, or one which already lapped it with a
+	// newer sequence, keeps it: this record is dropped rather than interleaved
+	std::atomic_ref claim(entry.claim);
+	uint64_t current = claim.load(std::memory_order_relaxed);
+	do {
+		if ((current & 1) != 0 || (current >> 1) > sequence) {
+			return;
+		}
+	} while (!claim.compare_exchange_weak(current, (sequence << 1) | 1, std::memory_order_acquire, std::memory_order_relaxed));
+
+	std::atomic_ref(entry.sequence).store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	const size_t length = std::min(text.size(), kTextSize);
+	entry.time = SteadyNow();
+	entry.thread = ThreadHash();
+	entry.event = event;
+	entry.severity = severity;
+	entry.length = static_cast<uint16_t>(length);
+	std::memcpy(slot + sizeof(Slot), text.data(), length);
+
+	std::atomic_ref(entry.sequence).store(sequence + 1, std::memory_order_release);
+	claim.store(sequence << 1, std::memory_order_release);
+}
+
+size_t FlightRecorder::GetCapacity() const noexcept {
+	return _impl->capacity;
+}
+
+const std::filesystem::path& FlightRecorder::GetPath() const noexcept {
+	return _impl->path;
+}
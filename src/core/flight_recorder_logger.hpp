@@ -0,0 +1,50 @@
+#pragma once
+
+#include "plugify/flight_recorder.hpp"
+#include "plugify/logger.hpp"
+
+namespace plugify {
+	// Tee in front of the configured logger: every message it would print is
+	// also copied into the flight recorder, which survives a crash that
+	// leaves the logger's own buffers unwritten
+	class FlightRecorderLogger final : public ILogger {
+	public:
+		FlightRecorderLogger(std::shared_ptr<ILogger> logger, std::shared_ptr<FlightRecorder> recorder)
+			: _logger(std::move(logger))
+			, _recorder(std::move(recorder)) {
+		}
+
+		void Log(
+			std::string_view message,
+			Severity severity,
+			const Location& location = Location::current()
+		) override {
+			// the wrapped logger keeps the level, it may be changed on it directly;
+			// Unknown bypasses the level like it does in the other loggers
+			if (severity == Severity::Unknown || severity >= _logger->GetLogLevel()) {
+				_recorder->Record(FlightEvent::Log, severity, message);
+			}
+			_logger->Log(message, severity, location);
+		}
+
+		void SetLogLevel(Severity minSeverity) override {
+			_logger->SetLogLevel(minSeverity);
+		}
+
+		Severity GetLogLevel() override {
+			return _logger->GetLogLevel();
+		}
+
+		void Flush() override {
+			_logger->Flush();
+		}
+
+		LogStats GetStats() override {
+			return _logger->GetStats();
+		}
+
+	private:
+		std::shared_ptr<ILogger> _logger;
+		std::shared_ptr<FlightRecorder> _recorder;
+	};
+}
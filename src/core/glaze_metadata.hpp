@@ -228,6 +228,30 @@ struct glz::meta<plugify::CallConv> {
 	);
 };
 
+template <>
+struct glz::meta<plugify::Severity> {
+	using enum plugify::Severity;
+	static constexpr auto value = enumerate(
+		"unknown", Unknown,
+		"trace", Trace,
+		"debug", Debug,
+		"info", Info,
+		"warning", Warning,
+		"error", Error,
+		"fatal", Fatal
+	);
+};
+
+template <>
+struct glz::meta<plugify::OverflowPolicy> {
+	using enum plugify::OverflowPolicy;
+	static constexpr auto value = enumerate(
+		"block", Block,
+		"dropOldest", DropOldest,
+		"dropNewest", DropNewest
+	);
+};
+
 namespace glz {
 #if PLUGIFY_CPP_VERSION > 202002L
 	// std::chrono::duration
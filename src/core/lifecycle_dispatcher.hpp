@@ -0,0 +1,133 @@
+#pragma once
+
+#include "plugify/lifecycle.hpp"
+
+#include "core/ring_queue.hpp"
+
+namespace plugify {
+	// Compact POD record describing a single lifecycle event
+	struct LifecycleEvent {
+		enum class Kind : uint8_t {
+			Load,
+			Unload,
+			Start,
+			End,
+			Update,
+			Export
+		};
+
+		Kind kind{};
+		Extension* extension{};
+		std::chrono::milliseconds deltaTime{};
+	};
+	static_assert(std::is_trivially_copyable_v<LifecycleEvent>);
+
+	// Decouples the extension loader from the lifecycle observer.
+	// Events are pushed into a lock-free queue and handed to the observer
+	// in batches on Flush(), which the manager calls from its own thread, so
+	// observers never see an extension while the loader is changing it.
+	// Synchronous observers bypass the queue.
+	class LifecycleDispatcher {
+	public:
+		static constexpr size_t kDefaultCapacity = 4096;
+
+		explicit LifecycleDispatcher(std::shared_ptr<IExtensionLifecycle> observer, size_t capacity = kDefaultCapacity)
+			: _observer(std::move(observer))
+			, _delivery(_observer->GetDelivery())
+			, _queue(capacity) {
+		}
+
+		~LifecycleDispatcher() {
+			Flush();
+		}
+
+		LifecycleDispatcher(const LifecycleDispatcher&) = delete;
+		LifecycleDispatcher& operator=(const LifecycleDispatcher&) = delete;
+
+		void OnLoad(Extension& extension) {
+			Post({ LifecycleEvent::Kind::Load, &extension, {} });
+		}
+
+		void OnUnload(Extension& extension) {
+			Post({ LifecycleEvent::Kind::Unload, &extension, {} });
+		}
+
+		void OnStart(Extension& extension) {
+			Post({ LifecycleEvent::Kind::Start, &extension, {} });
+		}
+
+		void OnEnd(Extension& extension) {
+			Post({ LifecycleEvent::Kind::End, &extension, {} });
+		}
+
+		void OnUpdate(Extension& extension, std::chrono::milliseconds deltaTime) {
+			Post({ LifecycleEvent::Kind::Update, &extension, deltaTime });
+		}
+
+		void OnExport(Extension& extension) {
+			Post({ LifecycleEvent::Kind::Export, &extension, {} });
+		}
+
+		// Delivers every queued event on the calling thread
+		void Flush() {
+			std::lock_guard lock(_deliverMutex);
+			Drain();
+		}
+
+		LifecycleDelivery GetDelivery() const noexcept {
+			return _delivery;
+		}
+
+	private:
+		void Post(const LifecycleEvent& event) {
+			if (_delivery == LifecycleDelivery::Synchronous) {
+				Deliver(event);
+				return;
+			}
+
+			if (!_queue.TryPush(event)) {
+				// Queue is full: drain inline to keep ordering and never lose events
+				std::lock_guard lock(_deliverMutex);
+				Drain();
+				Deliver(event);
+			}
+		}
+
+		void Drain() {
+			LifecycleEvent event;
+			while (_queue.TryPop(event)) {
+				Deliver(event);
+			}
+		}
+
+		void Deliver(const LifecycleEvent& event) const {
+			auto& extension = *event.extension;
+			switch (event.kind) {
+				case LifecycleEvent::Kind::Load:
+					_observer->OnLoad(extension);
+					break;
+				case LifecycleEvent::Kind::Unload:
+					_observer->OnUnload(extension);
+					break;
+				case LifecycleEvent::Kind::Start:
+					_observer->OnStart(extension);
+					break;
+				case LifecycleEvent::Kind::End:
+					_observer->OnEnd(extension);
+					break;
+				case LifecycleEvent::Kind::Update:
+					_observer->OnUpdate(extension, event.deltaTime);
+					break;
+				case LifecycleEvent::Kind::Export:
+					_observer->OnExport(extension);
+					break;
+			}
+		}
+
+	private:
+		std::shared_ptr<IExtensionLifecycle> _observer;
+		LifecycleDelivery _delivery;
+		RingQueue<LifecycleEvent> _queue;
+		std::mutex _deliverMutex;
+	};
+}
@@ -117,6 +117,8 @@ public:
 
 		auto report = pipeline->Execute(extensions);
 
+		loader->FlushLifecycleEvents();
+
 		// compute total failed items across stages
 		size_t totalFailed = 0;
 		for (const auto& [name, stats] : report.stages) {
@@ -177,6 +179,9 @@ public:
 
 		std::lock_guard lock(lifecycleMutex);
 
+		// Runs while unloaded too, that is when parked assemblies age out
+		assemblyLoader->Update();
+
 		if (!initialized) {
 			return;
 		}
@@ -206,6 +211,8 @@ public:
 			}
 		}
 
+		loader->FlushLifecycleEvents();
+
 		if (profiler) {
 			profiler->MarkFrame("PlugifyLoop");
 		}
@@ -277,6 +284,8 @@ public:
 			}
 		}
 
+		loader->FlushLifecycleEvents();
+
 		initialized = false;
 	}
 
@@ -506,6 +515,14 @@ std::vector<const Extension*> Manager::GetExtensionsByType(ExtensionType type) c
 	return result;
 }
 
+std::span<const MethodData> Manager::FindMethods(std::string_view plugin) const {
+	return _impl->loader->GetMethodRegistry().FindMethods(plugin);
+}
+
+const MethodData* Manager::FindMethod(std::string_view plugin, std::string_view method) const {
+	return _impl->loader->GetMethodRegistry().FindMethod(plugin, method);
+}
+
 std::string Manager::GenerateLoadOrder() const {
 	return _impl->GenerateLoadOrder();
 }
@@ -454,6 +454,18 @@ Result<void> Manifest::Resolve() {
 		return result;
 	}
 
+	// Signatures are final from here on, plan the marshalling of each one once
+	// rather than on every stub and call made for it.
+	if (methods) {
+		for (auto& method : *methods) {
+			UpdateMarshalPlan(method);
+		}
+	}
+
+	for (const auto& [_, prototype] : table.prototypes) {
+		UpdateMarshalPlan(*prototype);
+	}
+
 	// Publish the merged tables, sorted by name so that consumers which generate
 	// code from a manifest get a stable ordering.
 	auto publish = [](auto& field, auto& table) {
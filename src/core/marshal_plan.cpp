@@ -0,0 +1,48 @@
+#include "plugify/marshal_plan.hpp"
+#include "plugify/method.hpp"
+#include "plugify/property.hpp"
+
+using namespace plugify;
+
+namespace {
+	RegClass GetRegClass(ValueType type) noexcept {
+		if (type == ValueType::Void) {
+			return RegClass::None;
+		}
+		if (ValueUtils::IsFloating(type)) {
+			return RegClass::Float;
+		}
+		if (ValueUtils::IsStruct(type)) {
+			return RegClass::Struct;
+		}
+		return RegClass::Int;
+	}
+
+	MarshalSlot MakeSlot(ValueType type, bool ref, bool hidden, size_t index) noexcept {
+		const ValueType native = ref || hidden ? ValueType::Pointer : type;
+		return { type, native, GetRegClass(native), ref, hidden, static_cast<uint16_t>(index * sizeof(uint64_t)) };
+	}
+}
+
+MarshalPlan::MarshalPlan(const Method& method, bool (*hidden)(ValueType)) {
+	retType = method.GetRetType().GetType();
+	retHidden = hidden ? hidden(retType) : ValueUtils::IsHiddenParam(retType);
+
+	signature = Signature(
+		method.GetCallConv(),
+		retHidden ? ValueType::Pointer : retType,
+		method.GetVarIndex()
+	);
+	retClass = GetRegClass(signature.retType);
+
+	// the hidden return travels as a plain pointer, even for a type a custom
+	// predicate hides which would otherwise be split into vector registers
+	if (retHidden) {
+		slots.push_back(MakeSlot(retType, false, true, slots.size()));
+		signature.AddArg(slots.back().native);
+	}
+	for (const auto& param : method.GetParamTypes()) {
+		slots.push_back(MakeSlot(param.GetType(), param.IsRef(), false, slots.size()));
+		signature.AddArg(slots.back().native);
+	}
+}
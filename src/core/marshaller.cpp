@@ -0,0 +1,191 @@
+#include <new>
+
+#include "plugify/marshaller.hpp"
+#include "plugify/property.hpp"
+#include "plg/enum.hpp"
+
+using namespace plugify;
+
+namespace {
+	using PackFunc = void (*)(Parameters& params, plg::any& arg) noexcept;
+	using UnpackFunc = plg::any (*)(Marshaller::Frame& frame);
+
+	// Every alternative of plg::any, which are laid out in ValueType order
+	constexpr size_t kTypeCount = static_cast<size_t>(ValueType::Vector4) + 1;
+
+	// Argument accepted whatever it holds
+	constexpr uint8_t kAnyIndex = 0xFF;
+
+	template <size_t I>
+	using Alternative = typename plg::any::template alternative<I>;
+
+	// By value: scalars go into the slot, objects and vectors are passed by pointer
+	template <size_t I>
+	void PackValue(Parameters& params, plg::any& arg) noexcept {
+		using T = Alternative<I>;
+		if constexpr (std::is_same_v<T, plg::function>) {
+			params.Add(plg::get_if<I>(&arg)->ptr);
+		} else if constexpr (SingleSlotType<T>) {
+			params.Add(*plg::get_if<I>(&arg));
+		} else {
+			params.Add(static_cast<void*>(plg::get_if<I>(&arg)));
+		}
+	}
+
+	template <size_t I>
+	void PackRef(Parameters& params, plg::any& arg) noexcept {
+		params.Add(static_cast<void*>(plg::get_if<I>(&arg)));
+	}
+
+	// plg::any parameters receive the argument itself
+	void PackAny(Parameters& params, plg::any& arg) noexcept {
+		params.Add(static_cast<void*>(&arg));
+	}
+
+	template <size_t I>
+	plg::any UnpackValue(Marshaller::Frame& frame) {
+		using T = Alternative<I>;
+		if constexpr (sizeof(T) <= Return::MaxSize && std::is_trivially_copyable_v<T>) {
+			return plg::any(plg::in_place_index<I>, frame.ret.Get<T>());
+		} else {
+			return {};
+		}
+	}
+
+	template <size_t I>
+	plg::any UnpackHidden(Marshaller::Frame& frame) {
+		using T = Alternative<I>;
+		// ValueType::Any is returned as a whole plg::any
+		using Object = std::conditional_t<I == static_cast<size_t>(ValueType::Any), plg::any, T>;
+		auto* object = std::launder(reinterpret_cast<Object*>(frame.storage.data()));
+		plg::any ret = [&] {
+			if constexpr (std::is_same_v<Object, plg::any>) {
+				return plg::any(std::move(*object));
+			} else {
+				return plg::any(plg::in_place_index<I>, std::move(*object));
+			}
+		}();
+		std::destroy_at(object);
+		return ret;
+	}
+
+	plg::any UnpackVoid(Marshaller::Frame&) {
+		return plg::none{};
+	}
+
+	constexpr auto kPackValue = []<size_t... I>(std::index_sequence<I...>) {
+		return std::array<PackFunc, kTypeCount>{ &PackValue<I>... };
+	}(std::make_index_sequence<kTypeCount>{});
+
+	constexpr auto kPackRef = []<size_t... I>(std::index_sequence<I...>) {
+		return std::array<PackFunc, kTypeCount>{ &PackRef<I>... };
+	}(std::make_index_sequence<kTypeCount>{});
+
+	constexpr auto kUnpackValue = []<size_t... I>(std::index_sequence<I...>) {
+		return std::array<UnpackFunc, kTypeCount>{ &UnpackValue<I>... };
+	}(std::make_index_sequence<kTypeCount>{});
+
+	constexpr auto kUnpackHidden = []<size_t... I>(std::index_sequence<I...>) {
+		return std::array<UnpackFunc, kTypeCount>{ &UnpackHidden<I>... };
+	}(std::make_index_sequence<kTypeCount>{});
+
+	bool IsMarshallable(ValueType type) noexcept {
+		// any[] and mat4x4 have no exact alternative in plg::any
+		return type != ValueType::Invalid && type != ValueType::ArrayAny && static_cast<size_t>(type) < kTypeCount;
+	}
+}
+
+struct Marshaller::Impl {
+	std::inplace_vector<PackFunc, Signature::kMaxFuncArgs> pack;
+	std::inplace_vector<uint8_t, Signature::kMaxFuncArgs> indices;
+	UnpackFunc unpack{};
+	bool hidden{};
+};
+
+Result<Marshaller> Marshaller::Create(const Method& method, JitCall::HiddenParam hidden) {
+	auto impl = std::make_unique<Impl>();
+
+	const ValueType retType = method.GetRetType().GetType();
+	if (retType == ValueType::Void) {
+		impl->unpack = &UnpackVoid;
+	} else if (!IsMarshallable(retType)) {
+		return MakeError("Return type '{}' of '{}' cannot be held by plg::any", plg::enum_to_string(retType), method.GetName());
+	} else {
+		impl->hidden = hidden ? hidden(retType) : ValueUtils::IsHiddenParam(retType);
+		impl->unpack = (impl->hidden ? kUnpackHidden : kUnpackValue)[static_cast<size_t>(retType)];
+	}
+
+	const auto& paramTypes = method.GetParamTypes();
+	// the hidden return takes a slot of the frame ahead of the parameters
+	if (impl->hidden && paramTypes.size() == Signature::kMaxFuncArgs) {
+		return MakeError("'{}' has {} parameters, a hidden return leaves room for {}", method.GetName(), paramTypes.size(), Signature::kMaxFuncArgs - 1);
+	}
+	for (size_t i = 0; i < paramTypes.size(); ++i) {
+		const auto& param = paramTypes[i];
+		const ValueType type = param.GetType();
+		if (type == ValueType::Void || !IsMarshallable(type)) {
+			return MakeError("Parameter {} of '{}' has type '{}' which cannot be held by plg::any", i, method.GetName(), plg::enum_to_string(type));
+		}
+
+		const auto index = static_cast<size_t>(type);
+		if (type == ValueType::Any) {
+			impl->pack.push_back(&PackAny);
+			impl->indices.push_back(kAnyIndex);
+		} else {
+			impl->pack.push_back((param.IsRef() ? kPackRef : kPackValue)[index]);
+			impl->indices.push_back(static_cast<uint8_t>(index));
+		}
+	}
+
+	return Marshaller(std::move(impl));
+}
+
+Marshaller::Marshaller(std::unique_ptr<Impl> impl) noexcept
+	: _impl(std::move(impl)) {
+}
+
+Marshaller::Marshaller(Marshaller&& other) noexcept = default;
+
+Marshaller::~Marshaller() = default;
+
+Marshaller& Marshaller::operator=(Marshaller&& other) noexcept = default;
+
+size_t Marshaller::GetArgCount() const noexcept {
+	return _impl->pack.size();
+}
+
+bool Marshaller::Pack(std::span<plg::any> args, Frame& frame) const noexcept {
+	const auto& indices = _impl->indices;
+	if (args.size() != indices.size()) {
+		return false;
+	}
+	for (size_t i = 0; i < args.size(); ++i) {
+		if (indices[i] != kAnyIndex && args[i].index() != indices[i]) {
+			return false;
+		}
+	}
+
+	auto& params = frame.params;
+	params.Reset();
+	if (_impl->hidden) {
+		params.Add(static_cast<void*>(frame.storage.data()));
+	}
+	for (size_t i = 0; i < args.size(); ++i) {
+		_impl->pack[i](params, args[i]);
+	}
+	return true;
+}
+
+plg::any Marshaller::Unpack(Frame& frame) const {
+	return _impl->unpack(frame);
+}
+
+bool Marshaller::Invoke(JitCall::CallingFunc func, std::span<plg::any> args, plg::any& ret) const {
+	Frame frame;
+	if (!Pack(args, frame)) {
+		return false;
+	}
+	func(frame.params.Get(), &frame.ret);
+	ret = Unpack(frame);
+	return true;
+}
@@ -48,12 +48,18 @@ uint8_t Method::GetVarIndex() const noexcept {
 	return _impl->varIndex.value_or(Signature::kNoVarArgs);
 }
 
+const MarshalPlan* Method::GetMarshalPlan() const noexcept {
+	return _impl->plan.get();
+}
+
 void Method::SetParamTypes(std::inplace_vector<Property, Signature::kMaxFuncArgs> paramTypes) {
 	_impl->paramTypes = std::move(paramTypes);
+	UpdateMarshalPlan(*this);
 }
 
 void Method::SetRetType(Property retType) {
 	_impl->retType = std::move(retType);
+	UpdateMarshalPlan(*this);
 }
 
 void Method::SetName(std::string name) {
@@ -66,10 +72,12 @@ void Method::SetFuncName(std::string funcName) {
 
 void Method::SetCallConv(CallConv callConv) {
 	_impl->callConv = callConv;
+	UpdateMarshalPlan(*this);
 }
 
 void Method::SetVarIndex(uint8_t varIndex) {
 	_impl->varIndex = varIndex;
+	UpdateMarshalPlan(*this);
 }
 
 bool Method::operator==(const Method& other) const noexcept = default;
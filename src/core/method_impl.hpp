@@ -1,5 +1,8 @@
 #pragma once
 
+#include <memory>
+
+#include "plugify/marshal_plan.hpp"
 #include "plugify/method.hpp"
 #include "plugify/property.hpp"
 #include "plugify/signarure.hpp"
@@ -12,5 +15,11 @@ namespace plugify {
 		std::string funcName;
 		std::optional<CallConv> callConv;
 		std::optional<uint8_t> varIndex;
+		std::shared_ptr<const MarshalPlan> plan;  // shared by copies, rebuilt when the signature changes
 	};
+
+	// Classifies the parameters once, for every stub and module marshalling calls to it
+	inline void UpdateMarshalPlan(Method& method) {
+		method._impl->plan = std::make_shared<const MarshalPlan>(method);
+	}
 }
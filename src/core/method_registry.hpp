@@ -0,0 +1,118 @@
+#pragma once
+
+#include "plg/hash.hpp"
+
+#include "plugify/extension.hpp"
+#include "plugify/method.hpp"
+
+namespace plugify {
+	// Central index of methods exported by plugins.
+	// Entries are views into Extension::GetMethodsData(), nothing is copied,
+	// so a plugin must be unregistered before its method data is cleared.
+	class MethodRegistry {
+		struct Entry {
+			std::span<const MethodData> methods;
+			std::unordered_map<std::string_view, const MethodData*> byName;
+		};
+
+		std::unordered_map<std::string, Entry, plg::string_hash, std::equal_to<>> _entries;
+		mutable std::shared_mutex _mutex;
+
+	public:
+		void Register(const Extension& plugin) {
+			const auto& methodsData = plugin.GetMethodsData();
+
+			Entry entry;
+			entry.methods = methodsData;
+			entry.byName.reserve(methodsData.size());
+			for (const auto& data : methodsData) {
+				entry.byName.emplace(data.method.GetName(), &data);
+			}
+
+			std::unique_lock lock(_mutex);
+			_entries.insert_or_assign(plugin.GetName(), std::move(entry));
+		}
+
+		void Unregister(const Extension& plugin) {
+			std::unique_lock lock(_mutex);
+			if (auto it = _entries.find(plugin.GetName()); it != _entries.end()) {
+				_entries.erase(it);
+			}
+		}
+
+		bool IsRegistered(std::string_view plugin) const {
+			std::shared_lock lock(_mutex);
+			return _entries.contains(plugin);
+		}
+
+		std::span<const MethodData> FindMethods(std::string_view plugin) const {
+			std::shared_lock lock(_mutex);
+			if (auto it = _entries.find(plugin); it != _entries.end()) {
+				return it->second.methods;
+			}
+			return {};
+		}
+
+		const MethodData* FindMethod(std::string_view plugin, std::string_view method) const {
+			std::shared_lock lock(_mutex);
+			if (auto it = _entries.find(plugin); it != _entries.end()) {
+				const auto& byName = it->second.byName;
+				if (auto jt = byName.find(method); jt != byName.end()) {
+					return jt->second;
+				}
+			}
+			return nullptr;
+		}
+
+		size_t Size() const {
+			std::shared_lock lock(_mutex);
+			return _entries.size();
+		}
+	};
+
+	// Plugin id -> running language modules to call OnMethodExport on
+	using ExportConsumers = std::unordered_map<UniqueId, std::vector<const Extension*>>;
+
+	// Only modules hosting a plugin which declares a dependency on the exporting
+	// plugin are notified, each once. Everyone else queries the registry.
+	inline ExportConsumers MapExportConsumers(
+		std::span<const Extension> items,
+		const std::unordered_map<UniqueId, std::vector<UniqueId>>& reverseDepGraph
+	) {
+		std::unordered_map<std::string_view, const Extension*> runningModules;
+		std::unordered_map<UniqueId, const Extension*> plugins;
+		for (const auto& ext : items) {
+			if (ext.GetType() == ExtensionType::Module) {
+				if (ext.GetState() == ExtensionState::Running) {
+					runningModules.emplace(ext.GetLanguage(), &ext);
+				}
+			} else if (ext.GetType() == ExtensionType::Plugin) {
+				plugins.emplace(ext.GetId(), &ext);
+			}
+		}
+
+		ExportConsumers consumers;
+		for (const auto& [id, plugin] : plugins) {
+			auto it = reverseDepGraph.find(id);
+			if (it == reverseDepGraph.end()) {
+				continue;
+			}
+
+			auto& modules = consumers[id];
+			for (const auto& dependentId : it->second) {
+				auto dependent = plugins.find(dependentId);
+				if (dependent == plugins.end()) {
+					continue;
+				}
+				auto module = runningModules.find(dependent->second->GetLanguage());
+				if (module == runningModules.end()) {
+					continue;
+				}
+				if (std::ranges::find(modules, module->second) == modules.end()) {
+					modules.push_back(module->second);
+				}
+			}
+		}
+		return consumers;
+	}
+}
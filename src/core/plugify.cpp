@@ -1,8 +1,10 @@
 #include "plugify/assembly_loader.hpp"
+#include "plugify/jit_context.hpp"
 #include "plugify/plugify.hpp"
 
 #include "core/glaze_metadata.hpp"
-#include "core/console_logger.hpp"
+#include "core/async_logger.hpp"
+#include "core/flight_recorder_logger.hpp"
 #include "core/libsolv_dependency_resolver.hpp"
 #include "core/standart_file_system.hpp"
 #include "core/basic_assembly_loader.hpp"
@@ -20,6 +22,7 @@ struct Plugify::Impl {
 	std::shared_ptr<IFileSystem> fileSystem;
 	std::shared_ptr<IPlatformOps> ops;
 	std::shared_ptr<IProfiler> profiler;
+	std::shared_ptr<FlightRecorder> recorder;
 
 	bool initialized{ false };
 
@@ -40,6 +43,12 @@ struct Plugify::Impl {
 		ops = services.Resolve<IPlatformOps>();
 		profiler = services.TryResolve<IProfiler>();
 
+		// Lifecycle events go to the recorder set up by the builder
+		recorder = services.TryResolve<FlightRecorder>();
+		if (recorder) {
+			FlightRecorder::SetActive(recorder);
+		}
+
 		// Set default logging level
 		logger->SetLogLevel(config.logging.severity);
 
@@ -51,6 +60,9 @@ struct Plugify::Impl {
 		if (initialized) {
 			Terminate();
 		}
+		if (recorder && FlightRecorder::GetActive() == recorder) {
+			FlightRecorder::SetActive(nullptr);
+		}
 	}
 
 	Result<void> Initialize() {
@@ -71,9 +83,15 @@ struct Plugify::Impl {
 			return MakeError("Failed to create directories");
 		}
 
+		// Persist generated JIT stubs between runs
+		JitContext::SetCacheDirectory(config.paths.cacheDir / "jit");
+
 		// Initialize manager
 		//manager.Initialize();
 
+		// Everything is registered by now, freeze the services for lock-free lookups
+		services.Seal();
+
 		logger->Log("Plugify initialized successfully", Severity::Info);
 		logger->Log(std::format("Version: {}", version), Severity::Info);
 
@@ -391,14 +409,35 @@ PlugifyBuilder& PlugifyBuilder::WithExtensionLifecycle(std::shared_ptr<IExtensio
 	return *this;
 }
 
+namespace {
+	// Services left unset by the user, tuned by the configuration
+	void RegisterDefaults(ServiceLocator& services, const Config& config) {
+		// checked first, the logger starts its writer thread on construction
+		if (!services.IsRegistered<ILogger>()) {
+			services.RegisterInstance<ILogger>(std::make_shared<AsyncLogger>(
+				config.logging.severity,
+				config.logging.queueCapacity,
+				config.logging.overflowPolicy
+			));
+		}
+		//services.RegisterInstanceIfMissing<IProfiler>(std::make_shared<TracyProfiler>());
+		services.RegisterInstanceIfMissing<IPlatformOps>(CreatePlatformOps());
+		services.RegisterInstanceIfMissing<IFileSystem>(std::make_shared<ExtendedFileSystem>());
+		if (!services.IsRegistered<IAssemblyLoader>()) {
+			BasicAssemblyLoader::WarmCacheOptions warmOptions{
+				.maxEntries = config.loading.warmCacheSize,
+				.maxAge = config.loading.warmCacheMaxAge,
+			};
+			services.RegisterInstance<IAssemblyLoader>(std::make_shared<BasicAssemblyLoader>(services.Resolve<IPlatformOps>(), services.Resolve<IFileSystem>(), warmOptions));
+		}
+		services.RegisterInstanceIfMissing<IDependencyResolver>(std::make_shared<LibsolvDependencyResolver>(services.Resolve<ILogger>()));
+		//services.RegisterInstanceIfMissing<IExtensionLifecycle>(std::make_shared<DummyLifecycle>());
+	}
+}
+
 PlugifyBuilder& PlugifyBuilder::WithDefaults() {
-	_impl->services.RegisterInstanceIfMissing<ILogger>(std::make_shared<ConsoleLogger>());
-	//_impl->services.RegisterInstanceIfMissing<IProfiler>(std::make_shared<TracyProfiler>());
-	_impl->services.RegisterInstanceIfMissing<IPlatformOps>(CreatePlatformOps());
-	_impl->services.RegisterInstanceIfMissing<IFileSystem>(std::make_shared<ExtendedFileSystem>());
-	_impl->services.RegisterInstanceIfMissing<IAssemblyLoader>(std::make_shared<BasicAssemblyLoader>(_impl->services.Resolve<IPlatformOps>(), _impl->services.Resolve<IFileSystem>()));
-	_impl->services.RegisterInstanceIfMissing<IDependencyResolver>(std::make_shared<LibsolvDependencyResolver>(_impl->services.Resolve<ILogger>()));
-	//_impl->services.RegisterInstanceIfMissing<IExtensionLifecycle>(std::make_shared<DummyLifecycle>());
+	// Build() registers them once the config file is merged, doing it here
+	// would fix them to the configuration known so far
 	return *this;
 }
 
@@ -440,9 +479,20 @@ Result<std::shared_ptr<Plugify>> PlugifyBuilder::Build() {
 	}
 
 	// 8. Set up services with defaults
-	WithDefaults();
+	RegisterDefaults(_impl->services, finalConfig);
+
+	// 9. Tee the logger into the flight recorder
+	if (finalConfig.logging.flightRecorder) {
+		auto recorder = FlightRecorder::Create(finalConfig.paths.logsDir / "flight.rec", finalConfig.logging.flightRecorderSize);
+		if (!recorder) {
+			return MakeError(std::move(recorder.error()));
+		}
+		auto logger = _impl->services.Resolve<ILogger>();
+		_impl->services.RegisterInstance<ILogger>(std::make_shared<FlightRecorderLogger>(std::move(logger), *recorder));
+		_impl->services.RegisterInstance<FlightRecorder>(std::move(*recorder));
+	}
 
-	// 9. Create Plugify instance
+	// 10. Create Plugify instance
 	return std::make_shared<Plugify>(std::move(_impl->services), std::move(finalConfig));
 }
 
@@ -12,31 +12,55 @@ struct Provider::Impl {
 	const Manager& manager;
 };
 
+// The level is not copied: the logger holds the one every provider filters by
 Provider::Provider(const ServiceLocator& services, const Config& config, const Manager& manager)
-	: _impl(std::make_unique<Impl>(services, config, manager)) {
+	: _impl(std::make_unique<Impl>(services, config, manager))
+	, _logger(services.Get<ILogger>()) {
 }
 
 Provider::~Provider() = default;
 
 Provider::Provider(const Provider& other)
-	: _impl(std::make_unique<Impl>(*other._impl)) {
+	: _impl(std::make_unique<Impl>(*other._impl))
+	, _logger(other._logger) {
 }
 
-Provider::Provider(Provider&& other) noexcept = default;
+Provider::Provider(Provider&& other) noexcept
+	: _impl(std::move(other._impl))
+	, _logger(other._logger) {
+}
 
 Provider& Provider::operator=(const Provider& other) {
 	if (this != &other) {
 		_impl = std::make_unique<Impl>(*other._impl);
+		_logger = other._logger;
 	}
 	return *this;
 }
 
-Provider& Provider::operator=(Provider&& other) noexcept = default;
+Provider& Provider::operator=(Provider&& other) noexcept {
+	if (this != &other) {
+		_impl = std::move(other._impl);
+		_logger = other._logger;
+	}
+	return *this;
+}
 
 void Provider::Log(std::string_view msg, Severity sev, const Location& loc) const {
-	if (auto logger = _impl->services.Resolve<ILogger>()) {
-		logger->Log(msg, sev, loc);
+	if (!_logger || (sev != Severity::Unknown && sev < _logger->GetLogLevel())) {
+		return;
 	}
+	_logger->Log(msg, sev, loc);
+}
+
+void Provider::SetLogLevel(Severity minSeverity) const {
+	if (_logger) {
+		_logger->SetLogLevel(minSeverity);
+	}
+}
+
+Severity Provider::GetLogLevel() const noexcept {
+	return _logger ? _logger->GetLogLevel() : Severity::Unknown;
 }
 
 bool Provider::IsPreferOwnSymbols() const noexcept {
@@ -83,9 +107,26 @@ std::vector<const Extension*> Provider::GetExtensions() const {
 	return _impl->manager.GetExtensions();
 }
 
-bool Provider::operator==(const Provider& other) const noexcept = default;
+std::span<const MethodData> Provider::FindMethods(std::string_view plugin) const {
+	return _impl->manager.FindMethods(plugin);
+}
 
-auto Provider::operator<=>(const Provider& other) const noexcept = default;
+const MethodData* Provider::FindMethod(std::string_view plugin, std::string_view method) const {
+	return _impl->manager.FindMethod(plugin, method);
+}
+
+JitStats Provider::GetJitStats() const {
+	return JitContext::GetStats();
+}
+
+// The logger and level are derived from the services, identity is the Impl
+bool Provider::operator==(const Provider& other) const noexcept {
+	return _impl == other._impl;
+}
+
+auto Provider::operator<=>(const Provider& other) const noexcept {
+	return _impl <=> other._impl;
+}
 
 const ServiceLocator& Provider::GetServices() const noexcept {
 	return _impl->services;
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <memory>
+
+namespace plugify {
+	// Bounded lock-free MPMC queue (Dmitry Vyukov's sequence based ring).
+	// Each cell carries a sequence number which tells producers and consumers
+	// whether the slot is free or published, so no locks are needed.
+	// Capacity is rounded up to a power of two.
+	template <typename T>
+	class RingQueue {
+		static constexpr size_t kCacheLine = 64;
+
+		struct Cell {
+			std::atomic<size_t> sequence;
+			T data;
+		};
+
+	public:
+		explicit RingQueue(size_t capacity)
+			: _capacity(std::bit_ceil(capacity < 2 ? size_t{ 2 } : capacity))
+			, _mask(_capacity - 1)
+			, _buffer(std::make_unique<Cell[]>(_capacity)) {
+			for (size_t i = 0; i < _capacity; ++i) {
+				_buffer[i].sequence.store(i, std::memory_order_relaxed);
+			}
+		}
+
+		RingQueue(const RingQueue&) = delete;
+		RingQueue& operator=(const RingQueue&) = delete;
+
+		template <typename U>
+		bool TryPush(U&& value) {
+			Cell* cell;
+			size_t pos = _enqueuePos.load(std::memory_order_relaxed);
+			while (true) {
+				cell = &_buffer[pos & _mask];
+				size_t seq = cell->sequence.load(std::memory_order_acquire);
+				auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+				if (diff == 0) {
+					if (_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+						break;
+					}
+				} else if (diff < 0) {
+					return false; // full
+				} else {
+					pos = _enqueuePos.load(std::memory_order_relaxed);
+				}
+			}
+			cell->data = std::forward<U>(value);
+			cell->sequence.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+
+		bool TryPop(T& value) {
+			Cell* cell;
+			size_t pos = _dequeuePos.load(std::memory_order_relaxed);
+			while (true) {
+				cell = &_buffer[pos & _mask];
+				size_t seq = cell->sequence.load(std::memory_order_acquire);
+				auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+				if (diff == 0) {
+					if (_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+						break;
+					}
+				} else if (diff < 0) {
+					return false; // empty
+				} else {
+					pos = _dequeuePos.load(std::memory_order_relaxed);
+				}
+			}
+			value = std::move(cell->data);
+			cell->sequence.store(pos + _mask + 1, std::memory_order_release);
+			return true;
+		}
+
+		size_t Capacity() const noexcept {
+			return _capacity;
+		}
+
+		// Approximate, only meaningful when producers and consumers are quiet
+		size_t SizeApprox() const noexcept {
+			size_t head = _dequeuePos.load(std::memory_order_relaxed);
+			size_t tail = _enqueuePos.load(std::memory_order_relaxed);
+			return tail >= head ? tail - head : 0;
+		}
+
+		bool EmptyApprox() const noexcept {
+			return SizeApprox() == 0;
+		}
+
+	private:
+		const size_t _capacity;
+		const size_t _mask;
+		std::unique_ptr<Cell[]> _buffer;
+		alignas(kCacheLine) std::atomic<size_t> _enqueuePos{ 0 };
+		alignas(kCacheLine) std::atomic<size_t> _dequeuePos{ 0 };
+	};
+}
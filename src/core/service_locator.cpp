@@ -3,6 +3,29 @@
 
 using namespace plugify;
 
+namespace {
+	// Slots are handed out process-wide, so a type has the same one in every locator
+	struct SlotRegistry {
+		std::mutex mutex;
+		std::unordered_map<std::type_index, size_t> slots;
+
+		size_t SlotOf(std::type_index type) {
+			std::lock_guard lock(mutex);
+			return slots.try_emplace(type, slots.size()).first->second;
+		}
+
+		size_t Count() {
+			std::lock_guard lock(mutex);
+			return slots.size();
+		}
+	};
+
+	SlotRegistry& GetSlotRegistry() {
+		static SlotRegistry registry;
+		return registry;
+	}
+}
+
 // ============================================
 // Implementation struct
 // ============================================
@@ -16,6 +39,10 @@ struct ServiceLocator::Impl {
 	std::unordered_map<std::type_index, ServiceDescriptor> services;
 	mutable std::shared_mutex mutex;
 
+	// Once set, services is never written again and is read without the lock
+	std::atomic<bool> sealed{ false };
+	std::vector<void*> table;
+
 	// Stack of scopes (thread_local for thread safety)
 	static inline thread_local std::vector<
 		std::unordered_map<std::type_index, std::shared_ptr<void>>
@@ -33,6 +60,7 @@ struct ServiceLocator::Impl {
 		}
 
 		std::unique_lock lock(mutex);
+		ThrowIfSealed(type);
 
 		services[type] = {
 			.factory = [instance] { return instance; },
@@ -53,6 +81,7 @@ struct ServiceLocator::Impl {
 		}
 
 		std::unique_lock lock(mutex);
+		ThrowIfSealed(type);
 
 		ServiceDescriptor descriptor{
 			.factory = std::move(factory),
@@ -69,7 +98,7 @@ struct ServiceLocator::Impl {
 	}
 
 	Result<std::shared_ptr<void>> ResolveInternal(std::type_index type) const noexcept {
-		std::shared_lock lock(mutex);
+		auto lock = LockShared();
 
 		auto it = services.find(type);
 		if (it == services.end()) {
@@ -123,11 +152,47 @@ struct ServiceLocator::Impl {
 		return *result;
 	}
 
+	void* Get(std::type_index type) const noexcept {
+		auto lock = LockShared();
+
+		auto it = services.find(type);
+		if (it == services.end() || it->second.lifetime != ServiceLifetime::Singleton) {
+			return nullptr;
+		}
+		return it->second.singleton.get();
+	}
+
 	bool IsRegistered(std::type_index type) const {
-		std::shared_lock lock(mutex);
+		auto lock = LockShared();
 		return services.contains(type);
 	}
 
+	std::span<void* const> Seal() {
+		std::unique_lock lock(mutex);
+
+		if (!sealed.load(std::memory_order_relaxed)) {
+			auto& registry = GetSlotRegistry();
+
+			std::vector<std::pair<size_t, void*>> singletons;
+			singletons.reserve(services.size());
+			for (const auto& [type, descriptor] : services) {
+				if (descriptor.lifetime == ServiceLifetime::Singleton) {
+					singletons.emplace_back(registry.SlotOf(type), descriptor.singleton.get());
+				}
+			}
+
+			// slots handed out later are past the end and read as missing
+			table.assign(registry.Count(), nullptr);
+			for (const auto& [slot, instance] : singletons) {
+				table[slot] = instance;
+			}
+
+			sealed.store(true, std::memory_order_release);
+		}
+
+		return table;
+	}
+
 	void BeginScope() {
 		scopeStack.emplace_back();
 	}
@@ -139,16 +204,37 @@ struct ServiceLocator::Impl {
 		scopeStack.pop_back();
 	}
 
+	// Lock-free readers may hold the table and the services once sealed,
+	// so they stay untouched for the lifetime of the locator
 	void Clear() {
 		std::unique_lock lock(mutex);
+		if (sealed.load(std::memory_order_relaxed)) {
+			throw std::logic_error("ServiceLocator is sealed: cannot clear it");
+		}
 		services.clear();
 		scopeStack.clear();
 	}
 
 	size_t Count() const {
-		std::shared_lock lock(mutex);
+		auto lock = LockShared();
 		return services.size();
 	}
+
+private:
+	std::shared_lock<std::shared_mutex> LockShared() const {
+		if (sealed.load(std::memory_order_acquire)) {
+			return {};
+		}
+		return std::shared_lock(mutex);
+	}
+
+	void ThrowIfSealed(std::type_index type) const {
+		if (sealed.load(std::memory_order_relaxed)) {
+			throw std::logic_error(
+				std::format("ServiceLocator is sealed: cannot register type '{}'", type.name())
+			);
+		}
+	}
 };
 
 // ============================================
@@ -160,8 +246,21 @@ ServiceLocator::ServiceLocator()
 
 ServiceLocator::~ServiceLocator() = default;
 
-ServiceLocator::ServiceLocator(ServiceLocator&&) noexcept = default;
-ServiceLocator& ServiceLocator::operator=(ServiceLocator&&) noexcept = default;
+// The sealed table lives in the Impl, so it follows it
+ServiceLocator::ServiceLocator(ServiceLocator&& other) noexcept
+	: _impl(std::move(other._impl))
+	, _slots(other._slots.exchange(nullptr))
+	, _slotCount(other._slotCount.exchange(0)) {
+}
+
+ServiceLocator& ServiceLocator::operator=(ServiceLocator&& other) noexcept {
+	if (this != &other) {
+		_impl = std::move(other._impl);
+		_slotCount.store(other._slotCount.exchange(0), std::memory_order_relaxed);
+		_slots.store(other._slots.exchange(nullptr), std::memory_order_release);
+	}
+	return *this;
+}
 
 void ServiceLocator::RegisterInstanceInternal(std::type_index type, std::shared_ptr<void> instance) {
 	_impl->RegisterInstance(type, std::move(instance));
@@ -187,6 +286,18 @@ bool ServiceLocator::IsRegisteredInternal(std::type_index type) const {
 	return _impl->IsRegistered(type);
 }
 
+void* ServiceLocator::GetInternal(std::type_index type) const noexcept {
+	return _impl->Get(type);
+}
+
+size_t ServiceLocator::SlotOfInternal(std::type_index type) noexcept {
+	try {
+		return GetSlotRegistry().SlotOf(type);
+	} catch (...) {
+		return kNoSlot;
+	}
+}
+
 void ServiceLocator::BeginScope() {
 	_impl->BeginScope();
 }
@@ -195,6 +306,16 @@ void ServiceLocator::EndScope() {
 	_impl->EndScope();
 }
 
+void ServiceLocator::Seal() {
+	auto table = _impl->Seal();
+	_slotCount.store(table.size(), std::memory_order_relaxed);
+	_slots.store(table.data(), std::memory_order_release);
+}
+
+bool ServiceLocator::IsSealed() const noexcept {
+	return _impl->sealed.load(std::memory_order_acquire);
+}
+
 void ServiceLocator::Clear() {
 	_impl->Clear();
 }
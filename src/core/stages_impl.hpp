@@ -4,6 +4,7 @@
 #include "core/pipeline.hpp"
 #include "core/stages.hpp"
 #include "core/glaze_metadata.hpp"
+#include "core/method_registry.hpp"
 
 namespace plugify {
 	// ============================================================================
@@ -509,7 +510,8 @@ namespace plugify {
 	// ============================================================================
 
 	class ExportingStage : public BaseFailurePropagatingStage<ExportingStage> {
-		std::vector<const Extension*> _runningModules;
+		// Plugin id -> running language modules hosting its dependents
+		ExportConsumers _consumers;
 
 	public:
 		using BaseFailurePropagatingStage::BaseFailurePropagatingStage;
@@ -527,12 +529,7 @@ namespace plugify {
 			std::span<Extension> items,
 			[[maybe_unused]] const ExecutionContext<Extension>& ctx
 		) override {
-			for (const auto& ext : items) {
-				if (ext.GetType() == ExtensionType::Module
-					&& ext.GetState() == ExtensionState::Running) {
-					_runningModules.push_back(&ext);
-				}
-			}
+			_consumers = MapExportConsumers(items, _reverseDepGraph);
 		}
 
 		Result<void> DoProcessItem(
@@ -543,12 +540,15 @@ namespace plugify {
 		) {
 			ext.StartOperation(ExtensionState::Exporting);
 
-			for (const auto& module : _runningModules) {
-				auto result = _loader.MethodExport(*module, ext);
-				if (!result) {
-					HandleOperationFailure(ext, result, ExtensionState::Failed);
-					return result;
-				}
+			std::span<const Extension* const> consumers;
+			if (auto it = _consumers.find(ext.GetId()); it != _consumers.end()) {
+				consumers = it->second;
+			}
+
+			auto result = _loader.MethodExport(ext, consumers);
+			if (!result) {
+				HandleOperationFailure(ext, result, ExtensionState::Failed);
+				return result;
 			}
 
 			ext.EndOperation(ExtensionState::Exported);
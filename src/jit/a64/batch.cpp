@@ -0,0 +1,337 @@
+#include <algorithm>
+
+#include <asmjit/a64.h>
+
+#include "plugify/jit_batch.hpp"
+
+#include "../helpers.hpp"
+#include "../runtime.hpp"
+#include "../stats.hpp"
+#include "../stub_cache.hpp"
+#include "emitters.hpp"
+
+using namespace plugify;
+using namespace asmjit;
+
+struct JitBatch::Impl {
+	enum class EntryKind : uint8_t { Call, Callback };
+
+	struct Entry {
+		EntryKind kind;
+		Signature signature;
+		Address target;  // call target or callback user data
+		const Method* method{};
+		JitCallback::CallbackHandler callback{};
+		JitCall::WaitType waitType{};
+		bool hidden{};
+		void* stub{};  // shared generic stub of a call entry
+		Label label;
+		Address function;
+		std::string name;  // method of a call, only kept for profilers
+	};
+
+	~Impl() {
+		ReleaseCode(block);
+	}
+
+	bool Compile() {
+		if (compiled) {
+			errorCode = "Batch is already compiled";
+			return false;
+		}
+		compiled = true;
+
+		if (entries.empty()) {
+			return true;
+		}
+
+		// the whole batch is one compilation, recorded once it succeeded
+		CompileTimer timer;
+		timer.Start();
+
+		if (!ResolveGenericStubs()) {
+			return false;
+		}
+
+		if (!CompileBlock()) {
+			return false;
+		}
+
+		timer.Stop();
+		timer.Record();
+		RecordStubs();
+		return true;
+	}
+
+	void RecordStubs() const {
+		auto& stats = JitStatistics::Instance();
+		for (const auto& entry : entries) {
+			stats.RecordStub(entry.kind == EntryKind::Call ? JitStubKind::Call : JitStubKind::Callback, entry.signature, entry.hidden);
+		}
+	}
+
+	// Looks up the generic stub of every call entry, the signatures not seen before
+	// are loaded from disk or compiled, then published to the shared cache with a single commit
+	bool ResolveGenericStubs() {
+		auto& cache = StubCache::Instance();
+
+		std::unordered_map<StubKey, std::vector<Entry*>, StubKeyHash> missing;
+		for (auto& entry : entries) {
+			if (entry.kind != EntryKind::Call) {
+				continue;
+			}
+			if (entry.waitType != JitCall::WaitType::None) {
+				// Debug stubs are not relocatable, take the regular path
+				entry.stub = GetGenericCallStub(entry.signature, entry.waitType, entry.hidden, errorCode);
+				if (!entry.stub) {
+					return false;
+				}
+				continue;
+			}
+			StubKey key(GetCallStubKind(static_cast<uint8_t>(entry.waitType)), entry.signature, static_cast<uint8_t>(entry.waitType), entry.hidden);
+			if (void* stub = cache.Find(key)) {
+				entry.stub = stub;
+			} else {
+				missing[std::move(key)].push_back(&entry);
+			}
+		}
+
+		if (missing.empty()) {
+			return true;
+		}
+
+		auto& rt = GetJitRuntime();
+
+		SimpleErrorHandler eh;
+		CodeHolder code;
+		code.init(rt.environment(), rt.cpu_features());
+		code.set_error_handler(&eh);
+
+		std::vector<std::tuple<const StubKey*, Label, size_t>> labels;
+		labels.reserve(missing.size());
+		{
+			a64::Assembler a(&code);
+			std::vector<uint8_t> bytes;
+			// already covered by the timer of the batch
+			CompileTimer generic;
+			for (const auto& [key, users] : missing) {
+				const Entry& first = *users.front();
+				if (!LoadOrCompileGenericCode(key, first.signature, first.hidden, bytes, generic, errorCode)) {
+					return false;
+				}
+				a.align(AlignMode::kCode, 16);
+				Label label = a.new_label();
+				a.bind(label);
+				a.embed(bytes.data(), bytes.size());
+				labels.emplace_back(&key, label, bytes.size());
+			}
+		}
+
+		// Generic stubs are owned by the cache and never released
+		auto base = static_cast<uint8_t*>(CommitCode(code));
+		if (eh.error != Error::kOk || !base) {
+			errorCode = eh.code ? eh.code : "Failed to commit code";
+			return false;
+		}
+
+		// Another thread may have published some of the keys meanwhile. The block
+		// is released when it lost all of them, otherwise the stubs that lost stay
+		// unused inside it, bounded by the size of the block.
+		auto& profiler = JitProfiler::Instance();
+		bool kept = false;
+		for (const auto& [key, label, size] : labels) {
+			const auto& users = missing[*key];
+			uint8_t* stubCode = base + code.label_offset(label);
+			void* stub = cache.Insert(*key, stubCode);
+			for (Entry* entry : users) {
+				entry->stub = stub;
+			}
+			if (stub == stubCode) {
+				kept = true;
+				JitStatistics::Instance().RecordStub(JitStubKind::Generic, users.front()->signature, users.front()->hidden);
+				if (profiler.IsEnabled()) {
+					profiler.AddSymbol(stubCode, size, { "generic", &users.front()->signature, users.front()->hidden });
+				}
+			}
+		}
+		if (!kept) {
+			ReleaseCode(base);
+		}
+
+		return true;
+	}
+
+	// Emits callbacks with the compiler, then appends
+	// the call thunks with an assembler into the same holder and commits everything at once
+	bool CompileBlock() {
+		auto& rt = GetJitRuntime();
+
+		SimpleErrorHandler eh;
+		CodeHolder code;
+		code.init(rt.environment(), rt.cpu_features());
+		code.set_error_handler(&eh);
+
+		{
+			a64::Compiler cc(&code);
+			bool hasFuncs = false;
+			for (auto& entry : entries) {
+				FuncNode* func = nullptr;
+				if (entry.kind == EntryKind::Callback) {
+					func = EmitCallbackStub(cc, entry.signature, entry.method, entry.callback, entry.target, entry.hidden, errorCode);
+				} else {
+					continue;  // bound to its generic stub by a thunk below
+				}
+
+				if (!func) {
+					return false;
+				}
+				entry.label = func->label();
+				hasFuncs = true;
+			}
+
+			if (hasFuncs) {
+				// write to buffer
+				cc.finalize();
+			}
+		}
+
+		{
+			a64::Assembler a(&code);
+			for (auto& entry : entries) {
+				if (entry.kind != EntryKind::Call) {
+					continue;
+				}
+				a.align(AlignMode::kCode, 16);
+				entry.label = a.new_label();
+				a.bind(entry.label);
+				EmitBindThunk(a, entry.stub, entry.target);
+			}
+		}
+
+		auto base = static_cast<uint8_t*>(CommitCode(code));
+		if (eh.error != Error::kOk || !base) {
+			errorCode = eh.code ? eh.code : "Failed to commit code";
+			return false;
+		}
+
+		block = base;
+		for (auto& entry : entries) {
+			entry.function = base + code.label_offset(entry.label);
+		}
+
+		if (JitProfiler::Instance().IsEnabled()) {
+			AddSymbols(base + code.text_section()->real_size());
+		}
+
+		return true;
+	}
+
+	// Stubs are laid out back to back, so each one extends up to the next
+	void AddSymbols(const uint8_t* end) const {
+		std::vector<const Entry*> sorted;
+		sorted.reserve(entries.size());
+		for (const auto& entry : entries) {
+			sorted.push_back(&entry);
+		}
+		std::ranges::sort(sorted, {}, [](const Entry* entry) { return entry->function.As<const uint8_t*>(); });
+
+		auto& profiler = JitProfiler::Instance();
+		for (size_t i = 0; i < sorted.size(); ++i) {
+			const Entry& entry = *sorted[i];
+			const auto* code = entry.function.As<const uint8_t*>();
+			const auto* next = i + 1 < sorted.size() ? sorted[i + 1]->function.As<const uint8_t*>() : end;
+			profiler.AddSymbol(code, static_cast<size_t>(next - code), {
+				entry.kind == EntryKind::Call ? "call" : "callback",
+				&entry.signature,
+				entry.hidden,
+				entry.method ? std::string_view(entry.method->GetName()) : std::string_view(entry.name),
+			});
+		}
+	}
+
+	std::vector<Entry> entries;
+	void* block{};
+	const char* errorCode{};
+	bool compiled{};
+};
+
+JitBatch::JitBatch()
+	: _impl(std::make_unique<Impl>()) {
+}
+
+JitBatch::JitBatch(JitBatch&& other) noexcept = default;
+
+JitBatch::~JitBatch() = default;
+
+JitBatch& JitBatch::operator=(JitBatch&& other) noexcept = default;
+
+size_t JitBatch::AddCall(const Signature& signature, Address target, JitCall::WaitType waitType, bool hidden) {
+	auto& entries = _impl->entries;
+	entries.push_back({
+		.kind = Impl::EntryKind::Call,
+		.signature = signature,
+		.target = target,
+		.waitType = waitType,
+		.hidden = hidden,
+	});
+	return entries.size() - 1;
+}
+
+size_t JitBatch::AddCall(const Method& method, Address target, JitCall::WaitType waitType, JitCall::HiddenParam hidden) {
+	bool retHidden;
+	Signature signature = MakeSignature(method, hidden, retHidden);
+
+	size_t index = AddCall(signature, target, waitType, retHidden);
+	if (JitProfiler::Instance().IsEnabled()) {
+		_impl->entries[index].name = method.GetName();
+	}
+	return index;
+}
+
+size_t JitBatch::AddCallback(
+	const Signature& signature,
+	const Method* method,
+	JitCallback::CallbackHandler callback,
+	Address data,
+	bool hidden
+) {
+	auto& entries = _impl->entries;
+	entries.push_back({
+		.kind = Impl::EntryKind::Callback,
+		.signature = signature,
+		.target = data,
+		.method = method,
+		.callback = callback,
+		.hidden = hidden,
+	});
+	return entries.size() - 1;
+}
+
+size_t JitBatch::AddCallback(
+	const Method& method,
+	JitCallback::CallbackHandler callback,
+	Address data,
+	JitCallback::HiddenParam hidden
+) {
+	bool retHidden;
+	Signature signature = MakeSignature(method, hidden, retHidden);
+
+	return AddCallback(signature, &method, callback, data, retHidden);
+}
+
+bool JitBatch::Compile() {
+	return _impl->Compile();
+}
+
+Address JitBatch::GetFunction(size_t index) const noexcept {
+	const auto& entries = _impl->entries;
+	return index < entries.size() ? entries[index].function : Address{};
+}
+
+size_t JitBatch::GetSize() const noexcept {
+	return _impl->entries.size();
+}
+
+std::string_view JitBatch::GetError() const noexcept {
+	return _impl->errorCode ? _impl->errorCode : "";
+}
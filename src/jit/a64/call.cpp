@@ -1,50 +1,141 @@
+#include <atomic>
+
 #include <asmjit/a64.h>
 
 #include "plugify/call.hpp"
 
 #include "../helpers.hpp"
+#include "../disk_cache.hpp"
+#include "../runtime.hpp"
+#include "../stats.hpp"
+#include "../stub_cache.hpp"
+#include "emitters.hpp"
 
 using namespace plugify;
 using namespace asmjit;
 
-static JitRuntime rt;
+namespace plugify {
+	using ArgRegisters = std::inplace_vector<Reg, Globals::kMaxFuncArgs>;
+
+	// map argument slots of the params block to registers, following abi. (We can have multiple
+	// register per arg slot such as the members of a by-value vector)
+	static bool LoadCallArgs(
+		a64::Compiler& cc,
+		const Signature& signature,
+		const FuncSignature& sig,
+		const a64::Gp& params,
+		int32_t offset,
+		ArgRegisters& argRegisters,
+		const char*& error
+	) {
+		uint32_t argIdx = 0;
+		for (const auto& valueType : signature.argTypes) {
+			a64::Mem paramMem = ptr(params, offset);
 
-struct JitCall::Impl {
-	Impl()
-		: function(nullptr)
-		, targetFunc(nullptr) {
+			// next structure slot (+= sizeof(uint64_t))
+			offset += sizeof(uint64_t);
+
+			if (auto parts = GetStructArgParts(valueType); parts.count != 0) {
+				// slot holds a pointer to the struct, load each member into its own register
+				a64::Gp structPtr = cc.new_gpz();
+				cc.ldr(structPtr, paramMem);
+
+				for (uint32_t part = 0; part < parts.count; ++part, ++argIdx) {
+					Reg arg = cc.new_vec(parts.types[part]);
+					cc.ldr(arg.as<a64::Vec>(), ptr(structPtr, static_cast<int32_t>(parts.offsets[part])));
+					argRegisters.push_back(std::move(arg));
+				}
+				continue;
+			}
+
+			const auto& argType = sig.args()[argIdx++];
+
+			Reg arg;
+			if (TypeUtils::is_int(argType)) {
+				arg = cc.new_gp(argType);
+				cc.ldr(arg.as<a64::Gp>(), paramMem);
+			} else if (TypeUtils::is_float(argType)) {
+				arg = cc.new_vec(argType);
+				cc.ldr(arg.as<a64::Vec>(), paramMem);
+			} else {
+				// ex: void example(__m128i xmmreg) is invalid:
+				// https://github.com/asmjit/asmjit/issues/83
+				error = "Parameters wider than 64bits not supported";
+				return false;
+			}
+
+			argRegisters.push_back(std::move(arg));
+		}
+
+		return true;
 	}
 
-	~Impl() {
-		if (function) {
-			rt.release(function);
+	// Map call params to the args
+	static void BindCallArgs(InvokeNode* invokeNode, const FuncSignature& sig, const ArgRegisters& argRegisters) {
+		for (uint32_t argIdx = 0; argIdx < sig.arg_count(); ++argIdx) {
+			invokeNode->set_arg(argIdx, argRegisters.at(argIdx));
 		}
 	}
 
-	Address GetJitFunc(const Signature& signature, Address target, WaitType waitType, bool hidden) {
-		if (function) {
-			return function;
+	// Stores the result of the call into the Return pointed by returnImm
+	static void StoreCallRet(a64::Compiler& cc, const FuncSignature& sig, InvokeNode* invokeNode, const a64::Gp& returnImm) {
+		if (!sig.has_ret()) {
+			return;
 		}
 
-		targetFunc = target;
+		if (TypeUtils::is_int(sig.ret())) {
+			a64::Gp tmp = cc.new_gp(sig.ret());
+			invokeNode->set_ret(0, tmp);
+			cc.str(tmp, ptr(returnImm));
+		} else if (TypeUtils::is_between(sig.ret(), TypeId::kInt8x16, TypeId::kUInt64x2)) {
+			cc.str(a64::x0, ptr(returnImm));
+			cc.str(a64::x1, ptr(returnImm, sizeof(uint64_t)));
+		} else if (sig.ret() == TypeId::kFloat32x2) {  // Vector2
+			cc.str(a64::s0, ptr(returnImm));
+			cc.str(a64::s1, ptr(returnImm, sizeof(float)));
+		} else if (sig.ret() == TypeId::kFloat64x2) {  // Vector3
+			cc.str(a64::s0, ptr(returnImm));
+			cc.str(a64::s1, ptr(returnImm, sizeof(float)));
+			cc.str(a64::s2, ptr(returnImm, sizeof(float) * 2));
+		} else if (sig.ret() == TypeId::kFloat32x4) {  // Vector4
+			cc.str(a64::s0, ptr(returnImm));
+			cc.str(a64::s1, ptr(returnImm, sizeof(float)));
+			cc.str(a64::s2, ptr(returnImm, sizeof(float) * 2));
+			cc.str(a64::s3, ptr(returnImm, sizeof(float) * 3));
+		} else {
+			a64::Vec ret = cc.new_vec(sig.ret());
+			invokeNode->set_ret(0, ret);
+			cc.str(ret, ptr(returnImm));
+		}
+	}
 
-		auto sig = ConvertSignature(signature);
+	FuncNode* EmitCallStub(
+		a64::Compiler& cc,
+		const Signature& signature,
+		Address target,
+		JitCall::WaitType waitType,
+		bool hidden,
+		const char*& error
+	) {
+		if (const char* structError = CheckStructArgs(signature)) {
+			error = structError;
+			return nullptr;
+		}
 
-		SimpleErrorHandler eh;
-		CodeHolder code;
-		code.init(rt.environment(), rt.cpu_features());
-		code.set_error_handler(&eh);
+		auto sig = ConvertSignature(signature);
 
 		// initialize function
-		a64::Compiler cc(&code);
-		FuncNode* func = cc.add_func(FuncSignature::build<void, void*, void*>());
+		FuncNode* func = cc.add_func(
+			target ? FuncSignature::build<void, void*, void*>()
+				   : FuncSignature::build<void, void*, void*, void*>()
+		);
 
 #if 0
 		StringLogger log;
 		auto kFormatFlags = FormatFlags::kMachineCode | FormatFlags::kExplainImms | FormatFlags::kRegCasts | FormatFlags::kHexImms | FormatFlags::kHexOffsets | FormatFlags::kPositions;
 
 		log.addFlags(kFormatFlags);
-		code.setLogger(&log);
+		cc.code()->setLogger(&log);
 #endif
 
 #if PLUGIFY_IS_RELEASE
@@ -58,54 +149,32 @@ struct JitCall::Impl {
 		a64::Gp returnImm = cc.new_gpz();
 		func->set_arg(1, returnImm);
 
-		// paramMem = ((char*)paramImm) + i (char* size walk, uint64_t size r/w)
-		a64::Gp i = cc.new_gpz();
-		a64::Mem paramMem = ptr(paramImm, i);
-
-		// i = 0
-		cc.mov(i, 0);
+		a64::Gp targetImm;
+		if (!target) {
+			targetImm = cc.new_gpz();
+			func->set_arg(2, targetImm);
+		}
 
+		int32_t offset = 0;
 		if (hidden) {
 			// load first arg and store its address to ret struct
 			a64::Gp tmp = cc.new_gpz();
-			cc.ldr(tmp, paramMem);
+			cc.ldr(tmp, ptr(paramImm));
 			cc.str(tmp, ptr(returnImm));
 
 			// next structure slot (+= sizeof(uint64_t))
-			cc.add(i, i, sizeof(uint64_t));
+			offset += sizeof(uint64_t);
 		}
 
-		std::inplace_vector<Reg, Globals::kMaxFuncArgs> argRegisters;
-
-		// map argument slots to registers, following abi. (We can have multiple register per arg
-		// slot such as high and low 32bits of a 64bit slot)
-		for (uint32_t argIdx = 0; argIdx < sig.arg_count(); ++argIdx) {
-			const auto& argType = sig.args()[argIdx];
-
-			Reg arg;
-			if (TypeUtils::is_int(argType)) {
-				arg = cc.new_gp(argType);
-				cc.ldr(arg.as<a64::Gp>(), paramMem);
-			} else if (TypeUtils::is_float(argType)) {
-				arg = cc.new_vec(argType);
-				cc.ldr(arg.as<a64::Vec>(), paramMem);
-			} else {
-				// ex: void example(__m128i xmmreg) is invalid:
-				// https://github.com/asmjit/asmjit/issues/83
-				errorCode = "Parameters wider than 64bits not supported";
-				return nullptr;
-			}
-
-			argRegisters.push_back(std::move(arg));
-
-			// next structure slot (+= sizeof(uint64_t))
-			cc.add(i, i, sizeof(uint64_t));
+		ArgRegisters argRegisters;
+		if (!LoadCallArgs(cc, signature, sig, paramImm, offset, argRegisters, error)) {
+			return nullptr;
 		}
 
 		// allows debuggers to trap
-		if (waitType == WaitType::Breakpoint) {
+		if (waitType == JitCall::WaitType::Breakpoint) {
 			cc.brk(0x1);
-		} else if (waitType == WaitType::Wait_Keypress) {
+		} else if (waitType == JitCall::WaitType::Wait_Keypress) {
 			a64::Gp dest = cc.new_gpz();
 			cc.mov(dest, reinterpret_cast<uintptr_t>(&getchar));
 			InvokeNode* invokeNode;
@@ -113,7 +182,11 @@ struct JitCall::Impl {
 		}
 
 		a64::Gp dest = cc.new_gpz();
-		cc.mov(dest, static_cast<uintptr_t>(target));
+		if (target) {
+			cc.mov(dest, static_cast<uintptr_t>(target));
+		} else {
+			cc.mov(dest, targetImm);
+		}
 
 		if (hidden) {
 			a64::Gp tmp = cc.new_gpz();
@@ -127,70 +200,592 @@ struct JitCall::Impl {
 		InvokeNode* invokeNode;
 		cc.invoke(Out(invokeNode), dest, sig);
 
-		// Map call params to the args
-		for (uint32_t argIdx = 0; argIdx < sig.arg_count(); ++argIdx) {
-			invokeNode->set_arg(argIdx, argRegisters.at(argIdx));
+		BindCallArgs(invokeNode, sig, argRegisters);
+
+		StoreCallRet(cc, sig, invokeNode, returnImm);
+
+		cc.ret();
+
+		// end of the function body
+		cc.end_func();
+
+		return func;
+	}
+
+	FuncNode* EmitLoopCallStub(
+		a64::Compiler& cc,
+		const Signature& signature,
+		LoopCallKind kind,
+		bool hidden,
+		const char*& error
+	) {
+		if (kind == LoopCallKind::Shared && hidden) {
+			error = kSharedHiddenError;
+			return nullptr;
+		}
+		if (const char* structError = CheckStructArgs(signature)) {
+			error = structError;
+			return nullptr;
+		}
+
+		auto sig = ConvertSignature(signature);
+
+		// void(params, paramStride, rets, retStride, targets, targetStride, count)
+		FuncNode* func = cc.add_func(FuncSignature::build<void, const void*, size_t, void*, size_t, const void*, size_t, size_t>());
+
+		a64::Gp params = cc.new_gpz("params");
+		a64::Gp paramStride = cc.new_gpz("paramStride");
+		a64::Gp rets = cc.new_gpz("rets");
+		a64::Gp retStride = cc.new_gpz("retStride");
+		a64::Gp targets = cc.new_gpz("targets");
+		a64::Gp targetStride = cc.new_gpz("targetStride");
+		a64::Gp count = cc.new_gpz("count");
+		func->set_arg(0, params);
+		func->set_arg(1, paramStride);
+		func->set_arg(2, rets);
+		func->set_arg(3, retStride);
+		func->set_arg(4, targets);
+		func->set_arg(5, targetStride);
+		func->set_arg(6, count);
+
+		if (hidden) {
+			func->frame().add_unavailable_regs(a64::x8);
+		}
+
+		Label loop = cc.new_label();
+		Label done = cc.new_label();
+
+		cc.cbz(count, done);
+
+		const int32_t offset = hidden ? sizeof(uint64_t) : 0;
+
+		// shared arguments are loaded once, the register allocator keeps them alive across calls
+		a64::Gp hiddenPtr = cc.new_gpz("hiddenPtr");
+		ArgRegisters sharedArgs;
+		if (kind == LoopCallKind::Shared) {
+			if (hidden) {
+				cc.ldr(hiddenPtr, ptr(params));
+			}
+			if (!LoadCallArgs(cc, signature, sig, params, offset, sharedArgs, error)) {
+				return nullptr;
+			}
+		}
+
+		cc.bind(loop);
+
+		ArgRegisters argRegisters;
+		if (kind == LoopCallKind::Each) {
+			if (hidden) {
+				cc.ldr(hiddenPtr, ptr(params));
+			}
+			if (!LoadCallArgs(cc, signature, sig, params, offset, argRegisters, error)) {
+				return nullptr;
+			}
 		}
 
+		a64::Gp dest = cc.new_gpz("target");
+		cc.ldr(dest, ptr(targets));
+
+		if (hidden) {
+			// the hidden return pointer is also the returned value
+			cc.str(hiddenPtr, ptr(rets));
+			cc.mov(a64::x8, hiddenPtr);
+		}
+
+		InvokeNode* invokeNode;
+		cc.invoke(Out(invokeNode), dest, sig);
+		BindCallArgs(invokeNode, sig, kind == LoopCallKind::Shared ? sharedArgs : argRegisters);
+
+		StoreCallRet(cc, sig, invokeNode, rets);
+
+		cc.add(params, params, paramStride);
+		cc.add(rets, rets, retStride);
+		cc.add(targets, targets, targetStride);
+		cc.subs(count, count, 1);
+		cc.b_ne(loop);
+
+		cc.bind(done);
+		cc.ret();
+
+		// end of the function body
+		cc.end_func();
+
+		return func;
+	}
+
+	bool CanAssembleCallStub(const Signature& signature) noexcept {
+		// Apple passes variadic arguments on the stack, left to the compiler
+		return signature.varIndex == Signature::kNoVarArgs;
+	}
+
+	// Integers up to 32 bits live in w registers, as the compiler allocates them
+	static bool IsNarrowInt(TypeId typeId) noexcept {
+		return TypeUtils::is_between(typeId, TypeId::kInt8, TypeId::kUInt32);
+	}
+
+	// Loads one argument of the call from memory into the register or stack slot the ABI assigns to it
+	static void LoadAssembledArg(a64::Assembler& a, const FuncValue& arg, TypeId typeId, const a64::Mem& src) {
+		static const std::array<a64::Gp, 8> kXRegs = { a64::x0, a64::x1, a64::x2, a64::x3, a64::x4, a64::x5, a64::x6, a64::x7 };
+		static const std::array<a64::Gp, 8> kWRegs = { a64::w0, a64::w1, a64::w2, a64::w3, a64::w4, a64::w5, a64::w6, a64::w7 };
+		static const std::array<a64::Vec, 8> kSRegs = { a64::s0, a64::s1, a64::s2, a64::s3, a64::s4, a64::s5, a64::s6, a64::s7 };
+		static const std::array<a64::Vec, 8> kDRegs = { a64::d0, a64::d1, a64::d2, a64::d3, a64::d4, a64::d5, a64::d6, a64::d7 };
+
+		const bool narrow = IsNarrowInt(typeId) || typeId == TypeId::kFloat32;
+
+		if (arg.is_stack()) {
+			// x11 is a temporary which carries no argument
+			const a64::Gp& temp = narrow ? a64::w11 : a64::x11;
+			a.ldr(temp, src);
+			a.str(temp, a64::ptr(a64::sp, arg.stack_offset()));
+		} else if (TypeUtils::is_float(typeId)) {
+			a.ldr(narrow ? kSRegs[arg.reg_id()] : kDRegs[arg.reg_id()], src);
+		} else {
+			a.ldr(narrow ? kWRegs[arg.reg_id()] : kXRegs[arg.reg_id()], src);
+		}
+	}
+
+	bool EmitAssembledCallStub(
+		a64::Assembler& a,
+		const Signature& signature,
+		bool hidden,
+		const char*& error
+	) {
+		if (const char* structError = CheckStructArgs(signature)) {
+			error = structError;
+			return false;
+		}
+
+		if (!CanAssembleCallStub(signature)) {
+			error = "Signature is not supported by the assembler emitter";
+			return false;
+		}
+
+		auto sig = ConvertSignature(signature);
+
+		// where the ABI places the arguments of the stub itself and of the call it makes,
+		// the same layout the compiler works from
+		FuncDetail stubDetail;
+		FuncDetail callDetail;
+		if (stubDetail.init(FuncSignature::build<void, void*, void*, void*>(), a.environment()) != Error::kOk ||
+			callDetail.init(sig, a.environment()) != Error::kOk) {
+			error = "Failed to lay out the call";
+			return false;
+		}
+
+		// params and the struct pointer use temporaries which never carry an argument,
+		// ret and target are kept in callee-saved registers
+		const a64::Gp params = a64::x9;
+		const a64::Gp structPtr = a64::x10;
+		const a64::Gp returnPtr = a64::x19;
+		const a64::Gp target = a64::x20;
+
+		FuncFrame frame;
+		frame.init(stubDetail);
+		frame.add_attributes(FuncAttributes::kHasFuncCalls);
+		frame.set_call_stack_size(callDetail.arg_stack_size());
+		frame.add_dirty_regs(returnPtr, target);
+		frame.finalize();
+
+		a.emit_prolog(frame);
+
+		// the argument registers of the stub are reused by the call
+		a.mov(params, a64::x0);
+		a.mov(returnPtr, a64::x1);
+		a.mov(target, a64::x2);
+
+		int32_t offset = 0;
+		if (hidden) {
+			// load first arg and store its address to ret struct
+			a.ldr(structPtr, a64::ptr(params));
+			a.str(structPtr, a64::ptr(returnPtr));
+
+			// next structure slot (+= sizeof(uint64_t))
+			offset += sizeof(uint64_t);
+		}
+
+		uint32_t argIdx = 0;
+		for (const auto& valueType : signature.argTypes) {
+			a64::Mem paramMem = a64::ptr(params, offset);
+
+			// next structure slot (+= sizeof(uint64_t))
+			offset += sizeof(uint64_t);
+
+			if (auto parts = GetStructArgParts(valueType); parts.count != 0) {
+				// slot holds a pointer to the struct, load each member into its own register
+				a.ldr(structPtr, paramMem);
+				for (uint32_t part = 0; part < parts.count; ++part, ++argIdx) {
+					LoadAssembledArg(a, callDetail.arg(argIdx), parts.types[part], a64::ptr(structPtr, static_cast<int32_t>(parts.offsets[part])));
+				}
+				continue;
+			}
+
+			const auto& argType = sig.args()[argIdx];
+			if (!TypeUtils::is_int(argType) && !TypeUtils::is_float(argType)) {
+				error = "Parameters wider than 64bits not supported";
+				return false;
+			}
+
+			LoadAssembledArg(a, callDetail.arg(argIdx++), argType, paramMem);
+		}
+
+		if (hidden) {
+			a.ldr(a64::x8, a64::ptr(returnPtr));
+		}
+
+		a.blr(target);
+
+		// Stores the result of the call into the Return pointed by ret
 		if (sig.has_ret()) {
 			if (TypeUtils::is_int(sig.ret())) {
-				a64::Gp tmp = cc.new_gp(sig.ret());
-				invokeNode->set_ret(0, tmp);
-				cc.str(tmp, ptr(returnImm));
+				a.str(IsNarrowInt(sig.ret()) ? a64::w0 : a64::x0, a64::ptr(returnPtr));
 			} else if (TypeUtils::is_between(sig.ret(), TypeId::kInt8x16, TypeId::kUInt64x2)) {
-				cc.str(a64::x0, ptr(returnImm));
-				cc.str(a64::x1, ptr(returnImm, sizeof(uint64_t)));
+				a.str(a64::x0, a64::ptr(returnPtr));
+				a.str(a64::x1, a64::ptr(returnPtr, sizeof(uint64_t)));
 			} else if (sig.ret() == TypeId::kFloat32x2) {  // Vector2
-				cc.str(a64::s0, ptr(returnImm));
-				cc.str(a64::s1, ptr(returnImm, sizeof(float)));
+				a.str(a64::s0, a64::ptr(returnPtr));
+				a.str(a64::s1, a64::ptr(returnPtr, sizeof(float)));
 			} else if (sig.ret() == TypeId::kFloat64x2) {  // Vector3
-				cc.str(a64::s0, ptr(returnImm));
-				cc.str(a64::s1, ptr(returnImm, sizeof(float)));
-				cc.str(a64::s2, ptr(returnImm, sizeof(float) * 2));
+				a.str(a64::s0, a64::ptr(returnPtr));
+				a.str(a64::s1, a64::ptr(returnPtr, sizeof(float)));
+				a.str(a64::s2, a64::ptr(returnPtr, sizeof(float) * 2));
 			} else if (sig.ret() == TypeId::kFloat32x4) {  // Vector4
-				cc.str(a64::s0, ptr(returnImm));
-				cc.str(a64::s1, ptr(returnImm, sizeof(float)));
-				cc.str(a64::s2, ptr(returnImm, sizeof(float) * 2));
-				cc.str(a64::s3, ptr(returnImm, sizeof(float) * 3));
+				a.str(a64::s0, a64::ptr(returnPtr));
+				a.str(a64::s1, a64::ptr(returnPtr, sizeof(float)));
+				a.str(a64::s2, a64::ptr(returnPtr, sizeof(float) * 2));
+				a.str(a64::s3, a64::ptr(returnPtr, sizeof(float) * 3));
 			} else {
-				a64::Vec ret = cc.new_vec(sig.ret());
-				invokeNode->set_ret(0, ret);
-				cc.str(ret, ptr(returnImm));
+				a.str(sig.ret() == TypeId::kFloat32 ? a64::s0 : a64::d0, a64::ptr(returnPtr));
 			}
 		}
 
-		cc.ret();
+		a.emit_epilog(frame);
 
-		// end of the function body
-		cc.end_func();
+		return true;
+	}
+
+	void EmitBindThunk(a64::Assembler& a, void* stub, Address target) {
+		// target -> x2 (third argument), then branch to the generic stub
+		a.mov(a64::x2, static_cast<uint64_t>(static_cast<uintptr_t>(target)));
+		a.mov(a64::x16, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(stub)));
+		a.br(a64::x16);
+	}
+}  // namespace plugify
+
+static void* CompileCallStub(
+	const Signature& signature,
+	Address target,
+	JitCall::WaitType waitType,
+	bool hidden,
+	const char*& error
+) {
+	auto& rt = GetJitRuntime();
+
+	SimpleErrorHandler eh;
+	CodeHolder code;
+	code.init(rt.environment(), rt.cpu_features());
+	code.set_error_handler(&eh);
+
+	a64::Compiler cc(&code);
+	if (!EmitCallStub(cc, signature, target, waitType, hidden, error)) {
+		return nullptr;
+	}
+
+	// write to buffer
+	cc.finalize();
+
+	void* function = CommitCode(code, {
+		target ? "call" : "generic",
+		&signature,
+		hidden,
+		target ? JitSymbolScope::Current() : std::string_view{},
+	});
+	if (eh.error != Error::kOk || !function) {
+		error = eh.code ? eh.code : "Failed to commit code";
+		return nullptr;
+	}
+
+	return function;
+}
+
+static void* CompileLoopCallStub(
+	const Signature& signature,
+	LoopCallKind kind,
+	bool hidden,
+	const char*& error
+) {
+	auto& rt = GetJitRuntime();
+
+	SimpleErrorHandler eh;
+	CodeHolder code;
+	code.init(rt.environment(), rt.cpu_features());
+	code.set_error_handler(&eh);
+
+	a64::Compiler cc(&code);
+	if (!EmitLoopCallStub(cc, signature, kind, hidden, error)) {
+		return nullptr;
+	}
+
+	// write to buffer
+	cc.finalize();
+
+	void* function = CommitCode(code, { "loop", &signature, hidden });
+	if (eh.error != Error::kOk || !function) {
+		error = eh.code ? eh.code : "Failed to commit code";
+		return nullptr;
+	}
+
+	return function;
+}
+
+static bool CompileGenericCode(
+	const Signature& signature,
+	bool hidden,
+	bool assembled,
+	std::vector<uint8_t>& out,
+	const char*& error
+) {
+	auto& rt = GetJitRuntime();
+
+	SimpleErrorHandler eh;
+	CodeHolder code;
+	code.init(rt.environment(), rt.cpu_features());
+	code.set_error_handler(&eh);
+
+	if (assembled && CanAssembleCallStub(signature)) {
+		// fixed calling sequence written directly, no register allocation
+		a64::Assembler a(&code);
+		if (!EmitAssembledCallStub(a, signature, hidden, error)) {
+			return false;
+		}
+	} else {
+		a64::Compiler cc(&code);
+		if (!EmitCallStub(cc, signature, nullptr, JitCall::WaitType::None, hidden, error)) {
+			return false;
+		}
 
 		// write to buffer
 		cc.finalize();
+	}
 
-		rt.add(&function, &code);
+	if (eh.error != Error::kOk) {
+		error = eh.code;
+		return false;
+	}
 
-		if (eh.error != Error::kOk) {
-			function = nullptr;
-			errorCode = eh.code;
+	// All labels are bound, so without relocations the buffer is the final code
+	if (code.section_count() != 1 || code.has_reloc_entries()) {
+		error = "Generic stub is not relocatable";
+		return false;
+	}
+
+	const auto& buffer = code.text_section()->buffer();
+	out.assign(buffer.data(), buffer.data() + buffer.size());
+	return true;
+}
+
+static void* CommitGenericCode(std::span<const uint8_t> bytes, const Signature& signature, bool hidden, const char*& error) {
+	auto& rt = GetJitRuntime();
+
+	SimpleErrorHandler eh;
+	CodeHolder code;
+	code.init(rt.environment(), rt.cpu_features());
+	code.set_error_handler(&eh);
+
+	a64::Assembler a(&code);
+	a.embed(bytes.data(), bytes.size());
+
+	void* function = CommitCode(code, { "generic", &signature, hidden });
+	if (eh.error != Error::kOk || !function) {
+		error = eh.code ? eh.code : "Failed to commit code";
+		return nullptr;
+	}
+
+	return function;
+}
+
+bool plugify::LoadOrCompileGenericCode(
+	const StubKey& key,
+	const Signature& signature,
+	bool hidden,
+	std::vector<uint8_t>& code,
+	CompileTimer& timer,
+	const char*& error
+) {
+	auto& disk = DiskCache::Instance();
+	if (disk.Load(key, code)) {
+		return true;
+	}
+	// only an actual compilation is timed, not the lookups before it
+	timer.Start();
+	const bool compiled = CompileGenericCode(signature, hidden, key.kind == StubKind::AssembledCall, code, error);
+	timer.Stop();
+	if (!compiled) {
+		return false;
+	}
+	disk.Store(key, code);
+	return true;
+}
+
+struct JitCall::Impl {
+	Impl()
+		: function(nullptr)
+		, targetFunc(nullptr) {
+	}
+
+	~Impl() {
+		ReleaseCode(function);
+	}
+
+	Address GetJitFunc(const Signature& signature, Address target, WaitType waitType, bool hidden) {
+		if (function) {
+			return function;
+		}
+
+		const char* error = nullptr;
+
+		// Methods sharing a signature share one generic stub,
+		// only a tiny thunk binding the target is emitted per call
+		void* stub = GetGenericCallStub(signature, waitType, hidden, error);
+		void* func = stub ? BindTarget(stub, target, signature, hidden, error) : nullptr;
+
+		if (!func) {
+			errorCode = error;
 			return nullptr;
 		}
 
-#if 0
-		std::printf("JIT Stub[%p]:\n%s\n", (void*)function, log.data());
-#endif
+		JitStatistics::Instance().RecordStub(JitStubKind::Call, signature, hidden);
 
+		function = func;
+		targetFunc = target;
+		callSignature = signature;
+		retHidden = hidden;
 		return function;
 	}
 
+	bool Invoke(
+		LoopCallKind kind,
+		const uint64_t* params,
+		size_t paramStride,
+		Return* rets,
+		size_t retStride,
+		const Address* targets,
+		size_t targetStride,
+		size_t count
+	) {
+		if (!function) {
+			return false;
+		}
+		if (kind == LoopCallKind::Shared && retHidden) {
+			invokeError.store(kSharedHiddenError, std::memory_order_release);
+			return false;
+		}
+
+		auto& slot = loopStubs[static_cast<size_t>(kind)];
+		void* stub = slot.load(std::memory_order_acquire);
+		if (!stub) {
+			const char* error = nullptr;
+			stub = GetLoopCallStub(callSignature, kind, retHidden, error);
+			if (!stub) {
+				invokeError.store(error, std::memory_order_release);
+				return false;
+			}
+			slot.store(stub, std::memory_order_release);
+		}
+
+		// the stub always stores the result, give it a slot to overwrite
+		Return scratch;
+		if (!rets) {
+			rets = &scratch;
+			retStride = 0;
+		}
+
+		using LoopFunc = void (*)(const void*, size_t, void*, size_t, const void*, size_t, size_t);
+		reinterpret_cast<LoopFunc>(stub)(params, paramStride, rets, retStride, targets, targetStride, count);
+		return true;
+	}
+
+	static void* BindTarget(void* stub, Address target, const Signature& signature, bool hidden, const char*& error) {
+		auto& rt = GetJitRuntime();
+
+		SimpleErrorHandler eh;
+		CodeHolder code;
+		code.init(rt.environment(), rt.cpu_features());
+		code.set_error_handler(&eh);
+
+		a64::Assembler a(&code);
+		EmitBindThunk(a, stub, target);
+
+		void* thunk = CommitCode(code, { "call", &signature, hidden, JitSymbolScope::Current() });
+		if (eh.error != Error::kOk || !thunk) {
+			error = eh.code ? eh.code : "Failed to commit code";
+			return nullptr;
+		}
+
+		return thunk;
+	}
+
 	Address function;
 
 	union {
 		Address targetFunc;
 		const char* errorCode{};
 	};
+
+	// Loop stubs are owned by the stub cache, only looked up once per kind
+	Signature callSignature;
+	bool retHidden{};
+	std::array<std::atomic<void*>, 2> loopStubs{};
+	// last failure of InvokeAll/InvokeEach, which may run concurrently
+	std::atomic<const char*> invokeError{};
 };
 
-using namespace plugify;
+void* plugify::GetGenericCallStub(
+	const Signature& signature,
+	JitCall::WaitType waitType,
+	bool hidden,
+	const char*& error
+) {
+	StubKey key(GetCallStubKind(static_cast<uint8_t>(waitType)), signature, static_cast<uint8_t>(waitType), hidden);
+	CompileTimer timer;
+	return StubCache::Instance().GetOrCompile(key, [&]() -> void* {
+		if (waitType != JitCall::WaitType::None) {
+			// Wait helpers are called by absolute address, never persisted
+			timer.Start();
+			void* stub = CompileCallStub(signature, nullptr, waitType, hidden, error);
+			timer.Stop();
+			return stub;
+		}
+
+		std::vector<uint8_t> code;
+		if (!LoadOrCompileGenericCode(key, signature, hidden, code, timer, error)) {
+			return nullptr;
+		}
+		return CommitGenericCode(code, signature, hidden, error);
+	}, [&] {
+		timer.Record();
+		JitStatistics::Instance().RecordStub(JitStubKind::Generic, signature, hidden);
+	});
+}
+
+void* plugify::GetLoopCallStub(
+	const Signature& signature,
+	LoopCallKind kind,
+	bool hidden,
+	const char*& error
+) {
+	// Loop stubs are rare enough to stay in memory only
+	StubKey key(kind == LoopCallKind::Shared ? StubKind::SharedLoop : StubKind::EachLoop, signature, 0, hidden);
+	CompileTimer timer;
+	return StubCache::Instance().GetOrCompile(key, [&]() -> void* {
+		timer.Start();
+		void* stub = CompileLoopCallStub(signature, kind, hidden, error);
+		timer.Stop();
+		return stub;
+	}, [&] {
+		timer.Record();
+		JitStatistics::Instance().RecordStub(JitStubKind::Loop, signature, hidden);
+	});
+}
 
 JitCall::JitCall()
 	: _impl(std::make_unique<Impl>()) {
@@ -207,20 +802,10 @@ Address JitCall::GetJitFunc(const Signature& signature, Address target, WaitType
 }
 
 Address JitCall::GetJitFunc(const Method& method, Address target, WaitType waitType, HiddenParam hidden) {
-	ValueType retType = method.GetRetType().GetType();
-	bool retHidden = hidden(retType);
+	JitSymbolScope scope(method.GetName());
 
-	Signature signature(
-		method.GetCallConv(),
-		retHidden ? ValueType::Pointer : retType,
-		method.GetVarIndex()
-	);
-	if (retHidden) {
-		signature.AddArg(retType);
-	}
-	for (const auto& type : method.GetParamTypes()) {
-		signature.AddArg(type.IsRef() ? ValueType::Pointer : type.GetType());
-	}
+	bool retHidden;
+	Signature signature = MakeSignature(method, hidden, retHidden);
 
 	return GetJitFunc(signature, target, waitType, retHidden);
 }
@@ -233,6 +818,50 @@ Address JitCall::GetTargetFunc() const noexcept {
 	return _impl->targetFunc;
 }
 
+const Signature& JitCall::GetSignature() const noexcept {
+	return _impl->callSignature;
+}
+
+bool JitCall::InvokeAll(std::span<const Address> targets, const Parameters& params, std::span<Return> rets) {
+	_impl->invokeError.store(nullptr, std::memory_order_relaxed);
+	if (!rets.empty() && rets.size() < targets.size()) {
+		_impl->invokeError.store(kShortRetsError, std::memory_order_release);
+		return false;
+	}
+
+	return _impl->Invoke(
+		LoopCallKind::Shared,
+		params.Get(), 0,
+		rets.data(), sizeof(Return),
+		targets.data(), sizeof(Address),
+		targets.size()
+	);
+}
+
+bool JitCall::InvokeEach(std::span<const Parameters> params, std::span<Return> rets) {
+	_impl->invokeError.store(nullptr, std::memory_order_relaxed);
+	if (!rets.empty() && rets.size() < params.size()) {
+		_impl->invokeError.store(kShortRetsError, std::memory_order_release);
+		return false;
+	}
+	if (params.empty()) {
+		return _impl->function != nullptr;
+	}
+
+	// Parameters are laid out back to back, so the slots of each are one object apart
+	return _impl->Invoke(
+		LoopCallKind::Each,
+		params.front().Get(), sizeof(Parameters),
+		rets.data(), sizeof(Return),
+		&_impl->targetFunc, 0,
+		params.size()
+	);
+}
+
 std::string_view JitCall::GetError() noexcept {
-	return !_impl->function && _impl->errorCode ? _impl->errorCode : "";
+	if (!_impl->function) {
+		return _impl->errorCode ? _impl->errorCode : "";
+	}
+	const char* error = _impl->invokeError.load(std::memory_order_acquire);
+	return error ? error : "";
 }
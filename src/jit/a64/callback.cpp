@@ -2,55 +2,49 @@
 
 #include "plugify/callback.hpp"
 
+#include "../closure.hpp"
 #include "../helpers.hpp"
+#include "../runtime.hpp"
+#include "../stats.hpp"
+#include "emitters.hpp"
 
 using namespace plugify;
 using namespace asmjit;
 
-static JitRuntime rt;
-
-struct JitCallback::Impl {
-	Impl()
-		: function(nullptr)
-		, userData(nullptr) {
-	}
-
-	~Impl() {
-		if (function) {
-			rt.release(function);
-		}
-	}
-
-	Address GetJitFunc(
+namespace plugify {
+	// Without a bound method, callback and data the stub reads them from the
+	// ClosureContext passed as extra trailing argument
+	static FuncNode* EmitCallbackBody(
+		a64::Compiler& cc,
 		const Signature& signature,
 		const Method* method,
-		CallbackHandler callback,
+		JitCallback::CallbackHandler callback,
 		Address data,
-		bool hidden
+		bool hidden,
+		bool closure,
+		const char*& error
 	) {
-		if (function) {
-			return function;
+		if (const char* structError = CheckStructArgs(signature)) {
+			error = structError;
+			return nullptr;
 		}
 
-		userData = data;
-
 		auto sig = ConvertSignature(signature);
 
-		SimpleErrorHandler eh;
-		CodeHolder code;
-		code.init(rt.environment(), rt.cpu_features());
-		code.set_error_handler(&eh);
+		FuncSignature funcSig = sig;
+		if (closure) {
+			funcSig.add_arg(TypeId::kUIntPtr);
+		}
 
 		// initialize function
-		a64::Compiler cc(&code);
-		FuncNode* func = cc.add_func(sig);
+		FuncNode* func = cc.add_func(funcSig);
 
 #if 0
 		StringLogger log;
 		auto kFormatFlags = FormatFlags::kMachineCode | FormatFlags::kExplainImms | FormatFlags::kRegCasts | FormatFlags::kHexImms | FormatFlags::kHexOffsets | FormatFlags::kPositions;
 
 		log.addFlags(kFormatFlags);
-		code.setLogger(&log);
+		cc.code()->setLogger(&log);
 #endif
 
 #if PLUGIFY_IS_RELEASE
@@ -70,7 +64,7 @@ struct JitCallback::Impl {
 			} else if (TypeUtils::is_float(argType)) {
 				arg = cc.new_vec(argType);
 			} else {
-				errorCode = "Parameters wider than 64bits not supported";
+				error = "Parameters wider than 64bits not supported";
 				return nullptr;
 			}
 
@@ -78,6 +72,12 @@ struct JitCallback::Impl {
 			argRegisters.push_back(std::move(arg));
 		}
 
+		a64::Gp contextPtr;
+		if (closure) {
+			contextPtr = cc.new_gpz("contextPtr");
+			func->set_arg(sig.arg_count(), contextPtr);
+		}
+
 		a64::Gp retStruct = cc.new_gpz("retStruct");
 
 		// store x8 in advance
@@ -88,7 +88,7 @@ struct JitCallback::Impl {
 		constexpr uint32_t alignment = 16;
 
 		// setup the stack structure to hold arguments for user callback
-		const auto stackSize = static_cast<uint32_t>(sizeof(uint64_t) * sig.arg_count());
+		const auto stackSize = static_cast<uint32_t>(sizeof(uint64_t) * signature.ArgCount());
 		a64::Mem argsStack;
 		if (stackSize > 0) {
 			argsStack = cc.new_stack(stackSize, alignment);
@@ -105,7 +105,25 @@ struct JitCallback::Impl {
 		cc.mov(i, 0);
 
 		//// mov from arguments registers into the stack structure
-		for (uint32_t argIdx = 0; argIdx < sig.arg_count(); ++argIdx) {
+		uint32_t argIdx = 0;
+		for (const auto& valueType : signature.argTypes) {
+			if (auto parts = GetStructArgParts(valueType); parts.count != 0) {
+				// reassemble the by-value vector in memory and pass a pointer to it
+				a64::Mem structStack = cc.new_stack(sizeof(float) * 4, alignment);
+				for (uint32_t part = 0; part < parts.count; ++part, ++argIdx) {
+					a64::Mem partMem(structStack);
+					partMem.add_offset(parts.offsets[part]);
+					cc.str(argRegisters.at(argIdx).as<a64::Vec>(), partMem);
+				}
+
+				a64::Gp structPtr = cc.new_gpz();
+				cc.load_address_of(structPtr, structStack);
+				cc.str(structPtr, argsStackIdx);
+
+				cc.add(i, i, sizeof(uint64_t));
+				continue;
+			}
+
 			const auto& argType = sig.args()[argIdx];
 
 			// have to cast back to explicit register types to gen right mov type
@@ -114,9 +132,10 @@ struct JitCallback::Impl {
 			} else if (TypeUtils::is_float(argType)) {
 				cc.str(argRegisters.at(argIdx).as<a64::Vec>(), argsStackIdx);
 			} else {
-				errorCode = "Parameters wider than 64bits not supported";
+				error = "Parameters wider than 64bits not supported";
 				return nullptr;
 			}
+			++argIdx;
 
 			// next structure slot (+= sizeof(uint64_t))
 			cc.add(i, i, sizeof(uint64_t));
@@ -124,11 +143,17 @@ struct JitCallback::Impl {
 
 		// fill reg to pass method ptr to callback
 		a64::Gp methodPtrParam = cc.new_gpz("methodPtrParam");
-		cc.mov(methodPtrParam, method);
 
 		// fill reg to pass data ptr to callback
 		a64::Gp dataPtrParam = cc.new_gpz("dataPtrParam");
-		cc.mov(dataPtrParam, static_cast<uintptr_t>(data));
+
+		if (closure) {
+			cc.ldr(methodPtrParam, a64::ptr(contextPtr, static_cast<int32_t>(offsetof(ClosureContext, method))));
+			cc.ldr(dataPtrParam, a64::ptr(contextPtr, static_cast<int32_t>(offsetof(ClosureContext, data))));
+		} else {
+			cc.mov(methodPtrParam, method);
+			cc.mov(dataPtrParam, static_cast<uintptr_t>(data));
+		}
 
 		// get pointer to stack structure and pass it to the user callback
 		a64::Gp argStruct = cc.new_gpz("argStruct");
@@ -136,7 +161,7 @@ struct JitCallback::Impl {
 
 		// fill reg to pass struct arg count to callback
 		a64::Gp argCountParam = cc.new_gpz("argCountParam");
-		cc.mov(argCountParam, static_cast<size_t>(sig.arg_count()));
+		cc.mov(argCountParam, static_cast<size_t>(signature.ArgCount()));
 
 		// create buffer for ret val
 		a64::Mem retStack;
@@ -151,7 +176,11 @@ struct JitCallback::Impl {
 		}
 
 		a64::Gp dest = cc.new_gpz();
-		cc.mov(dest, (uint64_t) callback);
+		if (closure) {
+			cc.ldr(dest, a64::ptr(contextPtr, static_cast<int32_t>(offsetof(ClosureContext, callback))));
+		} else {
+			cc.mov(dest, (uint64_t) callback);
+		}
 
 		InvokeNode* invokeNode;
 		cc.invoke(
@@ -169,16 +198,25 @@ struct JitCallback::Impl {
 
 		// mov from arguments stack structure into regs
 		cc.mov(i, 0);  // reset idx
-		for (uint32_t argIdx = 0; argIdx < sig.arg_count(); ++argIdx) {
+		argIdx = 0;
+		for (const auto& valueType : signature.argTypes) {
+			if (auto parts = GetStructArgParts(valueType); parts.count != 0) {
+				// by-value vectors are copies, nothing to write back
+				argIdx += parts.count;
+				cc.add(i, i, sizeof(uint64_t));
+				continue;
+			}
+
 			const auto& argType = sig.args()[argIdx];
 			if (TypeUtils::is_int(argType)) {
 				cc.ldr(argRegisters.at(argIdx).as<a64::Gp>(), argsStackIdx);
 			} else if (TypeUtils::is_float(argType)) {
 				cc.ldr(argRegisters.at(argIdx).as<a64::Vec>(), argsStackIdx);
 			} else {
-				errorCode = "Parameters wider than 64bits not supported";
+				error = "Parameters wider than 64bits not supported";
 				return nullptr;
 			}
+			++argIdx;
 
 			// next structure slot (+= sizeof(uint64_t))
 			cc.add(i, i, sizeof(uint64_t));
@@ -237,20 +275,316 @@ struct JitCallback::Impl {
 
 		cc.end_func();
 
+		return func;
+	}
+
+	FuncNode* EmitCallbackStub(
+		a64::Compiler& cc,
+		const Signature& signature,
+		const Method* method,
+		JitCallback::CallbackHandler callback,
+		Address data,
+		bool hidden,
+		const char*& error
+	) {
+		return EmitCallbackBody(cc, signature, method, callback, data, hidden, false, error);
+	}
+
+	FuncNode* EmitClosureStub(
+		a64::Compiler& cc,
+		const Signature& signature,
+		bool hidden,
+		const char*& error
+	) {
+		return EmitCallbackBody(cc, signature, nullptr, nullptr, nullptr, hidden, true, error);
+	}
+
+	// AAPCS64 passes a hidden return pointer in x8, so the leading pointer argument of a
+	// lowered signature does not occupy an argument register. By-value vectors travel
+	// in vector registers.
+	static size_t CountIntArgs(const Signature& signature, bool hidden) noexcept {
+		size_t count = 0;
+		for (size_t i = hidden ? 1 : 0; i < signature.argTypes.size(); ++i) {
+			const auto& type = signature.argTypes[i];
+			if (GetStructArgParts(type).count == 0 && TypeUtils::is_int(GetValueTypeId(type))) {
+				++count;
+			}
+		}
+		return count;
+	}
+
+	bool CanShiftTypedArgs(const Signature& signature, bool hidden) noexcept {
+		// integer and vector registers are assigned independently, so inserting one
+		// pointer only moves the integer arguments, as long as none of them spills
+		constexpr size_t kIntArgRegs = 8;
+		return signature.varIndex == Signature::kNoVarArgs && CountIntArgs(signature, hidden) < kIntArgRegs;
+	}
+
+	void EmitTypedThunk(a64::Assembler& a, const Signature& signature, Address handler, Address data, bool hidden) {
+		static const std::array<a64::Gp, 8> kArgRegs = {
+			a64::x0, a64::x1, a64::x2, a64::x3, a64::x4, a64::x5, a64::x6, a64::x7
+		};
+
+		// x8 (hidden return) is left untouched, data becomes the first argument
+		for (size_t i = CountIntArgs(signature, hidden); i > 0; --i) {
+			a.mov(kArgRegs[i], kArgRegs[i - 1]);
+		}
+		a.mov(a64::x0, static_cast<uint64_t>(static_cast<uintptr_t>(data)));
+
+		// the handler returns straight to the caller
+		a.mov(a64::x16, static_cast<uint64_t>(static_cast<uintptr_t>(handler)));
+		a.br(a64::x16);
+	}
+
+	FuncNode* EmitTypedCallbackStub(
+		a64::Compiler& cc,
+		const Signature& signature,
+		Address handler,
+		Address data,
+		bool hidden,
+		const char*& error
+	) {
+		if (signature.varIndex != Signature::kNoVarArgs) {
+			error = "Variadic signatures are not supported by typed callbacks";
+			return nullptr;
+		}
+
+		if (const char* structError = CheckStructArgs(signature)) {
+			error = structError;
+			return nullptr;
+		}
+
+		auto sig = ConvertSignature(signature);
+
+		// the hidden return pointer travels in x8 on both sides and is not an argument
+		const uint32_t firstArg = hidden ? 1 : 0;
+		FuncSignature nativeSig(sig.call_conv_id(), FuncSignature::kNoVarArgs, hidden ? TypeId::kVoid : sig.ret());
+		FuncSignature handlerSig(sig.call_conv_id(), FuncSignature::kNoVarArgs, nativeSig.ret());
+		handlerSig.add_arg(TypeId::kUIntPtr);
+		for (uint32_t argIdx = firstArg; argIdx < sig.arg_count(); ++argIdx) {
+			nativeSig.add_arg(sig.args()[argIdx]);
+			handlerSig.add_arg(sig.args()[argIdx]);
+		}
+
+		// initialize function
+		FuncNode* func = cc.add_func(nativeSig);
+		if (hidden) {
+			func->frame().add_unavailable_regs(a64::x8);
+		}
+
+		a64::Gp dataPtrParam = cc.new_gpz("dataPtrParam");
+		cc.mov(dataPtrParam, static_cast<uintptr_t>(data));
+
+		a64::Gp dest = cc.new_gpz();
+		cc.mov(dest, static_cast<uintptr_t>(handler));
+
+		InvokeNode* invokeNode;
+		cc.invoke(Out(invokeNode), dest, handlerSig);
+		invokeNode->set_arg(0, dataPtrParam);
+
+		// forward arguments register to register, no spilling
+		for (uint32_t argIdx = 0; argIdx < nativeSig.arg_count(); ++argIdx) {
+			const auto& argType = nativeSig.args()[argIdx];
+
+			Reg arg;
+			if (TypeUtils::is_int(argType)) {
+				arg = cc.new_gp(argType);
+			} else if (TypeUtils::is_float(argType)) {
+				arg = cc.new_vec(argType);
+			} else {
+				error = "Parameters wider than 64bits not supported";
+				return nullptr;
+			}
+
+			func->set_arg(argIdx, arg);
+			invokeNode->set_arg(argIdx + 1, arg);
+		}
+
+		if (!nativeSig.has_ret()) {
+			cc.ret();
+		} else if (TypeUtils::is_int(nativeSig.ret())) {
+			a64::Gp ret = cc.new_gp(nativeSig.ret());
+			invokeNode->set_ret(0, ret);
+			cc.ret(ret);
+		} else if (TypeUtils::is_float(nativeSig.ret())) {
+			a64::Vec ret = cc.new_vec(nativeSig.ret());
+			invokeNode->set_ret(0, ret);
+			cc.ret(ret);
+		} else {
+			error = "Return wider than 64bits not supported";
+			return nullptr;
+		}
+
+		// end of the function body
+		cc.end_func();
+
+		return func;
+	}
+}  // namespace plugify
+
+struct JitCallback::Impl {
+	Impl()
+		: function(nullptr)
+		, userData(nullptr) {
+	}
+
+	~Impl() {
+		ReleaseCode(function);
+	}
+
+	Address GetJitFunc(
+		const Signature& signature,
+		const Method* method,
+		CallbackHandler callback,
+		Address data,
+		bool hidden
+	) {
+		if (function) {
+			return function;
+		}
+
+		const char* error = nullptr;
+		CompileTimer timer;
+		timer.Start();
+		void* func = CompileStub(signature, method, callback, data, hidden, error);
+		timer.Stop();
+		if (!func) {
+			errorCode = error;
+			return nullptr;
+		}
+
+		timer.Record();
+		JitStatistics::Instance().RecordStub(JitStubKind::Callback, signature, hidden);
+
+		function = func;
+		userData = data;
+		return function;
+	}
+
+	Address GetTypedJitFunc(
+		const Signature& signature,
+		Address handler,
+		Address data,
+		bool hidden
+	) {
+		if (function) {
+			return function;
+		}
+
+		const char* error = nullptr;
+		CompileTimer timer;
+		void* func;
+		if (CanShiftTypedArgs(signature, hidden)) {
+			// a few moves and a jump, nothing to compile
+			func = BindTyped(signature, handler, data, hidden, error);
+		} else {
+			timer.Start();
+			func = CompileTypedStub(signature, handler, data, hidden, error);
+			timer.Stop();
+		}
+		if (!func) {
+			errorCode = error;
+			return nullptr;
+		}
+
+		timer.Record();
+		JitStatistics::Instance().RecordStub(JitStubKind::TypedCallback, signature, hidden);
+
+		function = func;
+		userData = data;
+		return function;
+	}
+
+	static void* BindTyped(
+		const Signature& signature,
+		Address handler,
+		Address data,
+		bool hidden,
+		const char*& error
+	) {
+		auto& rt = GetJitRuntime();
+
+		SimpleErrorHandler eh;
+		CodeHolder code;
+		code.init(rt.environment(), rt.cpu_features());
+		code.set_error_handler(&eh);
+
+		a64::Assembler a(&code);
+		EmitTypedThunk(a, signature, handler, data, hidden);
+
+		void* thunk = CommitCode(code, { "typed", &signature, hidden, JitSymbolScope::Current() });
+		if (eh.error != Error::kOk || !thunk) {
+			error = eh.code ? eh.code : "Failed to commit code";
+			return nullptr;
+		}
+
+		return thunk;
+	}
+
+	static void* CompileTypedStub(
+		const Signature& signature,
+		Address handler,
+		Address data,
+		bool hidden,
+		const char*& error
+	) {
+		auto& rt = GetJitRuntime();
+
+		SimpleErrorHandler eh;
+		CodeHolder code;
+		code.init(rt.environment(), rt.cpu_features());
+		code.set_error_handler(&eh);
+
+		a64::Compiler cc(&code);
+		if (!EmitTypedCallbackStub(cc, signature, handler, data, hidden, error)) {
+			return nullptr;
+		}
+
 		// write to buffer
 		cc.finalize();
 
-		rt.add(&function, &code);
+		void* function = CommitCode(code, { "typed", &signature, hidden, JitSymbolScope::Current() });
+		if (eh.error != Error::kOk || !function) {
+			error = eh.code ? eh.code : "Failed to commit code";
+			return nullptr;
+		}
+
+		return function;
+	}
+
+	static void* CompileStub(
+		const Signature& signature,
+		const Method* method,
+		CallbackHandler callback,
+		Address data,
+		bool hidden,
+		const char*& error
+	) {
+		auto& rt = GetJitRuntime();
+
+		SimpleErrorHandler eh;
+		CodeHolder code;
+		code.init(rt.environment(), rt.cpu_features());
+		code.set_error_handler(&eh);
 
-		if (eh.error != Error::kOk) {
-			function = nullptr;
-			errorCode = eh.code;
+		a64::Compiler cc(&code);
+		if (!EmitCallbackStub(cc, signature, method, callback, data, hidden, error)) {
 			return nullptr;
 		}
 
-#if 0
-		std::printf("JIT Stub[%p]:\n%s\n", (void*)function, log.data());
-#endif
+		// write to buffer
+		cc.finalize();
+
+		void* function = CommitCode(code, {
+			"callback",
+			&signature,
+			hidden,
+			method ? std::string_view(method->GetName()) : JitSymbolScope::Current(),
+		});
+		if (eh.error != Error::kOk || !function) {
+			error = eh.code ? eh.code : "Failed to commit code";
+			return nullptr;
+		}
 
 		return function;
 	}
@@ -263,8 +597,6 @@ struct JitCallback::Impl {
 	};
 };
 
-using namespace plugify;
-
 JitCallback::JitCallback()
 	: _impl(std::make_unique<Impl>()) {
 }
@@ -291,24 +623,35 @@ Address JitCallback::GetJitFunc(
 	Address data,
 	HiddenParam hidden
 ) {
-	ValueType retType = method.GetRetType().GetType();
-	bool retHidden = hidden(retType);
-
-	Signature signature(
-		method.GetCallConv(),
-		retHidden ? ValueType::Pointer : retType,
-		method.GetVarIndex()
-	);
-	if (retHidden) {
-		signature.AddArg(retType);
-	}
-	for (const auto& type : method.GetParamTypes()) {
-		signature.AddArg(type.IsRef() ? ValueType::Pointer : type.GetType());
-	}
+	bool retHidden;
+	Signature signature = MakeSignature(method, hidden, retHidden);
 
 	return GetJitFunc(signature, &method, callback, data, retHidden);
 }
 
+Address JitCallback::GetTypedJitFunc(
+	const Signature& signature,
+	Address handler,
+	Address data,
+	bool hidden
+) {
+	return _impl->GetTypedJitFunc(signature, handler, data, hidden);
+}
+
+Address JitCallback::GetTypedJitFunc(
+	const Method& method,
+	Address handler,
+	Address data,
+	HiddenParam hidden
+) {
+	JitSymbolScope scope(method.GetName());
+
+	bool retHidden;
+	Signature signature = MakeSignature(method, hidden, retHidden);
+
+	return GetTypedJitFunc(signature, handler, data, retHidden);
+}
+
 Address JitCallback::GetFunction() const noexcept {
 	return _impl->function;
 }
@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <array>
+#include <vector>
+
+#include <asmjit/a64.h>
+
+#include "../closure.hpp"
+#include "../helpers.hpp"
+#include "../runtime.hpp"
+#include "../stats.hpp"
+#include "../stub_cache.hpp"
+#include "emitters.hpp"
+
+using namespace plugify;
+using namespace asmjit;
+
+namespace plugify {
+	void EmitClosureThunk(a64::Assembler& a, const a64::Gp& contextReg, const ClosureCell* cell) {
+		// context -> its argument register, then jump through the entry stored right behind it
+		a.mov(contextReg, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(&cell->context)));
+		a.ldr(a64::x16, a64::ptr(contextReg, kClosureEntryOffset));
+		a.br(a64::x16);
+	}
+
+	// up to four mov/movk + ldr + br
+	static constexpr uint32_t kClosureThunkSize = 32;
+
+	static void* CompileClosureStub(const Signature& signature, bool hidden, const char*& error) {
+		auto& rt = GetJitRuntime();
+
+		SimpleErrorHandler eh;
+		CodeHolder code;
+		code.init(rt.environment(), rt.cpu_features());
+		code.set_error_handler(&eh);
+
+		a64::Compiler cc(&code);
+		if (!EmitClosureStub(cc, signature, hidden, error)) {
+			return nullptr;
+		}
+
+		// write to buffer
+		cc.finalize();
+
+		void* function = CommitCode(code, { "closure", &signature, hidden });
+		if (eh.error != Error::kOk || !function) {
+			error = eh.code ? eh.code : "Failed to commit code";
+			return nullptr;
+		}
+
+		return function;
+	}
+}  // namespace plugify
+
+void* plugify::GetClosureStub(const Signature& signature, bool hidden, const char*& error) {
+	StubKey key(StubKind::Closure, signature, 0, hidden);
+	CompileTimer timer;
+	return StubCache::Instance().GetOrCompile(key, [&]() -> void* {
+		timer.Start();
+		void* stub = CompileClosureStub(signature, hidden, error);
+		timer.Stop();
+		return stub;
+	}, [&] {
+		timer.Record();
+		JitStatistics::Instance().RecordStub(JitStubKind::Callback, signature, hidden);
+	});
+}
+
+void* plugify::CommitClosurePage(uint32_t contextReg, ClosureCell* cells, size_t count, void** thunks, const char*& error) {
+	static const std::array<a64::Gp, 8> kArgRegs = {
+		a64::x0, a64::x1, a64::x2, a64::x3, a64::x4, a64::x5, a64::x6, a64::x7
+	};
+
+	auto it = std::ranges::find_if(kArgRegs, [contextReg](const a64::Gp& reg) { return reg.id() == contextReg; });
+	if (it == kArgRegs.end()) {
+		error = "Closure context register is not an argument register";
+		return nullptr;
+	}
+
+	auto& rt = GetJitRuntime();
+
+	SimpleErrorHandler eh;
+	CodeHolder code;
+	code.init(rt.environment(), rt.cpu_features());
+	code.set_error_handler(&eh);
+
+	a64::Assembler a(&code);
+
+	std::vector<Label> labels(count);
+	for (size_t i = 0; i < count; ++i) {
+		a.align(AlignMode::kCode, kClosureThunkSize);
+		labels[i] = a.new_label();
+		a.bind(labels[i]);
+		EmitClosureThunk(a, *it, &cells[i]);
+	}
+
+	void* page = CommitCode(code, { "closure_page" });
+	if (eh.error != Error::kOk || !page) {
+		error = eh.code ? eh.code : "Failed to commit code";
+		return nullptr;
+	}
+
+	auto* base = static_cast<uint8_t*>(page);
+	for (size_t i = 0; i < count; ++i) {
+		thunks[i] = base + code.label_offset(labels[i]);
+	}
+	return page;
+}
@@ -175,4 +175,39 @@ namespace plugify {
 		}
 	}
 
+	StructArgParts GetStructArgParts(ValueType valueType) noexcept {
+		// Homogeneous floating-point aggregates are passed one member per register
+		constexpr auto kFloat = asmjit::TypeId::kFloat32;
+		switch (valueType) {
+			case ValueType::Vector2:
+				return { 2, { kFloat, kFloat }, { 0, 4 } };
+			case ValueType::Vector3:
+				return { 3, { kFloat, kFloat, kFloat }, { 0, 4, 8 } };
+			case ValueType::Vector4:
+				return { 4, { kFloat, kFloat, kFloat, kFloat }, { 0, 4, 8, 12 } };
+			default:
+				// mat4x4 has more than 4 members and is passed by reference
+				return {};
+		}
+	}
+
+	const char* CheckStructArgs(const Signature& sig) noexcept {
+		// An HFA which does not fit the remaining registers is copied to the stack with its
+		// memory layout, while split members would take a stack slot each
+		constexpr uint32_t kVecArgRegs = 8;
+		uint32_t used = 0;
+		for (const auto& arg : sig.argTypes) {
+			auto parts = GetStructArgParts(arg);
+			if (parts.count == 0) {
+				if (asmjit::TypeUtils::is_float(GetValueTypeId(arg))) {
+					++used;
+				}
+			} else if (used + parts.count > kVecArgRegs) {
+				return "Vector parameter does not fit into the floating point registers";
+			} else {
+				used += parts.count;
+			}
+		}
+		return nullptr;
+	}
 }  // namespace plugify
@@ -0,0 +1,108 @@
+#include <asmjit/a64.h>
+
+#include "../helpers.hpp"
+#include "../lazy.hpp"
+#include "../runtime.hpp"
+#include "emitters.hpp"
+
+using namespace plugify;
+using namespace asmjit;
+
+namespace plugify {
+	void EmitLazyTrampoline(a64::Assembler& a, const void* entry) {
+		// x16/x17 are the intra-procedure-call scratch registers, never arguments
+		a.mov(a64::x16, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(entry)));
+		a.ldr(a64::x17, a64::ptr(a64::x16));
+		a.br(a64::x17);
+	}
+
+	void EmitLazyResolver(a64::Assembler& a, void* resolve) {
+		// x0-x7 arguments, x8 indirect result pointer, q0-q7 vector arguments
+		constexpr int32_t kVecOffset = 80;
+		constexpr int32_t kFrameOffset = kVecOffset + 16 * 8;
+		constexpr int32_t kFrameSize = kFrameOffset + 16;
+
+		a.sub(a64::sp, a64::sp, kFrameSize);
+		a.stp(a64::x29, a64::x30, a64::ptr(a64::sp, kFrameOffset));
+		a.add(a64::x29, a64::sp, kFrameOffset);
+
+		a.stp(a64::x0, a64::x1, a64::ptr(a64::sp, 0));
+		a.stp(a64::x2, a64::x3, a64::ptr(a64::sp, 16));
+		a.stp(a64::x4, a64::x5, a64::ptr(a64::sp, 32));
+		a.stp(a64::x6, a64::x7, a64::ptr(a64::sp, 48));
+		a.str(a64::x8, a64::ptr(a64::sp, 64));
+		a.stp(a64::q0, a64::q1, a64::ptr(a64::sp, kVecOffset));
+		a.stp(a64::q2, a64::q3, a64::ptr(a64::sp, kVecOffset + 32));
+		a.stp(a64::q4, a64::q5, a64::ptr(a64::sp, kVecOffset + 64));
+		a.stp(a64::q6, a64::q7, a64::ptr(a64::sp, kVecOffset + 96));
+
+		// ResolveLazyEntry(entry)
+		a.mov(a64::x0, a64::x16);
+		a.mov(a64::x17, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(resolve)));
+		a.blr(a64::x17);
+		a.mov(a64::x16, a64::x0);
+
+		a.ldp(a64::x0, a64::x1, a64::ptr(a64::sp, 0));
+		a.ldp(a64::x2, a64::x3, a64::ptr(a64::sp, 16));
+		a.ldp(a64::x4, a64::x5, a64::ptr(a64::sp, 32));
+		a.ldp(a64::x6, a64::x7, a64::ptr(a64::sp, 48));
+		a.ldr(a64::x8, a64::ptr(a64::sp, 64));
+		a.ldp(a64::q0, a64::q1, a64::ptr(a64::sp, kVecOffset));
+		a.ldp(a64::q2, a64::q3, a64::ptr(a64::sp, kVecOffset + 32));
+		a.ldp(a64::q4, a64::q5, a64::ptr(a64::sp, kVecOffset + 64));
+		a.ldp(a64::q6, a64::q7, a64::ptr(a64::sp, kVecOffset + 96));
+
+		// the stack is back as the caller left it, the real function returns to it directly
+		a.ldp(a64::x29, a64::x30, a64::ptr(a64::sp, kFrameOffset));
+		a.add(a64::sp, a64::sp, kFrameSize);
+		a.br(a64::x16);
+	}
+}  // namespace plugify
+
+void* plugify::GetLazyResolver(const char*& error) {
+	static const char* resolverError = nullptr;
+	static void* resolver = [] {
+		auto& rt = GetJitRuntime();
+
+		SimpleErrorHandler eh;
+		CodeHolder code;
+		code.init(rt.environment(), rt.cpu_features());
+		code.set_error_handler(&eh);
+
+		a64::Assembler a(&code);
+		EmitLazyResolver(a, reinterpret_cast<void*>(&ResolveLazyEntry));
+
+		// shared by every lazy entry, never released
+		void* function = CommitCode(code, { "lazy_resolver" });
+		if (eh.error != Error::kOk || !function) {
+			resolverError = eh.code ? eh.code : "Failed to commit code";
+			return static_cast<void*>(nullptr);
+		}
+		return function;
+	}();
+
+	if (!resolver) {
+		error = resolverError;
+	}
+	return resolver;
+}
+
+void* plugify::CommitLazyTrampoline(LazyEntry* entry, std::string_view name, const char*& error) {
+	auto& rt = GetJitRuntime();
+
+	SimpleErrorHandler eh;
+	CodeHolder code;
+	code.init(rt.environment(), rt.cpu_features());
+	code.set_error_handler(&eh);
+
+	a64::Assembler a(&code);
+	EmitLazyTrampoline(a, entry);
+
+	void* thunk = CommitCode(code, { "lazy", nullptr, false, name });
+	if (eh.error != Error::kOk || !thunk) {
+		error = eh.code ? eh.code : "Failed to commit code";
+		return nullptr;
+	}
+
+	return thunk;
+}
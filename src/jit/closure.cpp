@@ -0,0 +1,202 @@
+#include <array>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "plugify/jit_closure.hpp"
+
+#include "closure.hpp"
+#include "helpers.hpp"
+#include "runtime.hpp"
+
+using namespace plugify;
+
+namespace {
+	// Thunks committed at once when a pool runs dry
+	constexpr size_t kClosurePageThunks = 256;
+
+	/**
+	 * Slab of thunks bound to one context register.
+	 * Pages are never released, like shared stubs they live for the process lifetime.
+	 */
+	class ClosurePool {
+	public:
+		bool Allocate(uint32_t contextReg, ClosureSlot& slot, const char*& error) {
+			std::lock_guard lock(_mutex);
+			if (_free.empty() && !Grow(contextReg, error)) {
+				return false;
+			}
+			slot = _free.back();
+			_free.pop_back();
+			return true;
+		}
+
+		void Release(const ClosureSlot& slot) {
+			std::lock_guard lock(_mutex);
+			_free.push_back(slot);
+		}
+
+	private:
+		bool Grow(uint32_t contextReg, const char*& error) {
+			auto cells = std::make_unique<ClosureCell[]>(kClosurePageThunks);
+			std::array<void*, kClosurePageThunks> thunks{};
+			if (!CommitClosurePage(contextReg, cells.get(), kClosurePageThunks, thunks.data(), error)) {
+				return false;
+			}
+
+			// handed out from the start of the page
+			_free.reserve(_free.size() + kClosurePageThunks);
+			for (size_t i = kClosurePageThunks; i-- > 0;) {
+				_free.push_back({ thunks[i], &cells[i] });
+			}
+			_cells.push_back(std::move(cells));
+			return true;
+		}
+
+		std::mutex _mutex;
+		std::vector<ClosureSlot> _free;
+		std::vector<std::unique_ptr<ClosureCell[]>> _cells;
+	};
+
+	// One pool per register id, the thunk code depends on the register only
+	ClosurePool* GetClosurePool(uint32_t contextReg) noexcept {
+		static std::array<ClosurePool, 32> pools;
+		return contextReg < pools.size() ? &pools[contextReg] : nullptr;
+	}
+}
+
+uint32_t plugify::GetClosureContextReg(const Signature& signature) noexcept {
+#if PLUGIFY_ARCH_BITS == 64
+	if (signature.varIndex != Signature::kNoVarArgs || CheckStructArgs(signature)) {
+		return kNoClosureReg;
+	}
+
+	// the context is an extra trailing pointer argument, let the ABI place it
+	asmjit::FuncSignature sig = ConvertSignature(signature);
+	if (sig.arg_count() >= asmjit::Globals::kMaxFuncArgs) {
+		return kNoClosureReg;
+	}
+	sig.add_arg(asmjit::TypeId::kUIntPtr);
+
+	asmjit::FuncDetail detail;
+	if (detail.init(sig, GetJitRuntime().environment()) != asmjit::Error::kOk) {
+		return kNoClosureReg;
+	}
+
+	const auto& context = detail.arg(sig.arg_count() - 1);
+	return context.is_reg() ? context.reg_id() : kNoClosureReg;
+#else
+	// 32-bit conventions pass it on the stack, which a thunk cannot extend
+	(void) signature;
+	return kNoClosureReg;
+#endif	// PLUGIFY_ARCH_BITS
+}
+
+struct JitClosure::Impl {
+	~Impl() {
+		if (slot.thunk) {
+			GetClosurePool(contextReg)->Release(slot);
+		}
+	}
+
+	Address GetJitFunc(
+		const Signature& signature,
+		const Method* method,
+		JitCallback::CallbackHandler callback,
+		Address data,
+		bool hidden
+	) {
+		if (function) {
+			return function;
+		}
+
+		const uint32_t reg = GetClosureContextReg(signature);
+		ClosurePool* pool = reg != kNoClosureReg ? GetClosurePool(reg) : nullptr;
+		if (!pool) {
+			// no register left for the context, the instance gets a stub of its own
+			function = fallback.GetJitFunc(signature, method, callback, data, hidden);
+			if (!function) {
+				errorCode = fallback.GetError();
+				return nullptr;
+			}
+			userData = data;
+			return function;
+		}
+
+		const char* error = nullptr;
+		void* entry = GetClosureStub(signature, hidden, error);
+		if (!entry) {
+			errorCode = error ? error : "Failed to compile closure stub";
+			return nullptr;
+		}
+
+		ClosureSlot newSlot;
+		if (!pool->Allocate(reg, newSlot, error)) {
+			errorCode = error ? error : "Failed to allocate closure thunk";
+			return nullptr;
+		}
+
+		newSlot.cell->context = { callback, method, data, hidden };
+		newSlot.cell->entry = entry;
+
+		slot = newSlot;
+		contextReg = reg;
+		function = slot.thunk;
+		userData = data;
+		return function;
+	}
+
+	ClosureSlot slot;
+	uint32_t contextReg{ kNoClosureReg };
+	JitCallback fallback;
+	Address function;
+	Address userData;
+	std::string errorCode;
+};
+
+JitClosure::JitClosure()
+	: _impl(std::make_unique<Impl>()) {
+}
+
+JitClosure::JitClosure(JitClosure&& other) noexcept = default;
+
+JitClosure::~JitClosure() = default;
+
+JitClosure& JitClosure::operator=(JitClosure&& other) noexcept = default;
+
+Address JitClosure::GetJitFunc(
+	const Signature& signature,
+	const Method* method,
+	JitCallback::CallbackHandler callback,
+	Address data,
+	bool hidden
+) {
+	return _impl->GetJitFunc(signature, method, callback, data, hidden);
+}
+
+Address JitClosure::GetJitFunc(
+	const Method& method,
+	JitCallback::CallbackHandler callback,
+	Address data,
+	JitCallback::HiddenParam hidden
+) {
+	JitSymbolScope scope(method.GetName());
+
+	bool retHidden;
+	Signature signature = MakeSignature(method, hidden, retHidden);
+
+	return GetJitFunc(signature, &method, callback, data, retHidden);
+}
+
+Address JitClosure::GetFunction() const noexcept {
+	return _impl->function;
+}
+
+Address JitClosure::GetUserData() const noexcept {
+	return _impl->userData;
+}
+
+std::string_view JitClosure::GetError() const noexcept {
+	return _impl->errorCode;
+}
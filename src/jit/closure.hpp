@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "plugify/callback.hpp"
+#include "plugify/signarure.hpp"
+
+namespace plugify {
+	/**
+	 * @brief Everything a callback stub would otherwise embed as immediates.
+	 * @details Shared stubs receive a pointer to it in the argument register following the
+	 * last argument, see GetClosureContextReg(). Must outlive the thunk bound to it.
+	 */
+	struct ClosureContext {
+		JitCallback::CallbackHandler callback{};
+		const Method* method{};
+		Address data{};
+		bool hidden{};
+	};
+
+	/**
+	 * @brief Data behind one pooled thunk.
+	 * @details The thunk loads the address of \p context into the context register and
+	 * jumps through \p entry, which is read relative to it.
+	 */
+	struct ClosureCell {
+		ClosureContext context;
+		void* entry{};
+	};
+
+	constexpr int32_t kClosureEntryOffset = offsetof(ClosureCell, entry) - offsetof(ClosureCell, context);
+
+	/**
+	 * @brief Pooled thunk and the cell it is bound to.
+	 */
+	struct ClosureSlot {
+		void* thunk{};
+		ClosureCell* cell{};
+	};
+
+	/**
+	 * @brief Register id used when the context cannot be passed in a register.
+	 */
+	constexpr uint32_t kNoClosureReg = UINT32_MAX;
+
+	/**
+	 * @brief Returns the id of the general purpose register which receives the context of
+	 * a closure with this signature, i.e. the one an extra trailing pointer argument is assigned to.
+	 * @return Register id, or kNoClosureReg if it would be passed on the stack or the
+	 * signature is variadic.
+	 */
+	uint32_t GetClosureContextReg(const Signature& signature) noexcept;
+
+	/**
+	 * @brief Returns the process-wide closure stub for the signature, compiling it on first use.
+	 * @details Same behaviour as a JitCallback stub, but the callback, method and data are read
+	 * from the ClosureContext passed as extra trailing argument.
+	 */
+	void* GetClosureStub(const Signature& signature, bool hidden, const char*& error);
+
+	/**
+	 * @brief Commits a page of \p count thunks, the i-th one binding \p cells[i].
+	 * @param contextReg Register receiving the context, see GetClosureContextReg().
+	 * @param thunks Receives the address of every thunk.
+	 * @return Start of the page, or nullptr with \p error set.
+	 */
+	void* CommitClosurePage(uint32_t contextReg, ClosureCell* cells, size_t count, void** thunks, const char*& error);
+}  // namespace plugify
@@ -0,0 +1,45 @@
+#include "plugify/jit_context.hpp"
+
+#include "disk_cache.hpp"
+#include "perf_map.hpp"
+#include "runtime.hpp"
+#include "stats.hpp"
+#include "stub_cache.hpp"
+
+using namespace plugify;
+
+void JitContext::SetCacheDirectory(const std::filesystem::path& directory) {
+	DiskCache::Instance().SetDirectory(directory);
+}
+
+std::filesystem::path JitContext::GetCacheDirectory() {
+	return DiskCache::Instance().GetDirectory();
+}
+
+void JitContext::ClearStubCache() {
+	StubCache::Instance().Clear();
+}
+
+JitStats JitContext::GetStats() {
+	return JitStatistics::Instance().Snapshot();
+}
+
+void JitContext::ResetStats() {
+	JitStatistics::Instance().Reset();
+}
+
+void JitContext::SetProfilerOutput(JitProfilerOutput output) {
+	JitProfiler::Instance().SetOutput(output);
+}
+
+JitProfilerOutput JitContext::GetProfilerOutput() {
+	return JitProfiler::Instance().GetOutput();
+}
+
+void JitContext::SetEmitter(JitEmitter emitter) {
+	SetJitEmitter(emitter);
+}
+
+JitEmitter JitContext::GetEmitter() {
+	return GetJitEmitter();
+}
@@ -0,0 +1,202 @@
+#include <format>
+#include <fstream>
+#include <thread>
+
+#if PLUGIFY_PLATFORM_WINDOWS
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "disk_cache.hpp"
+#include "runtime.hpp"
+#include "stats.hpp"
+
+namespace plugify {
+	namespace {
+		constexpr uint32_t kMagic = 0x54494A50;  // 'PJIT'
+		constexpr uint32_t kFormat = 1;
+
+		struct FileHeader {
+			uint32_t magic;
+			uint32_t format;
+			uint64_t environment;
+			uint64_t checksum;
+			uint32_t keySize;
+			uint32_t codeSize;
+		};
+
+		uint64_t Fnv1a(std::span<const uint8_t> bytes, uint64_t hash = 0xcbf29ce484222325ULL) noexcept {
+			for (uint8_t byte : bytes) {
+				hash ^= byte;
+				hash *= 0x100000001b3ULL;
+			}
+			return hash;
+		}
+
+		std::vector<uint8_t> SerializeKey(const StubKey& key) {
+			std::vector<uint8_t> bytes;
+			bytes.reserve(7 + key.argTypes.size());
+			bytes.push_back(static_cast<uint8_t>(key.kind));
+			bytes.push_back(static_cast<uint8_t>(key.callConv));
+			bytes.push_back(static_cast<uint8_t>(key.retType));
+			bytes.push_back(key.varIndex);
+			bytes.push_back(key.waitType);
+			bytes.push_back(static_cast<uint8_t>(key.hidden));
+			bytes.push_back(static_cast<uint8_t>(key.argTypes.size()));
+			for (const auto& arg : key.argTypes) {
+				bytes.push_back(static_cast<uint8_t>(arg));
+			}
+			return bytes;
+		}
+
+		uint64_t CurrentProcessId() noexcept {
+#if PLUGIFY_PLATFORM_WINDOWS
+			return static_cast<uint64_t>(_getpid());
+#else
+			return static_cast<uint64_t>(getpid());
+#endif
+		}
+	}
+
+	DiskCache::DiskCache() {
+		// Anything which changes the generated code must be part of the environment
+		std::string_view version = PLUGIFY_VERSION;
+		uint64_t hash = Fnv1a({ reinterpret_cast<const uint8_t*>(version.data()), version.size() });
+
+		const uint8_t bits = PLUGIFY_ARCH_BITS;
+		hash = Fnv1a({ &bits, 1 }, hash);
+
+		const auto& features = GetJitRuntime().cpu_features();
+		hash = Fnv1a({ reinterpret_cast<const uint8_t*>(&features), sizeof(features) }, hash);
+
+		_environment = hash;
+	}
+
+	DiskCache& DiskCache::Instance() {
+		static DiskCache cache;
+		return cache;
+	}
+
+	void DiskCache::SetDirectory(const std::filesystem::path& directory) {
+		std::error_code ec;
+		if (!directory.empty()) {
+			std::filesystem::create_directories(directory, ec);
+		}
+
+		std::unique_lock lock(_mutex);
+		_directory = ec ? std::filesystem::path{} : directory;
+	}
+
+	std::filesystem::path DiskCache::GetDirectory() const {
+		std::shared_lock lock(_mutex);
+		return _directory;
+	}
+
+	std::filesystem::path DiskCache::GetFilePath(const StubKey& key) const {
+		std::shared_lock lock(_mutex);
+		if (_directory.empty()) {
+			return {};
+		}
+		return _directory / std::format("{:016x}.stub", key.Hash() ^ _environment);
+	}
+
+	bool DiskCache::Load(const StubKey& key, std::vector<uint8_t>& code) const {
+		auto path = GetFilePath(key);
+		if (path.empty()) {
+			return false;
+		}
+
+		bool found = Read(path, key, code);
+		JitStatistics::Instance().RecordDiskLookup(found);
+		return found;
+	}
+
+	bool DiskCache::Read(const std::filesystem::path& path, const StubKey& key, std::vector<uint8_t>& code) const {
+		std::error_code ec;
+		const uintmax_t fileSize = std::filesystem::file_size(path, ec);
+		if (ec) {
+			return false;
+		}
+
+		std::ifstream file(path, std::ios::binary);
+		if (!file) {
+			return false;
+		}
+
+		// sizes are checked against the file before anything is allocated from them
+		FileHeader header{};
+		if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))
+			|| header.magic != kMagic
+			|| header.format != kFormat
+			|| header.environment != _environment
+			|| header.codeSize == 0
+			|| fileSize != uintmax_t{ sizeof(header) } + header.keySize + header.codeSize) {
+			return false;
+		}
+
+		// Full key comparison guards against hash collisions
+		auto expected = SerializeKey(key);
+		if (header.keySize != expected.size()) {
+			return false;
+		}
+		std::vector<uint8_t> stored(header.keySize);
+		if (!file.read(reinterpret_cast<char*>(stored.data()), static_cast<std::streamsize>(stored.size()))
+			|| stored != expected) {
+			return false;
+		}
+
+		code.resize(header.codeSize);
+		if (!file.read(reinterpret_cast<char*>(code.data()), static_cast<std::streamsize>(code.size()))
+			|| Fnv1a(code) != header.checksum) {
+			code.clear();
+			return false;
+		}
+
+		return true;
+	}
+
+	void DiskCache::Store(const StubKey& key, std::span<const uint8_t> code) const {
+		auto path = GetFilePath(key);
+		if (path.empty() || code.empty()) {
+			return;
+		}
+
+		auto keyBytes = SerializeKey(key);
+
+		FileHeader header{
+			.magic = kMagic,
+			.format = kFormat,
+			.environment = _environment,
+			.checksum = Fnv1a(code),
+			.keySize = static_cast<uint32_t>(keyBytes.size()),
+			.codeSize = static_cast<uint32_t>(code.size()),
+		};
+
+		// unique across the processes sharing the directory and the threads of each
+		auto temp = path;
+		temp += std::format(".{}.{:x}.tmp", CurrentProcessId(), std::hash<std::thread::id>{}(std::this_thread::get_id()));
+
+		{
+			std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+			if (!file) {
+				return;
+			}
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			file.write(reinterpret_cast<const char*>(keyBytes.data()), static_cast<std::streamsize>(keyBytes.size()));
+			file.write(reinterpret_cast<const char*>(code.data()), static_cast<std::streamsize>(code.size()));
+			if (!file.flush()) {
+				file.close();
+				std::error_code ec;
+				std::filesystem::remove(temp, ec);
+				return;
+			}
+		}
+
+		std::error_code ec;
+		std::filesystem::rename(temp, path, ec);
+		if (ec) {
+			std::filesystem::remove(temp, ec);
+		}
+	}
+}  // namespace plugify
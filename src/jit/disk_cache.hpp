@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <shared_mutex>
+#include <span>
+#include <vector>
+
+#include "stub_cache.hpp"
+
+namespace plugify {
+	/**
+	 * @brief Persistent store of position-independent stub machine code.
+	 * @details One file per stub, named after the key hash mixed with the environment
+	 * (library version, architecture and host CPU features). Files are validated on load
+	 * (header, full key and checksum), so stale or foreign entries are simply ignored.
+	 * Writes go to a temporary file which is renamed in place, so concurrent writers
+	 * and processes never observe partial files.
+	 */
+	class DiskCache {
+	public:
+		static DiskCache& Instance();
+
+		void SetDirectory(const std::filesystem::path& directory);
+
+		std::filesystem::path GetDirectory() const;
+
+		/**
+		 * @brief Reads the machine code stored for the key.
+		 * @return True if a valid entry was found.
+		 */
+		bool Load(const StubKey& key, std::vector<uint8_t>& code) const;
+
+		/**
+		 * @brief Stores the machine code for the key, failures are ignored.
+		 */
+		void Store(const StubKey& key, std::span<const uint8_t> code) const;
+
+	private:
+		DiskCache();
+
+		std::filesystem::path GetFilePath(const StubKey& key) const;
+
+		bool Read(const std::filesystem::path& path, const StubKey& key, std::vector<uint8_t>& code) const;
+
+		mutable std::shared_mutex _mutex;
+		std::filesystem::path _directory;
+		uint64_t _environment;
+	};
+}  // namespace plugify
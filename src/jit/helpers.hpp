@@ -1,7 +1,11 @@
 #pragma once
 
+#include <array>
+
 #include <asmjit/core.h>
 
+#include "plugify/marshal_plan.hpp"
+#include "plugify/method.hpp"
 #include "plugify/signarure.hpp"
 #include "plugify/value_type.hpp"
 
@@ -22,6 +26,25 @@ namespace plugify {
 
 	asmjit::CallConvId GetCallConvId(CallConv callConv) noexcept;
 
+	/**
+	 * @brief Native registers a by-value struct parameter (plg::vec2/3/4) is split into.
+	 * @details The parameter slot holds a pointer to the struct, stubs load or store each
+	 * part at its offset. A zero count means the type is passed as a plain value or pointer.
+	 */
+	struct StructArgParts {
+		uint32_t count{};
+		std::array<asmjit::TypeId, 4> types{};
+		std::array<uint32_t, 4> offsets{};
+	};
+
+	StructArgParts GetStructArgParts(ValueType valueType) noexcept;
+
+	/**
+	 * @brief Checks that every by-value struct parameter is passed the way the stubs model it.
+	 * @return Error message or nullptr.
+	 */
+	const char* CheckStructArgs(const Signature& sig) noexcept;
+
 	class SimpleErrorHandler final : public asmjit::ErrorHandler {
 	public:
 		void handle_error(
@@ -45,9 +68,34 @@ namespace plugify {
 		);
 
 		for (const auto& arg : sig.argTypes) {
-			asmSig.add_arg(GetValueTypeId(arg));
+			auto parts = GetStructArgParts(arg);
+			if (parts.count == 0) {
+				asmSig.add_arg(GetValueTypeId(arg));
+				continue;
+			}
+			for (uint32_t i = 0; i < parts.count; ++i) {
+				asmSig.add_arg(parts.types[i]);
+			}
 		}
 
 		return asmSig;
 	}
+
+	/**
+	 * @brief Lowers a method into a raw signature: a hidden return becomes a pointer
+	 * return plus a leading argument, and ref parameters become pointers.
+	 */
+	inline Signature MakeSignature(const Method& method, bool (*hidden)(ValueType), bool& retHidden) {
+		// resolved methods carry it already lowered with the default predicate
+		if (!hidden) {
+			if (const MarshalPlan* plan = method.GetMarshalPlan()) {
+				retHidden = plan->retHidden;
+				return plan->signature;
+			}
+		}
+
+		MarshalPlan plan(method, hidden);
+		retHidden = plan.retHidden;
+		return plan.signature;
+	}
 }  // namespace plugify::JitUtils
@@ -0,0 +1,142 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+
+#include "plugify/jit_lazy.hpp"
+
+#include "lazy.hpp"
+#include "runtime.hpp"
+
+using namespace plugify;
+
+struct JitLazy::Impl {
+	~Impl() {
+		ReleaseCode(trampoline);
+	}
+
+	Address GetLazyFunc(Factory func, std::string_view name) {
+		if (trampoline || GetResolvedFunc()) {
+			return GetFunction();
+		}
+
+		factory = std::move(func);
+		entry.owner = this;
+		entry.resolve = &Impl::Resolve;
+
+#if PLUGIFY_ARCH_BITS == 64
+		const char* error = nullptr;
+		void* resolver = GetLazyResolver(error);
+		if (!resolver) {
+			errorCode.store(error, std::memory_order_release);
+			return nullptr;
+		}
+		entry.target.store(resolver, std::memory_order_relaxed);
+
+		void* thunk = CommitLazyTrampoline(&entry, name, error);
+		if (!thunk) {
+			errorCode.store(error, std::memory_order_release);
+			return nullptr;
+		}
+
+		trampoline = thunk;
+		return trampoline;
+#else
+		// 32-bit conventions leave no register free to carry the entry, generate it now
+		(void) name;
+		return Resolve(this);
+#endif	// PLUGIFY_ARCH_BITS
+	}
+
+	Address GetFunction() const noexcept {
+		return trampoline ? trampoline : GetResolvedFunc();
+	}
+
+	Address GetResolvedFunc() const noexcept {
+		return resolved.load(std::memory_order_acquire);
+	}
+
+	std::string_view GetError() const noexcept {
+		const char* error = errorCode.load(std::memory_order_acquire);
+		return error ? error : "";
+	}
+
+	static void* Resolve(void* owner) noexcept {
+		auto* impl = static_cast<Impl*>(owner);
+		std::call_once(impl->once, [impl] {
+			Address func = impl->factory();
+			if (!func) {
+				if (!impl->errorCode.load(std::memory_order_relaxed)) {
+					impl->errorCode.store("Failed to generate the lazy function", std::memory_order_release);
+				}
+				return;
+			}
+			impl->resolved.store(func, std::memory_order_release);
+			// later calls of the trampoline go straight to the function
+			impl->entry.target.store(func, std::memory_order_release);
+		});
+		return impl->GetResolvedFunc();
+	}
+
+	LazyEntry entry{};
+	Factory factory;
+	std::once_flag once;
+	Address trampoline;
+	// written by whichever thread first calls the trampoline, read from any other
+	std::atomic<void*> resolved{};
+	JitCallback callback;
+	std::atomic<const char*> errorCode{};  // static strings only
+};
+
+void* plugify::ResolveLazyEntry(LazyEntry* entry) noexcept {
+	void* function = entry->resolve(entry->owner);
+	if (!function) {
+		// the caller of the trampoline has no way to receive an error
+		std::fputs("plugify: lazy function could not be generated\n", stderr);
+		std::abort();
+	}
+	return function;
+}
+
+JitLazy::JitLazy()
+	: _impl(std::make_unique<Impl>()) {
+}
+
+JitLazy::JitLazy(JitLazy&& other) noexcept = default;
+
+JitLazy::~JitLazy() = default;
+
+JitLazy& JitLazy::operator=(JitLazy&& other) noexcept = default;
+
+Address JitLazy::GetLazyFunc(Factory factory) {
+	return _impl->GetLazyFunc(std::move(factory), {});
+}
+
+Address JitLazy::GetLazyFunc(
+	const Method& method,
+	JitCallback::CallbackHandler callback,
+	Address data,
+	JitCallback::HiddenParam hidden
+) {
+	Impl& impl = *_impl;
+	return impl.GetLazyFunc([&impl, &method, callback, data, hidden]() -> Address {
+		Address func = impl.callback.GetJitFunc(method, callback, data, hidden);
+		if (!func) {
+			// the callback keeps static messages, the view ends in a terminator
+			impl.errorCode.store(impl.callback.GetError().data(), std::memory_order_release);
+		}
+		return func;
+	}, method.GetName());
+}
+
+Address JitLazy::GetFunction() const noexcept {
+	return _impl->GetFunction();
+}
+
+Address JitLazy::GetResolvedFunc() const noexcept {
+	return _impl->GetResolvedFunc();
+}
+
+std::string_view JitLazy::GetError() const noexcept {
+	return _impl->GetError();
+}
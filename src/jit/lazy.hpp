@@ -0,0 +1,35 @@
+#pragma once
+
+#include <atomic>
+#include <string_view>
+
+namespace plugify {
+	/**
+	 * @brief Slot a lazy trampoline jumps through.
+	 * @details The trampoline passes the entry to the resolver in a scratch register
+	 * (r11 on x86-64, x16 on AArch64) and reads the target at offset 0, so it stays the first member.
+	 */
+	struct LazyEntry {
+		std::atomic<void*> target;
+		void* owner;
+		void* (*resolve)(void* owner) noexcept;  // generates the function once, nullptr on failure
+	};
+
+	static_assert(std::atomic<void*>::is_always_lock_free);
+
+	/**
+	 * @brief Called by the resolver with the argument registers saved.
+	 * @return Function to continue into, after the slot was patched.
+	 */
+	void* ResolveLazyEntry(LazyEntry* entry) noexcept;
+
+	/**
+	 * @brief Returns the process-wide resolver, compiling it on first use.
+	 */
+	void* GetLazyResolver(const char*& error);
+
+	/**
+	 * @brief Commits a trampoline which jumps through \p entry.
+	 */
+	void* CommitLazyTrampoline(LazyEntry* entry, std::string_view name, const char*& error);
+}  // namespace plugify
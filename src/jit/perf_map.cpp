@@ -0,0 +1,216 @@
+#include <cinttypes>
+#include <cstdlib>
+
+#if PLUGIFY_PLATFORM_LINUX
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif	// PLUGIFY_PLATFORM_LINUX
+
+#include "perf_map.hpp"
+#include "stats.hpp"
+
+namespace plugify {
+	namespace {
+		constexpr uint32_t kJitDumpMagic = 0x4A695444;  // 'JiTD'
+		constexpr uint32_t kJitDumpVersion = 1;
+		constexpr uint32_t kJitCodeLoad = 0;
+
+		struct JitDumpHeader {
+			uint32_t magic;
+			uint32_t version;
+			uint32_t totalSize;
+			uint32_t elfMach;
+			uint32_t pad1;
+			uint32_t pid;
+			uint64_t timestamp;
+			uint64_t flags;
+		};
+
+		struct JitCodeLoad {
+			uint32_t id;
+			uint32_t totalSize;
+			uint64_t timestamp;
+			uint32_t pid;
+			uint32_t tid;
+			uint64_t vma;
+			uint64_t codeAddr;
+			uint64_t codeSize;
+			uint64_t codeIndex;
+		};
+
+		constexpr uint32_t GetElfMachine() noexcept {
+#if PLUGIFY_ARCH_ARM
+			return PLUGIFY_ARCH_BITS == 64 ? 183 : 40;  // EM_AARCH64 : EM_ARM
+#else
+			return PLUGIFY_ARCH_BITS == 64 ? 62 : 3;  // EM_X86_64 : EM_386
+#endif	// PLUGIFY_ARCH_ARM
+		}
+
+		bool IsEnvEnabled(const char* name) noexcept {
+			const char* value = std::getenv(name);
+			return value && *value && std::string_view(value) != "0";
+		}
+
+#if PLUGIFY_PLATFORM_LINUX
+		// perf samples carry CLOCK_MONOTONIC when recorded with -k mono
+		uint64_t GetTimestamp() noexcept {
+			timespec ts{};
+			clock_gettime(CLOCK_MONOTONIC, &ts);
+			return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000 + static_cast<uint64_t>(ts.tv_nsec);
+		}
+#endif	// PLUGIFY_PLATFORM_LINUX
+
+		std::string MakeName(const JitSymbol& symbol) {
+			std::string name = "plugify::";
+			name += symbol.kind;
+
+			if (!symbol.method.empty()) {
+				name += ' ';
+				name += symbol.method;
+			}
+			if (symbol.signature) {
+				name += ' ';
+				name += FormatSignature(*symbol.signature, symbol.hidden);
+			}
+			return name;
+		}
+	}
+
+	JitProfiler& JitProfiler::Instance() {
+		static JitProfiler profiler;
+		return profiler;
+	}
+
+	JitProfiler::JitProfiler() {
+		JitProfilerOutput output = JitProfilerOutput::None;
+		if (IsEnvEnabled("PLUGIFY_PERF_MAP")) {
+			output = output | JitProfilerOutput::PerfMap;
+		}
+		if (IsEnvEnabled("PLUGIFY_JITDUMP")) {
+			output = output | JitProfilerOutput::JitDump;
+		}
+		if (output != JitProfilerOutput::None) {
+			Open(output);
+		}
+	}
+
+	JitProfiler::~JitProfiler() {
+		Close(true, true);
+	}
+
+	void JitProfiler::SetOutput(JitProfilerOutput output) {
+		std::lock_guard lock(_mutex);
+		// files which stay enabled are kept, reopening the dump would truncate it
+		Close(!(output & JitProfilerOutput::PerfMap), !(output & JitProfilerOutput::JitDump));
+		Open(output);
+	}
+
+	void JitProfiler::Open([[maybe_unused]] JitProfilerOutput output) {
+#if PLUGIFY_PLATFORM_LINUX
+		const auto pid = static_cast<uint32_t>(getpid());
+		char path[64];
+
+		if ((output & JitProfilerOutput::PerfMap) && !_perfMap) {
+			std::snprintf(path, sizeof(path), "/tmp/perf-%" PRIu32 ".map", pid);
+			_perfMap = std::fopen(path, "a");
+		}
+
+		if ((output & JitProfilerOutput::JitDump) && !_jitDump) {
+			std::snprintf(path, sizeof(path), "/tmp/jit-%" PRIu32 ".dump", pid);
+			_jitDump = std::fopen(path, "w+");
+			if (_jitDump) {
+				// perf inject finds the dump through this executable mapping of the file
+				long pageSize = sysconf(_SC_PAGESIZE);
+				_marker = mmap(nullptr, static_cast<size_t>(pageSize), PROT_READ | PROT_EXEC, MAP_PRIVATE, fileno(_jitDump), 0);
+				if (_marker == MAP_FAILED) {
+					_marker = nullptr;
+				}
+
+				JitDumpHeader header{
+					.magic = kJitDumpMagic,
+					.version = kJitDumpVersion,
+					.totalSize = sizeof(JitDumpHeader),
+					.elfMach = GetElfMachine(),
+					.pad1 = 0,
+					.pid = pid,
+					.timestamp = GetTimestamp(),
+					.flags = 0,
+				};
+				std::fwrite(&header, sizeof(header), 1, _jitDump);
+				std::fflush(_jitDump);
+			}
+		}
+#endif	// PLUGIFY_PLATFORM_LINUX
+
+		UpdateOutput();
+	}
+
+	void JitProfiler::Close(bool perfMap, bool jitDump) {
+		if (perfMap && _perfMap) {
+			std::fclose(_perfMap);
+			_perfMap = nullptr;
+		}
+
+		if (jitDump && _jitDump) {
+#if PLUGIFY_PLATFORM_LINUX
+			if (_marker) {
+				munmap(_marker, static_cast<size_t>(sysconf(_SC_PAGESIZE)));
+				_marker = nullptr;
+			}
+#endif	// PLUGIFY_PLATFORM_LINUX
+			std::fclose(_jitDump);
+			_jitDump = nullptr;
+		}
+
+		UpdateOutput();
+	}
+
+	void JitProfiler::UpdateOutput() noexcept {
+		JitProfilerOutput output = JitProfilerOutput::None;
+		if (_perfMap) {
+			output = output | JitProfilerOutput::PerfMap;
+		}
+		if (_jitDump) {
+			output = output | JitProfilerOutput::JitDump;
+		}
+		_output.store(output, std::memory_order_relaxed);
+	}
+
+	void JitProfiler::AddSymbol([[maybe_unused]] const void* code, [[maybe_unused]] size_t size, [[maybe_unused]] const JitSymbol& symbol) {
+#if PLUGIFY_PLATFORM_LINUX
+		if (!IsEnabled() || !code || !size) {
+			return;
+		}
+
+		const std::string name = MakeName(symbol);
+		const auto address = reinterpret_cast<uintptr_t>(code);
+
+		std::lock_guard lock(_mutex);
+
+		if (_perfMap) {
+			std::fprintf(_perfMap, "%" PRIxPTR " %zx %s\n", address, size, name.c_str());
+			std::fflush(_perfMap);
+		}
+
+		if (_jitDump) {
+			JitCodeLoad record{
+				.id = kJitCodeLoad,
+				.totalSize = static_cast<uint32_t>(sizeof(JitCodeLoad) + name.size() + 1 + size),
+				.timestamp = GetTimestamp(),
+				.pid = static_cast<uint32_t>(getpid()),
+				.tid = static_cast<uint32_t>(syscall(SYS_gettid)),
+				.vma = address,
+				.codeAddr = address,
+				.codeSize = size,
+				.codeIndex = _codeIndex++,
+			};
+			std::fwrite(&record, sizeof(record), 1, _jitDump);
+			std::fwrite(name.c_str(), name.size() + 1, 1, _jitDump);
+			std::fwrite(code, size, 1, _jitDump);
+			std::fflush(_jitDump);
+		}
+#endif	// PLUGIFY_PLATFORM_LINUX
+	}
+}  // namespace plugify
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#include "plugify/jit_context.hpp"
+
+namespace plugify {
+	/**
+	 * @brief Describes a committed stub, only turned into a symbol name when an output is enabled.
+	 */
+	struct JitSymbol {
+		std::string_view kind;  ///< call, generic, loop, callback or typed
+		const Signature* signature{};
+		bool hidden{};
+		std::string_view method{};  ///< Empty for stubs shared by every method of a signature
+	};
+
+	/**
+	 * @brief Writes perf map and jitdump records for committed stubs.
+	 * @details See tools/perf/Documentation/jit-interface.txt and jitdump-specification.txt
+	 * of the Linux sources. Records are flushed one by one, stubs are rare enough and the
+	 * files stay usable if the process crashes.
+	 */
+	class JitProfiler {
+	public:
+		static JitProfiler& Instance();
+
+		bool IsEnabled() const noexcept {
+			return _output.load(std::memory_order_relaxed) != JitProfilerOutput::None;
+		}
+
+		JitProfilerOutput GetOutput() const noexcept {
+			return _output.load(std::memory_order_relaxed);
+		}
+
+		void SetOutput(JitProfilerOutput output);
+
+		/**
+		 * @brief Announces the code in [code, code + size).
+		 */
+		void AddSymbol(const void* code, size_t size, const JitSymbol& symbol);
+
+	private:
+		JitProfiler();
+		~JitProfiler();
+
+		void Open(JitProfilerOutput output);
+		void Close(bool perfMap, bool jitDump);
+		void UpdateOutput() noexcept;
+
+		std::atomic<JitProfilerOutput> _output{};
+		std::mutex _mutex;
+		FILE* _perfMap{};
+		FILE* _jitDump{};
+		void* _marker{};
+		uint64_t _codeIndex{};
+	};
+
+	/**
+	 * @brief Carries the method name down to the commit of stubs created through the
+	 * Signature based overloads, which do not know the method.
+	 */
+	class JitSymbolScope {
+	public:
+		explicit JitSymbolScope(std::string_view method) noexcept
+			: _previous(_current) {
+			_current = method;
+		}
+
+		~JitSymbolScope() {
+			_current = _previous;
+		}
+
+		JitSymbolScope(const JitSymbolScope&) = delete;
+		JitSymbolScope& operator=(const JitSymbolScope&) = delete;
+
+		static std::string_view Current() noexcept {
+			return _current;
+		}
+
+	private:
+		static inline thread_local std::string_view _current;
+		std::string_view _previous;
+	};
+}  // namespace plugify
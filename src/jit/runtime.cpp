@@ -0,0 +1,66 @@
+#include <atomic>
+#include <mutex>
+
+#include "runtime.hpp"
+#include "stats.hpp"
+
+namespace plugify {
+	asmjit::JitRuntime& GetJitRuntime() noexcept {
+		static asmjit::JitRuntime rt;
+		return rt;
+	}
+
+	// Code is generated on the caller's thread into its own CodeHolder,
+	// only the relocation into executable memory is serialized here.
+	static std::mutex& GetCommitMutex() noexcept {
+		static std::mutex mutex;
+		return mutex;
+	}
+
+	void* CommitCode(asmjit::CodeHolder& code, const JitSymbol& symbol) noexcept {
+		void* function = nullptr;
+		// everything past the machine code of .text is constant pools, data sections and padding
+		const size_t codeBytes = code.text_section()->real_size();
+		{
+			std::lock_guard lock(GetCommitMutex());
+			if (GetJitRuntime().add(&function, &code) != asmjit::Error::kOk) {
+				return nullptr;
+			}
+
+			const size_t totalBytes = code.code_size();
+			JitStatistics::Instance().OnCommit(function, codeBytes, totalBytes > codeBytes ? totalBytes - codeBytes : 0);
+		}
+
+		auto& profiler = JitProfiler::Instance();
+		if (!symbol.kind.empty() && profiler.IsEnabled()) {
+			profiler.AddSymbol(function, codeBytes, symbol);
+		}
+		return function;
+	}
+
+	void ReleaseCode(void* function) noexcept {
+		if (function) {
+			std::lock_guard lock(GetCommitMutex());
+			GetJitRuntime().release(function);
+			JitStatistics::Instance().OnRelease(function);
+		}
+	}
+
+	// the Assembler stays opt-in until its cross-check against the Compiler runs in CI
+	static std::atomic<JitEmitter> emitter{ JitEmitter::Compiler };
+
+	JitEmitter GetJitEmitter() noexcept {
+		return emitter.load(std::memory_order_relaxed);
+	}
+
+	void SetJitEmitter(JitEmitter value) noexcept {
+		emitter.store(value, std::memory_order_relaxed);
+	}
+
+	void GetRuntimeMemory(size_t& reserved, size_t& overhead) noexcept {
+		std::lock_guard lock(GetCommitMutex());
+		auto stats = GetJitRuntime().allocator()->statistics();
+		reserved = stats.reserved_size();
+		overhead = stats.overhead_size();
+	}
+}  // namespace plugify
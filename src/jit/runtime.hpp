@@ -0,0 +1,43 @@
+#pragma once
+
+#include <asmjit/core.h>
+
+#include "plugify/jit_context.hpp"
+
+#include "perf_map.hpp"
+
+namespace plugify {
+	/**
+	 * @brief Process-wide runtime shared by every generated stub
+	 * (JitCall, JitCallback and cached generic stubs).
+	 */
+	asmjit::JitRuntime& GetJitRuntime() noexcept;
+
+	/**
+	 * @brief Relocates the code held by \p code into executable memory of the shared runtime.
+	 * @details Single commit point for every generated stub or batch of stubs.
+	 * Thread-safe: callers emit into their own CodeHolder concurrently and only the
+	 * commit itself is serialized.
+	 * When a profiler output is enabled the block is announced under \p symbol; blocks holding
+	 * several stubs pass no symbol and announce each stub themselves.
+	 * @return Address of the start of the committed block, or nullptr on failure.
+	 */
+	void* CommitCode(asmjit::CodeHolder& code, const JitSymbol& symbol = {}) noexcept;
+
+	/**
+	 * @brief Releases a block previously returned by CommitCode. Thread-safe.
+	 */
+	void ReleaseCode(void* function) noexcept;
+
+	/**
+	 * @brief Emitter used for generic call stubs compiled from now on, see JitContext::SetEmitter().
+	 */
+	JitEmitter GetJitEmitter() noexcept;
+
+	void SetJitEmitter(JitEmitter emitter) noexcept;
+
+	/**
+	 * @brief Reads the executable memory reserved by the shared runtime and its allocator overhead.
+	 */
+	void GetRuntimeMemory(size_t& reserved, size_t& overhead) noexcept;
+}  // namespace plugify
@@ -0,0 +1,183 @@
+#include <algorithm>
+
+#include "runtime.hpp"
+#include "stats.hpp"
+
+namespace plugify {
+	namespace {
+		// In ValueType declaration order
+		constexpr std::array<std::string_view, static_cast<size_t>(ValueType::_LastAssigned) + 1> kValueNames = {
+			ValueName::Invalid,
+			ValueName::Void,
+			ValueName::Bool,
+			ValueName::Char8,
+			ValueName::Char16,
+			ValueName::Int8,
+			ValueName::Int16,
+			ValueName::Int32,
+			ValueName::Int64,
+			ValueName::UInt8,
+			ValueName::UInt16,
+			ValueName::UInt32,
+			ValueName::UInt64,
+			ValueName::Pointer,
+			ValueName::Float,
+			ValueName::Double,
+			ValueName::Function,
+			ValueName::String,
+			ValueName::Any,
+			ValueName::ArrayBool,
+			ValueName::ArrayChar8,
+			ValueName::ArrayChar16,
+			ValueName::ArrayInt8,
+			ValueName::ArrayInt16,
+			ValueName::ArrayInt32,
+			ValueName::ArrayInt64,
+			ValueName::ArrayUInt8,
+			ValueName::ArrayUInt16,
+			ValueName::ArrayUInt32,
+			ValueName::ArrayUInt64,
+			ValueName::ArrayPointer,
+			ValueName::ArrayFloat,
+			ValueName::ArrayDouble,
+			ValueName::ArrayString,
+			ValueName::ArrayAny,
+			ValueName::ArrayVector2,
+			ValueName::ArrayVector3,
+			ValueName::ArrayVector4,
+			ValueName::ArrayMatrix4x4,
+			ValueName::Vector2,
+			ValueName::Vector3,
+			ValueName::Vector4,
+			ValueName::Matrix4x4,
+		};
+
+		std::string_view GetValueName(ValueType type) noexcept {
+			auto index = static_cast<size_t>(type);
+			return index < kValueNames.size() ? kValueNames[index] : ValueName::Invalid;
+		}
+
+		Signature ToSignature(const StubKey& key) {
+			return { key.callConv, key.retType, key.varIndex, key.argTypes };
+		}
+	}
+
+	std::string FormatSignature(const Signature& signature, bool hidden) {
+		std::string name(GetValueName(signature.retType));
+		name += '(';
+		for (size_t i = 0; i < signature.argTypes.size(); ++i) {
+			if (i != 0) {
+				name += ", ";
+			}
+			if (i == signature.varIndex) {
+				name += "...";
+				break;
+			}
+			name += GetValueName(signature.argTypes[i]);
+		}
+		name += ')';
+		if (hidden) {
+			name += " [hidden]";
+		}
+		return name;
+	}
+
+	JitStatistics& JitStatistics::Instance() {
+		static JitStatistics stats;
+		return stats;
+	}
+
+	void JitStatistics::RecordStub(JitStubKind kind, const Signature& signature, bool hidden) {
+		const auto index = static_cast<size_t>(kind);
+		_stubs[index].fetch_add(1, std::memory_order_relaxed);
+
+		// StubKind only tells the cache entries apart, the stats kind is counted separately
+		StubKey key(StubKind::Call, signature, 0, hidden);
+		std::lock_guard lock(_mutex);
+		auto& counts = _signatures.try_emplace(std::move(key)).first->second;
+		++counts[index];
+	}
+
+	void JitStatistics::RecordCompile(std::chrono::nanoseconds elapsed) noexcept {
+		const int64_t ns = elapsed.count();
+		_compilations.fetch_add(1, std::memory_order_relaxed);
+		_totalCompileTime.fetch_add(ns, std::memory_order_relaxed);
+
+		int64_t max = _maxCompileTime.load(std::memory_order_relaxed);
+		while (ns > max && !_maxCompileTime.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+		}
+	}
+
+	void JitStatistics::OnCommit(void* block, size_t codeBytes, size_t dataBytes) {
+		std::lock_guard lock(_mutex);
+		_blocks.emplace(block, BlockSize{ codeBytes, dataBytes });
+		_codeBytes += codeBytes;
+		_dataBytes += dataBytes;
+	}
+
+	void JitStatistics::OnRelease(void* block) {
+		std::lock_guard lock(_mutex);
+		if (auto it = _blocks.find(block); it != _blocks.end()) {
+			_codeBytes -= it->second.code;
+			_dataBytes -= it->second.data;
+			_blocks.erase(it);
+		}
+	}
+
+	JitStats JitStatistics::Snapshot() const {
+		JitStats stats;
+		for (size_t i = 0; i < _stubs.size(); ++i) {
+			stats.stubs[i] = _stubs[i].load(std::memory_order_relaxed);
+		}
+		stats.compilations = _compilations.load(std::memory_order_relaxed);
+		stats.totalCompileTime = std::chrono::nanoseconds(_totalCompileTime.load(std::memory_order_relaxed));
+		stats.maxCompileTime = std::chrono::nanoseconds(_maxCompileTime.load(std::memory_order_relaxed));
+		stats.cacheHits = _cacheHits.load(std::memory_order_relaxed);
+		stats.cacheMisses = _cacheMisses.load(std::memory_order_relaxed);
+		stats.thunkHits = _thunkHits.load(std::memory_order_relaxed);
+		stats.diskHits = _diskHits.load(std::memory_order_relaxed);
+		stats.diskMisses = _diskMisses.load(std::memory_order_relaxed);
+
+		{
+			std::lock_guard lock(_mutex);
+			stats.liveBlocks = _blocks.size();
+			stats.codeBytes = _codeBytes;
+			stats.dataBytes = _dataBytes;
+
+			for (const auto& [key, counts] : _signatures) {
+				for (size_t i = 0; i < counts.size(); ++i) {
+					if (counts[i] != 0) {
+						stats.signatures.push_back({
+							.kind = static_cast<JitStubKind>(i),
+							.signature = ToSignature(key),
+							.name = FormatSignature(ToSignature(key), key.hidden),
+							.count = counts[i],
+						});
+					}
+				}
+			}
+		}
+
+		std::ranges::sort(stats.signatures, std::ranges::greater{}, &JitSignatureStats::count);
+
+		GetRuntimeMemory(stats.reservedBytes, stats.overheadBytes);
+		return stats;
+	}
+
+	void JitStatistics::Reset() {
+		for (auto& count : _stubs) {
+			count.store(0, std::memory_order_relaxed);
+		}
+		_compilations.store(0, std::memory_order_relaxed);
+		_totalCompileTime.store(0, std::memory_order_relaxed);
+		_maxCompileTime.store(0, std::memory_order_relaxed);
+		_cacheHits.store(0, std::memory_order_relaxed);
+		_cacheMisses.store(0, std::memory_order_relaxed);
+		_thunkHits.store(0, std::memory_order_relaxed);
+		_diskHits.store(0, std::memory_order_relaxed);
+		_diskMisses.store(0, std::memory_order_relaxed);
+
+		std::lock_guard lock(_mutex);
+		_signatures.clear();
+	}
+}  // namespace plugify
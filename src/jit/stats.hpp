@@ -0,0 +1,124 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "plugify/jit_context.hpp"
+
+#include "stub_cache.hpp"
+
+namespace plugify {
+	/**
+	 * @brief Process-wide JIT counters behind JitContext::GetStats.
+	 * @details Hot counters are relaxed atomics; the per-signature table and the
+	 * live block sizes take a mutex, which is only hit when code is generated or released.
+	 */
+	class JitStatistics {
+	public:
+		static JitStatistics& Instance();
+
+		/**
+		 * @brief Counts a created stub under its kind and signature.
+		 */
+		void RecordStub(JitStubKind kind, const Signature& signature, bool hidden);
+
+		/**
+		 * @brief Accounts one compiled code unit.
+		 */
+		void RecordCompile(std::chrono::nanoseconds elapsed) noexcept;
+
+		void RecordCacheLookup(bool hit) noexcept {
+			(hit ? _cacheHits : _cacheMisses).fetch_add(1, std::memory_order_relaxed);
+		}
+
+		void RecordThunkHit() noexcept {
+			_thunkHits.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		void RecordDiskLookup(bool hit) noexcept {
+			(hit ? _diskHits : _diskMisses).fetch_add(1, std::memory_order_relaxed);
+		}
+
+		/**
+		 * @brief Tracks a block committed to the runtime, called under the commit lock.
+		 */
+		void OnCommit(void* block, size_t codeBytes, size_t dataBytes);
+
+		/**
+		 * @brief Forgets a block released from the runtime, called under the commit lock.
+		 */
+		void OnRelease(void* block);
+
+		JitStats Snapshot() const;
+
+		void Reset();
+
+	private:
+		JitStatistics() = default;
+
+		struct BlockSize {
+			size_t code;
+			size_t data;
+		};
+
+		std::array<std::atomic<size_t>, static_cast<size_t>(JitStubKind::Count)> _stubs{};
+		std::atomic<size_t> _compilations{};
+		std::atomic<int64_t> _totalCompileTime{};
+		std::atomic<int64_t> _maxCompileTime{};
+		std::atomic<size_t> _cacheHits{};
+		std::atomic<size_t> _cacheMisses{};
+		std::atomic<size_t> _thunkHits{};
+		std::atomic<size_t> _diskHits{};
+		std::atomic<size_t> _diskMisses{};
+
+		mutable std::mutex _mutex;
+		std::unordered_map<StubKey, std::array<size_t, static_cast<size_t>(JitStubKind::Count)>, StubKeyHash> _signatures;
+		std::unordered_map<void*, BlockSize> _blocks;
+		size_t _codeBytes{};
+		size_t _dataBytes{};
+	};
+
+	/**
+	 * @brief Readable form of a signature, e.g. `double(double, int32)`.
+	 */
+	std::string FormatSignature(const Signature& signature, bool hidden);
+
+	/**
+	 * @brief Measures a compilation, accounted with Record() once its stub is kept.
+	 * @details Nothing is recorded on its own, so failed compilations and stubs which
+	 * lost the race to publish their key are not counted. The time between each Start()
+	 * and Stop() adds up, a timer which was never stopped records nothing.
+	 */
+	class CompileTimer {
+	public:
+		CompileTimer() noexcept = default;
+
+		void Start() noexcept {
+			_start = std::chrono::steady_clock::now();
+		}
+
+		void Stop() noexcept {
+			_elapsed += std::chrono::steady_clock::now() - _start;
+			_measured = true;
+		}
+
+		void Record() const noexcept {
+			if (_measured) {
+				JitStatistics::Instance().RecordCompile(_elapsed);
+			}
+		}
+
+		CompileTimer(const CompileTimer&) = delete;
+		CompileTimer& operator=(const CompileTimer&) = delete;
+
+	private:
+		std::chrono::steady_clock::time_point _start;
+		std::chrono::nanoseconds _elapsed{};
+		bool _measured{};
+	};
+}  // namespace plugify
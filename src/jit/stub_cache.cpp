@@ -0,0 +1,51 @@
+#include "stats.hpp"
+#include "stub_cache.hpp"
+
+namespace plugify {
+	StubKey::StubKey(StubKind kind, const Signature& sig, uint8_t waitType, bool hidden)
+		: kind(kind)
+		, callConv(sig.callConv)
+		, retType(sig.retType)
+		, varIndex(sig.varIndex)
+		, waitType(waitType)
+		, hidden(hidden)
+		, argTypes(sig.argTypes) {
+	}
+
+	uint64_t StubKey::Hash() const noexcept {
+		uint64_t hash = 0xcbf29ce484222325ULL;
+		auto mix = [&](uint8_t byte) {
+			hash ^= byte;
+			hash *= 0x100000001b3ULL;
+		};
+
+		mix(static_cast<uint8_t>(kind));
+		mix(static_cast<uint8_t>(callConv));
+		mix(static_cast<uint8_t>(retType));
+		mix(varIndex);
+		mix(waitType);
+		mix(static_cast<uint8_t>(hidden));
+		mix(static_cast<uint8_t>(argTypes.size()));
+		for (const auto& arg : argTypes) {
+			mix(static_cast<uint8_t>(arg));
+		}
+		return hash;
+	}
+
+	StubCache& StubCache::Instance() {
+		static StubCache cache;
+		return cache;
+	}
+
+	void* StubCache::Find(const StubKey& key) const {
+		void* stub = nullptr;
+		{
+			std::shared_lock lock(_mutex);
+			if (auto it = _stubs.find(key); it != _stubs.end()) {
+				stub = it->second;
+			}
+		}
+		JitStatistics::Instance().RecordCacheLookup(stub != nullptr);
+		return stub;
+	}
+}  // namespace plugify
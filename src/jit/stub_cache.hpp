@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include "plugify/signarure.hpp"
+#include "plugify/value_type.hpp"
+
+#include "runtime.hpp"
+
+namespace plugify {
+	/**
+	 * @brief Kind of generated code, part of the cache key.
+	 */
+	enum class StubKind : uint8_t {
+		Call,  ///< Generic JitCall stub, target is passed as data
+		SharedLoop,  ///< Loop stub calling many targets with the same parameters
+		EachLoop,  ///< Loop stub calling with a parameter block per iteration
+		Closure,  ///< JitClosure stub, callback and data are passed as context
+		AssembledCall,  ///< Generic JitCall stub written by the Assembler emitter
+	};
+
+	/**
+	 * @brief Canonical description of a stub: everything that influences the generated code.
+	 * @details Ref parameters are already lowered to ValueType::Pointer in the signature,
+	 * so methods which only differ by names or ref-ness of pointers share a key.
+	 */
+	struct StubKey {
+		StubKind kind{};
+		CallConv callConv{};
+		ValueType retType{};
+		uint8_t varIndex{ Signature::kNoVarArgs };
+		uint8_t waitType{};
+		bool hidden{};
+		std::inplace_vector<ValueType, Signature::kMaxFuncArgs> argTypes{};
+
+		StubKey(StubKind kind, const Signature& sig, uint8_t waitType, bool hidden);
+
+		bool operator==(const StubKey& other) const = default;
+
+		/**
+		 * @brief FNV-1a hash over the canonical fields.
+		 */
+		uint64_t Hash() const noexcept;
+	};
+
+	/**
+	 * @brief Kind of the generic call stub produced by the current emitter.
+	 * @details Stubs calling a wait helper always come from the compiler. Keeping the kinds
+	 * apart lets both emitters live side by side in the memory and disk caches.
+	 */
+	inline StubKind GetCallStubKind(uint8_t waitType) noexcept {
+		return waitType == 0 && GetJitEmitter() == JitEmitter::Assembler ? StubKind::AssembledCall : StubKind::Call;
+	}
+
+	struct StubKeyHash {
+		size_t operator()(const StubKey& key) const noexcept {
+			return static_cast<size_t>(key.Hash());
+		}
+	};
+
+	/**
+	 * @brief Process-wide cache of generic stubs, keyed by signature.
+	 * @details Stubs live for the whole process lifetime, so the amount of
+	 * generated code scales with the number of distinct signatures.
+	 */
+	class StubCache {
+	public:
+		static StubCache& Instance();
+
+		/**
+		 * @brief Returns the cached stub or compiles it with the given function.
+		 * @details Compilation runs outside of the lock so threads compiling different
+		 * signatures never wait for each other. If two threads race on the same key,
+		 * the first published stub wins and the other one is released.
+		 * Failed compilations (nullptr) are not cached.
+		 * @param published Called once the compiled stub is stored, never for a failed
+		 * compilation or a stub which lost the race, so statistics count each stub once.
+		 */
+		template <typename Compile, typename Published>
+		void* GetOrCompile(const StubKey& key, Compile&& compile, Published&& published) {
+			if (void* stub = Find(key)) {
+				return stub;
+			}
+			void* stub = compile();
+			if (!stub) {
+				return nullptr;
+			}
+			void* winner = Insert(key, stub);
+			if (winner != stub) {
+				ReleaseCode(stub);
+			} else {
+				published();
+			}
+			return winner;
+		}
+
+		/**
+		 * @brief Returns the cached stub or nullptr, counted as a cache hit or miss.
+		 */
+		void* Find(const StubKey& key) const;
+
+		/**
+		 * @brief Publishes a stub compiled elsewhere (e.g. by a batch).
+		 * @return The stub now stored for the key, which is the existing one if another
+		 * thread published first.
+		 */
+		void* Insert(const StubKey& key, void* stub) {
+			std::unique_lock lock(_mutex);
+			return _stubs.emplace(key, stub).first->second;
+		}
+
+		size_t Size() const {
+			std::shared_lock lock(_mutex);
+			return _stubs.size();
+		}
+
+		/**
+		 * @brief Forgets every stub, the code itself stays committed since
+		 * stubs handed out earlier may still be called.
+		 */
+		void Clear() {
+			std::unique_lock lock(_mutex);
+			_stubs.clear();
+		}
+
+	private:
+		mutable std::shared_mutex _mutex;
+		std::unordered_map<StubKey, void*, StubKeyHash> _stubs;
+	};
+}  // namespace plugify
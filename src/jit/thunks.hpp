@@ -0,0 +1,152 @@
+#pragma once
+
+#include <array>
+#include <cstring>
+#include <utility>
+
+#include <asmjit/core.h>
+
+#include "plugify/callback.hpp"
+#include "plugify/signarure.hpp"
+
+#include "closure.hpp"
+#include "helpers.hpp"
+#include "stats.hpp"
+
+// Ahead-of-time stubs for the most common signature shapes under the SysV x86-64 ABI:
+// up to 6 integer or pointer arguments and a void, integer or pointer return.
+// Every such argument travels in a full 64-bit general purpose register, exactly like
+// the generated code moves whole uint64_t slots, so one template per arity covers every
+// integer type and no asmjit compilation is needed for these signatures.
+#if PLUGIFY_ARCH_BITS == 64 && !PLUGIFY_ARCH_ARM && !PLUGIFY_PLATFORM_WINDOWS
+#define PLUGIFY_JIT_HAS_THUNKS 1
+#else
+#define PLUGIFY_JIT_HAS_THUNKS 0
+#endif
+
+#if PLUGIFY_JIT_HAS_THUNKS
+namespace plugify::thunks {
+	// Integer argument registers of the SysV ABI
+	constexpr size_t kMaxCallArgs = 6;
+
+	// Callback thunks receive their context in the register after the last argument
+	constexpr size_t kMaxCallbackArgs = kMaxCallArgs - 1;
+
+	template <size_t>
+	using Slot = uint64_t;
+
+	/**
+	 * @brief Generic call stub with the same contract as the compiled one:
+	 * void(params, ret, target).
+	 */
+	using CallThunkFunc = void (*)(const uint64_t* params, void* ret, void* target);
+
+	template <bool HasRet, size_t N>
+	void CallThunk([[maybe_unused]] const uint64_t* params, [[maybe_unused]] void* ret, void* target) {
+		[&]<size_t... I>(std::index_sequence<I...>) {
+			if constexpr (HasRet) {
+				using Func = uint64_t (*)(Slot<I>...);
+				uint64_t value = reinterpret_cast<Func>(target)(params[I]...);
+				std::memcpy(ret, &value, sizeof(value));
+			} else {
+				using Func = void (*)(Slot<I>...);
+				reinterpret_cast<Func>(target)(params[I]...);
+			}
+		}(std::make_index_sequence<N>{});
+	}
+
+	/**
+	 * @brief Context of a precompiled callback entry, the one closures use as well.
+	 */
+	using CallbackContext = ClosureContext;
+
+	template <typename Seq>
+	struct CallbackThunk;
+
+	template <size_t... I>
+	struct CallbackThunk<std::index_sequence<I...>> {
+		// Same behaviour as the compiled callback stub: spill, call the handler, return slot 0
+		static uint64_t Invoke(Slot<I>... args, const CallbackContext* context) {
+			constexpr size_t N = sizeof...(I);
+			std::array<uint64_t, N == 0 ? 1 : N> params{ args... };
+			std::array<uint64_t, 2> ret{};
+
+			if (context->hidden) {
+				auto* retPtr = reinterpret_cast<void*>(params[0]);
+				context->callback(context->method, context->data, params.data() + 1, N - 1, retPtr);
+				return params[0];
+			}
+
+			context->callback(context->method, context->data, params.data(), N, ret.data());
+			return ret[0];
+		}
+	};
+
+	inline bool IsThunkType(ValueType type) noexcept {
+		// By-value vectors are split into vector registers
+		return GetStructArgParts(type).count == 0 && asmjit::TypeUtils::is_int(GetValueTypeId(type));
+	}
+
+	inline bool IsThunkSignature(const Signature& signature, size_t maxArgs) noexcept {
+		if (signature.callConv != CallConv::CDecl && signature.callConv != CallConv::X64SystemV) {
+			return false;
+		}
+		if (signature.varIndex != Signature::kNoVarArgs || signature.ArgCount() > maxArgs) {
+			return false;
+		}
+		if (signature.HasRet() && !asmjit::TypeUtils::is_int(GetRetTypeId(signature.retType))) {
+			return false;
+		}
+		for (const auto& type : signature.argTypes) {
+			if (!IsThunkType(type)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	template <bool HasRet, size_t... N>
+	consteval std::array<CallThunkFunc, sizeof...(N)> MakeCallThunks(std::index_sequence<N...>) {
+		return { &CallThunk<HasRet, N>... };
+	}
+
+	template <size_t... N>
+	std::array<void*, sizeof...(N)> MakeCallbackThunks(std::index_sequence<N...>) {
+		return { reinterpret_cast<void*>(&CallbackThunk<std::make_index_sequence<N>>::Invoke)... };
+	}
+
+	/**
+	 * @brief Returns a precompiled generic call stub for the signature, or nullptr.
+	 */
+	inline void* FindCallThunk(const Signature& signature) noexcept {
+		static constexpr auto kVoidThunks = MakeCallThunks<false>(std::make_index_sequence<kMaxCallArgs + 1>{});
+		static constexpr auto kValueThunks = MakeCallThunks<true>(std::make_index_sequence<kMaxCallArgs + 1>{});
+
+		if (!IsThunkSignature(signature, kMaxCallArgs)) {
+			return nullptr;
+		}
+
+		JitStatistics::Instance().RecordThunkHit();
+
+		const auto& thunks = signature.HasRet() ? kValueThunks : kVoidThunks;
+		return reinterpret_cast<void*>(thunks[signature.ArgCount()]);
+	}
+
+	/**
+	 * @brief Returns a precompiled callback entry for the signature, or nullptr.
+	 * @details The entry expects a CallbackContext in the argument register following
+	 * the last argument, see @ref kMaxCallbackArgs.
+	 */
+	inline void* FindCallbackThunk(const Signature& signature) noexcept {
+		static const auto kThunks = MakeCallbackThunks(std::make_index_sequence<kMaxCallbackArgs + 1>{});
+
+		if (!IsThunkSignature(signature, kMaxCallbackArgs)) {
+			return nullptr;
+		}
+
+		JitStatistics::Instance().RecordThunkHit();
+
+		return kThunks[signature.ArgCount()];
+	}
+}  // namespace plugify::thunks
+#endif	// PLUGIFY_JIT_HAS_THUNKS
@@ -1,55 +1,191 @@
+#include <atomic>
+
 #include <asmjit/x86.h>
 
 #include "plugify/call.hpp"
 
 #include "../helpers.hpp"
+#include "../disk_cache.hpp"
+#include "../runtime.hpp"
+#include "../stats.hpp"
+#include "../stub_cache.hpp"
+#include "../thunks.hpp"
+#include "emitters.hpp"
 
 using namespace plugify;
 using namespace asmjit;
 
-static JitRuntime rt;
+namespace plugify {
+	struct ArgRegSlot {
+		explicit ArgRegSlot(uint32_t idx) {
+			argIdx = idx;
+			useHighReg = false;
+		}
 
-struct JitCall::Impl {
-	Impl()
-		: function(nullptr)
-		, targetFunc(nullptr) {
+		Reg low;
+		Reg high;
+		uint32_t argIdx;
+		bool useHighReg;
+	};
+
+	using ArgRegSlots = std::inplace_vector<ArgRegSlot, Globals::kMaxFuncArgs>;
+
+	// map argument slots of the params block to registers, following abi. (We can have multiple
+	// register per arg slot such as high and low 32bits of a 64bit slot, or the parts of a by-value vector)
+	static bool LoadCallArgs(
+		x86::Compiler& cc,
+		const Signature& signature,
+		const FuncSignature& sig,
+		const x86::Gp& params,
+		ArgRegSlots& argRegSlots,
+		const char*& error
+	) {
+		int32_t offset = 0;
+		uint32_t argIdx = 0;
+		for (const auto& valueType : signature.argTypes) {
+			x86::Mem paramMem = ptr(params, offset);
+			paramMem.set_size(sizeof(uint64_t));
+
+			// next structure slot (+= sizeof(uint64_t))
+			offset += sizeof(uint64_t);
+
+			if (auto parts = GetStructArgParts(valueType); parts.count != 0) {
+				// slot holds a pointer to the struct, load each part into its own register
+				x86::Gp structPtr = cc.new_gpz();
+				cc.mov(structPtr, paramMem);
+
+				for (uint32_t part = 0; part < parts.count; ++part) {
+					ArgRegSlot argSlot(argIdx++);
+					x86::Mem partMem = ptr(structPtr, static_cast<int32_t>(parts.offsets[part]));
+					if (parts.types[part] == TypeId::kFloat32) {
+						argSlot.low = cc.new_xmm();
+						cc.movd(argSlot.low.as<x86::Vec>(), partMem);
+					} else if (parts.types[part] == TypeId::kFloat64) {
+						argSlot.low = cc.new_xmm();
+						cc.movq(argSlot.low.as<x86::Vec>(), partMem);
+					} else {
+						argSlot.low = cc.new_gpz();
+						cc.mov(argSlot.low.as<x86::Gp>(), partMem);
+					}
+					argRegSlots.push_back(std::move(argSlot));
+				}
+				continue;
+			}
+
+			const auto& argType = sig.args()[argIdx];
+
+			ArgRegSlot argSlot(argIdx++);
+
+			if (TypeUtils::is_int(argType)) {
+				argSlot.low = cc.new_gpz();
+				cc.mov(argSlot.low.as<x86::Gp>(), paramMem);
+
+				if (HasHiArgSlot(argType)) {
+					paramMem.add_offset(sizeof(uint32_t));
+
+					argSlot.high = cc.new_gpz();
+					argSlot.useHighReg = true;
+					cc.mov(argSlot.high.as<x86::Gp>(), paramMem);
+				}
+			} else if (TypeUtils::is_float(argType)) {
+				argSlot.low = cc.new_xmm();
+				cc.movq(argSlot.low.as<x86::Vec>(), paramMem);
+			} else {
+				// ex: void example(__m128i xmmreg) is invalid:
+				// https://github.com/asmjit/asmjit/issues/83
+				error = "Parameters wider than 64bits not supported";
+				return false;
+			}
+
+			argRegSlots.push_back(std::move(argSlot));
+		}
+
+		return true;
 	}
 
-	~Impl() {
-		if (function) {
-			rt.release(function);
+	// Map call params to the args
+	static void BindCallArgs(InvokeNode* invokeNode, const ArgRegSlots& argRegSlots) {
+		for (const auto& argSlot : argRegSlots) {
+			invokeNode->set_arg(argSlot.argIdx, 0, argSlot.low);
+			if (argSlot.useHighReg) {
+				invokeNode->set_arg(argSlot.argIdx, 1, argSlot.high);
+			}
 		}
 	}
 
-	Address GetJitFunc(
+	// Stores the result of the call into the Return pointed by ret
+	static bool StoreCallRet(
+		x86::Compiler& cc,
+		const FuncSignature& sig,
+		InvokeNode* invokeNode,
+		const x86::Gp& returnImm,
+		const char*& error
+	) {
+		if (!sig.has_ret()) {
+			return true;
+		}
+
+#if PLUGIFY_ARCH_BITS == 32
+		if (TypeUtils::is_between(sig.ret(), TypeId::kInt64, TypeId::kUInt64)) {
+			cc.mov(ptr(returnImm), x86::eax);
+			cc.mov(ptr(returnImm, sizeof(uint32_t)), x86::edx);
+		} else
+#endif	// PLUGIFY_ARCH_BITS
+			if (TypeUtils::is_int(sig.ret())) {
+				x86::Gp tmp = cc.new_gpz();
+				invokeNode->set_ret(0, tmp);
+				cc.mov(ptr(returnImm), tmp);
+			}
+#if !PLUGIFY_PLATFORM_WINDOWS && PLUGIFY_ARCH_BITS == 64
+			else if (TypeUtils::is_between(sig.ret(), TypeId::kInt8x16, TypeId::kUInt64x2)) {
+				cc.mov(ptr(returnImm), x86::rax);
+				cc.mov(ptr(returnImm, sizeof(uint64_t)), x86::rdx);
+			} else if (TypeUtils::is_between(sig.ret(), TypeId::kFloat32x4, TypeId::kFloat64x2)) {
+				cc.movq(ptr(returnImm), x86::xmm0);
+				cc.movq(ptr(returnImm, sizeof(uint64_t)), x86::xmm1);
+			}
+#endif	// PLUGIFY_ARCH_BITS
+			else if (TypeUtils::is_float(sig.ret())) {
+				x86::Vec ret = cc.new_xmm();
+				invokeNode->set_ret(0, ret);
+				cc.movq(ptr(returnImm), ret);
+			} else {
+				// ex: void example(__m128i xmmreg) is invalid:
+				// https://github.com/asmjit/asmjit/issues/83
+				error = "Return wider than 64bits not supported";
+				return false;
+			}
+
+		return true;
+	}
+
+	FuncNode* EmitCallStub(
+		x86::Compiler& cc,
 		const Signature& signature,
 		Address target,
-		WaitType waitType,
-		[[maybe_unused]] bool hidden
+		JitCall::WaitType waitType,
+		[[maybe_unused]] bool hidden,
+		const char*& error
 	) {
-		if (function) {
-			return function;
+		if (const char* structError = CheckStructArgs(signature)) {
+			error = structError;
+			return nullptr;
 		}
 
-		targetFunc = target;
-
 		auto sig = ConvertSignature(signature);
 
-		SimpleErrorHandler eh;
-		CodeHolder code;
-		code.init(rt.environment(), rt.cpu_features());
-		code.set_error_handler(&eh);
-
 		// initialize function
-		x86::Compiler cc(&code);
-		FuncNode* func = cc.add_func(FuncSignature::build<void, void*, void*>());
+		FuncNode* func = cc.add_func(
+			target ? FuncSignature::build<void, void*, void*>()
+				   : FuncSignature::build<void, void*, void*, void*>()
+		);
 
 #if 0
 		StringLogger log;
 		auto kFormatFlags = FormatFlags::kMachineCode | FormatFlags::kExplainImms | FormatFlags::kRegCasts | FormatFlags::kHexImms | FormatFlags::kHexOffsets | FormatFlags::kPositions;
 
 		log.addFlags(kFormatFlags);
-		code.setLogger(&log);
+		cc.code()->setLogger(&log);
 #endif
 
 #if PLUGIFY_IS_RELEASE
@@ -63,150 +199,633 @@ struct JitCall::Impl {
 		x86::Gp returnImm = cc.new_gpz();
 		func->set_arg(1, returnImm);
 
-		// paramMem = ((char*)paramImm) + i (char* size walk, uint64_t size r/w)
-		x86::Gp i = cc.new_gpz();
-		x86::Mem paramMem = ptr(paramImm, i);
-		paramMem.set_size(sizeof(uint64_t));
+		x86::Gp targetImm;
+		if (!target) {
+			targetImm = cc.new_gpz();
+			func->set_arg(2, targetImm);
+		}
 
-		// i = 0
-		cc.mov(i, 0);
+		ArgRegSlots argRegSlots;
+		if (!LoadCallArgs(cc, signature, sig, paramImm, argRegSlots, error)) {
+			return nullptr;
+		}
+
+		// allows debuggers to trap
+		if (waitType == JitCall::WaitType::Breakpoint) {
+			cc.int3();
+		} else if (waitType == JitCall::WaitType::Wait_Keypress) {
+			InvokeNode* invokeNode;
+			cc.invoke(Out(invokeNode), static_cast<uint64_t>(reinterpret_cast<uintptr_t>(&getchar)), FuncSignature::build<int>());
+		}
+
+		// Gen the call
+		InvokeNode* invokeNode;
+		if (target) {
+			cc.invoke(Out(invokeNode), static_cast<uint64_t>(static_cast<uintptr_t>(target)), sig);
+		} else {
+			cc.invoke(Out(invokeNode), targetImm, sig);
+		}
+
+		BindCallArgs(invokeNode, argRegSlots);
+
+		if (!StoreCallRet(cc, sig, invokeNode, returnImm, error)) {
+			return nullptr;
+		}
+
+		cc.ret();
+
+		// end of the function body
+		cc.end_func();
 
-		struct ArgRegSlot {
-			explicit ArgRegSlot(uint32_t idx) {
-				argIdx = idx;
-				useHighReg = false;
+		return func;
+	}
+
+	FuncNode* EmitLoopCallStub(
+		x86::Compiler& cc,
+		const Signature& signature,
+		LoopCallKind kind,
+		bool hidden,
+		const char*& error
+	) {
+		if (kind == LoopCallKind::Shared && hidden) {
+			error = kSharedHiddenError;
+			return nullptr;
+		}
+		if (const char* structError = CheckStructArgs(signature)) {
+			error = structError;
+			return nullptr;
+		}
+
+		auto sig = ConvertSignature(signature);
+
+		// void(params, paramStride, rets, retStride, targets, targetStride, count)
+		FuncNode* func = cc.add_func(FuncSignature::build<void, const void*, size_t, void*, size_t, const void*, size_t, size_t>());
+
+		x86::Gp params = cc.new_gpz("params");
+		x86::Gp paramStride = cc.new_gpz("paramStride");
+		x86::Gp rets = cc.new_gpz("rets");
+		x86::Gp retStride = cc.new_gpz("retStride");
+		x86::Gp targets = cc.new_gpz("targets");
+		x86::Gp targetStride = cc.new_gpz("targetStride");
+		x86::Gp count = cc.new_gpz("count");
+		func->set_arg(0, params);
+		func->set_arg(1, paramStride);
+		func->set_arg(2, rets);
+		func->set_arg(3, retStride);
+		func->set_arg(4, targets);
+		func->set_arg(5, targetStride);
+		func->set_arg(6, count);
+
+		Label loop = cc.new_label();
+		Label done = cc.new_label();
+
+		cc.test(count, count);
+		cc.jz(done);
+
+		// shared arguments are loaded once, the register allocator keeps them alive across calls
+		ArgRegSlots sharedArgs;
+		if (kind == LoopCallKind::Shared && !LoadCallArgs(cc, signature, sig, params, sharedArgs, error)) {
+			return nullptr;
+		}
+
+		cc.bind(loop);
+
+		ArgRegSlots argRegSlots;
+		if (kind == LoopCallKind::Each) {
+			if (!LoadCallArgs(cc, signature, sig, params, argRegSlots, error)) {
+				return nullptr;
 			}
+		}
 
-			Reg low;
-			Reg high;
-			uint32_t argIdx;
-			bool useHighReg;
-		};
+		x86::Gp target = cc.new_gpz("target");
+		cc.mov(target, ptr(targets));
 
-		std::inplace_vector<ArgRegSlot, Globals::kMaxFuncArgs> argRegSlots;
-		size_t offsetNextSlot = sizeof(uint64_t);
+		InvokeNode* invokeNode;
+		cc.invoke(Out(invokeNode), target, sig);
+		BindCallArgs(invokeNode, kind == LoopCallKind::Shared ? sharedArgs : argRegSlots);
 
-		// map argument slots to registers, following abi. (We can have multiple register per arg
-		// slot such as high and low 32bits of a 64bit slot)
-		for (uint32_t argIdx = 0; argIdx < sig.arg_count(); ++argIdx) {
-			const auto& argType = sig.args()[argIdx];
+		if (!StoreCallRet(cc, sig, invokeNode, rets, error)) {
+			return nullptr;
+		}
 
-			ArgRegSlot argSlot(argIdx);
+		cc.add(params, paramStride);
+		cc.add(rets, retStride);
+		cc.add(targets, targetStride);
+		cc.dec(count);
+		cc.jnz(loop);
 
-			if (TypeUtils::is_int(argType)) {
-				argSlot.low = cc.new_gpz();
-				cc.mov(argSlot.low.as<x86::Gp>(), paramMem);
+		cc.bind(done);
+		cc.ret();
 
-				if (HasHiArgSlot(argType)) {
-					cc.add(i, sizeof(uint32_t));
-					offsetNextSlot -= sizeof(uint32_t);
+		// end of the function body
+		cc.end_func();
 
-					argSlot.high = cc.new_gpz();
-					argSlot.useHighReg = true;
-					cc.mov(argSlot.high.as<x86::Gp>(), paramMem);
-				}
-			} else if (TypeUtils::is_float(argType)) {
-				argSlot.low = cc.new_xmm();
-				cc.movq(argSlot.low.as<x86::Vec>(), paramMem);
+		return func;
+	}
+
+	bool CanAssembleCallStub([[maybe_unused]] const Signature& signature) noexcept {
+#if PLUGIFY_ARCH_BITS == 64
+		// varargs need al and Win64 float duplication, left to the compiler
+		return signature.varIndex == Signature::kNoVarArgs;
+#else
+		return false;
+#endif	// PLUGIFY_ARCH_BITS
+	}
+
+	// Registers by id, as FuncDetail reports them
+	static const std::array<x86::Gp, 16> kGpRegs = {
+		x86::rax, x86::rcx, x86::rdx, x86::rbx, x86::rsp, x86::rbp, x86::rsi, x86::rdi,
+		x86::r8, x86::r9, x86::r10, x86::r11, x86::r12, x86::r13, x86::r14, x86::r15
+	};
+	static const std::array<x86::Vec, 16> kVecRegs = {
+		x86::xmm0, x86::xmm1, x86::xmm2, x86::xmm3, x86::xmm4, x86::xmm5, x86::xmm6, x86::xmm7,
+		x86::xmm8, x86::xmm9, x86::xmm10, x86::xmm11, x86::xmm12, x86::xmm13, x86::xmm14, x86::xmm15
+	};
+
+	// Loads one argument of the call from memory into the register or stack slot the ABI assigns to it
+	static void LoadAssembledArg(x86::Assembler& a, const FuncValue& arg, TypeId typeId, x86::Mem src) {
+
+		// only the float members of a by-value vector are narrower than a slot
+		const bool narrow = typeId == TypeId::kFloat32;
+		src.set_size(narrow ? sizeof(float) : sizeof(uint64_t));
+
+		if (arg.is_stack()) {
+			// rax carries no argument in either convention
+			x86::Mem dst = x86::ptr(x86::rsp, arg.stack_offset(), narrow ? sizeof(float) : sizeof(uint64_t));
+			if (narrow) {
+				a.mov(x86::eax, src);
+				a.mov(dst, x86::eax);
 			} else {
-				// ex: void example(__m128i xmmreg) is invalid:
-				// https://github.com/asmjit/asmjit/issues/83
-				errorCode = "Parameters wider than 64bits not supported";
-				return nullptr;
+				a.mov(x86::rax, src);
+				a.mov(dst, x86::rax);
 			}
+		} else if (TypeUtils::is_float(typeId)) {
+			if (narrow) {
+				a.movd(kVecRegs[arg.reg_id()], src);
+			} else {
+				a.movq(kVecRegs[arg.reg_id()], src);
+			}
+		} else {
+			a.mov(kGpRegs[arg.reg_id()], src);
+		}
+	}
 
-			argRegSlots.push_back(std::move(argSlot));
+	bool EmitAssembledCallStub(
+		x86::Assembler& a,
+		const Signature& signature,
+		[[maybe_unused]] bool hidden,
+		const char*& error
+	) {
+		if (const char* structError = CheckStructArgs(signature)) {
+			error = structError;
+			return false;
+		}
 
-			// next structure slot (+= sizeof(uint64_t))
-			cc.add(i, offsetNextSlot);
-			offsetNextSlot = sizeof(uint64_t);
+		if (!CanAssembleCallStub(signature)) {
+			error = "Signature is not supported by the assembler emitter";
+			return false;
 		}
 
-		// allows debuggers to trap
-		if (waitType == WaitType::Breakpoint) {
-			cc.int3();
-		} else if (waitType == WaitType::Wait_Keypress) {
-			InvokeNode* invokeNode;
-			cc.invoke(Out(invokeNode), static_cast<uint64_t>(reinterpret_cast<uintptr_t>(&getchar)), FuncSignature::build<int>());
+		auto sig = ConvertSignature(signature);
+
+		// where the ABI places the arguments of the stub itself and of the call it makes,
+		// the same layout the compiler works from
+		FuncDetail stubDetail;
+		FuncDetail callDetail;
+		if (stubDetail.init(FuncSignature::build<void, void*, void*, void*>(), a.environment()) != Error::kOk ||
+			callDetail.init(sig, a.environment()) != Error::kOk) {
+			error = "Failed to lay out the call";
+			return false;
 		}
 
-		// Gen the call
-		InvokeNode* invokeNode;
-		cc.invoke(Out(invokeNode), static_cast<uint64_t>(static_cast<uintptr_t>(target)), sig);
+		// params and the struct pointer use volatile registers which never carry an argument,
+		// ret and target are kept in callee-saved ones
+		const x86::Gp params = x86::r10;
+		const x86::Gp structPtr = x86::r11;
+		const x86::Gp returnPtr = x86::rbx;
+		const x86::Gp target = x86::r12;
 
-		// Map call params to the args
-		for (const auto& argSlot : argRegSlots) {
-			invokeNode->set_arg(argSlot.argIdx, 0, argSlot.low);
-			if (argSlot.useHighReg) {
-				invokeNode->set_arg(argSlot.argIdx, 1, argSlot.high);
+		FuncFrame frame;
+		frame.init(stubDetail);
+		frame.add_attributes(FuncAttributes::kHasFuncCalls);
+		frame.set_call_stack_size(callDetail.arg_stack_size());
+		frame.add_dirty_regs(returnPtr, target);
+		frame.finalize();
+
+		a.emit_prolog(frame);
+
+		// the argument registers of the stub are reused by the call
+		a.mov(params, kGpRegs[stubDetail.arg(0).reg_id()]);
+		a.mov(returnPtr, kGpRegs[stubDetail.arg(1).reg_id()]);
+		a.mov(target, kGpRegs[stubDetail.arg(2).reg_id()]);
+
+		int32_t offset = 0;
+		uint32_t argIdx = 0;
+		for (const auto& valueType : signature.argTypes) {
+			x86::Mem paramMem = x86::ptr(params, offset);
+
+			// next structure slot (+= sizeof(uint64_t))
+			offset += sizeof(uint64_t);
+
+			if (auto parts = GetStructArgParts(valueType); parts.count != 0) {
+				// slot holds a pointer to the struct, load each part into its own register
+				a.mov(structPtr, paramMem);
+				for (uint32_t part = 0; part < parts.count; ++part, ++argIdx) {
+					LoadAssembledArg(a, callDetail.arg(argIdx), parts.types[part], x86::ptr(structPtr, static_cast<int32_t>(parts.offsets[part])));
+				}
+				continue;
+			}
+
+			const auto& argType = sig.args()[argIdx];
+			if (!TypeUtils::is_int(argType) && !TypeUtils::is_float(argType)) {
+				error = "Parameters wider than 64bits not supported";
+				return false;
 			}
+
+			// slots are read whole, as the compiler does
+			LoadAssembledArg(a, callDetail.arg(argIdx++), TypeUtils::is_float(argType) ? TypeId::kFloat64 : argType, paramMem);
 		}
 
+		a.call(target);
+
+		// Stores the result of the call into the Return pointed by ret
 		if (sig.has_ret()) {
-#if PLUGIFY_ARCH_BITS == 32
-			if (TypeUtils::is_between(sig.ret(), TypeId::kInt64, TypeId::kUInt64)) {
-				cc.mov(ptr(returnImm), x86::eax);
-				cc.mov(ptr(returnImm, sizeof(uint32_t)), x86::edx);
-			} else
-#endif	// PLUGIFY_ARCH_BITS
-				if (TypeUtils::is_int(sig.ret())) {
-					x86::Gp tmp = cc.new_gpz();
-					invokeNode->set_ret(0, tmp);
-					cc.mov(ptr(returnImm), tmp);
-				}
-#if !PLUGIFY_PLATFORM_WINDOWS && PLUGIFY_ARCH_BITS == 64
-				else if (TypeUtils::is_between(sig.ret(), TypeId::kInt8x16, TypeId::kUInt64x2)) {
-					cc.mov(ptr(returnImm), x86::rax);
-					cc.mov(ptr(returnImm, sizeof(uint64_t)), x86::rdx);
-				} else if (TypeUtils::is_between(sig.ret(), TypeId::kFloat32x4, TypeId::kFloat64x2)) {
-					cc.movq(ptr(returnImm), x86::xmm0);
-					cc.movq(ptr(returnImm, sizeof(uint64_t)), x86::xmm1);
-				}
-#endif	// PLUGIFY_ARCH_BITS
-				else if (TypeUtils::is_float(sig.ret())) {
-					x86::Vec ret = cc.new_xmm();
-					invokeNode->set_ret(0, ret);
-					cc.movq(ptr(returnImm), ret);
-				} else {
-					// ex: void example(__m128i xmmreg) is invalid:
-					// https://github.com/asmjit/asmjit/issues/83
-					errorCode = "Return wider than 64bits not supported";
-					return nullptr;
-				}
+			if (TypeUtils::is_int(sig.ret())) {
+				a.mov(x86::qword_ptr(returnPtr), x86::rax);
+			}
+#if !PLUGIFY_PLATFORM_WINDOWS
+			else if (TypeUtils::is_between(sig.ret(), TypeId::kInt8x16, TypeId::kUInt64x2)) {
+				a.mov(x86::qword_ptr(returnPtr), x86::rax);
+				a.mov(x86::qword_ptr(returnPtr, sizeof(uint64_t)), x86::rdx);
+			} else if (TypeUtils::is_between(sig.ret(), TypeId::kFloat32x4, TypeId::kFloat64x2)) {
+				a.movq(x86::qword_ptr(returnPtr), x86::xmm0);
+				a.movq(x86::qword_ptr(returnPtr, sizeof(uint64_t)), x86::xmm1);
+			}
+#endif	// PLUGIFY_PLATFORM_WINDOWS
+			else if (TypeUtils::is_float(sig.ret())) {
+				a.movq(x86::qword_ptr(returnPtr), x86::xmm0);
+			} else {
+				// ex: void example(__m128i xmmreg) is invalid:
+				// https://github.com/asmjit/asmjit/issues/83
+				error = "Return wider than 64bits not supported";
+				return false;
+			}
 		}
 
-		cc.ret();
+		a.emit_epilog(frame);
 
-		// end of the function body
-		cc.end_func();
+		return true;
+	}
+
+	void EmitBindThunk(x86::Assembler& a, void* stub, Address target) {
+		// target -> third argument register, then jump to the generic stub
+#if PLUGIFY_PLATFORM_WINDOWS
+		a.mov(x86::r8, static_cast<uint64_t>(static_cast<uintptr_t>(target)));
+#else
+		a.mov(x86::rdx, static_cast<uint64_t>(static_cast<uintptr_t>(target)));
+#endif	// PLUGIFY_PLATFORM_WINDOWS
+		a.mov(x86::rax, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(stub)));
+		a.jmp(x86::rax);
+	}
+}  // namespace plugify
+
+static void* CompileCallStub(
+	const Signature& signature,
+	Address target,
+	JitCall::WaitType waitType,
+	bool hidden,
+	const char*& error
+) {
+	auto& rt = GetJitRuntime();
+
+	SimpleErrorHandler eh;
+	CodeHolder code;
+	code.init(rt.environment(), rt.cpu_features());
+	code.set_error_handler(&eh);
+
+	x86::Compiler cc(&code);
+	if (!EmitCallStub(cc, signature, target, waitType, hidden, error)) {
+		return nullptr;
+	}
+
+	// write to buffer
+	cc.finalize();
+
+	void* function = CommitCode(code, {
+		target ? "call" : "generic",
+		&signature,
+		hidden,
+		target ? JitSymbolScope::Current() : std::string_view{},
+	});
+	if (eh.error != Error::kOk || !function) {
+		error = eh.code ? eh.code : "Failed to commit code";
+		return nullptr;
+	}
+
+	return function;
+}
+
+static void* CompileLoopCallStub(
+	const Signature& signature,
+	LoopCallKind kind,
+	bool hidden,
+	const char*& error
+) {
+	auto& rt = GetJitRuntime();
+
+	SimpleErrorHandler eh;
+	CodeHolder code;
+	code.init(rt.environment(), rt.cpu_features());
+	code.set_error_handler(&eh);
+
+	x86::Compiler cc(&code);
+	if (!EmitLoopCallStub(cc, signature, kind, hidden, error)) {
+		return nullptr;
+	}
+
+	// write to buffer
+	cc.finalize();
+
+	void* function = CommitCode(code, { "loop", &signature, hidden });
+	if (eh.error != Error::kOk || !function) {
+		error = eh.code ? eh.code : "Failed to commit code";
+		return nullptr;
+	}
+
+	return function;
+}
+
+static bool CompileGenericCode(
+	const Signature& signature,
+	bool hidden,
+	bool assembled,
+	std::vector<uint8_t>& out,
+	const char*& error
+) {
+	auto& rt = GetJitRuntime();
+
+	SimpleErrorHandler eh;
+	CodeHolder code;
+	code.init(rt.environment(), rt.cpu_features());
+	code.set_error_handler(&eh);
+
+	if (assembled && CanAssembleCallStub(signature)) {
+		// fixed calling sequence written directly, no register allocation
+		x86::Assembler a(&code);
+		if (!EmitAssembledCallStub(a, signature, hidden, error)) {
+			return false;
+		}
+	} else {
+		x86::Compiler cc(&code);
+		if (!EmitCallStub(cc, signature, nullptr, JitCall::WaitType::None, hidden, error)) {
+			return false;
+		}
 
 		// write to buffer
 		cc.finalize();
+	}
+
+	if (eh.error != Error::kOk) {
+		error = eh.code;
+		return false;
+	}
+
+	// All labels are bound, so without relocations the buffer is the final code
+	if (code.section_count() != 1 || code.has_reloc_entries()) {
+		error = "Generic stub is not relocatable";
+		return false;
+	}
+
+	const auto& buffer = code.text_section()->buffer();
+	out.assign(buffer.data(), buffer.data() + buffer.size());
+	return true;
+}
+
+static void* CommitGenericCode(std::span<const uint8_t> bytes, const Signature& signature, bool hidden, const char*& error) {
+	auto& rt = GetJitRuntime();
+
+	SimpleErrorHandler eh;
+	CodeHolder code;
+	code.init(rt.environment(), rt.cpu_features());
+	code.set_error_handler(&eh);
+
+	x86::Assembler a(&code);
+	a.embed(bytes.data(), bytes.size());
+
+	void* function = CommitCode(code, { "generic", &signature, hidden });
+	if (eh.error != Error::kOk || !function) {
+		error = eh.code ? eh.code : "Failed to commit code";
+		return nullptr;
+	}
+
+	return function;
+}
+
+bool plugify::LoadOrCompileGenericCode(
+	const StubKey& key,
+	const Signature& signature,
+	bool hidden,
+	std::vector<uint8_t>& code,
+	CompileTimer& timer,
+	const char*& error
+) {
+	auto& disk = DiskCache::Instance();
+	if (disk.Load(key, code)) {
+		return true;
+	}
+	// only an actual compilation is timed, not the lookups before it
+	timer.Start();
+	const bool compiled = CompileGenericCode(signature, hidden, key.kind == StubKind::AssembledCall, code, error);
+	timer.Stop();
+	if (!compiled) {
+		return false;
+	}
+	disk.Store(key, code);
+	return true;
+}
+
+struct JitCall::Impl {
+	Impl()
+		: function(nullptr)
+		, targetFunc(nullptr) {
+	}
+
+	~Impl() {
+		ReleaseCode(function);
+	}
+
+	Address GetJitFunc(
+		const Signature& signature,
+		Address target,
+		WaitType waitType,
+		bool hidden
+	) {
+		if (function) {
+			return function;
+		}
 
-		rt.add(&function, &code);
+		const char* error = nullptr;
+		CompileTimer timer;
+
+#if PLUGIFY_ARCH_BITS == 64
+		// Methods sharing a signature share one generic stub,
+		// only a tiny thunk binding the target is emitted per call
+		void* stub = GetGenericCallStub(signature, waitType, hidden, error);
+		void* func = stub ? BindTarget(stub, target, signature, hidden, error) : nullptr;
+#else
+		timer.Start();
+		void* func = CompileCallStub(signature, target, waitType, hidden, error);
+		timer.Stop();
+#endif	// PLUGIFY_ARCH_BITS
 
-		if (eh.error != Error::kOk) {
-			function = nullptr;
-			errorCode = eh.code;
+		if (!func) {
+			errorCode = error;
 			return nullptr;
 		}
 
-#if 0
-		std::printf("JIT Stub[%p]:\n%s\n", (void*)function, log.data());
-#endif
+		timer.Record();
+		JitStatistics::Instance().RecordStub(JitStubKind::Call, signature, hidden);
 
+		function = func;
+		targetFunc = target;
+		callSignature = signature;
+		retHidden = hidden;
 		return function;
 	}
 
+	bool Invoke(
+		LoopCallKind kind,
+		const uint64_t* params,
+		size_t paramStride,
+		Return* rets,
+		size_t retStride,
+		const Address* targets,
+		size_t targetStride,
+		size_t count
+	) {
+		if (!function) {
+			return false;
+		}
+		if (kind == LoopCallKind::Shared && retHidden) {
+			invokeError.store(kSharedHiddenError, std::memory_order_release);
+			return false;
+		}
+
+		auto& slot = loopStubs[static_cast<size_t>(kind)];
+		void* stub = slot.load(std::memory_order_acquire);
+		if (!stub) {
+			const char* error = nullptr;
+			stub = GetLoopCallStub(callSignature, kind, retHidden, error);
+			if (!stub) {
+				invokeError.store(error, std::memory_order_release);
+				return false;
+			}
+			slot.store(stub, std::memory_order_release);
+		}
+
+		// the stub always stores the result, give it a slot to overwrite
+		Return scratch;
+		if (!rets) {
+			rets = &scratch;
+			retStride = 0;
+		}
+
+		using LoopFunc = void (*)(const void*, size_t, void*, size_t, const void*, size_t, size_t);
+		reinterpret_cast<LoopFunc>(stub)(params, paramStride, rets, retStride, targets, targetStride, count);
+		return true;
+	}
+
+	static void* BindTarget(void* stub, Address target, const Signature& signature, bool hidden, const char*& error) {
+		auto& rt = GetJitRuntime();
+
+		SimpleErrorHandler eh;
+		CodeHolder code;
+		code.init(rt.environment(), rt.cpu_features());
+		code.set_error_handler(&eh);
+
+		x86::Assembler a(&code);
+		EmitBindThunk(a, stub, target);
+
+		void* thunk = CommitCode(code, { "call", &signature, hidden, JitSymbolScope::Current() });
+		if (eh.error != Error::kOk || !thunk) {
+			error = eh.code ? eh.code : "Failed to commit code";
+			return nullptr;
+		}
+
+		return thunk;
+	}
+
 	Address function;
 
 	union {
 		Address targetFunc;
 		const char* errorCode{};
 	};
+
+	// Loop stubs are owned by the stub cache, only looked up once per kind
+	Signature callSignature;
+	bool retHidden{};
+	std::array<std::atomic<void*>, 2> loopStubs{};
+	// last failure of InvokeAll/InvokeEach, which may run concurrently
+	std::atomic<const char*> invokeError{};
 };
 
-using namespace plugify;
+void* plugify::GetGenericCallStub(
+	const Signature& signature,
+	JitCall::WaitType waitType,
+	bool hidden,
+	const char*& error
+) {
+#if PLUGIFY_JIT_HAS_THUNKS
+	// Common integer/pointer shapes are served by precompiled stubs
+	if (waitType == JitCall::WaitType::None) {
+		if (void* thunk = thunks::FindCallThunk(signature)) {
+			return thunk;
+		}
+	}
+#endif	// PLUGIFY_JIT_HAS_THUNKS
+
+	StubKey key(GetCallStubKind(static_cast<uint8_t>(waitType)), signature, static_cast<uint8_t>(waitType), hidden);
+	CompileTimer timer;
+	return StubCache::Instance().GetOrCompile(key, [&]() -> void* {
+		if (waitType != JitCall::WaitType::None) {
+			// Wait helpers are called by absolute address, never persisted
+			timer.Start();
+			void* stub = CompileCallStub(signature, nullptr, waitType, hidden, error);
+			timer.Stop();
+			return stub;
+		}
+
+		std::vector<uint8_t> code;
+		if (!LoadOrCompileGenericCode(key, signature, hidden, code, timer, error)) {
+			return nullptr;
+		}
+		return CommitGenericCode(code, signature, hidden, error);
+	}, [&] {
+		timer.Record();
+		JitStatistics::Instance().RecordStub(JitStubKind::Generic, signature, hidden);
+	});
+}
+
+void* plugify::GetLoopCallStub(
+	const Signature& signature,
+	LoopCallKind kind,
+	bool hidden,
+	const char*& error
+) {
+	// Loop stubs are rare enough to stay in memory only
+	StubKey key(kind == LoopCallKind::Shared ? StubKind::SharedLoop : StubKind::EachLoop, signature, 0, hidden);
+	CompileTimer timer;
+	return StubCache::Instance().GetOrCompile(key, [&]() -> void* {
+		timer.Start();
+		void* stub = CompileLoopCallStub(signature, kind, hidden, error);
+		timer.Stop();
+		return stub;
+	}, [&] {
+		timer.Record();
+		JitStatistics::Instance().RecordStub(JitStubKind::Loop, signature, hidden);
+	});
+}
 
 JitCall::JitCall()
 	: _impl(std::make_unique<Impl>()) {
@@ -223,20 +842,10 @@ Address JitCall::GetJitFunc(const Signature& signature, Address target, WaitType
 }
 
 Address JitCall::GetJitFunc(const Method& method, Address target, WaitType waitType, HiddenParam hidden) {
-	ValueType retType = method.GetRetType().GetType();
-	bool retHidden = hidden(retType);
+	JitSymbolScope scope(method.GetName());
 
-	Signature signature(
-		method.GetCallConv(),
-		retHidden ? ValueType::Pointer : retType,
-		method.GetVarIndex()
-	);
-	if (retHidden) {
-		signature.AddArg(retType);
-	}
-	for (const auto& type : method.GetParamTypes()) {
-		signature.AddArg(type.IsRef() ? ValueType::Pointer : type.GetType());
-	}
+	bool retHidden;
+	Signature signature = MakeSignature(method, hidden, retHidden);
 
 	return GetJitFunc(signature, target, waitType, retHidden);
 }
@@ -249,6 +858,50 @@ Address JitCall::GetTargetFunc() const noexcept {
 	return _impl->targetFunc;
 }
 
+const Signature& JitCall::GetSignature() const noexcept {
+	return _impl->callSignature;
+}
+
+bool JitCall::InvokeAll(std::span<const Address> targets, const Parameters& params, std::span<Return> rets) {
+	_impl->invokeError.store(nullptr, std::memory_order_relaxed);
+	if (!rets.empty() && rets.size() < targets.size()) {
+		_impl->invokeError.store(kShortRetsError, std::memory_order_release);
+		return false;
+	}
+
+	return _impl->Invoke(
+		LoopCallKind::Shared,
+		params.Get(), 0,
+		rets.data(), sizeof(Return),
+		targets.data(), sizeof(Address),
+		targets.size()
+	);
+}
+
+bool JitCall::InvokeEach(std::span<const Parameters> params, std::span<Return> rets) {
+	_impl->invokeError.store(nullptr, std::memory_order_relaxed);
+	if (!rets.empty() && rets.size() < params.size()) {
+		_impl->invokeError.store(kShortRetsError, std::memory_order_release);
+		return false;
+	}
+	if (params.empty()) {
+		return _impl->function != nullptr;
+	}
+
+	// Parameters are laid out back to back, so the slots of each are one object apart
+	return _impl->Invoke(
+		LoopCallKind::Each,
+		params.front().Get(), sizeof(Parameters),
+		rets.data(), sizeof(Return),
+		&_impl->targetFunc, 0,
+		params.size()
+	);
+}
+
 std::string_view JitCall::GetError() noexcept {
-	return !_impl->function && _impl->errorCode ? _impl->errorCode : "";
+	if (!_impl->function) {
+		return _impl->errorCode ? _impl->errorCode : "";
+	}
+	const char* error = _impl->invokeError.load(std::memory_order_acquire);
+	return error ? error : "";
 }
@@ -2,55 +2,50 @@
 
 #include "plugify/callback.hpp"
 
+#include "../closure.hpp"
 #include "../helpers.hpp"
+#include "../runtime.hpp"
+#include "../stats.hpp"
+#include "../thunks.hpp"
+#include "emitters.hpp"
 
 using namespace plugify;
 using namespace asmjit;
 
-static JitRuntime rt;
-
-struct JitCallback::Impl {
-	Impl()
-		: function(nullptr)
-		, userData(nullptr) {
-	}
-
-	~Impl() {
-		if (function) {
-			rt.release(function);
-		}
-	}
-
-	Address GetJitFunc(
+namespace plugify {
+	// Without a bound method, callback and data the stub reads them from the
+	// ClosureContext passed as extra trailing argument
+	static FuncNode* EmitCallbackBody(
+		x86::Compiler& cc,
 		const Signature& signature,
 		const Method* method,
-		CallbackHandler callback,
+		JitCallback::CallbackHandler callback,
 		Address data,
-		bool hidden
+		bool hidden,
+		bool closure,
+		const char*& error
 	) {
-		if (function) {
-			return function;
+		if (const char* structError = CheckStructArgs(signature)) {
+			error = structError;
+			return nullptr;
 		}
 
-		userData = data;
-
 		auto sig = ConvertSignature(signature);
 
-		SimpleErrorHandler eh;
-		CodeHolder code;
-		code.init(rt.environment(), rt.cpu_features());
-		code.set_error_handler(&eh);
+		FuncSignature funcSig = sig;
+		if (closure) {
+			funcSig.add_arg(TypeId::kUIntPtr);
+		}
 
 		// initialize function
-		x86::Compiler cc(&code);
-		FuncNode* func = cc.add_func(sig);
+		FuncNode* func = cc.add_func(funcSig);
 
 #if 0
 		StringLogger log;
 		auto kFormatFlags = FormatFlags::kMachineCode | FormatFlags::kExplainImms | FormatFlags::kRegCasts | FormatFlags::kHexImms | FormatFlags::kHexOffsets | FormatFlags::kPositions;
 
 		log.addFlags(kFormatFlags);
-		code.setLogger(&log);
+		cc.code()->setLogger(&log);
 #endif
 
 #if PLUGIFY_IS_RELEASE
@@ -89,7 +84,7 @@ struct JitCallback::Impl {
 			} else if (TypeUtils::is_float(argType)) {
 				argSlot.low = cc.new_xmm();
 			} else {
-				errorCode = "Parameters wider than 64bits not supported";
+				error = "Parameters wider than 64bits not supported";
 				return nullptr;
 			}
 
@@ -101,11 +96,17 @@ struct JitCallback::Impl {
 			argRegSlots.push_back(std::move(argSlot));
 		}
 
+		x86::Gp contextPtr;
+		if (closure) {
+			contextPtr = cc.new_gpz("contextPtr");
+			func->set_arg(sig.arg_count(), contextPtr);
+		}
+
 		constexpr uint32_t alignment = 16;
 		size_t offsetNextSlot = sizeof(uint64_t);
 
 		// setup the stack structure to hold arguments for user callback
-		const auto stackSize = static_cast<uint32_t>(sizeof(uint64_t) * sig.arg_count());
+		const auto stackSize = static_cast<uint32_t>(sizeof(uint64_t) * signature.ArgCount());
 		x86::Mem argsStack;
 		if (stackSize > 0) {
 			argsStack = cc.new_stack(stackSize, alignment);
@@ -125,7 +126,35 @@ struct JitCallback::Impl {
 		cc.mov(i, 0);
 
 		//// mov from arguments registers into the stack structure
-		for (const auto& argSlot : argRegSlots) {
+		auto argSlotIt = argRegSlots.begin();
+		for (const auto& valueType : signature.argTypes) {
+			if (auto parts = GetStructArgParts(valueType); parts.count != 0) {
+				// reassemble the by-value vector in memory and pass a pointer to it
+				x86::Mem structStack = cc.new_stack(sizeof(uint64_t) * 2, alignment);
+				for (uint32_t part = 0; part < parts.count; ++part, ++argSlotIt) {
+					x86::Mem partMem(structStack);
+					partMem.add_offset(parts.offsets[part]);
+					if (parts.types[part] == TypeId::kFloat32) {
+						partMem.set_size(sizeof(float));
+						cc.movd(partMem, argSlotIt->low.as<x86::Vec>());
+					} else if (parts.types[part] == TypeId::kFloat64) {
+						partMem.set_size(sizeof(double));
+						cc.movq(partMem, argSlotIt->low.as<x86::Vec>());
+					} else {
+						partMem.set_size(sizeof(uint64_t));
+						cc.mov(partMem, argSlotIt->low.as<x86::Gp>());
+					}
+				}
+
+				x86::Gp structPtr = cc.new_gpz();
+				cc.lea(structPtr, structStack);
+				cc.mov(argsStackIdx, structPtr);
+
+				cc.add(i, offsetNextSlot);
+				continue;
+			}
+
+			const auto& argSlot = *argSlotIt++;
 			const auto& argType = sig.args()[argSlot.argIdx];
 
 			// have to cast back to explicit register types to gen right mov type
@@ -141,7 +170,7 @@ struct JitCallback::Impl {
 			} else if (TypeUtils::is_float(argType)) {
 				cc.movq(argsStackIdx, argSlot.low.as<x86::Vec>());
 			} else {
-				errorCode = "Parameters wider than 64bits not supported";
+				error = "Parameters wider than 64bits not supported";
 				return nullptr;
 			}
 
@@ -152,15 +181,21 @@ struct JitCallback::Impl {
 
 		// fill reg to pass method ptr to callback
 		x86::Gp methodPtrParam = cc.new_gpz("methodPtrParam");
-		cc.mov(methodPtrParam, method);
 
 		// fill reg to pass data ptr to callback
 		x86::Gp dataPtrParam = cc.new_gpz("dataPtrParam");
-		cc.mov(dataPtrParam, static_cast<uintptr_t>(data));
+
+		if (closure) {
+			cc.mov(methodPtrParam, x86::ptr(contextPtr, static_cast<int32_t>(offsetof(ClosureContext, method))));
+			cc.mov(dataPtrParam, x86::ptr(contextPtr, static_cast<int32_t>(offsetof(ClosureContext, data))));
+		} else {
+			cc.mov(methodPtrParam, method);
+			cc.mov(dataPtrParam, static_cast<uintptr_t>(data));
+		}
 
 		// get pointer to stack structure and pass it to the user callback
 		x86::Gp argStruct = cc.new_gpz("argStruct");
-		auto argCount = static_cast<size_t>(sig.arg_count());
+		auto argCount = static_cast<size_t>(signature.ArgCount());
 		if (hidden) {
 			// if hidden param, then we need to offset it
 			if (--argCount != 0) {
@@ -191,11 +226,21 @@ struct JitCallback::Impl {
 		}
 
 		InvokeNode* invokeNode;
-		cc.invoke(
-			Out(invokeNode),
-			static_cast<uint64_t>(reinterpret_cast<uintptr_t>(callback)),
-			FuncSignature::build<void, void*, void*, uint64_t*, size_t, void*>()
-		);
+		if (closure) {
+			x86::Gp callbackPtr = cc.new_gpz("callbackPtr");
+			cc.mov(callbackPtr, x86::ptr(contextPtr, static_cast<int32_t>(offsetof(ClosureContext, callback))));
+			cc.invoke(
+				Out(invokeNode),
+				callbackPtr,
+				FuncSignature::build<void, void*, void*, uint64_t*, size_t, void*>()
+			);
+		} else {
+			cc.invoke(
+				Out(invokeNode),
+				static_cast<uint64_t>(reinterpret_cast<uintptr_t>(callback)),
+				FuncSignature::build<void, void*, void*, uint64_t*, size_t, void*>()
+			);
+		}
 
 		// call to user provided function (use ABI of host compiler)
 		invokeNode->set_arg(0, methodPtrParam);
@@ -206,7 +251,16 @@ struct JitCallback::Impl {
 
 		// mov from arguments stack structure into regs
 		cc.mov(i, 0);  // reset idx
-		for (const auto& argSlot : argRegSlots) {
+		argSlotIt = argRegSlots.begin();
+		for (const auto& valueType : signature.argTypes) {
+			if (auto parts = GetStructArgParts(valueType); parts.count != 0) {
+				// by-value vectors are copies, nothing to write back
+				argSlotIt += parts.count;
+				cc.add(i, offsetNextSlot);
+				continue;
+			}
+
+			const auto& argSlot = *argSlotIt++;
 			const auto& argType = sig.args()[argSlot.argIdx];
 			if (TypeUtils::is_int(argType)) {
 				cc.mov(argSlot.low.as<x86::Gp>(), argsStackIdx);
@@ -220,7 +274,7 @@ struct JitCallback::Impl {
 			} else if (TypeUtils::is_float(argType)) {
 				cc.movq(argSlot.low.as<x86::Vec>(), argsStackIdx);
 			} else {
-				errorCode = "Parameters wider than 64bits not supported";
+				error = "Parameters wider than 64bits not supported";
 				return nullptr;
 			}
 
@@ -276,7 +330,7 @@ struct JitCallback::Impl {
 				} else {
 					// ex: void example(__m128i xmmreg) is invalid:
 					// https://github.com/asmjit/asmjit/issues/83
-					errorCode = "Return wider than 64bits not supported";
+					error = "Return wider than 64bits not supported";
 					return nullptr;
 				}
 		} else {
@@ -285,34 +339,407 @@ struct JitCallback::Impl {
 
 		cc.end_func();
 
+		return func;
+	}
+
+	FuncNode* EmitCallbackStub(
+		x86::Compiler& cc,
+		const Signature& signature,
+		const Method* method,
+		JitCallback::CallbackHandler callback,
+		Address data,
+		bool hidden,
+		const char*& error
+	) {
+		return EmitCallbackBody(cc, signature, method, callback, data, hidden, false, error);
+	}
+
+	FuncNode* EmitClosureStub(
+		x86::Compiler& cc,
+		const Signature& signature,
+		bool hidden,
+		const char*& error
+	) {
+		return EmitCallbackBody(cc, signature, nullptr, nullptr, nullptr, hidden, true, error);
+	}
+
+#if PLUGIFY_JIT_HAS_THUNKS
+	void EmitContextThunk(x86::Assembler& a, void* entry, const void* context, size_t argCount) {
+		static const std::array<x86::Gp, thunks::kMaxCallArgs> kArgRegs = { x86::rdi, x86::rsi, x86::rdx, x86::rcx, x86::r8, x86::r9 };
+
+		// context -> next free argument register, then jump to the shared entry
+		a.mov(kArgRegs[argCount], static_cast<uint64_t>(reinterpret_cast<uintptr_t>(context)));
+		a.mov(x86::rax, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(entry)));
+		a.jmp(x86::rax);
+	}
+#endif	// PLUGIFY_JIT_HAS_THUNKS
+
+	static size_t CountIntArgs(const Signature& signature) noexcept {
+		size_t count = 0;
+		for (const auto& type : signature.argTypes) {
+			auto parts = GetStructArgParts(type);
+			if (parts.count == 0) {
+				count += TypeUtils::is_int(GetValueTypeId(type)) ? 1 : 0;
+				continue;
+			}
+			for (uint32_t part = 0; part < parts.count; ++part) {
+				count += TypeUtils::is_int(parts.types[part]) ? 1 : 0;
+			}
+		}
+		return count;
+	}
+
+	bool CanShiftTypedArgs(const Signature& signature, [[maybe_unused]] bool hidden) noexcept {
+#if PLUGIFY_ARCH_BITS == 64 && !PLUGIFY_PLATFORM_WINDOWS
+		// SysV assigns integer and vector registers independently, so inserting one
+		// pointer only moves the integer arguments, as long as none of them spills
+		constexpr size_t kIntArgRegs = 6;
+		if (signature.callConv != CallConv::CDecl && signature.callConv != CallConv::X64SystemV) {
+			return false;
+		}
+		return signature.varIndex == Signature::kNoVarArgs && CountIntArgs(signature) < kIntArgRegs;
+#else
+		// Win64 assigns registers by position and x86 passes arguments on the stack
+		return false;
+#endif
+	}
+
+	void EmitTypedThunk(x86::Assembler& a, const Signature& signature, Address handler, Address data, bool hidden) {
+		static const std::array<x86::Gp, 6> kArgRegs = { x86::rdi, x86::rsi, x86::rdx, x86::rcx, x86::r8, x86::r9 };
+
+		// the hidden return pointer stays in the first register, data goes right after it
+		const size_t insertAt = hidden ? 1 : 0;
+		for (size_t i = CountIntArgs(signature); i > insertAt; --i) {
+			a.mov(kArgRegs[i], kArgRegs[i - 1]);
+		}
+		a.mov(kArgRegs[insertAt], static_cast<uint64_t>(static_cast<uintptr_t>(data)));
+
+		// the handler returns straight to the caller
+		a.mov(x86::rax, static_cast<uint64_t>(static_cast<uintptr_t>(handler)));
+		a.jmp(x86::rax);
+	}
+
+	FuncNode* EmitTypedCallbackStub(
+		x86::Compiler& cc,
+		const Signature& signature,
+		Address handler,
+		Address data,
+		bool hidden,
+		const char*& error
+	) {
+		if (signature.varIndex != Signature::kNoVarArgs) {
+			error = "Variadic signatures are not supported by typed callbacks";
+			return nullptr;
+		}
+
+		if (const char* structError = CheckStructArgs(signature)) {
+			error = structError;
+			return nullptr;
+		}
+
+		auto sig = ConvertSignature(signature);
+
+		// initialize function
+		FuncNode* func = cc.add_func(sig);
+
+		// handler signature: data pointer inserted after the hidden return pointer
+		const uint32_t insertAt = hidden ? 1 : 0;
+		FuncSignature handlerSig(sig.call_conv_id(), FuncSignature::kNoVarArgs, sig.ret());
+		for (uint32_t argIdx = 0; argIdx < sig.arg_count(); ++argIdx) {
+			if (argIdx == insertAt) {
+				handlerSig.add_arg(TypeId::kUIntPtr);
+			}
+			handlerSig.add_arg(sig.args()[argIdx]);
+		}
+		if (insertAt == sig.arg_count()) {
+			handlerSig.add_arg(TypeId::kUIntPtr);
+		}
+
+		x86::Gp dataPtrParam = cc.new_gpz("dataPtrParam");
+		cc.mov(dataPtrParam, static_cast<uintptr_t>(data));
+
+		InvokeNode* invokeNode;
+		cc.invoke(Out(invokeNode), static_cast<uint64_t>(static_cast<uintptr_t>(handler)), handlerSig);
+		invokeNode->set_arg(insertAt, dataPtrParam);
+
+		// forward arguments register to register, no spilling
+		for (uint32_t argIdx = 0; argIdx < sig.arg_count(); ++argIdx) {
+			const auto& argType = sig.args()[argIdx];
+			const uint32_t handlerIdx = argIdx < insertAt ? argIdx : argIdx + 1;
+
+			if (TypeUtils::is_int(argType)) {
+				x86::Gp low = cc.new_gpz();
+				func->set_arg(argIdx, 0, low);
+				invokeNode->set_arg(handlerIdx, 0, low);
+
+				if (HasHiArgSlot(argType)) {
+					x86::Gp high = cc.new_gpz();
+					func->set_arg(argIdx, 1, high);
+					invokeNode->set_arg(handlerIdx, 1, high);
+				}
+			} else if (TypeUtils::is_float(argType)) {
+				x86::Vec arg = cc.new_xmm();
+				func->set_arg(argIdx, arg);
+				invokeNode->set_arg(handlerIdx, arg);
+			} else {
+				error = "Parameters wider than 64bits not supported";
+				return nullptr;
+			}
+		}
+
+		if (!sig.has_ret()) {
+			cc.ret();
+		} else if (TypeUtils::is_int(sig.ret())) {
+			x86::Gp low = cc.new_gpz();
+			invokeNode->set_ret(0, low);
+			if (HasHiArgSlot(sig.ret())) {
+				x86::Gp high = cc.new_gpz();
+				invokeNode->set_ret(1, high);
+				cc.ret(low, high);
+			} else {
+				cc.ret(low);
+			}
+		} else if (TypeUtils::is_float(sig.ret())) {
+			x86::Vec ret = cc.new_xmm();
+			invokeNode->set_ret(0, ret);
+			cc.ret(ret);
+		} else {
+			// ex: void example(__m128i xmmreg) is invalid:
+			// https://github.com/asmjit/asmjit/issues/83
+			error = "Return wider than 64bits not supported";
+			return nullptr;
+		}
+
+		// end of the function body
+		cc.end_func();
+
+		return func;
+	}
+}  // namespace plugify
+
+struct JitCallback::Impl {
+	Impl()
+		: function(nullptr)
+		, userData(nullptr) {
+	}
+
+	~Impl() {
+		ReleaseCode(function);
+	}
+
+	Address GetJitFunc(
+		const Signature& signature,
+		const Method* method,
+		CallbackHandler callback,
+		Address data,
+		bool hidden
+	) {
+		if (function) {
+			return function;
+		}
+
+		const char* error = nullptr;
+		CompileTimer timer;
+		void* func;
+#if PLUGIFY_JIT_HAS_THUNKS
+		if (void* entry = thunks::FindCallbackThunk(signature)) {
+			// Common integer/pointer shapes are served by a precompiled entry
+			context = { callback, method, data, hidden };
+			func = BindContext(entry, &context, signature, method, hidden, error);
+		} else
+#endif	// PLUGIFY_JIT_HAS_THUNKS
+		{
+			timer.Start();
+			func = CompileStub(signature, method, callback, data, hidden, error);
+			timer.Stop();
+		}
+		if (!func) {
+			errorCode = error;
+			return nullptr;
+		}
+
+		timer.Record();
+		JitStatistics::Instance().RecordStub(JitStubKind::Callback, signature, hidden);
+
+		function = func;
+		userData = data;
+		return function;
+	}
+
+	Address GetTypedJitFunc(
+		const Signature& signature,
+		Address handler,
+		Address data,
+		bool hidden
+	) {
+		if (function) {
+			return function;
+		}
+
+		const char* error = nullptr;
+		CompileTimer timer;
+		void* func;
+		if (CanShiftTypedArgs(signature, hidden)) {
+			// a few moves and a jump, nothing to compile
+			func = BindTyped(signature, handler, data, hidden, error);
+		} else {
+			timer.Start();
+			func = CompileTypedStub(signature, handler, data, hidden, error);
+			timer.Stop();
+		}
+		if (!func) {
+			errorCode = error;
+			return nullptr;
+		}
+
+		timer.Record();
+		JitStatistics::Instance().RecordStub(JitStubKind::TypedCallback, signature, hidden);
+
+		function = func;
+		userData = data;
+		return function;
+	}
+
+	static void* BindTyped(
+		const Signature& signature,
+		Address handler,
+		Address data,
+		bool hidden,
+		const char*& error
+	) {
+		auto& rt = GetJitRuntime();
+
+		SimpleErrorHandler eh;
+		CodeHolder code;
+		code.init(rt.environment(), rt.cpu_features());
+		code.set_error_handler(&eh);
+
+		x86::Assembler a(&code);
+		EmitTypedThunk(a, signature, handler, data, hidden);
+
+		void* thunk = CommitCode(code, { "typed", &signature, hidden, JitSymbolScope::Current() });
+		if (eh.error != Error::kOk || !thunk) {
+			error = eh.code ? eh.code : "Failed to commit code";
+			return nullptr;
+		}
+
+		return thunk;
+	}
+
+	static void* CompileTypedStub(
+		const Signature& signature,
+		Address handler,
+		Address data,
+		bool hidden,
+		const char*& error
+	) {
+		auto& rt = GetJitRuntime();
+
+		SimpleErrorHandler eh;
+		CodeHolder code;
+		code.init(rt.environment(), rt.cpu_features());
+		code.set_error_handler(&eh);
+
+		x86::Compiler cc(&code);
+		if (!EmitTypedCallbackStub(cc, signature, handler, data, hidden, error)) {
+			return nullptr;
+		}
+
 		// write to buffer
 		cc.finalize();
 
-		rt.add(&function, &code);
+		void* function = CommitCode(code, { "typed", &signature, hidden, JitSymbolScope::Current() });
+		if (eh.error != Error::kOk || !function) {
+			error = eh.code ? eh.code : "Failed to commit code";
+			return nullptr;
+		}
+
+		return function;
+	}
+
+#if PLUGIFY_JIT_HAS_THUNKS
+	static void* BindContext(
+		void* entry,
+		const void* context,
+		const Signature& signature,
+		const Method* method,
+		bool hidden,
+		const char*& error
+	) {
+		auto& rt = GetJitRuntime();
+
+		SimpleErrorHandler eh;
+		CodeHolder code;
+		code.init(rt.environment(), rt.cpu_features());
+		code.set_error_handler(&eh);
 
-		if (eh.error != Error::kOk) {
-			function = nullptr;
-			errorCode = eh.code;
+		x86::Assembler a(&code);
+		EmitContextThunk(a, entry, context, signature.ArgCount());
+
+		void* thunk = CommitCode(code, {
+			"callback",
+			&signature,
+			hidden,
+			method ? std::string_view(method->GetName()) : JitSymbolScope::Current(),
+		});
+		if (eh.error != Error::kOk || !thunk) {
+			error = eh.code ? eh.code : "Failed to commit code";
 			return nullptr;
 		}
 
-#if 0
-		std::printf("JIT Stub[%p]:\n%s\n", (void*)function, log.data());
-#endif
+		return thunk;
+	}
+#endif	// PLUGIFY_JIT_HAS_THUNKS
+
+	static void* CompileStub(
+		const Signature& signature,
+		const Method* method,
+		CallbackHandler callback,
+		Address data,
+		bool hidden,
+		const char*& error
+	) {
+		auto& rt = GetJitRuntime();
+
+		SimpleErrorHandler eh;
+		CodeHolder code;
+		code.init(rt.environment(), rt.cpu_features());
+		code.set_error_handler(&eh);
+
+		x86::Compiler cc(&code);
+		if (!EmitCallbackStub(cc, signature, method, callback, data, hidden, error)) {
+			return nullptr;
+		}
+
+		// write to buffer
+		cc.finalize();
+
+		void* function = CommitCode(code, {
+			"callback",
+			&signature,
+			hidden,
+			method ? std::string_view(method->GetName()) : JitSymbolScope::Current(),
+		});
+		if (eh.error != Error::kOk || !function) {
+			error = eh.code ? eh.code : "Failed to commit code";
+			return nullptr;
+		}
 
 		return function;
 	}
 
 	Address function;
 
+#if PLUGIFY_JIT_HAS_THUNKS
+	thunks::CallbackContext context;
+#endif	// PLUGIFY_JIT_HAS_THUNKS
+
 	union {
 		Address userData;
 		const char* errorCode{};
 	};
 };
 
-using namespace plugify;
-
 JitCallback::JitCallback()
 	: _impl(std::make_unique<Impl>()) {
 }
@@ -339,24 +766,35 @@ Address JitCallback::GetJitFunc(
 	Address data,
 	HiddenParam hidden
 ) {
-	ValueType retType = method.GetRetType().GetType();
-	bool retHidden = hidden(retType);
-
-	Signature signature(
-		method.GetCallConv(),
-		retHidden ? ValueType::Pointer : retType,
-		method.GetVarIndex()
-	);
-	if (retHidden) {
-		signature.AddArg(retType);
-	}
-	for (const auto& type : method.GetParamTypes()) {
-		signature.AddArg(type.IsRef() ? ValueType::Pointer : type.GetType());
-	}
+	bool retHidden;
+	Signature signature = MakeSignature(method, hidden, retHidden);
 
 	return GetJitFunc(signature, &method, callback, data, retHidden);
 }
 
+Address JitCallback::GetTypedJitFunc(
+	const Signature& signature,
+	Address handler,
+	Address data,
+	bool hidden
+) {
+	return _impl->GetTypedJitFunc(signature, handler, data, hidden);
+}
+
+Address JitCallback::GetTypedJitFunc(
+	const Method& method,
+	Address handler,
+	Address data,
+	HiddenParam hidden
+) {
+	JitSymbolScope scope(method.GetName());
+
+	bool retHidden;
+	Signature signature = MakeSignature(method, hidden, retHidden);
+
+	return GetTypedJitFunc(signature, handler, data, retHidden);
+}
+
 Address JitCallback::GetFunction() const noexcept {
 	return _impl->function;
 }
@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <array>
+#include <vector>
+
+#include <asmjit/x86.h>
+
+#include "../closure.hpp"
+#include "../helpers.hpp"
+#include "../runtime.hpp"
+#include "../stats.hpp"
+#include "../stub_cache.hpp"
+#include "../thunks.hpp"
+#include "emitters.hpp"
+
+using namespace plugify;
+using namespace asmjit;
+
+namespace plugify {
+	void EmitClosureThunk(x86::Assembler& a, const x86::Gp& contextReg, const ClosureCell* cell) {
+		// context -> its argument register, then jump through the entry stored right behind it
+		a.mov(contextReg, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(&cell->context)));
+		a.jmp(x86::qword_ptr(contextReg, kClosureEntryOffset));
+	}
+
+	// movabs + jmp [reg + disp8] fit in 14 bytes
+	static constexpr uint32_t kClosureThunkSize = 16;
+
+	static void* CompileClosureStub(const Signature& signature, bool hidden, const char*& error) {
+		auto& rt = GetJitRuntime();
+
+		SimpleErrorHandler eh;
+		CodeHolder code;
+		code.init(rt.environment(), rt.cpu_features());
+		code.set_error_handler(&eh);
+
+		x86::Compiler cc(&code);
+		if (!EmitClosureStub(cc, signature, hidden, error)) {
+			return nullptr;
+		}
+
+		// write to buffer
+		cc.finalize();
+
+		void* function = CommitCode(code, { "closure", &signature, hidden });
+		if (eh.error != Error::kOk || !function) {
+			error = eh.code ? eh.code : "Failed to commit code";
+			return nullptr;
+		}
+
+		return function;
+	}
+}  // namespace plugify
+
+void* plugify::GetClosureStub(const Signature& signature, bool hidden, const char*& error) {
+#if PLUGIFY_JIT_HAS_THUNKS
+	// precompiled entries expect the same context in the same register
+	if (void* entry = thunks::FindCallbackThunk(signature)) {
+		return entry;
+	}
+#endif	// PLUGIFY_JIT_HAS_THUNKS
+
+	StubKey key(StubKind::Closure, signature, 0, hidden);
+	CompileTimer timer;
+	return StubCache::Instance().GetOrCompile(key, [&]() -> void* {
+		timer.Start();
+		void* stub = CompileClosureStub(signature, hidden, error);
+		timer.Stop();
+		return stub;
+	}, [&] {
+		timer.Record();
+		JitStatistics::Instance().RecordStub(JitStubKind::Callback, signature, hidden);
+	});
+}
+
+void* plugify::CommitClosurePage(uint32_t contextReg, ClosureCell* cells, size_t count, void** thunks, const char*& error) {
+	// the integer argument registers of SysV, which include those of Win64
+	static const std::array<x86::Gp, 6> kArgRegs = { x86::rdi, x86::rsi, x86::rdx, x86::rcx, x86::r8, x86::r9 };
+
+	auto it = std::ranges::find_if(kArgRegs, [contextReg](const x86::Gp& reg) { return reg.id() == contextReg; });
+	if (it == kArgRegs.end()) {
+		error = "Closure context register is not an argument register";
+		return nullptr;
+	}
+
+	auto& rt = GetJitRuntime();
+
+	SimpleErrorHandler eh;
+	CodeHolder code;
+	code.init(rt.environment(), rt.cpu_features());
+	code.set_error_handler(&eh);
+
+	x86::Assembler a(&code);
+
+	std::vector<Label> labels(count);
+	for (size_t i = 0; i < count; ++i) {
+		a.align(AlignMode::kCode, kClosureThunkSize);
+		labels[i] = a.new_label();
+		a.bind(labels[i]);
+		EmitClosureThunk(a, *it, &cells[i]);
+	}
+
+	void* page = CommitCode(code, { "closure_page" });
+	if (eh.error != Error::kOk || !page) {
+		error = eh.code ? eh.code : "Failed to commit code";
+		return nullptr;
+	}
+
+	auto* base = static_cast<uint8_t*>(page);
+	for (size_t i = 0; i < count; ++i) {
+		thunks[i] = base + code.label_offset(labels[i]);
+	}
+	return page;
+}
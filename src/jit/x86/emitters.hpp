@@ -0,0 +1,190 @@
+#pragma once
+
+#include <asmjit/x86.h>
+
+#include "plugify/call.hpp"
+#include "plugify/callback.hpp"
+
+#include "../closure.hpp"
+#include "../stats.hpp"
+#include "../stub_cache.hpp"
+
+namespace plugify {
+	/**
+	 * @brief Emits a JitCall stub function into the compiler.
+	 * @details Produces void(params, ret) calling the \p target immediate or, when
+	 * \p target is null, a generic void(params, ret, target) stub.
+	 * @return Function node or nullptr with \p error set.
+	 */
+	asmjit::FuncNode* EmitCallStub(
+		asmjit::x86::Compiler& cc,
+		const Signature& signature,
+		Address target,
+		JitCall::WaitType waitType,
+		bool hidden,
+		const char*& error
+	);
+
+	/**
+	 * @brief Tells whether EmitAssembledCallStub() handles the signature.
+	 */
+	bool CanAssembleCallStub(const Signature& signature) noexcept;
+
+	/**
+	 * @brief Emits a generic call stub void(params, ret, target) with the Assembler.
+	 * @details Same behaviour as the stub EmitCallStub() produces without target and wait
+	 * helper, but the argument moves are written straight from the FuncDetail of the call,
+	 * so no register allocation runs.
+	 * @return False with \p error set on failure.
+	 */
+	bool EmitAssembledCallStub(
+		asmjit::x86::Assembler& a,
+		const Signature& signature,
+		bool hidden,
+		const char*& error
+	);
+
+	/**
+	 * @brief Returns the process-wide generic stub for the signature, compiling it on first use.
+	 */
+	void* GetGenericCallStub(
+		const Signature& signature,
+		JitCall::WaitType waitType,
+		bool hidden,
+		const char*& error
+	);
+
+	/**
+	 * @brief How a loop call stub walks its inputs.
+	 */
+	enum class LoopCallKind : uint8_t {
+		Shared,	 ///< One set of parameters is loaded once and passed to every target
+		Each,	 ///< Parameters are loaded per iteration, the target may be the same
+	};
+
+	// Shared parameters hold a single hidden return buffer, every target would construct
+	// its result into it
+	inline constexpr const char* kSharedHiddenError = "Hidden returns need a buffer per call, use InvokeEach";
+	inline constexpr const char* kShortRetsError = "Fewer return slots than calls";
+
+	/**
+	 * @brief Emits a stub which performs \p count calls in a single loop.
+	 * @details Produces void(params, paramStride, rets, retStride, targets, targetStride, count):
+	 * every pointer is advanced by its stride after a call, so a stride of zero repeats the same
+	 * parameters, return slot or target. A hidden return is rejected for LoopCallKind::Shared.
+	 * @return Function node or nullptr with \p error set.
+	 */
+	asmjit::FuncNode* EmitLoopCallStub(
+		asmjit::x86::Compiler& cc,
+		const Signature& signature,
+		LoopCallKind kind,
+		bool hidden,
+		const char*& error
+	);
+
+	/**
+	 * @brief Returns the process-wide loop stub for the signature, compiling it on first use.
+	 */
+	void* GetLoopCallStub(
+		const Signature& signature,
+		LoopCallKind kind,
+		bool hidden,
+		const char*& error
+	);
+
+	/**
+	 * @brief Produces the machine code of a generic call stub, read from the disk cache when possible.
+	 * @details Only for WaitType::None: such a stub references nothing but itself (the target
+	 * arrives as an argument), so its code can be persisted and placed at any address.
+	 * Only an actual compilation runs under \p timer, not the disk lookup.
+	 */
+	bool LoadOrCompileGenericCode(
+		const StubKey& key,
+		const Signature& signature,
+		bool hidden,
+		std::vector<uint8_t>& code,
+		CompileTimer& timer,
+		const char*& error
+	);
+
+	/**
+	 * @brief Emits a thunk which binds \p target and jumps into a generic call stub.
+	 */
+	void EmitBindThunk(asmjit::x86::Assembler& a, void* stub, Address target);
+
+	/**
+	 * @brief Emits a thunk which loads \p context into the argument register following the
+	 * last of \p argCount arguments and jumps into a precompiled callback entry.
+	 * @note Only available when precompiled thunks are (SysV x86-64).
+	 */
+	void EmitContextThunk(asmjit::x86::Assembler& a, void* entry, const void* context, size_t argCount);
+
+	/**
+	 * @brief Emits a JitCallback stub function into the compiler.
+	 * @return Function node or nullptr with \p error set.
+	 */
+	asmjit::FuncNode* EmitCallbackStub(
+		asmjit::x86::Compiler& cc,
+		const Signature& signature,
+		const Method* method,
+		JitCallback::CallbackHandler callback,
+		Address data,
+		bool hidden,
+		const char*& error
+	);
+
+	/**
+	 * @brief Emits a closure stub function into the compiler: a JitCallback stub which reads
+	 * its callback, method and data from a ClosureContext passed as extra trailing argument.
+	 * @return Function node or nullptr with \p error set.
+	 */
+	asmjit::FuncNode* EmitClosureStub(
+		asmjit::x86::Compiler& cc,
+		const Signature& signature,
+		bool hidden,
+		const char*& error
+	);
+
+	/**
+	 * @brief Emits a pooled closure thunk: loads the context of \p cell into \p contextReg
+	 * and jumps through the entry of the cell.
+	 */
+	void EmitClosureThunk(asmjit::x86::Assembler& a, const asmjit::x86::Gp& contextReg, const ClosureCell* cell);
+
+	/**
+	 * @brief Tells whether a typed callback can be a register shift plus tail-jump.
+	 */
+	bool CanShiftTypedArgs(const Signature& signature, bool hidden) noexcept;
+
+	/**
+	 * @brief Emits a thunk which inserts \p data in front of the arguments (after the hidden
+	 * return pointer) by shifting the integer argument registers, then tail-jumps into \p handler.
+	 * @note Only valid if CanShiftTypedArgs() returned true.
+	 */
+	void EmitTypedThunk(asmjit::x86::Assembler& a, const Signature& signature, Address handler, Address data, bool hidden);
+
+	/**
+	 * @brief Emits a function which calls the typed \p handler with \p data inserted,
+	 * used when the registers cannot simply be shifted.
+	 * @return Function node or nullptr with \p error set.
+	 */
+	asmjit::FuncNode* EmitTypedCallbackStub(
+		asmjit::x86::Compiler& cc,
+		const Signature& signature,
+		Address handler,
+		Address data,
+		bool hidden,
+		const char*& error
+	);
+
+	/**
+	 * @brief Emits a trampoline which passes \p entry to the resolver and jumps through its slot.
+	 */
+	void EmitLazyTrampoline(asmjit::x86::Assembler& a, const void* entry);
+
+	/**
+	 * @brief Emits the shared resolver of lazy trampolines: saves the argument registers,
+	 * calls \p resolve with the entry, restores them and jumps to the returned function.
+	 */
+	void EmitLazyResolver(asmjit::x86::Assembler& a, void* resolve);
+}  // namespace plugify
@@ -255,4 +255,56 @@ namespace plugify {
 				return asmjit::CallConvId::kCDecl;
 		}
 	}
+
+	StructArgParts GetStructArgParts([[maybe_unused]] ValueType valueType) noexcept {
+#if PLUGIFY_ARCH_BITS == 64
+#if PLUGIFY_PLATFORM_WINDOWS
+		// Win64 passes 8 byte structs by value in a general purpose register,
+		// bigger ones by pointer to a copy
+		if (valueType == ValueType::Vector2) {
+			return { 1, { asmjit::TypeId::kInt64 }, { 0 } };
+		}
+#else
+		// SysV classifies every eightbyte of a float struct as SSE
+		switch (valueType) {
+			case ValueType::Vector2:
+				return { 1, { asmjit::TypeId::kFloat64 }, { 0 } };
+			case ValueType::Vector3:
+				return { 2, { asmjit::TypeId::kFloat64, asmjit::TypeId::kFloat32 }, { 0, 8 } };
+			case ValueType::Vector4:
+				return { 2, { asmjit::TypeId::kFloat64, asmjit::TypeId::kFloat64 }, { 0, 8 } };
+			default:
+				// mat4x4 is MEMORY class: the ABI copies all 64 bytes onto the
+				// stack, it is not passed by pointer. A signature cannot place
+				// arguments on the stack, so it is still lowered to a pointer
+				// and does not match native code taking it by value.
+				break;
+		}
+#endif	// PLUGIFY_PLATFORM_WINDOWS
+#endif	// PLUGIFY_ARCH_BITS
+		return {};
+	}
+
+	const char* CheckStructArgs([[maybe_unused]] const Signature& sig) noexcept {
+#if PLUGIFY_ARCH_BITS == 64 && !PLUGIFY_PLATFORM_WINDOWS
+		// A struct is passed in registers only if all of its eightbytes fit,
+		// otherwise the whole struct goes to the stack and the registers stay free
+		// for later arguments, which a split signature cannot express.
+		constexpr uint32_t kVecArgRegs = 8;
+		uint32_t used = 0;
+		for (const auto& arg : sig.argTypes) {
+			auto parts = GetStructArgParts(arg);
+			if (parts.count == 0) {
+				if (asmjit::TypeUtils::is_float(GetValueTypeId(arg))) {
+					++used;
+				}
+			} else if (used < kVecArgRegs && used + parts.count > kVecArgRegs) {
+				return "Vector parameter would be split between registers and stack";
+			} else {
+				used += parts.count;
+			}
+		}
+#endif	// PLUGIFY_ARCH_BITS
+		return nullptr;
+	}
 }  // namespace plugify
@@ -0,0 +1,108 @@
+#include <asmjit/x86.h>
+
+#include "../helpers.hpp"
+#include "../lazy.hpp"
+#include "../runtime.hpp"
+#include "emitters.hpp"
+
+using namespace plugify;
+using namespace asmjit;
+
+#if PLUGIFY_ARCH_BITS == 64
+namespace plugify {
+	void EmitLazyTrampoline(x86::Assembler& a, const void* entry) {
+		// r11 is a scratch register which carries no argument in either x86-64 convention
+		a.mov(x86::r11, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(entry)));
+		a.jmp(x86::qword_ptr(x86::r11));
+	}
+
+	void EmitLazyResolver(x86::Assembler& a, void* resolve) {
+		// every register which may carry an argument in SysV or Win64, al holds the vector count of varargs
+		static const std::array<x86::Gp, 7> kGpRegs = { x86::rdi, x86::rsi, x86::rdx, x86::rcx, x86::r8, x86::r9, x86::rax };
+		static const std::array<x86::Vec, 8> kVecRegs = { x86::xmm0, x86::xmm1, x86::xmm2, x86::xmm3, x86::xmm4, x86::xmm5, x86::xmm6, x86::xmm7 };
+
+		// 32 bytes of Win64 shadow space, then the saved registers, 16-byte aligned
+		constexpr int32_t kGpOffset = 32;
+		constexpr int32_t kVecOffset = kGpOffset + 64;
+		constexpr int32_t kFrameSize = kVecOffset + 16 * 8;
+
+		a.push(x86::rbp);
+		a.mov(x86::rbp, x86::rsp);
+		a.sub(x86::rsp, kFrameSize);
+
+		for (size_t i = 0; i < kGpRegs.size(); ++i) {
+			a.mov(x86::qword_ptr(x86::rsp, kGpOffset + 8 * static_cast<int32_t>(i)), kGpRegs[i]);
+		}
+		for (size_t i = 0; i < kVecRegs.size(); ++i) {
+			a.movups(x86::xmmword_ptr(x86::rsp, kVecOffset + 16 * static_cast<int32_t>(i)), kVecRegs[i]);
+		}
+
+		// ResolveLazyEntry(entry), first argument of both conventions
+		a.mov(x86::rdi, x86::r11);
+		a.mov(x86::rcx, x86::r11);
+		a.mov(x86::rax, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(resolve)));
+		a.call(x86::rax);
+		a.mov(x86::r11, x86::rax);
+
+		for (size_t i = 0; i < kGpRegs.size(); ++i) {
+			a.mov(kGpRegs[i], x86::qword_ptr(x86::rsp, kGpOffset + 8 * static_cast<int32_t>(i)));
+		}
+		for (size_t i = 0; i < kVecRegs.size(); ++i) {
+			a.movups(kVecRegs[i], x86::xmmword_ptr(x86::rsp, kVecOffset + 16 * static_cast<int32_t>(i)));
+		}
+
+		// the stack is back as the caller left it, the real function returns to it directly
+		a.mov(x86::rsp, x86::rbp);
+		a.pop(x86::rbp);
+		a.jmp(x86::r11);
+	}
+}  // namespace plugify
+
+void* plugify::GetLazyResolver(const char*& error) {
+	static const char* resolverError = nullptr;
+	static void* resolver = [] {
+		auto& rt = GetJitRuntime();
+
+		SimpleErrorHandler eh;
+		CodeHolder code;
+		code.init(rt.environment(), rt.cpu_features());
+		code.set_error_handler(&eh);
+
+		x86::Assembler a(&code);
+		EmitLazyResolver(a, reinterpret_cast<void*>(&ResolveLazyEntry));
+
+		// shared by every lazy entry, never released
+		void* function = CommitCode(code, { "lazy_resolver" });
+		if (eh.error != Error::kOk || !function) {
+			resolverError = eh.code ? eh.code : "Failed to commit code";
+			return static_cast<void*>(nullptr);
+		}
+		return function;
+	}();
+
+	if (!resolver) {
+		error = resolverError;
+	}
+	return resolver;
+}
+
+void* plugify::CommitLazyTrampoline(LazyEntry* entry, std::string_view name, const char*& error) {
+	auto& rt = GetJitRuntime();
+
+	SimpleErrorHandler eh;
+	CodeHolder code;
+	code.init(rt.environment(), rt.cpu_features());
+	code.set_error_handler(&eh);
+
+	x86::Assembler a(&code);
+	EmitLazyTrampoline(a, entry);
+
+	void* thunk = CommitCode(code, { "lazy", nullptr, false, name });
+	if (eh.error != Error::kOk || !thunk) {
+		error = eh.code ? eh.code : "Failed to commit code";
+		return nullptr;
+	}
+
+	return thunk;
+}
+#endif	// PLUGIFY_ARCH_BITS
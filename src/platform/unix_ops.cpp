@@ -1,4 +1,6 @@
+#include <cerrno>
 #include <dlfcn.h>
+#include <sys/stat.h>
 
 #include "plugify/platform_ops.hpp"
 
@@ -71,6 +73,14 @@ namespace plugify {
 			return MakeError("Failed to get library path");
 		}
 
+		Result<uint64_t> GetFileId(const std::filesystem::path& path) override {
+			struct stat st{};
+			if (::stat(path.c_str(), &st) != 0) {
+				return MakeError("Failed to stat '{}': {}", plg::as_string(path), std::strerror(errno));
+			}
+			return static_cast<uint64_t>(st.st_ino) ^ (static_cast<uint64_t>(st.st_dev) << 48);
+		}
+
 		bool SupportsRuntimePathModification() const override {
 			return false;
 		}
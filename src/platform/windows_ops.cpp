@@ -274,6 +274,30 @@ namespace plugify {
 			return std::filesystem::path(std::move(path));
 		}
 
+		Result<uint64_t> GetFileId(const std::filesystem::path& path) override {
+			HANDLE file = ::CreateFileW(
+				path.c_str(),
+				0,
+				FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+				nullptr,
+				OPEN_EXISTING,
+				FILE_ATTRIBUTE_NORMAL,
+				nullptr
+			);
+			if (file == INVALID_HANDLE_VALUE) {
+				return MakeError("Failed to open '{}': {}", plg::as_string(path), GetLastErrorString());
+			}
+
+			BY_HANDLE_FILE_INFORMATION info{};
+			BOOL ok = ::GetFileInformationByHandle(file, &info);
+			::CloseHandle(file);
+			if (!ok) {
+				return MakeError("Failed to query '{}': {}", plg::as_string(path), GetLastErrorString());
+			}
+			return (static_cast<uint64_t>(info.nFileIndexHigh) << 32 | info.nFileIndexLow)
+				   ^ (static_cast<uint64_t>(info.dwVolumeSerialNumber) << 48);
+		}
+
 		bool SupportsRuntimePathModification() const override {
 			return true;
 		}
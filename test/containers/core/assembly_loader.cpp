@@ -0,0 +1,179 @@
+#include <catch_amalgamated.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include "core/basic_assembly_loader.hpp"
+
+using namespace plugify;
+
+namespace {
+	struct MockOps final : IPlatformOps {
+		Result<void*> LoadLibrary(const std::filesystem::path&, LoadFlag) override {
+			++loads;
+			return reinterpret_cast<void*>(static_cast<uintptr_t>(loads * 16));
+		}
+
+		Result<void> UnloadLibrary(void*) override {
+			++unloads;
+			return {};
+		}
+
+		Result<Address> GetSymbol(void*, std::string_view) override {
+			return MakeError("No symbols in a mock");
+		}
+
+		Result<std::filesystem::path> GetLibraryPath(void*) override {
+			return MakeError("No paths in a mock");
+		}
+
+		Result<uint64_t> GetFileId(const std::filesystem::path& path) override {
+			++stats;
+			return fileIds[path];
+		}
+
+		bool SupportsRuntimePathModification() const override { return false; }
+		bool SupportsLazyBinding() const override { return false; }
+
+		std::map<std::filesystem::path, uint64_t> fileIds;
+		int loads{};
+		int unloads{};
+		int stats{};
+	};
+
+	struct MockFileSystem final : IFileSystem {
+		Result<FileInfo> GetFileInfo(const std::filesystem::path& path) override {
+			++stats;
+			auto it = files.find(path);
+			if (it == files.end()) {
+				return MakeError("File not found");
+			}
+			return it->second;
+		}
+
+		bool IsExists(const std::filesystem::path& path) override {
+			return files.contains(path);
+		}
+
+		bool IsRegularFile(const std::filesystem::path& path) override {
+			return files.contains(path);
+		}
+
+		Result<std::filesystem::path> GetAbsolutePath(const std::filesystem::path& path) override {
+			return path;
+		}
+
+		// unused by the loader
+		Result<std::string> ReadTextFile(const std::filesystem::path&) override { return MakeError("Unsupported"); }
+		Result<std::vector<uint8_t>> ReadBinaryFile(const std::filesystem::path&) override { return MakeError("Unsupported"); }
+		Result<void> WriteTextFile(const std::filesystem::path&, std::string_view) override { return MakeError("Unsupported"); }
+		Result<void> WriteBinaryFile(const std::filesystem::path&, std::span<const uint8_t>) override { return MakeError("Unsupported"); }
+		bool IsDirectory(const std::filesystem::path&) override { return false; }
+		Result<std::vector<FileInfo>> ListDirectory(const std::filesystem::path&) override { return MakeError("Unsupported"); }
+		Result<std::vector<FileInfo>> IterateDirectory(const std::filesystem::path&, const DirectoryIterationOptions&) override { return MakeError("Unsupported"); }
+		Result<std::vector<std::filesystem::path>> FindFiles(const std::filesystem::path&, std::span<const std::string_view>, bool) override { return MakeError("Unsupported"); }
+		Result<void> CreateDirectories(const std::filesystem::path&) override { return MakeError("Unsupported"); }
+		Result<void> Remove(const std::filesystem::path&) override { return MakeError("Unsupported"); }
+		Result<void> RemoveAll(const std::filesystem::path&) override { return MakeError("Unsupported"); }
+		Result<void> Copy(const std::filesystem::path&, const std::filesystem::path&) override { return MakeError("Unsupported"); }
+		Result<void> Move(const std::filesystem::path&, const std::filesystem::path&) override { return MakeError("Unsupported"); }
+		Result<std::filesystem::path> GetCanonicalPath(const std::filesystem::path& path) override { return path; }
+		Result<std::filesystem::path> GetRelativePath(const std::filesystem::path& path, const std::filesystem::path&) override { return path; }
+
+		std::map<std::filesystem::path, FileInfo> files;
+		int stats{};
+	};
+
+	void AddFile(MockFileSystem& fs, MockOps& ops, const std::filesystem::path& path, uint64_t fileId) {
+		fs.files[path] = FileInfo{
+			.path = path,
+			.size = 1024,
+			.last_write_time = std::filesystem::file_time_type::clock::now(),
+			.type = std::filesystem::file_type::regular,
+			.permissions = std::filesystem::perms::owner_all,
+		};
+		ops.fileIds[path] = fileId;
+	}
+
+	// Loads and unloads once, so the assembly ends up parked
+	void Park(BasicAssemblyLoader& loader, const std::filesystem::path& path) {
+		auto assembly = loader.Load(path, LoadFlag::Default, {});
+		REQUIRE(assembly);
+		REQUIRE(loader.Unload(*assembly));
+	}
+}
+
+TEST_CASE("assembly loader warm cache", "[core]") {
+	auto ops = std::make_shared<MockOps>();
+	auto fs = std::make_shared<MockFileSystem>();
+	auto a = std::filesystem::temp_directory_path() / "warm_a.so";
+	auto b = std::filesystem::temp_directory_path() / "warm_b.so";
+	AddFile(*fs, *ops, a, 1);
+	AddFile(*fs, *ops, b, 2);
+
+	SECTION("reuses an unchanged file") {
+		BasicAssemblyLoader loader(ops, fs, { .maxEntries = 4 });
+		Park(loader, a);
+
+		auto again = loader.Load(a, LoadFlag::Default, {});
+		REQUIRE(again);
+		REQUIRE(ops->loads == 1);
+		REQUIRE(ops->unloads == 0);
+	}
+
+	SECTION("reloads a changed file") {
+		BasicAssemblyLoader loader(ops, fs, { .maxEntries = 4 });
+		Park(loader, a);
+
+		SECTION("size") {
+			fs->files[a].size += 1;
+		}
+		SECTION("write time") {
+			fs->files[a].last_write_time += std::chrono::seconds{ 1 };
+		}
+		SECTION("file id") {
+			ops->fileIds[a] = 42;
+		}
+
+		auto again = loader.Load(a, LoadFlag::Default, {});
+		REQUIRE(again);
+		REQUIRE(ops->loads == 2);
+		REQUIRE(ops->unloads == 1);
+	}
+
+	SECTION("evicts the oldest beyond the entry limit") {
+		BasicAssemblyLoader loader(ops, fs, { .maxEntries = 1 });
+		Park(loader, a);
+		Park(loader, b);
+		REQUIRE(ops->unloads == 1);
+
+		REQUIRE(loader.Load(b, LoadFlag::Default, {}));
+		REQUIRE(ops->loads == 2);
+		REQUIRE(loader.Load(a, LoadFlag::Default, {}));
+		REQUIRE(ops->loads == 3);
+	}
+
+	SECTION("evicts entries past their age") {
+		BasicAssemblyLoader loader(ops, fs, { .maxEntries = 4, .maxAge = std::chrono::seconds{ 0 } });
+		Park(loader, a);
+		std::this_thread::sleep_for(std::chrono::milliseconds{ 2 });
+
+		loader.Update();
+		REQUIRE(ops->unloads == 1);
+
+		REQUIRE(loader.Load(a, LoadFlag::Default, {}));
+		REQUIRE(ops->loads == 2);
+	}
+
+	SECTION("skips file identity when disabled") {
+		BasicAssemblyLoader loader(ops, fs);
+		Park(loader, a);
+		REQUIRE(ops->unloads == 1);
+		REQUIRE(fs->stats == 0);
+		REQUIRE(ops->stats == 0);
+	}
+}
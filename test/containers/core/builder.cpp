@@ -0,0 +1,47 @@
+#include <catch_amalgamated.hpp>
+
+#include <plugify/plugify.hpp>
+
+#include <filesystem>
+#include <fstream>
+
+using namespace plugify;
+
+TEST_CASE("builder applies the config file", "[core]") {
+	auto dir = std::filesystem::temp_directory_path() / "plugify_builder_test";
+	std::filesystem::remove_all(dir);
+	std::filesystem::create_directories(dir);
+	auto file = dir / "plugify.pconfig";
+
+	std::ofstream(file) << R"({
+		"loading": { "warmCacheSize": 3, "warmCacheMaxAge": 60 },
+		"logging": { "severity": "warning", "queueCapacity": 2, "overflowPolicy": "dropNewest" }
+	})";
+
+	// WithDefaults() before the file is read must not fix the services to
+	// the default configuration
+	auto plugify = PlugifyBuilder()
+		.WithBaseDir(dir)
+		.WithDefaults()
+		.WithConfigFile(file)
+		.Build();
+	REQUIRE(plugify);
+
+	const auto& config = (*plugify)->GetConfig();
+	REQUIRE(config.loading.warmCacheSize == 3);
+	REQUIRE(config.loading.warmCacheMaxAge == std::chrono::seconds{ 60 });
+	REQUIRE(config.logging.queueCapacity == 2);
+	REQUIRE(config.logging.overflowPolicy == OverflowPolicy::DropNewest);
+
+	// a queue of two which drops new messages cannot keep up with a burst
+	auto logger = (*plugify)->GetServices().Resolve<ILogger>();
+	REQUIRE(logger->GetLogLevel() == Severity::Warning);
+	for (int i = 0; i < 256; ++i) {
+		logger->Log("burst", Severity::Warning);
+	}
+	REQUIRE(logger->GetStats().droppedNewest > 0);
+	logger->Flush();
+
+	plugify->reset();
+	std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,95 @@
+#include <catch_amalgamated.hpp>
+
+#include <plugify/extension.hpp>
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "core/lifecycle_dispatcher.hpp"
+
+using namespace plugify;
+
+namespace {
+	using Kind = LifecycleEvent::Kind;
+
+	struct RecordingLifecycle final : IExtensionLifecycle {
+		explicit RecordingLifecycle(LifecycleDelivery delivery) : delivery(delivery) {}
+
+		LifecycleDelivery GetDelivery() const override { return delivery; }
+		void OnLoad(Extension& extension) override { events.emplace_back(Kind::Load, &extension); }
+		void OnUnload(Extension& extension) override { events.emplace_back(Kind::Unload, &extension); }
+		void OnStart(Extension& extension) override { events.emplace_back(Kind::Start, &extension); }
+		void OnEnd(Extension& extension) override { events.emplace_back(Kind::End, &extension); }
+		void OnUpdate(Extension& extension, std::chrono::milliseconds) override { events.emplace_back(Kind::Update, &extension); }
+		void OnExport(Extension& extension) override { events.emplace_back(Kind::Export, &extension); }
+
+		LifecycleDelivery delivery;
+		std::vector<std::pair<Kind, Extension*>> events;
+	};
+}
+
+TEST_CASE("lifecycle dispatcher", "[core]") {
+	Extension first;
+	Extension second;
+
+	SECTION("defers events until flushed, in order") {
+		auto observer = std::make_shared<RecordingLifecycle>(LifecycleDelivery::Deferred);
+		LifecycleDispatcher dispatcher(observer);
+
+		dispatcher.OnLoad(first);
+		dispatcher.OnLoad(second);
+		dispatcher.OnExport(first);
+		dispatcher.OnStart(second);
+		dispatcher.OnUpdate(first, std::chrono::milliseconds{ 16 });
+		REQUIRE(observer->events.empty());
+
+		dispatcher.Flush();
+		REQUIRE(observer->events == std::vector<std::pair<Kind, Extension*>>{
+			{ Kind::Load, &first },
+			{ Kind::Load, &second },
+			{ Kind::Export, &first },
+			{ Kind::Start, &second },
+			{ Kind::Update, &first },
+		});
+	}
+
+	SECTION("delivers synchronous observers inline") {
+		auto observer = std::make_shared<RecordingLifecycle>(LifecycleDelivery::Synchronous);
+		LifecycleDispatcher dispatcher(observer);
+
+		dispatcher.OnEnd(first);
+		REQUIRE(observer->events.size() == 1);
+		REQUIRE(observer->events[0] == std::pair{ Kind::End, &first });
+	}
+
+	SECTION("drains inline when the queue is full") {
+		auto observer = std::make_shared<RecordingLifecycle>(LifecycleDelivery::Deferred);
+		LifecycleDispatcher dispatcher(observer, 2);
+
+		dispatcher.OnLoad(first);
+		dispatcher.OnLoad(second);
+		REQUIRE(observer->events.empty());
+
+		// no room: the queued events go first, then this one
+		dispatcher.OnStart(first);
+		REQUIRE(observer->events.size() == 3);
+		REQUIRE(observer->events[2] == std::pair{ Kind::Start, &first });
+
+		dispatcher.OnUnload(second);
+		dispatcher.Flush();
+		REQUIRE(observer->events.size() == 4);
+		REQUIRE(observer->events[3] == std::pair{ Kind::Unload, &second });
+	}
+
+	SECTION("flushes on destruction") {
+		auto observer = std::make_shared<RecordingLifecycle>(LifecycleDelivery::Deferred);
+		{
+			LifecycleDispatcher dispatcher(observer);
+			dispatcher.OnUnload(first);
+		}
+		REQUIRE(observer->events.size() == 1);
+	}
+}
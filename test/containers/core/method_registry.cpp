@@ -0,0 +1,101 @@
+#include <catch_amalgamated.hpp>
+
+#include <plugify/extension.hpp>
+#include <plugify/manifest.hpp>
+#include <plugify/method.hpp>
+
+#include <algorithm>
+#include <shared_mutex>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "core/method_registry.hpp"
+
+using namespace plugify;
+
+namespace {
+	void Add(std::vector<Extension>& items, UniqueId::Value id, std::string name, std::string language, bool running = false) {
+		auto& ext = items.emplace_back(UniqueId{ id }, name + (language.empty() ? ".pmodule" : ".pplugin"));
+
+		Manifest manifest;
+		manifest.name = std::move(name);
+		manifest.language = language.empty() ? manifest.name : std::move(language);
+		ext.SetManifest(std::move(manifest));
+
+		for (auto state : { ExtensionState::Parsing, ExtensionState::Parsed, ExtensionState::Resolving,
+		                    ExtensionState::Resolved, ExtensionState::Loading, ExtensionState::Loaded }) {
+			ext.SetState(state);
+		}
+		if (running) {
+			ext.SetState(ExtensionState::Running);
+		}
+	}
+}
+
+TEST_CASE("export consumers", "[core]") {
+	std::vector<Extension> items;
+	items.reserve(6);
+	Add(items, 0, "cpp", "", true);            // module of language "cpp"
+	Add(items, 1, "lua", "", true);            // module of language "lua"
+	Add(items, 2, "py", "", false);            // module which is not running
+	Add(items, 3, "provider", "cpp");
+	Add(items, 4, "dependent", "lua");
+	Add(items, 5, "sleeper", "py");
+
+	SECTION("the module hosting a dependent gets the export") {
+		std::unordered_map<UniqueId, std::vector<UniqueId>> reverse{ { UniqueId{ 3 }, { UniqueId{ 4 } } } };
+		auto consumers = MapExportConsumers(items, reverse);
+		REQUIRE(consumers[UniqueId{ 3 }] == std::vector<const Extension*>{ &items[1] });
+	}
+
+	SECTION("unrelated hosts do not") {
+		std::unordered_map<UniqueId, std::vector<UniqueId>> reverse{ { UniqueId{ 3 }, { UniqueId{ 4 } } } };
+		auto consumers = MapExportConsumers(items, reverse);
+		const auto& modules = consumers[UniqueId{ 3 }];
+		// the provider's own host has no dependent of it
+		REQUIRE(std::ranges::find(modules, &items[0]) == modules.end());
+		REQUIRE_FALSE(consumers.contains(UniqueId{ 4 }));
+	}
+
+	SECTION("hosts which are not running and repeated hosts are skipped") {
+		std::unordered_map<UniqueId, std::vector<UniqueId>> reverse{
+			{ UniqueId{ 3 }, { UniqueId{ 4 }, UniqueId{ 4 }, UniqueId{ 5 } } },
+		};
+		auto consumers = MapExportConsumers(items, reverse);
+		REQUIRE(consumers[UniqueId{ 3 }] == std::vector<const Extension*>{ &items[1] });
+	}
+}
+
+TEST_CASE("method registry", "[core]") {
+	std::vector<Extension> items;
+	Add(items, 0, "provider", "cpp");
+	auto& plugin = items.front();
+
+	std::vector<Method> methods(2);
+	methods[0].SetName("Add");
+	methods[1].SetName("Sub");
+	int add = 0;
+	int sub = 0;
+	plugin.SetMethodsData({ { methods[0], Address(&add) }, { methods[1], Address(&sub) } });
+
+	MethodRegistry registry;
+	REQUIRE_FALSE(registry.IsRegistered("provider"));
+	REQUIRE(registry.FindMethod("provider", "Add") == nullptr);
+
+	registry.Register(plugin);
+	REQUIRE(registry.IsRegistered("provider"));
+	REQUIRE(registry.Size() == 1);
+	REQUIRE(registry.FindMethods("provider").size() == 2);
+
+	const MethodData* found = registry.FindMethod("provider", "Sub");
+	REQUIRE(found);
+	REQUIRE(&found->method == &methods[1]);
+	REQUIRE(found->addr == Address(&sub));
+	REQUIRE(registry.FindMethod("provider", "Mul") == nullptr);
+	REQUIRE(registry.FindMethods("missing").empty());
+
+	registry.Unregister(plugin);
+	REQUIRE_FALSE(registry.IsRegistered("provider"));
+	REQUIRE(registry.FindMethods("provider").empty());
+}
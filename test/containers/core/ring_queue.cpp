@@ -0,0 +1,98 @@
+#include <catch_amalgamated.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "core/ring_queue.hpp"
+
+using namespace plugify;
+
+TEST_CASE("ring queue", "[core]") {
+	SECTION("rounds the capacity up to a power of two") {
+		REQUIRE(RingQueue<int>(0).Capacity() == 2);
+		REQUIRE(RingQueue<int>(5).Capacity() == 8);
+		REQUIRE(RingQueue<int>(16).Capacity() == 16);
+	}
+
+	SECTION("pops nothing when empty") {
+		RingQueue<int> queue(4);
+		int value = -1;
+		REQUIRE(queue.EmptyApprox());
+		REQUIRE_FALSE(queue.TryPop(value));
+		REQUIRE(value == -1);
+	}
+
+	SECTION("refuses pushes when full") {
+		RingQueue<int> queue(4);
+		for (int i = 0; i < 4; ++i) {
+			REQUIRE(queue.TryPush(i));
+		}
+		REQUIRE_FALSE(queue.TryPush(4));
+		REQUIRE(queue.SizeApprox() == 4);
+
+		int value;
+		REQUIRE(queue.TryPop(value));
+		REQUIRE(value == 0);
+		REQUIRE(queue.TryPush(4));
+	}
+
+	SECTION("keeps order across wrap-around") {
+		RingQueue<int> queue(4);
+		int next = 0;
+		int expected = 0;
+		for (int round = 0; round < 10; ++round) {
+			// uneven batches move the positions across the end of the buffer
+			for (int i = 0; i < 3; ++i) {
+				REQUIRE(queue.TryPush(next++));
+			}
+			int value;
+			for (int i = 0; i < 3; ++i) {
+				REQUIRE(queue.TryPop(value));
+				REQUIRE(value == expected++);
+			}
+		}
+		REQUIRE(queue.EmptyApprox());
+	}
+
+	SECTION("conserves elements across producers and consumers") {
+		constexpr int kThreads = 4;
+		constexpr int kPerProducer = 20000;
+		RingQueue<int> queue(64);
+
+		std::vector<std::atomic<int>> seen(kThreads * kPerProducer);
+		std::atomic<int> consumed{ 0 };
+		std::vector<std::thread> threads;
+
+		for (int p = 0; p < kThreads; ++p) {
+			threads.emplace_back([&, p] {
+				for (int i = 0; i < kPerProducer; ++i) {
+					while (!queue.TryPush(p * kPerProducer + i)) {
+						std::this_thread::yield();
+					}
+				}
+			});
+		}
+		for (int c = 0; c < kThreads; ++c) {
+			threads.emplace_back([&] {
+				int value;
+				while (consumed.load(std::memory_order_relaxed) < kThreads * kPerProducer) {
+					if (queue.TryPop(value)) {
+						seen[value].fetch_add(1, std::memory_order_relaxed);
+						consumed.fetch_add(1, std::memory_order_relaxed);
+					} else {
+						std::this_thread::yield();
+					}
+				}
+			});
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+
+		REQUIRE(consumed == kThreads * kPerProducer);
+		REQUIRE(std::ranges::all_of(seen, [](const auto& count) { return count.load() == 1; }));
+		REQUIRE(queue.EmptyApprox());
+	}
+}
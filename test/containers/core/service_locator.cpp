@@ -0,0 +1,87 @@
+#include <catch_amalgamated.hpp>
+
+#include <plugify/global.h>
+#include <plugify/service_locator.hpp>
+
+#include <memory>
+#include <stdexcept>
+
+using namespace plugify;
+
+namespace {
+	struct IClock {
+		virtual ~IClock() = default;
+		virtual int Now() const = 0;
+	};
+
+	struct FixedClock final : IClock {
+		explicit FixedClock(int time) : time(time) {}
+		int Now() const override { return time; }
+		int time;
+	};
+
+	struct ICounter {
+		virtual ~ICounter() = default;
+	};
+
+	struct Counter final : ICounter {};
+}
+
+TEST_CASE("service locator sealing", "[core]") {
+	ServiceLocator services;
+	auto clock = std::make_shared<FixedClock>(42);
+	services.RegisterInstance<IClock>(clock);
+	services.RegisterType<ICounter, Counter>(ServiceLifetime::Transient);
+
+	SECTION("Get before and after Seal") {
+		REQUIRE_FALSE(services.IsSealed());
+		REQUIRE(services.Get<IClock>() == clock.get());
+		// only singletons can be borrowed
+		REQUIRE(services.Get<ICounter>() == nullptr);
+
+		services.Seal();
+		REQUIRE(services.IsSealed());
+		REQUIRE(services.Get<IClock>() == clock.get());
+		REQUIRE(services.Get<IClock>()->Now() == 42);
+		REQUIRE(services.Get<ICounter>() == nullptr);
+		REQUIRE(services.Resolve<IClock>() == clock);
+		REQUIRE(services.Resolve<ICounter>() != services.Resolve<ICounter>());
+
+		// sealing twice keeps the table
+		services.Seal();
+		REQUIRE(services.Get<IClock>() == clock.get());
+	}
+
+	SECTION("registering after Seal throws") {
+		services.Seal();
+
+		REQUIRE_THROWS_AS(services.RegisterInstance<IClock>(std::make_shared<FixedClock>(7)), std::logic_error);
+		REQUIRE_THROWS_AS(services.RegisterType<ICounter, Counter>(), std::logic_error);
+		// the existing registration is untouched
+		REQUIRE(services.Get<IClock>()->Now() == 42);
+
+		// nothing is missing, so nothing is registered and nothing throws
+		REQUIRE_NOTHROW(services.RegisterInstanceIfMissing<IClock>(std::make_shared<FixedClock>(7)));
+	}
+
+	SECTION("Clear before Seal") {
+		services.Clear();
+		REQUIRE(services.Count() == 0);
+		REQUIRE(services.Get<IClock>() == nullptr);
+
+		auto other = std::make_shared<FixedClock>(7);
+		REQUIRE_NOTHROW(services.RegisterInstance<IClock>(other));
+		services.Seal();
+		REQUIRE(services.Get<IClock>()->Now() == 7);
+	}
+
+	SECTION("Clear after Seal throws") {
+		services.Seal();
+		REQUIRE_THROWS_AS(services.Clear(), std::logic_error);
+
+		// lock-free readers still see the sealed table
+		REQUIRE(services.IsSealed());
+		REQUIRE(services.Count() == 2);
+		REQUIRE(services.Get<IClock>()->Now() == 42);
+	}
+}
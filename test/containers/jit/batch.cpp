@@ -0,0 +1,120 @@
+#include <catch_amalgamated.hpp>
+
+#include <plugify/jit_batch.hpp>
+
+#include <cstring>
+
+using namespace plugify;
+
+namespace {
+	int64_t Sum(int64_t a, int64_t b) {
+		return a + b;
+	}
+
+	double Scale(double value, int32_t factor) {
+		return value * factor;
+	}
+
+	float Mix(float a, int32_t b, double c, int64_t d) {
+		return a + static_cast<float>(b) + static_cast<float>(c) + static_cast<float>(d);
+	}
+
+	// data + a + b
+	void SumHandler(const Method*, Address data, uint64_t* params, size_t count, void* ret) {
+		ParametersSpan args(params, count);
+		int64_t sum = static_cast<int64_t>(data.GetPtr()) + args.Get<int64_t>(0) + args.Get<int64_t>(1);
+		std::memcpy(ret, &sum, sizeof(sum));
+	}
+
+	// data * value * factor
+	void ScaleHandler(const Method*, Address data, uint64_t* params, size_t count, void* ret) {
+		ParametersSpan args(params, count);
+		double value = static_cast<double>(data.GetPtr()) * args.Get<double>(0) * args.Get<int32_t>(1);
+		std::memcpy(ret, &value, sizeof(value));
+	}
+}
+
+TEST_CASE("batched stub generation", "[jit]") {
+	Signature sumSignature(CallConv::CDecl, ValueType::Int64, Signature::kNoVarArgs);
+	sumSignature.AddArg(ValueType::Int64);
+	sumSignature.AddArg(ValueType::Int64);
+
+	Signature scaleSignature(CallConv::CDecl, ValueType::Double, Signature::kNoVarArgs);
+	scaleSignature.AddArg(ValueType::Double);
+	scaleSignature.AddArg(ValueType::Int32);
+
+	Signature mixSignature(CallConv::CDecl, ValueType::Float, Signature::kNoVarArgs);
+	mixSignature.AddArg(ValueType::Float);
+	mixSignature.AddArg(ValueType::Int32);
+	mixSignature.AddArg(ValueType::Double);
+	mixSignature.AddArg(ValueType::Int64);
+
+	SECTION("calls and callbacks in one block") {
+		JitBatch batch;
+		size_t sumCall = batch.AddCall(sumSignature, &Sum, JitCall::WaitType::None, false);
+		size_t scaleCall = batch.AddCall(scaleSignature, &Scale, JitCall::WaitType::None, false);
+		size_t mixCall = batch.AddCall(mixSignature, &Mix, JitCall::WaitType::None, false);
+		size_t sumCallback = batch.AddCallback(sumSignature, nullptr, &SumHandler, 100, false);
+		size_t scaleCallback = batch.AddCallback(scaleSignature, nullptr, &ScaleHandler, 2, false);
+		// same signature again, gets its own entry
+		size_t otherSumCall = batch.AddCall(sumSignature, &Sum, JitCall::WaitType::None, false);
+		REQUIRE(batch.GetSize() == 6);
+
+		REQUIRE_FALSE(batch.GetFunction(sumCall));
+		REQUIRE(batch.Compile());
+		REQUIRE(batch.GetError().empty());
+		for (size_t i = 0; i < batch.GetSize(); ++i) {
+			REQUIRE(batch.GetFunction(i));
+		}
+
+		{
+			Parameters params(2);
+			params.Add(int64_t{ 40 });
+			params.Add(int64_t{ 2 });
+			Return ret;
+			batch.GetFunction(sumCall).As<JitCall::CallingFunc>()(params.Get(), &ret);
+			REQUIRE(ret.Get<int64_t>() == 42);
+
+			Return other;
+			batch.GetFunction(otherSumCall).As<JitCall::CallingFunc>()(params.Get(), &other);
+			REQUIRE(other.Get<int64_t>() == 42);
+		}
+		{
+			Parameters params(2);
+			params.Add(1.25);
+			params.Add(int32_t{ 4 });
+			Return ret;
+			batch.GetFunction(scaleCall).As<JitCall::CallingFunc>()(params.Get(), &ret);
+			REQUIRE(ret.Get<double>() == Scale(1.25, 4));
+		}
+		{
+			Parameters params(4);
+			params.Add(0.5f);
+			params.Add(int32_t{ 2 });
+			params.Add(0.25);
+			params.Add(int64_t{ 8 });
+			Return ret;
+			batch.GetFunction(mixCall).As<JitCall::CallingFunc>()(params.Get(), &ret);
+			REQUIRE(ret.Get<float>() == Mix(0.5f, 2, 0.25, 8));
+		}
+
+		REQUIRE(batch.GetFunction(sumCallback).As<decltype(&Sum)>()(1, 2) == 103);
+		REQUIRE(batch.GetFunction(scaleCallback).As<decltype(&Scale)>()(1.5, 3) == 9.0);
+	}
+
+	SECTION("a batch compiles only once") {
+		JitBatch batch;
+		size_t index = batch.AddCall(sumSignature, &Sum, JitCall::WaitType::None, false);
+		REQUIRE(batch.Compile());
+		Address func = batch.GetFunction(index);
+		REQUIRE_FALSE(batch.Compile());
+		REQUIRE(batch.GetFunction(index) == func);
+	}
+
+	SECTION("out of range entries") {
+		JitBatch batch;
+		REQUIRE(batch.Compile());
+		REQUIRE(batch.GetSize() == 0);
+		REQUIRE_FALSE(batch.GetFunction(0));
+	}
+}
@@ -0,0 +1,80 @@
+#include <catch_amalgamated.hpp>
+
+#include <plugify/jit_closure.hpp>
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using namespace plugify;
+
+namespace {
+	double Scale(int64_t a, double b);
+
+	int64_t Sum(int64_t a, int64_t b);
+
+	// data + a * b
+	void ScaleHandler(const Method*, Address data, uint64_t* params, size_t count, void* ret) {
+		ParametersSpan args(params, count);
+		double value = static_cast<double>(data.GetPtr()) + static_cast<double>(args.Get<int64_t>(0)) * args.Get<double>(1);
+		std::memcpy(ret, &value, sizeof(value));
+	}
+
+	// data + a + b
+	void SumHandler(const Method*, Address data, uint64_t* params, size_t count, void* ret) {
+		auto sum = static_cast<int64_t>(data.GetPtr());
+		for (size_t i = 0; i < count; ++i) {
+			sum += static_cast<int64_t>(params[i]);
+		}
+		std::memcpy(ret, &sum, sizeof(sum));
+	}
+}
+
+TEST_CASE("pooled closures", "[jit]") {
+	SECTION("many instances share one stub per signature") {
+		// more than a page of thunks
+		constexpr size_t kClosureCount = 1000;
+
+		Signature signature(CallConv::CDecl, ValueType::Double, Signature::kNoVarArgs);
+		signature.AddArg(ValueType::Int64);
+		signature.AddArg(ValueType::Double);
+
+		std::vector<std::unique_ptr<JitClosure>> closures;
+		for (size_t i = 0; i < kClosureCount; ++i) {
+			auto closure = std::make_unique<JitClosure>();
+			REQUIRE(closure->GetJitFunc(signature, nullptr, &ScaleHandler, static_cast<int64_t>(i), false));
+			REQUIRE(closure->GetUserData().GetPtr() == i);
+			closures.push_back(std::move(closure));
+		}
+
+		size_t mismatches = 0;
+		for (size_t i = 0; i < kClosureCount; ++i) {
+			auto func = closures[i]->GetFunction().As<decltype(&Scale)>();
+			if (func(3, 0.5) != static_cast<double>(i) + 1.5) {
+				++mismatches;
+			}
+		}
+		REQUIRE(mismatches == 0);
+	}
+
+	SECTION("released thunks are handed out again") {
+		Signature signature(CallConv::CDecl, ValueType::Int64, Signature::kNoVarArgs);
+		signature.AddArg(ValueType::Int64);
+		signature.AddArg(ValueType::Int64);
+
+		auto first = std::make_unique<JitClosure>();
+		Address released = first->GetJitFunc(signature, nullptr, &SumHandler, 10, false);
+		REQUIRE(released);
+		REQUIRE(released.As<decltype(&Sum)>()(1, 2) == 13);
+		first.reset();
+
+		JitClosure second;
+		Address func = second.GetJitFunc(signature, nullptr, &SumHandler, 20, false);
+		REQUIRE(func);
+		REQUIRE(func.As<decltype(&Sum)>()(1, 2) == 23);
+
+		if constexpr (sizeof(void*) == sizeof(uint64_t)) {
+			REQUIRE(func == released);
+		}
+	}
+}
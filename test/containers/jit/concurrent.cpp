@@ -0,0 +1,232 @@
+#include <catch_amalgamated.hpp>
+
+#include <plugify/call.hpp>
+#include <plugify/callback.hpp>
+#include <plugify/jit_context.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace plugify;
+
+namespace {
+	// Floating point arguments, integer only shapes are served by the
+	// precompiled thunks and would never reach the compiler
+	double Sum1(double a) {
+		return a;
+	}
+
+	double Sum2(double a, double b) {
+		return a + b;
+	}
+
+	double Sum3(double a, double b, double c) {
+		return a + b + c;
+	}
+
+	Signature MakeSumSignature(size_t argCount) {
+		Signature signature(CallConv::CDecl, ValueType::Double, Signature::kNoVarArgs);
+		for (size_t i = 0; i < argCount; ++i) {
+			signature.AddArg(ValueType::Double);
+		}
+		return signature;
+	}
+
+	void SumHandler(const Method*, Address data, uint64_t* params, size_t count, void* ret) {
+		ParametersSpan args(params, count);
+		auto sum = static_cast<double>(data.GetPtr());
+		for (size_t i = 0; i < count; ++i) {
+			sum += args.Get<double>(i);
+		}
+		std::memcpy(ret, &sum, sizeof(sum));
+	}
+
+	// Bit i of the mask makes argument i a double, an int64 otherwise
+	Signature MakeMixedSignature(size_t argCount, uint32_t mask) {
+		Signature signature(CallConv::CDecl, ValueType::Double, Signature::kNoVarArgs);
+		for (size_t i = 0; i < argCount; ++i) {
+			signature.AddArg(mask & (1u << i) ? ValueType::Double : ValueType::Int64);
+		}
+		return signature;
+	}
+
+	void MixedHandler(const Method*, Address data, uint64_t* params, size_t count, void* ret) {
+		ParametersSpan args(params, count);
+		const auto mask = static_cast<uint32_t>(data.GetPtr());
+		double sum = 0;
+		for (size_t i = 0; i < count; ++i) {
+			sum += mask & (1u << i) ? args.Get<double>(i) : static_cast<double>(args.Get<int64_t>(i));
+		}
+		std::memcpy(ret, &sum, sizeof(sum));
+	}
+
+	size_t ThreadCount() {
+		return std::max<size_t>(4, std::thread::hardware_concurrency());
+	}
+}
+
+TEST_CASE("concurrent stub generation", "[jit]") {
+	SECTION("JitCall from many threads") {
+		constexpr size_t kStubCount = 100'000;
+
+		const size_t threadCount = ThreadCount();
+		const std::array<Address, 3> targets = { &Sum1, &Sum2, &Sum3 };
+
+		std::vector<std::unique_ptr<JitCall>> calls(kStubCount);
+		std::atomic<size_t> failures{ 0 };
+
+		std::vector<std::thread> threads;
+		threads.reserve(threadCount);
+		for (size_t t = 0; t < threadCount; ++t) {
+			threads.emplace_back([&, t] {
+				for (size_t i = t; i < kStubCount; i += threadCount) {
+					size_t argCount = i % targets.size() + 1;
+
+					auto call = std::make_unique<JitCall>();
+					Address func = call->GetJitFunc(MakeSumSignature(argCount), targets[argCount - 1], JitCall::WaitType::None, false);
+					if (!func) {
+						failures.fetch_add(1, std::memory_order_relaxed);
+						continue;
+					}
+
+					Parameters params(argCount);
+					for (size_t j = 0; j < argCount; ++j) {
+						params.Add(static_cast<double>(i + j));
+					}
+					Return ret;
+					func.As<JitCall::CallingFunc>()(params.Get(), &ret);
+
+					double expected = 0;
+					for (size_t j = 0; j < argCount; ++j) {
+						expected += static_cast<double>(i + j);
+					}
+					if (ret.Get<double>() != expected) {
+						failures.fetch_add(1, std::memory_order_relaxed);
+					}
+
+					calls[i] = std::move(call);
+				}
+			});
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+
+		REQUIRE(failures.load() == 0);
+		REQUIRE(std::ranges::all_of(calls, [](const auto& call) { return call && call->GetFunction(); }));
+	}
+
+	SECTION("distinct signatures from many threads") {
+		constexpr size_t kMaxArgs = 8;
+
+		struct Target {
+			Signature signature;
+			uint32_t mask;
+			std::unique_ptr<JitCallback> callback;
+		};
+
+		// every mix of double and int64 arguments up to kMaxArgs, with at least
+		// one double so none of them is served by a precompiled thunk
+		std::vector<Target> targets;
+		for (size_t argCount = 1; argCount <= kMaxArgs; ++argCount) {
+			for (uint32_t mask = 1; mask < (1u << argCount); ++mask) {
+				targets.push_back({ MakeMixedSignature(argCount, mask), mask, std::make_unique<JitCallback>() });
+				auto& target = targets.back();
+				REQUIRE(target.callback->GetJitFunc(target.signature, nullptr, &MixedHandler, static_cast<int64_t>(mask), false));
+			}
+		}
+		REQUIRE(targets.size() == 502);
+
+		const auto previous = JitContext::GetCacheDirectory();
+		JitContext::SetCacheDirectory({});
+		JitContext::ClearStubCache();
+		JitContext::ResetStats();
+
+		// every thread asks for every signature, starting at a different one,
+		// so the first compilation of each races with the others
+		const size_t threadCount = ThreadCount();
+		std::atomic<size_t> failures{ 0 };
+		std::vector<std::thread> threads;
+		threads.reserve(threadCount);
+		for (size_t t = 0; t < threadCount; ++t) {
+			threads.emplace_back([&, t] {
+				for (size_t n = 0; n < targets.size(); ++n) {
+					const auto& target = targets[(n + t * 7) % targets.size()];
+					const size_t argCount = target.signature.ArgCount();
+
+					JitCall call;
+					Address func = call.GetJitFunc(target.signature, target.callback->GetFunction(), JitCall::WaitType::None, false);
+					if (!func) {
+						failures.fetch_add(1, std::memory_order_relaxed);
+						continue;
+					}
+
+					Parameters params(argCount);
+					double expected = 0;
+					for (size_t j = 0; j < argCount; ++j) {
+						if (target.mask & (1u << j)) {
+							params.Add(static_cast<double>(j) + 0.5);
+							expected += static_cast<double>(j) + 0.5;
+						} else {
+							params.Add(static_cast<int64_t>(t + j));
+							expected += static_cast<double>(t + j);
+						}
+					}
+					Return ret;
+					func.As<JitCall::CallingFunc>()(params.Get(), &ret);
+					if (ret.Get<double>() != expected) {
+						failures.fetch_add(1, std::memory_order_relaxed);
+					}
+				}
+			});
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+
+		auto stats = JitContext::GetStats();
+		JitContext::SetCacheDirectory(previous);
+
+		REQUIRE(failures.load() == 0);
+		// a stub which lost the race to publish its signature is not counted
+		REQUIRE(stats.GetStubCount(JitStubKind::Generic) == targets.size());
+		REQUIRE(stats.GetStubCount(JitStubKind::Call) == targets.size() * threadCount);
+		REQUIRE(stats.cacheMisses >= targets.size());
+	}
+
+	SECTION("JitCallback from many threads") {
+		constexpr size_t kStubCount = 10'000;
+
+		const size_t threadCount = ThreadCount();
+
+		std::vector<std::unique_ptr<JitCallback>> callbacks(kStubCount);
+		std::atomic<size_t> failures{ 0 };
+
+		std::vector<std::thread> threads;
+		threads.reserve(threadCount);
+		for (size_t t = 0; t < threadCount; ++t) {
+			threads.emplace_back([&, t] {
+				for (size_t i = t; i < kStubCount; i += threadCount) {
+					auto callback = std::make_unique<JitCallback>();
+					Address func = callback->GetJitFunc(MakeSumSignature(2), nullptr, &SumHandler, static_cast<int64_t>(i), false);
+					if (!func || func.As<decltype(&Sum2)>()(1.0, 2.0) != static_cast<double>(i) + 3.0) {
+						failures.fetch_add(1, std::memory_order_relaxed);
+						continue;
+					}
+
+					callbacks[i] = std::move(callback);
+				}
+			});
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+
+		REQUIRE(failures.load() == 0);
+	}
+}
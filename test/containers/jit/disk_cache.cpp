@@ -0,0 +1,151 @@
+#include <catch_amalgamated.hpp>
+
+#include <plugify/call.hpp>
+#include <plugify/jit_context.hpp>
+
+#include <fstream>
+#include <vector>
+
+using namespace plugify;
+
+namespace {
+	float Blend(float a, double b, int16_t c) {
+		return a * static_cast<float>(b) + c;
+	}
+
+	Signature MakeBlendSignature() {
+		Signature signature(CallConv::CDecl, ValueType::Float, Signature::kNoVarArgs);
+		signature.AddArg(ValueType::Float);
+		signature.AddArg(ValueType::Double);
+		signature.AddArg(ValueType::Int16);
+		return signature;
+	}
+
+	// Compiles, or loads, the stub of a fresh JitCall and checks it calls through
+	bool CallBlend() {
+		JitCall call;
+		Address func = call.GetJitFunc(MakeBlendSignature(), &Blend, JitCall::WaitType::None, false);
+		if (!func) {
+			return false;
+		}
+
+		Parameters params(3);
+		params.Add(1.5f);
+		params.Add(2.0);
+		params.Add(int16_t{ 4 });
+		Return ret;
+		func.As<JitCall::CallingFunc>()(params.Get(), &ret);
+		return ret.Get<float>() == Blend(1.5f, 2.0, 4);
+	}
+
+	std::vector<std::filesystem::path> ListStubs(const std::filesystem::path& directory) {
+		std::vector<std::filesystem::path> stubs;
+		for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+			if (entry.path().extension() == ".stub") {
+				stubs.push_back(entry.path());
+			}
+		}
+		return stubs;
+	}
+
+	// Inverts a byte in place, offsets follow the file header of the disk cache:
+	// magic, format, environment, checksum, key size, code size, then key and code
+	void Flip(const std::filesystem::path& path, std::streamoff offset) {
+		std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+		auto dir = offset < 0 ? std::ios::end : std::ios::beg;
+		file.seekg(offset, dir);
+		char byte = static_cast<char>(file.get());
+		file.seekp(offset, dir);
+		file.put(static_cast<char>(~byte));
+	}
+
+	constexpr std::streamoff kEnvironmentOffset = 8;
+	constexpr std::streamoff kCodeSizeOffset = 28;
+}
+
+TEST_CASE("persistent stub cache", "[jit]") {
+	if (sizeof(void*) != sizeof(uint64_t)) {
+		SKIP("generic stubs are used on 64-bit targets only");
+	}
+
+	const auto previous = JitContext::GetCacheDirectory();
+	const auto directory = std::filesystem::temp_directory_path() / "plugify_disk_cache_test";
+	std::filesystem::remove_all(directory);
+	JitContext::SetCacheDirectory(directory);
+	JitContext::ClearStubCache();
+
+	// first use stores the stub
+	JitContext::ResetStats();
+	REQUIRE(CallBlend());
+	auto stats = JitContext::GetStats();
+	REQUIRE(stats.diskHits == 0);
+	REQUIRE(stats.diskMisses == 1);
+
+	auto stubs = ListStubs(directory);
+	REQUIRE(stubs.size() == 1);
+	const auto& stub = stubs.front();
+
+	SECTION("stored stubs are loaded back") {
+		JitContext::ClearStubCache();
+		JitContext::ResetStats();
+		REQUIRE(CallBlend());
+
+		stats = JitContext::GetStats();
+		REQUIRE(stats.diskHits == 1);
+		REQUIRE(stats.diskMisses == 0);
+	}
+
+	SECTION("a bad checksum is rejected") {
+		// last byte of the machine code
+		Flip(stub, -1);
+
+		JitContext::ClearStubCache();
+		JitContext::ResetStats();
+		REQUIRE(CallBlend());
+
+		stats = JitContext::GetStats();
+		REQUIRE(stats.diskHits == 0);
+		REQUIRE(stats.diskMisses == 1);
+
+		// the compiled stub replaced the broken one
+		JitContext::ClearStubCache();
+		JitContext::ResetStats();
+		REQUIRE(CallBlend());
+		REQUIRE(JitContext::GetStats().diskHits == 1);
+	}
+
+	SECTION("a stub of another environment is rejected") {
+		// as if written by another library version or on another CPU
+		Flip(stub, kEnvironmentOffset);
+
+		JitContext::ClearStubCache();
+		JitContext::ResetStats();
+		REQUIRE(CallBlend());
+
+		stats = JitContext::GetStats();
+		REQUIRE(stats.diskHits == 0);
+		REQUIRE(stats.diskMisses == 1);
+	}
+
+	SECTION("a code size beyond the file is rejected") {
+		// would ask for 4 GiB before the read fails
+		{
+			std::fstream file(stub, std::ios::binary | std::ios::in | std::ios::out);
+			file.seekp(kCodeSizeOffset);
+			const uint32_t codeSize = 0xFFFFFFFF;
+			file.write(reinterpret_cast<const char*>(&codeSize), sizeof(codeSize));
+		}
+
+		JitContext::ClearStubCache();
+		JitContext::ResetStats();
+		REQUIRE(CallBlend());
+
+		stats = JitContext::GetStats();
+		REQUIRE(stats.diskHits == 0);
+		REQUIRE(stats.diskMisses == 1);
+	}
+
+	JitContext::SetCacheDirectory(previous);
+	JitContext::ClearStubCache();
+	std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,127 @@
+#include <catch_amalgamated.hpp>
+
+#include <plugify/call.hpp>
+#include <plugify/jit_context.hpp>
+
+#include <cstring>
+
+using namespace plugify;
+
+namespace {
+	double Mix(int32_t a, double b, float c, int64_t d) {
+		return a * b + c - static_cast<double>(d);
+	}
+
+	float Narrow(float a, int8_t b, uint16_t c, const float* d) {
+		return a + b + c + *d;
+	}
+
+	// more arguments than registers in every convention, both kinds spill
+	double Spill(
+		int64_t i0, double f0, int64_t i1, double f1, int64_t i2, double f2, int64_t i3, double f3,
+		int64_t i4, double f4, int64_t i5, double f5, int64_t i6, double f6, int64_t i7, double f7,
+		int64_t i8, double f8, int64_t i9, double f9
+	) {
+		return static_cast<double>(i0 + 2 * i1 + 3 * i2 + 4 * i3 + 5 * i4 + 6 * i5 + 7 * i6 + 8 * i7 + 9 * i8 + 10 * i9)
+			+ f0 + 2 * f1 + 3 * f2 + 4 * f3 + 5 * f4 + 6 * f5 + 7 * f6 + 8 * f7 + 9 * f8 + 10 * f9;
+	}
+
+	void Store(int64_t* out, double value, int32_t count) {
+		*out = static_cast<int64_t>(value) * count;
+	}
+
+	// Calls the target through a stub of each emitter with the same parameters
+	template <typename Fill>
+	void CrossCheck(const Signature& signature, Address target, Fill&& fill, Return& assembled, Return& compiled) {
+		const JitEmitter previous = JitContext::GetEmitter();
+
+		JitContext::SetEmitter(JitEmitter::Compiler);
+		JitCall compilerCall;
+		Address compilerFunc = compilerCall.GetJitFunc(signature, target, JitCall::WaitType::None, false);
+		REQUIRE(compilerFunc);
+
+		JitContext::SetEmitter(JitEmitter::Assembler);
+		JitCall assemblerCall;
+		Address assemblerFunc = assemblerCall.GetJitFunc(signature, target, JitCall::WaitType::None, false);
+		REQUIRE(assemblerFunc);
+
+		JitContext::SetEmitter(previous);
+
+		Parameters params(signature.ArgCount());
+		fill(params);
+		compilerFunc.As<JitCall::CallingFunc>()(params.Get(), &compiled);
+		assemblerFunc.As<JitCall::CallingFunc>()(params.Get(), &assembled);
+	}
+}
+
+TEST_CASE("compiler emitter is the default", "[jit]") {
+	REQUIRE(JitContext::GetEmitter() == JitEmitter::Compiler);
+}
+
+TEST_CASE("assembler emitter matches the compiler", "[jit]") {
+	SECTION("mixed register arguments") {
+		Signature signature(CallConv::CDecl, ValueType::Double, Signature::kNoVarArgs);
+		signature.AddArg(ValueType::Int32);
+		signature.AddArg(ValueType::Double);
+		signature.AddArg(ValueType::Float);
+		signature.AddArg(ValueType::Int64);
+
+		Return assembled, compiled;
+		CrossCheck(signature, &Mix, [](Parameters& params) {
+			params.Add(int32_t{ -3 }).Add(2.5).Add(0.25f).Add(int64_t{ 7 });
+		}, assembled, compiled);
+
+		REQUIRE(compiled.Get<double>() == Mix(-3, 2.5, 0.25f, 7));
+		REQUIRE(assembled.Get<double>() == compiled.Get<double>());
+	}
+
+	SECTION("narrow integers and float return") {
+		Signature signature(CallConv::CDecl, ValueType::Float, Signature::kNoVarArgs);
+		signature.AddArg(ValueType::Float);
+		signature.AddArg(ValueType::Int8);
+		signature.AddArg(ValueType::UInt16);
+		signature.AddArg(ValueType::Pointer);
+
+		const float extra = 0.5f;
+		Return assembled, compiled;
+		CrossCheck(signature, &Narrow, [&extra](Parameters& params) {
+			params.Add(1.25f).Add(int8_t{ -4 }).Add(uint16_t{ 300 }).Add(&extra);
+		}, assembled, compiled);
+
+		REQUIRE(compiled.Get<float>() == Narrow(1.25f, -4, 300, &extra));
+		REQUIRE(assembled.Get<float>() == compiled.Get<float>());
+	}
+
+	SECTION("stack arguments") {
+		Signature signature(CallConv::CDecl, ValueType::Double, Signature::kNoVarArgs);
+		for (int i = 0; i < 10; ++i) {
+			signature.AddArg(ValueType::Int64);
+			signature.AddArg(ValueType::Double);
+		}
+
+		Return assembled, compiled;
+		CrossCheck(signature, &Spill, [](Parameters& params) {
+			for (int i = 0; i < 10; ++i) {
+				params.Add(int64_t{ i + 1 }).Add(0.5 * i);
+			}
+		}, assembled, compiled);
+
+		REQUIRE(compiled.Get<double>() == Spill(1, 0.0, 2, 0.5, 3, 1.0, 4, 1.5, 5, 2.0, 6, 2.5, 7, 3.0, 8, 3.5, 9, 4.0, 10, 4.5));
+		REQUIRE(assembled.Get<double>() == compiled.Get<double>());
+	}
+
+	SECTION("void return") {
+		Signature signature(CallConv::CDecl, ValueType::Void, Signature::kNoVarArgs);
+		signature.AddArg(ValueType::Pointer);
+		signature.AddArg(ValueType::Double);
+		signature.AddArg(ValueType::Int32);
+
+		int64_t out = 0;
+		Return assembled, compiled;
+		CrossCheck(signature, &Store, [&out](Parameters& params) {
+			params.Add(&out).Add(6.0).Add(int32_t{ 7 });
+		}, assembled, compiled);
+
+		REQUIRE(out == 42);
+	}
+}
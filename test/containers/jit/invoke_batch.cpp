@@ -0,0 +1,151 @@
+#include <catch_amalgamated.hpp>
+
+#include <plugify/call.hpp>
+#include <plugify/method.hpp>
+#include <plugify/property.hpp>
+
+#include <array>
+#include <memory>
+
+using namespace plugify;
+
+namespace {
+	int64_t Add(int64_t a, int64_t b) {
+		return a + b;
+	}
+
+	int64_t Sub(int64_t a, int64_t b) {
+		return a - b;
+	}
+
+	int64_t Mul(int64_t a, int64_t b) {
+		return a * b;
+	}
+
+	double Scale(double value, int32_t factor) {
+		return value * factor;
+	}
+
+	plg::string Greet(const plg::string& name) {
+		return "hello " + name;
+	}
+
+	plg::string Shout(const plg::string& name) {
+		return name + "!";
+	}
+
+	Method MakeStringMethod() {
+		Property string;
+		string.SetType(ValueType::String);
+
+		Method method;
+		method.SetName("Greet");
+		method.SetRetType(string);
+		method.SetParamTypes({ string });
+		return method;
+	}
+
+	// Uninitialized storage the callee constructs its hidden return into
+	struct StringBuffer {
+		alignas(plg::string) std::byte storage[sizeof(plg::string)];
+
+		plg::string* Get() noexcept {
+			return reinterpret_cast<plg::string*>(storage);
+		}
+	};
+}
+
+TEST_CASE("batched invoke", "[jit]") {
+	SECTION("InvokeAll fans out one parameter set") {
+		Signature signature(CallConv::CDecl, ValueType::Int64, Signature::kNoVarArgs);
+		signature.AddArg(ValueType::Int64);
+		signature.AddArg(ValueType::Int64);
+
+		JitCall call;
+		REQUIRE(call.GetJitFunc(signature, &Add, JitCall::WaitType::None, false));
+
+		Parameters params(2);
+		params.Add(int64_t{ 7 });
+		params.Add(int64_t{ 3 });
+
+		std::array<Address, 3> targets{ &Add, &Sub, &Mul };
+		std::array<Return, 3> rets{};
+		REQUIRE(call.InvokeAll(targets, params, rets));
+
+		REQUIRE(rets[0].Get<int64_t>() == 10);
+		REQUIRE(rets[1].Get<int64_t>() == 4);
+		REQUIRE(rets[2].Get<int64_t>() == 21);
+
+		// returns can be dropped, but must cover every target when given
+		REQUIRE(call.InvokeAll(targets, params));
+		REQUIRE_FALSE(call.InvokeAll(targets, params, std::span(rets).first(2)));
+		REQUIRE_FALSE(call.GetError().empty());
+
+		// a later success clears the error
+		REQUIRE(call.InvokeAll(targets, params, rets));
+		REQUIRE(call.GetError().empty());
+	}
+
+	SECTION("InvokeEach walks parameter blocks") {
+		Signature signature(CallConv::CDecl, ValueType::Double, Signature::kNoVarArgs);
+		signature.AddArg(ValueType::Double);
+		signature.AddArg(ValueType::Int32);
+
+		JitCall call;
+		REQUIRE(call.GetJitFunc(signature, &Scale, JitCall::WaitType::None, false));
+
+		std::array<Parameters, 4> params{ Parameters(2), Parameters(2), Parameters(2), Parameters(2) };
+		for (int32_t i = 0; i < static_cast<int32_t>(params.size()); ++i) {
+			params[i].Add(1.5 * i);
+			params[i].Add(i + 1);
+		}
+
+		std::array<Return, 4> rets{};
+		REQUIRE(call.InvokeEach(params, rets));
+
+		for (int32_t i = 0; i < static_cast<int32_t>(rets.size()); ++i) {
+			REQUIRE(rets[i].Get<double>() == Scale(1.5 * i, i + 1));
+		}
+
+		REQUIRE(call.InvokeEach({}));
+	}
+
+	SECTION("hidden returns get a buffer per call") {
+		JitCall call;
+		REQUIRE(call.GetJitFunc(MakeStringMethod(), &Greet));
+
+		const std::array<plg::string, 3> names{ "a", "bb", "a name long enough to live on the heap" };
+
+		// the one hidden buffer of shared parameters cannot serve several targets
+		StringBuffer shared;
+		Parameters sharedParams(2);
+		sharedParams.Add(shared.Get());
+		sharedParams.Add(&names[0]);
+		std::array<Address, 2> targets{ &Greet, &Shout };
+		REQUIRE_FALSE(call.InvokeAll(targets, sharedParams));
+		REQUIRE_FALSE(call.GetError().empty());
+
+		std::array<StringBuffer, 3> buffers;
+		std::array<Parameters, 3> params{ Parameters(2), Parameters(2), Parameters(2) };
+		for (size_t i = 0; i < params.size(); ++i) {
+			params[i].Add(buffers[i].Get());
+			params[i].Add(&names[i]);
+		}
+
+		std::array<Return, 3> rets{};
+		REQUIRE(call.InvokeEach(params, rets));
+
+		for (size_t i = 0; i < buffers.size(); ++i) {
+			REQUIRE(rets[i].Get<plg::string*>() == buffers[i].Get());
+			REQUIRE(*buffers[i].Get() == Greet(names[i]));
+			std::destroy_at(buffers[i].Get());
+		}
+	}
+
+	SECTION("nothing is invoked without a generated function") {
+		JitCall call;
+		Parameters params(0);
+		std::array<Address, 1> targets{ &Add };
+		REQUIRE_FALSE(call.InvokeAll(targets, params));
+	}
+}
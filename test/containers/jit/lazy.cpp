@@ -0,0 +1,71 @@
+#include <catch_amalgamated.hpp>
+
+#include <plugify/jit_lazy.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace plugify;
+
+namespace {
+	double Mix(int64_t a, double b, int32_t c, float d) {
+		return static_cast<double>(a) * b + c + d;
+	}
+}
+
+TEST_CASE("lazy entry points", "[jit]") {
+	using MixFunc = decltype(&Mix);
+	constexpr bool kLazy = sizeof(void*) == sizeof(uint64_t);
+
+	SECTION("the function is generated on first call only") {
+		std::atomic<int> generated{};
+
+		JitLazy lazy;
+		Address entry = lazy.GetLazyFunc([&generated]() -> Address {
+			++generated;
+			return &Mix;
+		});
+		REQUIRE(entry);
+
+		if constexpr (kLazy) {
+			REQUIRE(generated == 0);
+			REQUIRE_FALSE(lazy.GetResolvedFunc());
+		}
+
+		// arguments in integer and vector registers survive the resolver
+		REQUIRE(entry.As<MixFunc>()(3, 1.5, 2, 0.25f) == Mix(3, 1.5, 2, 0.25f));
+		REQUIRE(entry.As<MixFunc>()(-1, 4.0, 7, 1.0f) == Mix(-1, 4.0, 7, 1.0f));
+
+		REQUIRE(generated == 1);
+		REQUIRE(lazy.GetResolvedFunc() == Address(&Mix));
+	}
+
+	SECTION("concurrent first calls generate once") {
+		std::atomic<int> generated{};
+
+		JitLazy lazy;
+		Address entry = lazy.GetLazyFunc([&generated]() -> Address {
+			++generated;
+			std::this_thread::yield();
+			return &Mix;
+		});
+		REQUIRE(entry);
+
+		std::atomic<int> mismatches{};
+		std::vector<std::thread> threads;
+		for (int i = 0; i < 8; ++i) {
+			threads.emplace_back([&, i] {
+				if (entry.As<MixFunc>()(i, 2.0, i, 0.5f) != Mix(i, 2.0, i, 0.5f)) {
+					++mismatches;
+				}
+			});
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+
+		REQUIRE(generated == 1);
+		REQUIRE(mismatches == 0);
+	}
+}
@@ -0,0 +1,95 @@
+#include <catch_amalgamated.hpp>
+
+#include <plugify/call.hpp>
+#include <plugify/marshal_plan.hpp>
+#include <plugify/method.hpp>
+#include <plugify/property.hpp>
+
+#include <algorithm>
+
+#include "method_builder.hpp"
+
+using namespace plugify;
+using test::MakeMethod;
+using test::MakeProperty;
+
+namespace {
+	double Blend(double a, float b, int32_t& count) {
+		++count;
+		return a * b;
+	}
+}
+
+TEST_CASE("method marshal plan", "[jit]") {
+	SECTION("slots of a hidden return, refs and structs") {
+		Method method = MakeMethod(ValueType::String, {
+			MakeProperty(ValueType::Vector3),
+			MakeProperty(ValueType::Double),
+			MakeProperty(ValueType::Int32, true),
+		});
+
+		const MarshalPlan* plan = method.GetMarshalPlan();
+		REQUIRE(plan);
+		REQUIRE(plan->retHidden);
+		REQUIRE(plan->retClass == RegClass::Int);
+		REQUIRE(plan->slots.size() == 4);
+		REQUIRE(plan->GetFrameSize() == 4 * sizeof(uint64_t));
+
+		REQUIRE(plan->slots[0].hidden);
+		REQUIRE(plan->slots[0].native == ValueType::Pointer);
+		REQUIRE(plan->slots[1].regClass == RegClass::Struct);
+		REQUIRE(plan->slots[2].regClass == RegClass::Float);
+		REQUIRE(plan->slots[2].offset == 2 * sizeof(uint64_t));
+		REQUIRE(plan->slots[3].ref);
+		REQUIRE(plan->slots[3].native == ValueType::Pointer);
+		REQUIRE(plan->slots[3].regClass == RegClass::Int);
+
+		// same lowering as a plan built on demand
+		MarshalPlan rebuilt(method);
+		REQUIRE(rebuilt.signature.retType == plan->signature.retType);
+		REQUIRE(std::ranges::equal(rebuilt.signature.argTypes, plan->signature.argTypes));
+	}
+
+	SECTION("a custom predicate is honoured") {
+		Method method = MakeMethod(ValueType::Vector2, {
+			MakeProperty(ValueType::Float),
+		});
+		REQUIRE_FALSE(method.GetMarshalPlan()->retHidden);
+
+		MarshalPlan plan(method, [](ValueType type) { return type == ValueType::Vector2; });
+		REQUIRE(plan.retHidden);
+		REQUIRE(plan.signature.retType == ValueType::Pointer);
+		REQUIRE(plan.signature.argTypes[0] == ValueType::Pointer);
+		REQUIRE(plan.slots.size() == 2);
+
+		// nullptr stands for the default one
+		MarshalPlan defaulted(method, nullptr);
+		REQUIRE(defaulted.retHidden == method.GetMarshalPlan()->retHidden);
+	}
+
+	SECTION("setters refresh the plan and calls use it") {
+		Method method = MakeMethod(ValueType::Double, {
+			MakeProperty(ValueType::Double),
+			MakeProperty(ValueType::Int32),
+		});
+		REQUIRE(method.GetMarshalPlan()->slots[1].native == ValueType::Int32);
+
+		method.SetParamTypes({ MakeProperty(ValueType::Double), MakeProperty(ValueType::Float), MakeProperty(ValueType::Int32, true) });
+		const MarshalPlan* plan = method.GetMarshalPlan();
+		REQUIRE(plan->slots.size() == 3);
+		REQUIRE(plan->slots[2].native == ValueType::Pointer);
+
+		JitCall call;
+		Address func = call.GetJitFunc(method, &Blend);
+		REQUIRE(func);
+
+		int32_t count = 0;
+		Parameters params(plan->slots.size());
+		params.Add(3.0).Add(0.5f).Add(&count);
+		Return ret;
+		func.As<JitCall::CallingFunc>()(params.Get(), &ret);
+
+		REQUIRE(ret.Get<double>() == 1.5);
+		REQUIRE(count == 1);
+	}
+}
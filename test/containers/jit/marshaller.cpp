@@ -0,0 +1,97 @@
+#include <catch_amalgamated.hpp>
+
+#include <plugify/call.hpp>
+#include <plugify/marshaller.hpp>
+#include <plugify/method.hpp>
+#include <plugify/property.hpp>
+
+#include <array>
+
+#include "method_builder.hpp"
+
+using namespace plugify;
+using test::MakeMethod;
+using test::MakeProperty;
+
+namespace {
+	plg::string Repeat(const plg::string& text, int32_t count, int32_t& total) {
+		plg::string result;
+		for (int32_t i = 0; i < count; ++i) {
+			result += text;
+		}
+		total += count;
+		return result;
+	}
+
+	double Scale(double value, int32_t factor) {
+		return value * factor;
+	}
+}
+
+TEST_CASE("plg::any marshaller", "[jit]") {
+	SECTION("objects, refs and hidden returns") {
+		Method method = MakeMethod("Repeat", ValueType::String, {
+			MakeProperty(ValueType::String),
+			MakeProperty(ValueType::Int32),
+			MakeProperty(ValueType::Int32, true),
+		});
+
+		auto marshaller = Marshaller::Create(method);
+		REQUIRE(marshaller);
+		REQUIRE(marshaller->GetArgCount() == 3);
+
+		JitCall call;
+		Address func = call.GetJitFunc(method, &Repeat);
+		REQUIRE(func);
+
+		std::array<plg::any, 3> args{ plg::string("ab"), int32_t{ 3 }, int32_t{ 1 } };
+		plg::any ret;
+		REQUIRE(marshaller->Invoke(func.As<JitCall::CallingFunc>(), args, ret));
+
+		REQUIRE(plg::get<plg::string>(ret) == "ababab");
+		REQUIRE(plg::get<int32_t>(args[2]) == 4);  // written back through the ref
+	}
+
+	SECTION("scalars are returned in registers") {
+		Method method = MakeMethod("Scale", ValueType::Double, {
+			MakeProperty(ValueType::Double),
+			MakeProperty(ValueType::Int32),
+		});
+
+		auto marshaller = Marshaller::Create(method);
+		REQUIRE(marshaller);
+
+		JitCall call;
+		Address func = call.GetJitFunc(method, &Scale);
+		REQUIRE(func);
+
+		std::array<plg::any, 2> args{ 1.5, int32_t{ 4 } };
+		plg::any ret;
+		REQUIRE(marshaller->Invoke(func.As<JitCall::CallingFunc>(), args, ret));
+		REQUIRE(plg::get<double>(ret) == 6.0);
+
+		// wrong type or count, nothing is called
+		std::array<plg::any, 2> wrong{ 1.5, 4.0 };
+		REQUIRE_FALSE(marshaller->Invoke(func.As<JitCall::CallingFunc>(), wrong, ret));
+		REQUIRE_FALSE(marshaller->Invoke(func.As<JitCall::CallingFunc>(), std::span(args).first(1), ret));
+	}
+
+	SECTION("types without a plg::any alternative are rejected") {
+		Method method = MakeMethod("Transform", ValueType::Void, {
+			MakeProperty(ValueType::Matrix4x4, true),
+		});
+		REQUIRE_FALSE(Marshaller::Create(method));
+	}
+
+	SECTION("a hidden return needs a free slot") {
+		Method full;
+		full.SetName("Join");
+		full.SetRetType(MakeProperty(ValueType::String));
+		full.SetParamTypes(std::inplace_vector<Property, Signature::kMaxFuncArgs>(Signature::kMaxFuncArgs, MakeProperty(ValueType::Int32)));
+		REQUIRE_FALSE(Marshaller::Create(full));
+
+		// returned in a register, every slot is available
+		full.SetRetType(MakeProperty(ValueType::Int32));
+		REQUIRE(Marshaller::Create(full));
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <plugify/method.hpp>
+#include <plugify/property.hpp>
+#include <plugify/signarure.hpp>
+
+#include <initializer_list>
+#include <string>
+
+// Builds the method descriptions the marshalling tests run against
+namespace test {
+	inline plugify::Property MakeProperty(plugify::ValueType type, bool ref = false) {
+		plugify::Property property;
+		property.SetType(type);
+		property.SetRef(ref);
+		return property;
+	}
+
+	inline plugify::Method MakeMethod(std::string name, plugify::ValueType retType, std::initializer_list<plugify::Property> params) {
+		plugify::Method method;
+		method.SetName(std::move(name));
+		method.SetRetType(MakeProperty(retType));
+		std::inplace_vector<plugify::Property, plugify::Signature::kMaxFuncArgs> paramTypes;
+		for (const auto& param : params) {
+			paramTypes.push_back(param);
+		}
+		method.SetParamTypes(std::move(paramTypes));
+		return method;
+	}
+
+	inline plugify::Method MakeMethod(plugify::ValueType retType, std::initializer_list<plugify::Property> params) {
+		return MakeMethod({}, retType, params);
+	}
+}
@@ -0,0 +1,53 @@
+#include <catch_amalgamated.hpp>
+
+#include <plugify/call.hpp>
+#include <plugify/jit_context.hpp>
+
+#include <fstream>
+#include <string>
+
+#if PLUGIFY_PLATFORM_LINUX
+#include <unistd.h>
+#endif
+
+using namespace plugify;
+
+namespace {
+	double Scale(double value, int32_t factor) {
+		return value * factor;
+	}
+}
+
+TEST_CASE("jit profiler output", "[jit]") {
+#if PLUGIFY_PLATFORM_LINUX
+	const auto previous = JitContext::GetProfilerOutput();
+	JitContext::SetProfilerOutput(JitProfilerOutput::PerfMap);
+	REQUIRE(JitContext::GetProfilerOutput() == JitProfilerOutput::PerfMap);
+
+	Signature signature(CallConv::CDecl, ValueType::Double, Signature::kNoVarArgs);
+	signature.AddArg(ValueType::Double);
+	signature.AddArg(ValueType::Int32);
+
+	JitCall call;
+	Address func = call.GetJitFunc(signature, &Scale, JitCall::WaitType::None, false);
+	REQUIRE(func);
+
+	std::ifstream map("/tmp/perf-" + std::to_string(getpid()) + ".map");
+	REQUIRE(map.is_open());
+
+	// <start> <size> <name>, both numbers in hex without prefix
+	bool found = false;
+	for (std::string line; std::getline(map, line);) {
+		if (line.find("plugify::call double(double, int32)") == std::string::npos) {
+			continue;
+		}
+		const auto start = std::stoull(line.substr(0, line.find(' ')), nullptr, 16);
+		found |= start == func.GetPtr();
+	}
+	REQUIRE(found);
+
+	JitContext::SetProfilerOutput(previous);
+#else
+	SKIP("profiler output is only written on Linux");
+#endif
+}
@@ -0,0 +1,101 @@
+#include <catch_amalgamated.hpp>
+
+#include <plugify/call.hpp>
+#include <plugify/callback.hpp>
+#include <plugify/jit_context.hpp>
+
+#include <algorithm>
+#include <array>
+
+using namespace plugify;
+
+namespace {
+	// a signature no other test uses, so its generic stub is compiled here
+	double Scale(double value, uint32_t factor) {
+		return value * factor;
+	}
+
+	void NoopHandler(const Method*, Address, uint64_t*, size_t, void*) {
+	}
+}
+
+TEST_CASE("jit statistics", "[jit]") {
+	Signature signature(CallConv::CDecl, ValueType::Double, Signature::kNoVarArgs);
+	signature.AddArg(ValueType::Double);
+	signature.AddArg(ValueType::UInt32);
+
+	SECTION("stubs are counted by kind and signature") {
+		JitContext::ResetStats();
+
+		JitCall call;
+		REQUIRE(call.GetJitFunc(signature, &Scale, JitCall::WaitType::None, false));
+
+		JitCallback callback;
+		REQUIRE(callback.GetJitFunc(signature, nullptr, &NoopHandler, nullptr, false));
+
+		auto stats = JitContext::GetStats();
+		REQUIRE(stats.GetStubCount(JitStubKind::Call) == 1);
+		REQUIRE(stats.GetStubCount(JitStubKind::Callback) == 1);
+		REQUIRE(stats.compilations == 2);
+		REQUIRE(stats.maxCompileTime <= stats.totalCompileTime);
+		REQUIRE(stats.liveBlocks > 0);
+		REQUIRE(stats.codeBytes > 0);
+
+		auto it = std::ranges::find(stats.signatures, "double(double, uint32)", &JitSignatureStats::name);
+		REQUIRE(it != stats.signatures.end());
+	}
+
+	SECTION("generic stubs are shared through the cache") {
+		if (sizeof(void*) != sizeof(uint64_t)) {
+			SKIP("generic stubs are used on 64-bit targets only");
+		}
+
+		JitCall first;
+		REQUIRE(first.GetJitFunc(signature, &Scale, JitCall::WaitType::None, false));
+
+		JitContext::ResetStats();
+
+		JitCall second;
+		REQUIRE(second.GetJitFunc(signature, &Scale, JitCall::WaitType::None, false));
+
+		auto stats = JitContext::GetStats();
+		REQUIRE(stats.GetStubCount(JitStubKind::Generic) == 0);
+		REQUIRE(stats.compilations == 0);
+		REQUIRE(stats.cacheHits == 1);
+		REQUIRE(stats.cacheMisses == 0);
+		REQUIRE(stats.GetCacheHitRate() == 1.0);
+	}
+
+	SECTION("loop stubs are counted apart") {
+		if (sizeof(void*) != sizeof(uint64_t)) {
+			SKIP("generic stubs are used on 64-bit targets only");
+		}
+
+		JitCall call;
+		REQUIRE(call.GetJitFunc(signature, &Scale, JitCall::WaitType::None, false));
+
+		Parameters params(2);
+		params.Add(1.5);
+		params.Add(uint32_t{ 2 });
+		std::array<Address, 2> targets{ &Scale, &Scale };
+
+		JitContext::ResetStats();
+		REQUIRE(call.InvokeAll(targets, params));
+		REQUIRE(call.InvokeAll(targets, params));
+
+		auto stats = JitContext::GetStats();
+		REQUIRE(stats.GetStubCount(JitStubKind::Loop) == 1);
+		REQUIRE(stats.GetStubCount(JitStubKind::Generic) == 0);
+		REQUIRE(stats.compilations == 1);
+	}
+
+	SECTION("released code is no longer accounted") {
+		size_t liveBlocks;
+		{
+			JitCallback callback;
+			REQUIRE(callback.GetJitFunc(signature, nullptr, &NoopHandler, nullptr, false));
+			liveBlocks = JitContext::GetStats().liveBlocks;
+		}
+		REQUIRE(JitContext::GetStats().liveBlocks == liveBlocks - 1);
+	}
+}
@@ -0,0 +1,149 @@
+#include <catch_amalgamated.hpp>
+
+#include <plugify/call.hpp>
+#include <plugify/callback.hpp>
+#include <plugify/jit_context.hpp>
+
+#include <cstring>
+
+using namespace plugify;
+
+// Integer only shapes are answered by precompiled thunks on the SysV x86-64 ABI,
+// elsewhere the same signatures are compiled and must behave the same
+#if (defined(__x86_64__) || defined(_M_X64)) && !defined(_WIN32)
+#define TEST_HAS_THUNKS 1
+#else
+#define TEST_HAS_THUNKS 0
+#endif
+
+namespace {
+	int64_t Combine(int64_t a, int32_t b, uint8_t c, const int64_t* d, uint16_t e, int64_t f) {
+		return a * 1000 + b * 100 + c * 10 + *d + e - f;
+	}
+
+	int64_t g_stored = 0;
+
+	void Store(int64_t a, int32_t b) {
+		g_stored = a - b;
+	}
+
+	int32_t Pick(int32_t a, int64_t b, uint8_t c) {
+		return c ? a : static_cast<int32_t>(b);
+	}
+
+	// data + a * 100 + b * 10 + c
+	void PickHandler(const Method*, Address data, uint64_t* params, size_t count, void* ret) {
+		ParametersSpan args(params, count);
+		auto value = static_cast<int32_t>(data.GetPtr()) + args.Get<int32_t>(0) * 100 + static_cast<int32_t>(args.Get<int64_t>(1)) * 10 + args.Get<uint8_t>(2);
+		std::memcpy(ret, &value, sizeof(value));
+	}
+
+	int32_t PickDirect(int32_t data, int32_t a, int64_t b, uint8_t c) {
+		return data + a * 100 + static_cast<int32_t>(b) * 10 + c;
+	}
+
+	int64_t g_handled = 0;
+
+	void StoreHandler(const Method*, Address data, uint64_t* params, size_t count, void*) {
+		ParametersSpan args(params, count);
+		g_handled = static_cast<int64_t>(data.GetPtr()) + args.Get<int64_t>(0) - args.Get<int32_t>(1);
+	}
+
+	size_t ThunkHits() {
+		return JitContext::GetStats().thunkHits;
+	}
+}
+
+TEST_CASE("precompiled thunks", "[jit]") {
+	SECTION("call shapes match direct calls") {
+		Signature combine(CallConv::CDecl, ValueType::Int64, Signature::kNoVarArgs);
+		combine.AddArg(ValueType::Int64);
+		combine.AddArg(ValueType::Int32);
+		combine.AddArg(ValueType::UInt8);
+		combine.AddArg(ValueType::Pointer);
+		combine.AddArg(ValueType::UInt16);
+		combine.AddArg(ValueType::Int64);
+
+		Signature store(CallConv::CDecl, ValueType::Void, Signature::kNoVarArgs);
+		store.AddArg(ValueType::Int64);
+		store.AddArg(ValueType::Int32);
+
+		JitContext::ResetStats();
+
+		JitCall combineCall;
+		auto combineFunc = combineCall.GetJitFunc(combine, &Combine, JitCall::WaitType::None, false).As<JitCall::CallingFunc>();
+		REQUIRE(combineFunc);
+		JitCall storeCall;
+		auto storeFunc = storeCall.GetJitFunc(store, &Store, JitCall::WaitType::None, false).As<JitCall::CallingFunc>();
+		REQUIRE(storeFunc);
+
+		REQUIRE(ThunkHits() == (TEST_HAS_THUNKS ? 2 : 0));
+
+		const int64_t d = 7;
+		Parameters params(6);
+		params.Add(int64_t{ -3 });
+		params.Add(int32_t{ 5 });
+		params.Add(uint8_t{ 9 });
+		params.Add(&d);
+		params.Add(uint16_t{ 60000 });
+		params.Add(int64_t{ 1 } << 40);
+		Return ret;
+		combineFunc(params.Get(), &ret);
+		REQUIRE(ret.Get<int64_t>() == Combine(-3, 5, 9, &d, 60000, int64_t{ 1 } << 40));
+
+		Parameters storeParams(2);
+		storeParams.Add(int64_t{ 100 });
+		storeParams.Add(int32_t{ -20 });
+		storeFunc(storeParams.Get(), nullptr);
+		REQUIRE(g_stored == 120);
+	}
+
+	SECTION("callback shapes match direct calls") {
+		Signature pick(CallConv::CDecl, ValueType::Int32, Signature::kNoVarArgs);
+		pick.AddArg(ValueType::Int32);
+		pick.AddArg(ValueType::Int64);
+		pick.AddArg(ValueType::UInt8);
+
+		Signature store(CallConv::CDecl, ValueType::Void, Signature::kNoVarArgs);
+		store.AddArg(ValueType::Int64);
+		store.AddArg(ValueType::Int32);
+
+		JitContext::ResetStats();
+
+		JitCallback pickCallback;
+		auto pickFunc = pickCallback.GetJitFunc(pick, nullptr, &PickHandler, 4, false).As<decltype(&Pick)>();
+		REQUIRE(pickFunc);
+		JitCallback storeCallback;
+		auto storeFunc = storeCallback.GetJitFunc(store, nullptr, &StoreHandler, 1000, false).As<decltype(&Store)>();
+		REQUIRE(storeFunc);
+
+		REQUIRE(ThunkHits() == (TEST_HAS_THUNKS ? 2 : 0));
+
+		REQUIRE(pickFunc(-2, 3, 1) == PickDirect(4, -2, 3, 1));
+		REQUIRE(pickFunc(7, -5, 0) == PickDirect(4, 7, -5, 0));
+
+		storeFunc(50, -8);
+		REQUIRE(g_handled == 1058);
+	}
+
+	SECTION("shapes outside the thunks are compiled") {
+		Signature wide(CallConv::CDecl, ValueType::Int64, Signature::kNoVarArgs);
+		for (size_t i = 0; i < 7; ++i) {
+			wide.AddArg(ValueType::Int64);
+		}
+
+		Signature floating(CallConv::CDecl, ValueType::Int32, Signature::kNoVarArgs);
+		floating.AddArg(ValueType::Int32);
+		floating.AddArg(ValueType::Int64);
+		floating.AddArg(ValueType::Float);
+
+		JitContext::ResetStats();
+
+		JitCallback wideCallback;
+		REQUIRE(wideCallback.GetJitFunc(wide, nullptr, &PickHandler, nullptr, false));
+		JitCallback floatingCallback;
+		REQUIRE(floatingCallback.GetJitFunc(floating, nullptr, &PickHandler, nullptr, false));
+
+		REQUIRE(ThunkHits() == 0);
+	}
+}
@@ -0,0 +1,111 @@
+#include <catch_amalgamated.hpp>
+
+#include <plugify/callback.hpp>
+#include <plugify/jit_context.hpp>
+
+using namespace plugify;
+
+namespace {
+	struct Context {
+		int64_t base{};
+		int calls{};
+	};
+
+	// Handlers take the user data in front of the callback arguments
+
+	int64_t SumHandler(void* data, int64_t a, int32_t b, const int64_t* c) {
+		auto* context = static_cast<Context*>(data);
+		++context->calls;
+		return context->base + a + b + *c;
+	}
+
+	double MixHandler(void* data, float a, int64_t b, double c, int32_t d) {
+		auto* context = static_cast<Context*>(data);
+		++context->calls;
+		return static_cast<double>(context->base) + a * b + c * d;
+	}
+
+	// six integer arguments, the data pointer no longer fits a register
+	int64_t WideHandler(void* data, int64_t a, int64_t b, int64_t c, int64_t d, int64_t e, int64_t f) {
+		auto* context = static_cast<Context*>(data);
+		++context->calls;
+		return context->base + a - b + c - d + e - f;
+	}
+
+	void NotifyHandler(void* data, int32_t value) {
+		static_cast<Context*>(data)->base += value;
+	}
+
+	using SumFunc = int64_t (*)(int64_t, int32_t, const int64_t*);
+	using MixFunc = double (*)(float, int64_t, double, int32_t);
+	using WideFunc = int64_t (*)(int64_t, int64_t, int64_t, int64_t, int64_t, int64_t);
+	using NotifyFunc = void (*)(int32_t);
+}
+
+TEST_CASE("typed callbacks", "[jit]") {
+	Context context{ .base = 1000 };
+
+	SECTION("integer arguments") {
+		Signature signature(CallConv::CDecl, ValueType::Int64, Signature::kNoVarArgs);
+		signature.AddArg(ValueType::Int64);
+		signature.AddArg(ValueType::Int32);
+		signature.AddArg(ValueType::Pointer);
+
+		JitContext::ResetStats();
+
+		JitCallback callback;
+		auto func = callback.GetTypedJitFunc(signature, &SumHandler, &context, false).As<SumFunc>();
+		REQUIRE(func);
+		REQUIRE(callback.GetFunction() == Address(func));
+		REQUIRE(callback.GetUserData() == Address(&context));
+		REQUIRE(JitContext::GetStats().GetStubCount(JitStubKind::TypedCallback) == 1);
+
+		const int64_t c = 5;
+		REQUIRE(func(-40, 3, &c) == 968);
+		REQUIRE(func(int64_t{ 1 } << 40, -1, &c) == (int64_t{ 1 } << 40) + 1004);
+		REQUIRE(context.calls == 2);
+	}
+
+	SECTION("floating point and integer arguments") {
+		Signature signature(CallConv::CDecl, ValueType::Double, Signature::kNoVarArgs);
+		signature.AddArg(ValueType::Float);
+		signature.AddArg(ValueType::Int64);
+		signature.AddArg(ValueType::Double);
+		signature.AddArg(ValueType::Int32);
+
+		JitCallback callback;
+		auto func = callback.GetTypedJitFunc(signature, &MixHandler, &context, false).As<MixFunc>();
+		REQUIRE(func);
+
+		REQUIRE(func(0.5f, 8, 1.25, -4) == MixHandler(&context, 0.5f, 8, 1.25, -4));
+		REQUIRE(context.calls == 2);
+	}
+
+	SECTION("every integer register taken") {
+		Signature signature(CallConv::CDecl, ValueType::Int64, Signature::kNoVarArgs);
+		for (size_t i = 0; i < 6; ++i) {
+			signature.AddArg(ValueType::Int64);
+		}
+
+		JitCallback callback;
+		auto func = callback.GetTypedJitFunc(signature, &WideHandler, &context, false).As<WideFunc>();
+		REQUIRE(func);
+
+		REQUIRE(func(1, 2, 3, 4, 5, 6) == 997);
+		REQUIRE(func(60, 50, 40, 30, 20, 10) == 1030);
+		REQUIRE(context.calls == 2);
+	}
+
+	SECTION("void return") {
+		Signature signature(CallConv::CDecl, ValueType::Void, Signature::kNoVarArgs);
+		signature.AddArg(ValueType::Int32);
+
+		JitCallback callback;
+		auto func = callback.GetTypedJitFunc(signature, &NotifyHandler, &context, false).As<NotifyFunc>();
+		REQUIRE(func);
+
+		func(24);
+		func(-12);
+		REQUIRE(context.base == 1012);
+	}
+}
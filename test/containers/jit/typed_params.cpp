@@ -0,0 +1,52 @@
+#include <catch_amalgamated.hpp>
+
+#include <plugify/call.hpp>
+
+using namespace plugify;
+
+namespace {
+	double Weigh(int32_t count, double weight, float bias, const int64_t* offset) {
+		return count * weight + bias + static_cast<double>(*offset);
+	}
+}
+
+TEST_CASE("typed parameters", "[jit]") {
+	Signature signature(CallConv::CDecl, ValueType::Double, Signature::kNoVarArgs);
+	signature.AddArg(ValueType::Int32);
+	signature.AddArg(ValueType::Double);
+	signature.AddArg(ValueType::Float);
+	signature.AddArg(ValueType::Pointer);
+
+	SECTION("same slots as the dynamic builder") {
+		const int64_t offset = 4;
+		TypedParameters typed(int32_t{ 3 }, 1.5, 0.25f, &offset);
+
+		Parameters dynamic(signature.ArgCount());
+		dynamic.Add(int32_t{ 3 }).Add(1.5).Add(0.25f).Add(&offset);
+
+		REQUIRE(std::memcmp(typed.Get(), dynamic.Get(), decltype(typed)::SlotCount * sizeof(uint64_t)) == 0);
+	}
+
+	SECTION("checked against the signature") {
+		REQUIRE(TypedParameters<int32_t, double, float, const int64_t*>::Matches(signature));
+		REQUIRE_FALSE(TypedParameters<int32_t, double, float>::Matches(signature));
+		REQUIRE_FALSE(TypedParameters<int64_t, double, float, const int64_t*>::Matches(signature));
+		REQUIRE_FALSE(TypedParameters<int32_t, float, float, const int64_t*>::Matches(signature));
+	}
+
+	SECTION("invoked through the call stub") {
+		JitCall call;
+		REQUIRE(call.GetJitFunc(signature, &Weigh, JitCall::WaitType::None, false));
+
+		const int64_t offset = 4;
+		TypedParameters params(int32_t{ 2 }, 1.5, 0.5f, &offset);
+
+		Return ret;
+		call.Invoke(params, &ret);
+		REQUIRE(ret.Get<double>() == Weigh(2, 1.5, 0.5f, &offset));
+
+		params.Set<0>(10);
+		call.Invoke(params, &ret);
+		REQUIRE(ret.Get<double>() == Weigh(10, 1.5, 0.5f, &offset));
+	}
+}
@@ -0,0 +1,96 @@
+#include <catch_amalgamated.hpp>
+
+#include <plugify/call.hpp>
+#include <plugify/callback.hpp>
+
+#include <plg/numerics.hpp>
+
+#include <cstring>
+
+using namespace plugify;
+
+namespace {
+	float Dot3(plg::vec3 a, plg::vec3 b) {
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	float Mixed(float scale, plg::vec2 a, int32_t offset, plg::vec4 b) {
+		return scale * (a.x + a.y + b.x + b.y + b.z + b.w) + static_cast<float>(offset);
+	}
+
+	void SumHandler(const Method*, Address, uint64_t* params, size_t count, void* ret) {
+		// by-value vectors arrive as pointers to a copy
+		float sum = 0.0f;
+		for (size_t i = 0; i < count; ++i) {
+			const auto* v = reinterpret_cast<const plg::vec3*>(params[i]);
+			sum += v->x + v->y + v->z;
+		}
+		std::memcpy(ret, &sum, sizeof(sum));
+	}
+}
+
+TEST_CASE("by-value vector parameters", "[jit]") {
+	if (sizeof(void*) != sizeof(uint64_t)) {
+		SKIP("vectors are passed in registers on 64-bit targets only");
+	}
+
+	SECTION("JitCall passes vectors in registers") {
+		Signature signature(CallConv::CDecl, ValueType::Float, Signature::kNoVarArgs);
+		signature.AddArg(ValueType::Vector3);
+		signature.AddArg(ValueType::Vector3);
+
+		JitCall call;
+		Address func = call.GetJitFunc(signature, &Dot3, JitCall::WaitType::None, false);
+		REQUIRE(func);
+
+		plg::vec3 a{ { { 1.0f, 2.0f, 3.0f } } };
+		plg::vec3 b{ { { 4.0f, 5.0f, 6.0f } } };
+
+		Parameters params(2);
+		params.Add(&a);
+		params.Add(&b);
+		Return ret;
+		func.As<JitCall::CallingFunc>()(params.Get(), &ret);
+
+		REQUIRE(ret.Get<float>() == Dot3(a, b));
+	}
+
+	SECTION("JitCall mixes vectors with scalars") {
+		Signature signature(CallConv::CDecl, ValueType::Float, Signature::kNoVarArgs);
+		signature.AddArg(ValueType::Float);
+		signature.AddArg(ValueType::Vector2);
+		signature.AddArg(ValueType::Int32);
+		signature.AddArg(ValueType::Vector4);
+
+		JitCall call;
+		Address func = call.GetJitFunc(signature, &Mixed, JitCall::WaitType::None, false);
+		REQUIRE(func);
+
+		plg::vec2 a{ { { 1.0f, 2.0f } } };
+		plg::vec4 b{ { { 3.0f, 4.0f, 5.0f, 6.0f } } };
+
+		Parameters params(4);
+		params.Add(2.0f);
+		params.Add(&a);
+		params.Add(int32_t{ 7 });
+		params.Add(&b);
+		Return ret;
+		func.As<JitCall::CallingFunc>()(params.Get(), &ret);
+
+		REQUIRE(ret.Get<float>() == Mixed(2.0f, a, 7, b));
+	}
+
+	SECTION("JitCallback receives vectors from registers") {
+		Signature signature(CallConv::CDecl, ValueType::Float, Signature::kNoVarArgs);
+		signature.AddArg(ValueType::Vector3);
+		signature.AddArg(ValueType::Vector3);
+
+		JitCallback callback;
+		Address func = callback.GetJitFunc(signature, nullptr, &SumHandler, nullptr, false);
+		REQUIRE(func);
+
+		plg::vec3 a{ { { 1.0f, 2.0f, 3.0f } } };
+		plg::vec3 b{ { { 4.0f, 5.0f, 6.0f } } };
+		REQUIRE(func.As<decltype(&Dot3)>()(a, b) == 21.0f);
+	}
+}
@@ -0,0 +1,132 @@
+#include <catch_amalgamated.hpp>
+
+#include <plugify/binary_log.hpp>
+
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace plugify;
+
+namespace {
+	struct CaptureLogger final : ILogger {
+		void Log(std::string_view message, Severity severity, const Location&) override {
+			std::lock_guard lock(mutex);
+			messages.emplace_back(message);
+			severities.push_back(severity);
+		}
+
+		void SetLogLevel(Severity) override {}
+		Severity GetLogLevel() override { return Severity::Trace; }
+		void Flush() override {}
+
+		std::mutex mutex;
+		std::vector<std::string> messages;
+		std::vector<Severity> severities;
+	};
+}
+
+TEST_CASE("binary log", "[log]") {
+	SECTION("rendered into a logger") {
+		auto capture = std::make_shared<CaptureLogger>();
+		auto log = BinaryLog::Create(capture);
+
+		std::string name = "frame";
+		for (int i = 0; i < 3; ++i) {
+			PLUGIFY_LOG_BINARY(*log, Severity::Info, "{} {} took {:.2f} ms ({})", name, i, 1.5 * i, i % 2 == 0);
+		}
+		PLUGIFY_LOG_BINARY(*log, Severity::Warning, "no arguments");
+		log->Flush();
+
+		REQUIRE(capture->messages == std::vector<std::string>{
+			"frame 0 took 0.00 ms (true)",
+			"frame 1 took 1.50 ms (false)",
+			"frame 2 took 3.00 ms (true)",
+			"no arguments",
+		});
+		REQUIRE(capture->severities.back() == Severity::Warning);
+	}
+
+	SECTION("filtered by level") {
+		auto capture = std::make_shared<CaptureLogger>();
+		auto log = BinaryLog::Create(capture, { .minSeverity = Severity::Info });
+
+		PLUGIFY_LOG_BINARY(*log, Severity::Debug, "hidden {}", 1);
+		log->SetLogLevel(Severity::Debug);
+		PLUGIFY_LOG_BINARY(*log, Severity::Debug, "shown {}", 2);
+		log->Flush();
+
+		REQUIRE(capture->messages == std::vector<std::string>{ "shown 2" });
+	}
+
+	SECTION("full ring drops instead of blocking") {
+		auto capture = std::make_shared<CaptureLogger>();
+		auto log = BinaryLog::Create(capture, { .threadBufferSize = 4096, .flushInterval = std::chrono::hours(1) });
+
+		for (uint64_t i = 0; i < 1000; ++i) {
+			PLUGIFY_LOG_BINARY(*log, Severity::Info, "{}", i);
+		}
+		REQUIRE(log->GetDropped() > 0);
+	}
+
+	SECTION("one thread writes to several logs") {
+		auto first = std::make_shared<CaptureLogger>();
+		auto second = std::make_shared<CaptureLogger>();
+		auto a = BinaryLog::Create(first);
+		auto b = BinaryLog::Create(second);
+
+		for (int i = 0; i < 3; ++i) {
+			PLUGIFY_LOG_BINARY(*a, Severity::Info, "a {}", i);
+			PLUGIFY_LOG_BINARY(*b, Severity::Info, "b {}", i);
+		}
+		a->Flush();
+		b->Flush();
+
+		REQUIRE(first->messages == std::vector<std::string>{ "a 0", "a 1", "a 2" });
+		REQUIRE(second->messages == std::vector<std::string>{ "b 0", "b 1", "b 2" });
+	}
+
+	SECTION("rings of exited threads are drained and freed") {
+		auto capture = std::make_shared<CaptureLogger>();
+		auto log = BinaryLog::Create(capture, { .threadBufferSize = 4096, .flushInterval = std::chrono::hours(1) });
+
+		for (int t = 0; t < 4; ++t) {
+			std::thread([&] {
+				for (uint64_t i = 0; i < 1000; ++i) {
+					PLUGIFY_LOG_BINARY(*log, Severity::Info, "{}", i);
+				}
+			}).join();
+		}
+		const uint64_t dropped = log->GetDropped();
+		REQUIRE(dropped > 0);
+
+		log->Flush();
+		const size_t delivered = capture->messages.size() - 1;  // the last one reports the drops
+		REQUIRE(delivered + dropped == 4000);
+
+		// freeing the rings keeps what they dropped
+		log->Flush();
+		REQUIRE(log->GetDropped() == dropped);
+	}
+
+	SECTION("decoded from a file") {
+		auto path = std::filesystem::temp_directory_path() / "plugify_binary_log_test.blog";
+		{
+			auto log = BinaryLog::Create(path);
+			REQUIRE(log);
+			int32_t value = -7;
+			PLUGIFY_LOG_BINARY(**log, Severity::Error, "value {} at {:#x} in {}", value, 255u, "main");
+		}
+
+		std::vector<std::string> messages;
+		auto result = BinaryLog::Decode(path, [&](const BinaryLogRecord& record) {
+			messages.emplace_back(record.message);
+			REQUIRE(record.severity == Severity::Error);
+			REQUIRE(record.location.line() != 0);
+		});
+		std::filesystem::remove(path);
+
+		REQUIRE(result);
+		REQUIRE(messages == std::vector<std::string>{ "value -7 at 0xff in main" });
+	}
+}
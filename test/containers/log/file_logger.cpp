@@ -0,0 +1,111 @@
+#include <catch_amalgamated.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/file_logger.hpp"
+
+using namespace plugify;
+
+namespace {
+	std::string ReadFile(const std::filesystem::path& file) {
+		std::ifstream in(file, std::ios::binary);
+		std::stringstream ss;
+		ss << in.rdbuf();
+		return ss.str();
+	}
+
+	std::vector<std::string> ListDir(const std::filesystem::path& dir) {
+		std::vector<std::string> names;
+		for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+			names.push_back(entry.path().filename().string());
+		}
+		std::ranges::sort(names);
+		return names;
+	}
+
+	size_t CountRotated(const std::vector<std::string>& names) {
+		return static_cast<size_t>(std::ranges::count_if(names, [](const std::string& name) {
+			return name.starts_with("session-2") && name.ends_with(".log");
+		}));
+	}
+}
+
+TEST_CASE("file logger", "[log]") {
+	auto dir = std::filesystem::temp_directory_path() / "plugify_file_logger_test";
+	std::filesystem::remove_all(dir);
+	std::filesystem::create_directories(dir);
+	auto path = dir / "session.log";
+
+	SECTION("keeps lines buffered until flushed") {
+		FileLogger logger(path, Severity::Info, { .flushInterval = std::chrono::hours(1) });
+		logger.Log("buffered line", Severity::Info);
+		REQUIRE(std::filesystem::file_size(path) == 0);
+
+		logger.Flush();
+		REQUIRE(ReadFile(path).find("buffered line") != std::string::npos);
+
+		// errors skip the buffer
+		logger.Log("failed line", Severity::Error);
+		REQUIRE(ReadFile(path).find("failed line") != std::string::npos);
+	}
+
+	SECTION("rotates a full file") {
+		{
+			FileLogger logger(path, Severity::Info, { .maxFileSize = 16, .bufferSize = 1, .maxFiles = 0 });
+			for (int i = 0; i < 3; ++i) {
+				logger.Log(std::format("line {}", i), Severity::Info);
+			}
+		}
+
+		auto names = ListDir(dir);
+		REQUIRE(CountRotated(names) == 3);
+		REQUIRE(std::ranges::find(names, "session.log") != names.end());
+	}
+
+	SECTION("syncs rotated files off the logging thread") {
+		{
+			FileLogger logger(path, Severity::Info, { .maxFileSize = 16, .bufferSize = 1, .maxFiles = 0, .fsync = FsyncPolicy::OnRotate });
+			for (int i = 0; i < 3; ++i) {
+				logger.Log(std::format("line {}", i), Severity::Info);
+			}
+		}
+
+		auto names = ListDir(dir);
+		REQUIRE(CountRotated(names) == 3);
+		for (const auto& name : names) {
+			if (name.starts_with("session-2")) {
+				REQUIRE(ReadFile(dir / name).find("line") != std::string::npos);
+			}
+		}
+	}
+
+	SECTION("keeps only the newest rotated files") {
+		// share the stem with the log but were not written by it
+		std::ofstream(dir / "session-notes.log") << "notes";
+		std::ofstream(dir / "session-20260101_000000.txt") << "report";
+
+		{
+			FileLogger logger(path, Severity::Info, { .maxFileSize = 16, .bufferSize = 1, .maxFiles = 2 });
+			for (int i = 0; i < 5; ++i) {
+				logger.Log(std::format("line {}", i), Severity::Info);
+			}
+		}
+
+		auto names = ListDir(dir);
+		REQUIRE(CountRotated(names) == 2);
+		REQUIRE(std::ranges::find(names, "session-notes.log") != names.end());
+		REQUIRE(std::ranges::find(names, "session-20260101_000000.txt") != names.end());
+	}
+
+	std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,140 @@
+#include <catch_amalgamated.hpp>
+
+#include <plugify/flight_recorder.hpp>
+
+#include <atomic>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/flight_recorder_logger.hpp"
+
+using namespace plugify;
+
+namespace {
+	struct NullLogger final : ILogger {
+		void Log(std::string_view, Severity, const Location&) override {}
+		void SetLogLevel(Severity severity) override { level = severity; }
+		Severity GetLogLevel() override { return level; }
+		void Flush() override {}
+
+		Severity level{ Severity::Error };
+	};
+
+	// Offset of the capacity in the file header: magic, version, slot size
+	constexpr std::streamoff kCapacityOffset = 16;
+}
+
+TEST_CASE("flight recorder", "[log]") {
+	auto path = std::filesystem::temp_directory_path() / "plugify_flight_recorder_test.rec";
+
+	SECTION("keeps the latest entries in order") {
+		{
+			auto recorder = FlightRecorder::Create(path, 16);
+			REQUIRE(recorder);
+			REQUIRE((*recorder)->GetCapacity() == 16);
+			for (int i = 0; i < 40; ++i) {
+				(*recorder)->Record(FlightEvent::Log, Severity::Info, "entry {}", i);
+			}
+			(*recorder)->Record(FlightEvent::State, Severity::Error, "plugin crashed");
+		}
+
+		std::vector<std::string> texts;
+		uint64_t last = 0;
+		auto result = FlightRecorder::Decode(path, [&](const FlightRecord& record) {
+			REQUIRE((texts.empty() || record.sequence > last));
+			last = record.sequence;
+			texts.emplace_back(record.text);
+		});
+		REQUIRE(result);
+		REQUIRE(texts.size() == 16);
+		REQUIRE(texts.front() == "entry 25");
+		REQUIRE(texts.back() == "plugin crashed");
+	}
+
+	SECTION("truncates long texts") {
+		{
+			auto recorder = FlightRecorder::Create(path);
+			REQUIRE(recorder);
+			(*recorder)->Record(FlightEvent::Loader, Severity::Debug, std::string(4 * FlightRecorder::kSlotSize, 'x'));
+		}
+
+		size_t length = 0;
+		REQUIRE(FlightRecorder::Decode(path, [&](const FlightRecord& record) { length = record.text.size(); }));
+		REQUIRE(length > 0);
+		REQUIRE(length < FlightRecorder::kSlotSize);
+	}
+
+	SECTION("writers lapping the ring never mix their entries") {
+		constexpr int kThreads = 8;
+		constexpr int kEntries = 20000;
+		{
+			auto recorder = FlightRecorder::Create(path, 16);
+			REQUIRE(recorder);
+
+			std::vector<std::thread> threads;
+			for (int t = 0; t < kThreads; ++t) {
+				threads.emplace_back([&, t] {
+					// every text of a thread has the same length and character
+					const std::string text(static_cast<size_t>(16 + t * 8), static_cast<char>('a' + t));
+					for (int i = 0; i < kEntries; ++i) {
+						(*recorder)->Record(FlightEvent::Log, Severity::Info, text);
+					}
+				});
+			}
+			for (auto& thread : threads) {
+				thread.join();
+			}
+		}
+
+		size_t count = 0;
+		bool mixed = false;
+		auto result = FlightRecorder::Decode(path, [&](const FlightRecord& record) {
+			++count;
+			const int t = record.text.empty() ? -1 : record.text.front() - 'a';
+			if (t < 0 || t >= kThreads || record.text.size() != static_cast<size_t>(16 + t * 8)
+				|| record.text.find_first_not_of(record.text.front()) != std::string_view::npos) {
+				mixed = true;
+			}
+		});
+		REQUIRE(result);
+		REQUIRE(count > 0);
+		REQUIRE_FALSE(mixed);
+	}
+
+	SECTION("rejects a capacity larger than the file") {
+		{
+			auto recorder = FlightRecorder::Create(path, 16);
+			REQUIRE(recorder);
+		}
+		{
+			std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+			file.seekp(kCapacityOffset);
+			const uint64_t capacity = uint64_t{ 1 } << 40;
+			file.write(reinterpret_cast<const char*>(&capacity), sizeof(capacity));
+		}
+
+		REQUIRE_FALSE(FlightRecorder::Decode(path, [](const FlightRecord&) {}));
+	}
+
+	SECTION("records Unknown whatever the level") {
+		{
+			auto recorder = FlightRecorder::Create(path, 16);
+			REQUIRE(recorder);
+			FlightRecorderLogger logger(std::make_shared<NullLogger>(), *recorder);
+			logger.Log("hidden", Severity::Info);
+			logger.Log("always", Severity::Unknown);
+			logger.Log("failed", Severity::Error);
+		}
+
+		std::vector<std::string> texts;
+		REQUIRE(FlightRecorder::Decode(path, [&](const FlightRecord& record) { texts.emplace_back(record.text); }));
+		REQUIRE(texts == std::vector<std::string>{ "always", "failed" });
+	}
+
+	std::filesystem::remove(path);
+	std::filesystem::remove(std::filesystem::path(path) += ".prev");
+}
@@ -11,7 +11,10 @@
 
 #include <plg/format.hpp>
 
+#include "plugify/binary_log.hpp"
 #include "plugify/extension.hpp"
+#include "plugify/flight_recorder.hpp"
+#include "plugify/jit_context.hpp"
 #include "plugify/logger.hpp"
 #include "plugify/manager.hpp"
 #include "plugify/plugify.hpp"
@@ -194,18 +197,21 @@ namespace {
 		return totalSize;
 	}
 
+	std::string FormatBytes(uintmax_t size) {
+		if (size < 1024) {
+			return std::format("{} B", size);
+		} else if (size < 1024 * 1024) {
+			return std::format("{:.1f} KB", static_cast<double>(size) / 1024.0);
+		} else if (size < 1024ull * 1024 * 1024) {
+			return std::format("{:.1f} MB", static_cast<double>(size) / (1024.0 * 1024.0));
+		} else {
+			return std::format("{:.1f} GB", static_cast<double>(size) / (1024.0 * 1024.0 * 1024.0));
+		}
+	}
+
 	std::string FormatFileSize(const std::filesystem::path& path) {
 		try {
-			auto size = GetSizeRecursive(path);
-			if (size < 1024) {
-				return std::format("{} B", size);
-			} else if (size < 1024 * 1024) {
-				return std::format("{:.1f} KB", static_cast<double>(size) / 1024.0);
-			} else if (size < 1024ull * 1024 * 1024) {
-				return std::format("{:.1f} MB", static_cast<double>(size) / (1024.0 * 1024.0));
-			} else {
-				return std::format("{:.1f} GB", static_cast<double>(size) / (1024.0 * 1024.0 * 1024.0));
-			}
+			return FormatBytes(GetSizeRecursive(path));
 		} catch (...) {
 			return "N/A";
 		}
@@ -1496,6 +1502,98 @@ public:
 		plg::print(DOUBLE_LINE);
 	}
 
+	void ShowJitStats(bool jsonOutput, size_t topSignatures, bool reset) {
+		auto stats = JitContext::GetStats();
+		if (reset) {
+			JitContext::ResetStats();
+		}
+
+		auto toMs = [](std::chrono::nanoseconds ns) {
+			return std::chrono::duration<double, std::milli>(ns).count();
+		};
+		auto average = stats.compilations
+			? stats.totalCompileTime / static_cast<int64_t>(stats.compilations)
+			: std::chrono::nanoseconds{};
+		auto signatureCount = std::min(topSignatures, stats.signatures.size());
+
+		if (jsonOutput) {
+			json output;
+			for (size_t i = 0; i < stats.stubs.size(); ++i) {
+				auto kind = static_cast<JitStubKind>(i);
+				output["stubs"][std::string(plg::enum_to_string(kind))] = stats.GetStubCount(kind);
+			}
+			output["memory"]["liveBlocks"] = stats.liveBlocks;
+			output["memory"]["codeBytes"] = stats.codeBytes;
+			output["memory"]["dataBytes"] = stats.dataBytes;
+			output["memory"]["reservedBytes"] = stats.reservedBytes;
+			output["memory"]["overheadBytes"] = stats.overheadBytes;
+			output["compile"]["count"] = stats.compilations;
+			output["compile"]["totalMs"] = toMs(stats.totalCompileTime);
+			output["compile"]["averageMs"] = toMs(average);
+			output["compile"]["maxMs"] = toMs(stats.maxCompileTime);
+			output["cache"]["hits"] = stats.cacheHits;
+			output["cache"]["misses"] = stats.cacheMisses;
+			output["cache"]["thunkHits"] = stats.thunkHits;
+			output["cache"]["hitRate"] = stats.GetCacheHitRate();
+			output["cache"]["diskHits"] = stats.diskHits;
+			output["cache"]["diskMisses"] = stats.diskMisses;
+			output["cache"]["diskHitRate"] = stats.GetDiskHitRate();
+			json::array_t signatures;
+			signatures.reserve(signatureCount);
+			for (size_t i = 0; i < signatureCount; ++i) {
+				const auto& entry = stats.signatures[i];
+				json::object_t signature;
+				signature["kind"] = std::string(plg::enum_to_string(entry.kind));
+				signature["signature"] = entry.name;
+				signature["count"] = entry.count;
+				signatures.emplace_back(std::move(signature));
+			}
+			output["signatures"] = std::move(signatures);
+			plg::print(*output.dump());
+			return;
+		}
+
+		plg::print(DOUBLE_LINE);
+		plg::print(Colorize("JIT STATISTICS", Colors::BOLD));
+		plg::print(DOUBLE_LINE);
+
+		plg::print(Colorize("\n[Stubs]", Colors::CYAN));
+		for (size_t i = 0; i < stats.stubs.size(); ++i) {
+			auto kind = static_cast<JitStubKind>(i);
+			plg::print("  {:<24} {}", std::format("{}:", plg::enum_to_string(kind)), stats.GetStubCount(kind));
+		}
+
+		plg::print(Colorize("\n[Memory]", Colors::CYAN));
+		plg::print("  Live Blocks:             {}", stats.liveBlocks);
+		plg::print("  Code:                    {}", FormatBytes(stats.codeBytes));
+		plg::print("  Data:                    {}", FormatBytes(stats.dataBytes));
+		plg::print("  Reserved:                {}", FormatBytes(stats.reservedBytes));
+		plg::print("  Allocator Overhead:      {}", FormatBytes(stats.overheadBytes));
+
+		plg::print(Colorize("\n[Compilation]", Colors::CYAN));
+		plg::print("  Compilations:            {}", stats.compilations);
+		plg::print("  Total Time:              {:.3f} ms", toMs(stats.totalCompileTime));
+		plg::print("  Average Time:            {:.3f} ms", toMs(average));
+		plg::print("  Max Time:                {:.3f} ms", toMs(stats.maxCompileTime));
+
+		plg::print(Colorize("\n[Cache]", Colors::CYAN));
+		plg::print("  Hits / Misses:           {} / {}", stats.cacheHits, stats.cacheMisses);
+		plg::print("  Precompiled Thunks:      {}", stats.thunkHits);
+		plg::print("  Hit Rate:                {:.1f}%", stats.GetCacheHitRate() * 100.0);
+		plg::print("  Disk Hits / Misses:      {} / {}", stats.diskHits, stats.diskMisses);
+		plg::print("  Disk Hit Rate:           {:.1f}%", stats.GetDiskHitRate() * 100.0);
+
+		if (signatureCount > 0) {
+			plg::print(Colorize(std::format("\n[Top {} Signatures]", signatureCount), Colors::CYAN));
+			for (size_t i = 0; i < signatureCount; ++i) {
+				const auto& entry = stats.signatures[i];
+				plg::print("  {:>8}  {:<14} {}", entry.count, plg::enum_to_string(entry.kind), entry.name);
+			}
+		}
+
+		plg::print(DOUBLE_LINE);
+	}
+
 	void ShowDependencyTree(std::string_view name, bool useId = false) {
 		if (!CheckManager()) {
 			return;
@@ -1604,6 +1702,96 @@ public:
 		plg::print(SEPARATOR_LINE);
 	}
 
+	void DecodeBinaryLog(const std::filesystem::path& path, bool jsonOutput) {
+		json::array_t records;
+		auto result = BinaryLog::Decode(path, [&](const BinaryLogRecord& record) {
+			if (jsonOutput) {
+				json::object_t entry;
+				entry["time"] = std::format("{:%F %T}", std::chrono::floor<std::chrono::microseconds>(record.time));
+				entry["severity"] = std::string(plg::enum_to_string(record.severity));
+				entry["file"] = std::string(record.location.file_name());
+				entry["line"] = record.location.line();
+				entry["function"] = std::string(record.location.function_name());
+				entry["message"] = std::string(record.message);
+				records.emplace_back(std::move(entry));
+				return;
+			}
+
+			auto seconds = std::chrono::floor<std::chrono::seconds>(record.time);
+			auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(record.time - seconds);
+			auto color = record.severity >= Severity::Error ? Colors::RED
+				: record.severity == Severity::Warning    ? Colors::YELLOW
+				                                          : Colors::GRAY;
+			plg::print(
+				"[{:%F %T}.{:03d}] [{}] [{}:({}:{}): {}] {}",
+				seconds,
+				static_cast<int>(ms.count()),
+				Colorize(plg::enum_to_string(record.severity), color),
+				record.location.module_name().empty()
+					? record.location.file_name()
+					: std::format("{} => {}", record.location.module_name(), record.location.file_name()),
+				record.location.line(),
+				record.location.column(),
+				record.location.function_name(),
+				record.message
+			);
+		});
+
+		if (!result) {
+			plg::print("{}: {}", Colorize("Error", Colors::RED), result.error());
+			return;
+		}
+
+		if (jsonOutput) {
+			json output;
+			output["records"] = std::move(records);
+			plg::print(*output.dump());
+		}
+	}
+
+	void DecodeFlightRecorder(const std::filesystem::path& path, bool jsonOutput) {
+		json::array_t records;
+		auto result = FlightRecorder::Decode(path, [&](const FlightRecord& record) {
+			if (jsonOutput) {
+				json::object_t entry;
+				entry["time"] = std::format("{:%F %T}", std::chrono::floor<std::chrono::microseconds>(record.time));
+				entry["sequence"] = record.sequence;
+				entry["thread"] = record.thread;
+				entry["event"] = std::string(plg::enum_to_string(record.event));
+				entry["severity"] = std::string(plg::enum_to_string(record.severity));
+				entry["text"] = std::string(record.text);
+				records.emplace_back(std::move(entry));
+				return;
+			}
+
+			auto seconds = std::chrono::floor<std::chrono::seconds>(record.time);
+			auto us = std::chrono::duration_cast<std::chrono::microseconds>(record.time - seconds);
+			auto color = record.severity >= Severity::Error ? Colors::RED
+				: record.severity == Severity::Warning    ? Colors::YELLOW
+				                                          : Colors::GRAY;
+			plg::print(
+				"[{:%F %T}.{:06d}] [{:08x}] [{:<6}] [{}] {}",
+				seconds,
+				static_cast<int>(us.count()),
+				record.thread,
+				plg::enum_to_string(record.event),
+				Colorize(plg::enum_to_string(record.severity), color),
+				record.text
+			);
+		});
+
+		if (!result) {
+			plg::print("{}: {}", Colorize("Error", Colors::RED), result.error());
+			return;
+		}
+
+		if (jsonOutput) {
+			json output;
+			output["records"] = std::move(records);
+			plg::print(*output.dump());
+		}
+	}
+
 	void ValidateExtension(const std::filesystem::path& path) {
 		plg::print("{}: {}", Colorize("VALIDATING", Colors::BOLD), plg::as_string(path));
 		plg::print(SEPARATOR_LINE);
@@ -1878,6 +2066,7 @@ void RunEnhancedInteractiveMode(PlugifyApp& app) {
 		auto* search = interactiveApp.add_subcommand("search", "Search extensions");
 		auto* validate = interactiveApp.add_subcommand("validate", "Validate extension file");
 		auto* compare = interactiveApp.add_subcommand("compare", "Compare two extensions");
+		auto* jit = interactiveApp.add_subcommand("jit", "Show JIT statistics");
 
 		// Enhanced list commands with filters and sorting
 		std::string pluginFilterState;
@@ -1950,6 +2139,11 @@ void RunEnhancedInteractiveMode(PlugifyApp& app) {
 		compare->add_flag("-u,--uuid", compare_use_id, "Use ID instead of name");
 		compare->validate_positionals();
 
+		size_t jit_top = 10;
+		bool jit_reset = false;
+		jit->add_option("-n,--top", jit_top, "Number of signatures to show")->capture_default_str();
+		jit->add_flag("--reset", jit_reset, "Reset counters after printing");
+
 		// Set callbacks
 		init->callback([&app]() { app.Initialize(); });
 		term->callback([&app]() { app.Terminate(); });
@@ -2011,6 +2205,8 @@ void RunEnhancedInteractiveMode(PlugifyApp& app) {
 			app.CompareExtensions(compare_ext1, compare_ext2, compare_use_id);
 		});
 
+		jit->callback([&app, &jit_top, &jit_reset]() { app.ShowJitStats(false, jit_top, jit_reset); });
+
 		try {
 			interactiveApp.parse(args);
 		} catch (const CLI::ParseError& e) {
@@ -2144,6 +2340,22 @@ int main(int argc, char** argv) {
 	compare_cmd->validate_positionals();
 	compare_cmd->add_flag("-u,--uuid", compare_use_id, "Use ID instead of name");
 
+	auto* jit_cmd = cliApp.add_subcommand("jit", "Show JIT statistics");
+	size_t jit_top = 10;
+	bool jit_reset = false;
+	jit_cmd->add_option("-n,--top", jit_top, "Number of signatures to show")->capture_default_str();
+	jit_cmd->add_flag("--reset", jit_reset, "Reset counters after printing");
+
+	auto* decode_cmd = cliApp.add_subcommand("decode", "Render a binary log file");
+	std::string decode_path;
+	decode_cmd->add_option("path", decode_path, "Path to binary log file")->required();
+	decode_cmd->validate_positionals();
+
+	auto* flight_cmd = cliApp.add_subcommand("flight", "Render a flight recorder file");
+	std::string flight_path;
+	flight_cmd->add_option("path", flight_path, "Path to flight recorder file, e.g. logs/flight.rec")->required();
+	flight_cmd->validate_positionals();
+
 	// Set callbacks for commands
 	init_cmd->callback([&app]() {
 		app.Initialize();
@@ -2259,6 +2471,17 @@ int main(int argc, char** argv) {
 		app.CompareExtensions(compare_ext1, compare_ext2, compare_use_id);
 	});
 
+	jit_cmd->callback([&app, &jit_top, &jit_reset, &jsonOutput]() {
+		if (!app.IsInitialized()) {
+			app.Initialize();
+		}
+		app.ShowJitStats(jsonOutput, jit_top, jit_reset);
+	});
+
+	decode_cmd->callback([&app, &decode_path, &jsonOutput]() { app.DecodeBinaryLog(decode_path, jsonOutput); });
+
+	flight_cmd->callback([&app, &flight_path, &jsonOutput]() { app.DecodeFlightRecorder(flight_path, jsonOutput); });
+
 	// Parse command line arguments
 	try {
 		// Set global color flag